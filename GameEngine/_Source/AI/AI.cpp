@@ -8,16 +8,22 @@
 #include <map>
 #include <set>
 #include <deque>
+#include <vector>
+#include <float.h>
 #include <assert.h>
+#include <algorithm>
 
 // Utilities header
 #include <Time/Time.h>
 #include <Debug/Debug.h>
 #include <UtilitiesDefault.h>
 #include <SmartPtr/SmartPtr.h>
+#include <HandleTable/HandleTable.h>
 #include <MemoryPool/MemoryPool.h>
 
 #include "AI.h"
+#include "../GameEngine.h"
+#include "../GameEngineDefault.h"
 #include "DebugMenu/DebugMenu.h"
 
 /****************************************************************************************************
@@ -36,34 +42,59 @@ namespace GameEngine
 			E_AI_STATE_MAX
 		} E_AI_STATE;
 
-		typedef struct _s_way_point_open_list_node_
+		// Way points and links compiled into compressed sparse rows, a node is the index of its way
+		// point in ascending ID order
+		typedef struct _s_way_point_graph_
 		{
-			UINT32 u32ID;
-			UINT32 u32ParentID;
-			float g;
-			float h;
-		} S_WAY_POINT_OPEN_LIST_NODE;
-
-		typedef struct _s_way_point_open_list_node_by_f_less
+			std::vector<UINT32> u32NodeID;
+			std::vector<D3DXVECTOR3> centre;
+			// Links of node i are [u32FirstLink[i], u32FirstLink[i + 1])
+			std::vector<UINT32> u32FirstLink;
+			std::vector<UINT32> u32LinkTo;
+			std::vector<float> linkLength;
+			// Same links by the node they end at, links into node i are [u32FirstLinkIn[i], u32FirstLinkIn[i + 1])
+			std::vector<UINT32> u32FirstLinkIn;
+			std::vector<UINT32> u32LinkFrom;
+			std::vector<float> linkLengthIn;
+		} S_WAY_POINT_GRAPH;
+
+		// Per node state of the path search, valid only where u32Generation matches the current
+		// search, so nothing has to be cleared or allocated between searches
+		typedef struct _s_path_search_
 		{
-			bool operator()( const S_WAY_POINT_OPEN_LIST_NODE &i_lhs, const S_WAY_POINT_OPEN_LIST_NODE &i_rhs )
-			{
-				if( (i_lhs.g + i_lhs.h) < (i_rhs.g + i_rhs.h) )
-					return TRUE;
-				else if( (i_lhs.g + i_lhs.h) > (i_rhs.g + i_rhs.h) )
-					return FALSE;
-				else
-					return i_lhs.u32ID < i_rhs.u32ID;
-			}
-		} S_WAY_POINT_OPEN_LIST_NODE_BY_F_LESS;
-
-		typedef struct _s_way_point_open_list_node_by_number_less
+			std::vector<UINT32> u32Generation;
+			std::vector<UINT32> u32Parent;
+			// Position in the open heap, PATH_NODE_CLOSED once expanded
+			std::vector<UINT32> u32HeapIndex;
+			std::vector<float> g;
+			std::vector<float> f;
+			std::vector<UINT32> u32OpenHeap;
+			UINT32 u32CurrentGeneration;
+		} S_PATH_SEARCH;
+
+		const UINT32 PATH_NODE_CLOSED = Utilities::MAX_UINT32;
+
+		// Length of the shortest path from every node to one goal and the next node along it, found by
+		// a single search from the goal over the reversed links
+		typedef struct _s_goal_field_
 		{
-			bool operator()( const S_WAY_POINT_OPEN_LIST_NODE &i_lhs, const S_WAY_POINT_OPEN_LIST_NODE &i_rhs )
-			{
-				return i_lhs.u32ID < i_rhs.u32ID;
-			}
-		} S_WAY_POINT_OPEN_LIST_NODE_BY_NUMBER_LESS;
+			std::vector<float> distance;
+			std::vector<UINT32> u32Next;
+			// Node of the goal, MAX_UINT32 while the field is unused
+			UINT32 u32Goal;
+			UINT32 u32LastUsed;
+		} S_GOAL_FIELD;
+
+		typedef struct _s_path_request_
+		{
+			UINT32 u32Handle;
+			UINT32 u32FromNodeID;
+			UINT32 u32ToNodeID;
+			PathCallback callback;
+			void *data;
+			// AI entity waiting for the path, INVALID_HANDLE for requests made through RequestPath
+			UINT32 u32AIEntityHandle;
+		} S_PATH_REQUEST;
 
 		class AIEntity
 		{
@@ -71,9 +102,13 @@ namespace GameEngine
 			static Utilities::MemoryPool					*m_AIEntityPool;
 
 			Utilities::Pointer::SmartPtr<Entity>	m_entity;
-			std::deque<UINT32> *m_optimalPath;
+			// Nodes left to go to, the next one last
+			std::vector<UINT32> *m_optimalPath;
 			E_AI_STATE m_AIState;
 			UINT32 m_u32TargetNodeID;
+			// Destination of the pending path request while in E_AI_STATE_PATH_FINDING
+			UINT32 m_u32DestinationNodeID;
+			UINT32 m_u32PathRequest;
 
 			AIEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity );
 			~AIEntity( void );
@@ -99,11 +134,54 @@ namespace GameEngine
 		//bool bActivateAI;
 
 		static std::vector< Utilities::Pointer::SmartPtr<AIEntity> > *AIEntityDatabase;
-		void RemoveDeadEntities( void );
-		bool FindOptimalPath( const UINT32 &i_u32FromNodeID, const UINT32 &i_u32ToNodeID, std::deque<UINT32> &o_path );
+		static Utilities::HandleTable *AIHandleTable;
+		bool FindOptimalPath( const UINT32 &i_u32FromNodeID, const UINT32 &i_u32ToNodeID, std::vector<UINT32> &o_path );
+		void CompileWayPointGraph( void );
+		bool FindNode( const UINT32 &i_u32NodeID, UINT32 &o_u32Node );
+		inline bool IsBetterOpenNode( const UINT32 &i_u32NodeA, const UINT32 &i_u32NodeB );
+		void SiftUp( UINT32 i_u32HeapIndex );
+		void SiftDown( UINT32 i_u32HeapIndex );
+		void BeginSearch( const UINT32 &i_u32Node, const float &i_h );
+		UINT32 PopOpenNode( void );
+		void RelaxLink( const UINT32 &i_u32Node, const UINT32 &i_u32Parent, const float &i_g, const D3DXVECTOR3 *i_destination );
+		S_GOAL_FIELD *GetGoalField( const UINT32 &i_u32ToNodeID, const bool &i_bSearch );
+		void SearchFromGoal( const UINT32 &i_u32Goal, S_GOAL_FIELD &o_field );
+		bool GetPathToGoal( const S_GOAL_FIELD &i_field, const UINT32 &i_u32FromNodeID, std::vector<UINT32> &o_path );
 
 		std::map<UINT32, S_WAY_POINT> *wayPointList = NULL;
 		std::set<S_WAY_POINT_LINK, S_WAY_POINT_COMPARE> *wayPointLinkList = NULL;
+		// Rebuilt from the lists above by the first search after they change
+		static S_WAY_POINT_GRAPH *wayPointGraph = NULL;
+		static S_PATH_SEARCH *pathSearch = NULL;
+		static bool bWayPointGraphDirty = true;
+		// Least recently used field is searched again for a new goal
+		static std::vector<S_GOAL_FIELD> *goalFields = NULL;
+		static UINT32 u32GoalFieldClock = 0;
+
+		// Path requests are searched in the order they are made, within a time budget per frame
+		static std::deque<S_PATH_REQUEST> *pathRequestQueue = NULL;
+		static Utilities::HandleTable *pathRequestHandleTable = NULL;
+		static UINT32 u32PathBudgetLeft_us = 0;
+		// Kept between frames and sized to the graph, so searching a request allocates nothing
+		static std::vector<UINT32> *foundPath = NULL;
+		static std::vector<S_PATH_REQUEST> *sameRequests = NULL;
+		UINT32 QueuePathRequest( const UINT32 &i_u32FromNodeID, const UINT32 &i_u32ToNodeID, PathCallback i_callback,
+			void *i_data, const UINT32 &i_u32AIEntityHandle );
+		void ProcessPathRequests( void );
+		void CompletePathRequest( const S_PATH_REQUEST &i_request, const bool &i_bFound, const std::vector<UINT32> &i_path );
+
+#ifdef _DEBUG
+		typedef struct _s_path_test_result_
+		{
+			UINT32 u32Calls;
+			bool bFound;
+			std::vector<UINT32> path;
+		} S_PATH_TEST_RESULT;
+
+		void PathTestCallback( const UINT32 &i_u32Request, const bool &i_bFound, const std::vector<UINT32> &i_path, void *i_data );
+		float FindTestDistance( const UINT32 &i_u32FromNodeID, const UINT32 &i_u32ToNodeID );
+		float GetTestPathLength( const std::vector<UINT32> &i_path );
+#endif	// #ifdef _DEBUG
 	}
 }
 
@@ -130,6 +208,8 @@ bool GameEngine::AI::Initialize( void )
 
 	AIEntity::m_AIEntityPool = Utilities::MemoryPool::Create( sizeof(AIEntity), Utilities::DEFAULT_MEMORY_POOL_SIZE );
 	AIEntityDatabase = new std::vector< Utilities::Pointer::SmartPtr<AIEntity> >;
+	AIHandleTable = Utilities::HandleTable::Create( Utilities::DEFAULT_MEMORY_POOL_SIZE );
+	assert( AIHandleTable );
 
 	assert( wayPointList == NULL );
 	wayPointList = new std::map<UINT32, S_WAY_POINT>();
@@ -137,6 +217,22 @@ bool GameEngine::AI::Initialize( void )
 	assert( wayPointLinkList == NULL );
 	wayPointLinkList = new std::set<S_WAY_POINT_LINK, S_WAY_POINT_COMPARE>();
 
+	assert( wayPointGraph == NULL );
+	wayPointGraph = new S_WAY_POINT_GRAPH;
+	pathSearch = new S_PATH_SEARCH;
+	pathSearch->u32CurrentGeneration = 0;
+	goalFields = new std::vector<S_GOAL_FIELD>( DEFAULT_GOAL_FIELDS );
+	u32GoalFieldClock = 0;
+	bWayPointGraphDirty = true;
+
+	assert( pathRequestQueue == NULL );
+	pathRequestQueue = new std::deque<S_PATH_REQUEST>();
+	pathRequestHandleTable = Utilities::HandleTable::Create( Utilities::DEFAULT_MEMORY_POOL_SIZE );
+	assert( pathRequestHandleTable );
+	foundPath = new std::vector<UINT32>();
+	sameRequests = new std::vector<S_PATH_REQUEST>();
+	sameRequests->reserve( Utilities::DEFAULT_MEMORY_POOL_SIZE );
+
 #ifdef ENABLE_WAY_POINT_DISPLAY
 	g_debugMenu::Get().AddCheckBox( "Show AI way point node", bShowAIWayPoint );
 	g_debugMenu::Get().AddCheckBox( "Show optimal AI way point node", bShowOptimalAIWayPoint );
@@ -159,6 +255,8 @@ void GameEngine::AI::BeginUpdate( void )
 {
 	FUNCTION_START;
 
+	u32PathBudgetLeft_us = DEFAULT_PATH_BUDGET_US;
+
 	FUNCTION_FINISH;
 }
 
@@ -176,6 +274,8 @@ void GameEngine::AI::Update( void )
 
 	FUNCTION_START;
 
+	ProcessPathRequests();
+
 	if( bShowAIWayPoint )
 	{
 		std::map<UINT32, S_WAY_POINT>::const_iterator wayPointIter = wayPointList->begin();
@@ -197,7 +297,7 @@ void GameEngine::AI::Update( void )
 
 		if( bShowOptimalAIWayPoint )
 		{
-			std::deque<UINT32>::const_iterator optimalPathIter = (*iter)->m_optimalPath->begin();
+			std::vector<UINT32>::const_iterator optimalPathIter = (*iter)->m_optimalPath->begin();
 			for( ; optimalPathIter != (*iter)->m_optimalPath->end(); ++optimalPathIter )
 			{
 				D3DXVECTOR3 startPoint = wayPointList->find((*optimalPathIter))->second.centre;
@@ -217,6 +317,7 @@ void GameEngine::AI::Update( void )
 			break;
 
 		case E_AI_STATE_GO_TO_TARGET_NODE:
+		case E_AI_STATE_PATH_FINDING:
 			bMove = true;
 			break;
 
@@ -224,14 +325,14 @@ void GameEngine::AI::Update( void )
 			if( !(*iter)->m_optimalPath->empty() )
 			{
 				UINT32 u32OldTargetNodeID = (*iter)->m_u32TargetNodeID;
-				(*iter)->m_u32TargetNodeID = (*iter)->m_optimalPath->front();
-				(*iter)->m_optimalPath->pop_front();
+				(*iter)->m_u32TargetNodeID = (*iter)->m_optimalPath->back();
+				(*iter)->m_optimalPath->pop_back();
 
 				// If previous target is the same as current, get a new one
 				if( u32OldTargetNodeID == (*iter)->m_u32TargetNodeID && !(*iter)->m_optimalPath->empty() )
 				{
-					(*iter)->m_u32TargetNodeID = (*iter)->m_optimalPath->front();
-					(*iter)->m_optimalPath->pop_front();
+					(*iter)->m_u32TargetNodeID = (*iter)->m_optimalPath->back();
+					(*iter)->m_optimalPath->pop_back();
 				}
 				(*iter)->m_AIState = E_AI_STATE_GO_TO_TARGET_NODE;
 				bMove = true;
@@ -254,15 +355,17 @@ void GameEngine::AI::Update( void )
 					(*iter)->m_entity->m_v3Position.Y(), (*iter)->m_entity->m_v3Position.Z());
 
 				D3DXVECTOR3 direction = wayPoint->second.centre - entityPosition;
-				if( Utilities::Math::AreWithinRange(entityPosition, wayPoint->second.centre, Utilities::Time::GetTimeElapsedThisFrame_ms()) )
+				if( Utilities::Math::AreWithinRange(entityPosition, wayPoint->second.centre, Utilities::Time::GetFixedTimeStep_ms()) )
 				{
+					// Waits at the closest node until its path is found
 					direction = D3DXVECTOR3( 0.0f, 0.0f, 0.0f );
-					(*iter)->m_AIState = E_AI_STATE_ARRIVED_AT_TARGET_NODE;
+					if( (*iter)->m_AIState != E_AI_STATE_PATH_FINDING )
+						(*iter)->m_AIState = E_AI_STATE_ARRIVED_AT_TARGET_NODE;
 				}
 				else
 					D3DXVec3Normalize( &direction, &direction );
 
-				(*iter)->m_entity->m_v3Velocity = direction;
+				(*iter)->m_entity->SetVelocity( direction );
 			}
 		}
 	}
@@ -303,6 +406,12 @@ void GameEngine::AI::ShutDown( void )
 		AIEntityDatabase = NULL;
 	}
 
+	if( AIHandleTable )
+	{
+		delete AIHandleTable;
+		AIHandleTable = NULL;
+	}
+
 	if( AIEntity::m_AIEntityPool )
 	{
 		delete AIEntity::m_AIEntityPool;
@@ -321,6 +430,48 @@ void GameEngine::AI::ShutDown( void )
 		wayPointLinkList = NULL;
 	}
 
+	if( wayPointGraph )
+	{
+		delete wayPointGraph;
+		wayPointGraph = NULL;
+	}
+
+	if( pathSearch )
+	{
+		delete pathSearch;
+		pathSearch = NULL;
+	}
+
+	if( goalFields )
+	{
+		delete goalFields;
+		goalFields = NULL;
+	}
+
+	if( pathRequestQueue )
+	{
+		delete pathRequestQueue;
+		pathRequestQueue = NULL;
+	}
+
+	if( pathRequestHandleTable )
+	{
+		delete pathRequestHandleTable;
+		pathRequestHandleTable = NULL;
+	}
+
+	if( foundPath )
+	{
+		delete foundPath;
+		foundPath = NULL;
+	}
+
+	if( sameRequests )
+	{
+		delete sameRequests;
+		sameRequests = NULL;
+	}
+
 	FUNCTION_FINISH;
 }
 
@@ -339,6 +490,7 @@ void GameEngine::AI::AddWayPoint( const UINT32 &i_u32ID, const S_WAY_POINT &i_wa
 
 	std::pair<UINT32, S_WAY_POINT> insertingPair( i_u32ID, i_wayPoint );
 	wayPointList->insert( insertingPair );
+	bWayPointGraphDirty = true;
 
 	FUNCTION_FINISH;
 }
@@ -356,75 +508,167 @@ void GameEngine::AI::AddWayPointLink( const S_WAY_POINT_LINK &i_newWayPointLink
 	FUNCTION_START;
 
 	wayPointLinkList->insert( i_newWayPointLink );
+	bWayPointGraphDirty = true;
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void GetWayPoints( std::vector<UINT32> &o_IDs, std::vector<S_WAY_POINT> &o_wayPoints )
+	\brief		Get every way point ordered by ID
+	\param		o_IDs IDs of the way points
+	\param		o_wayPoints the way points
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::AI::GetWayPoints( std::vector<UINT32> &o_IDs, std::vector<S_WAY_POINT> &o_wayPoints )
+{
+	FUNCTION_START;
+
+	o_IDs.clear();
+	o_wayPoints.clear();
+	o_IDs.reserve( wayPointList->size() );
+	o_wayPoints.reserve( wayPointList->size() );
+
+	for( std::map<UINT32, S_WAY_POINT>::const_iterator iter = wayPointList->begin(); iter != wayPointList->end(); ++iter )
+	{
+		o_IDs.push_back( iter->first );
+		o_wayPoints.push_back( iter->second );
+	}
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void GetWayPointLinks( std::vector<S_WAY_POINT_LINK> &o_wayPointLinks )
+	\brief		Get every way point link
+	\param		o_wayPointLinks the way point links
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::AI::GetWayPointLinks( std::vector<S_WAY_POINT_LINK> &o_wayPointLinks )
+{
+	FUNCTION_START;
+
+	o_wayPointLinks.assign( wayPointLinkList->begin(), wayPointLinkList->end() );
 
 	FUNCTION_FINISH;
 }
 
 /**
  ****************************************************************************************************
-	\fn			UINT8 AddAIEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity )
-	\brief		Add trigger box entity to AIEntityDatabase
+	\fn			UINT32 AddAIEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity )
+	\brief		Add AI entity to AIEntityDatabase
 	\param		*i_entity entity to be added
-	\param		i_centre the center of the bounding box
-	\return		UINT8
-	\retval		index of the new added trigger box entity in database
+	\return		UINT32
+	\retval		handle of the new added AI entity
+	\retval		INVALID_HANDLE if the database is full
  ****************************************************************************************************
 */
-UINT8 GameEngine::AI::AddAIEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity )
+UINT32 GameEngine::AI::AddAIEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity )
 {
 	FUNCTION_START;
 
+	UINT32 u32Handle = AIHandleTable->Add( AIEntityDatabase->size() );
+	if( u32Handle == Utilities::INVALID_HANDLE )
+	{
+		DBG_MSG_LEVEL( D_ERR, "AI entity database is full\n" );
+		FUNCTION_FINISH;
+		return Utilities::INVALID_HANDLE;
+	}
+
 	AIEntityDatabase->push_back( new AIEntity(i_entity) );
 
 	FUNCTION_FINISH;
-	return AIEntityDatabase->size() - 1;
+	return u32Handle;
 }
 
-void GameEngine::AI::RemoveAIEntity( UINT8 &i_u8Index )
+/**
+ ****************************************************************************************************
+	\fn			void RemoveAIEntity( UINT32 &io_u32Handle )
+	\brief		Remove AI entity from AIEntityDatabase
+	\param		io_u32Handle handle of the AI entity, set to INVALID_HANDLE once removed
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::AI::RemoveAIEntity( UINT32 &io_u32Handle )
 {
-	if( i_u8Index < AIEntityDatabase->size() )
+	FUNCTION_START;
+
+	if( AIHandleTable->IsValid(io_u32Handle) )
 	{
-		std::vector< Utilities::Pointer::SmartPtr<AIEntity> >::iterator AIEntityDatabaseIter;
-		AIEntityDatabaseIter = AIEntityDatabase->begin();
-		UINT8 i = 0;
-		while( i < i_u8Index )
+		UINT32 u32Index = AIHandleTable->GetIndex( io_u32Handle );
+
+		CancelPathRequest( AIEntityDatabase->at(u32Index)->m_u32PathRequest );
+		if( IsDeterministic() )
 		{
-			++i;
-			++AIEntityDatabaseIter;
+			// Keep the order the entities were added in, it decides the order the controllers are updated in
+			for( UINT32 i = u32Index + 1; i < AIEntityDatabase->size(); ++i )
+				AIHandleTable->SetIndex( AIEntityDatabase->at(i)->m_entity->m_u32AIEntityHandle, i - 1 );
+			AIHandleTable->Remove( io_u32Handle );
+			AIEntityDatabase->erase( AIEntityDatabase->begin() + u32Index );
+		}
+		else
+		{
+			AIHandleTable->SetIndex( AIEntityDatabase->back()->m_entity->m_u32AIEntityHandle, u32Index );
+			AIHandleTable->Remove( io_u32Handle );
+			AIEntityDatabase->at(u32Index) = AIEntityDatabase->back();
+			AIEntityDatabase->pop_back();
 		}
-		AIEntityDatabase->erase( AIEntityDatabaseIter );
 	}
+
+	io_u32Handle = Utilities::INVALID_HANDLE;
+
+	FUNCTION_FINISH;
 }
 
 /**
  ****************************************************************************************************
-	\fn			void UpdateAIDestinationTo( UINT8 &i_u8Index, const UINT8 &i_u8NodeID )
-	\brief		Update destination for this AI
-	\param		i_u8Index index of entity in AI entity
+	\fn			void UpdateAIDestinationTo( const UINT32 &i_u32Handle, const UINT8 &i_u8NodeID )
+	\brief		Update destination for this AI. The entity heads for the closest node while its path is
+				searched by a later AI update, asking again for the same destination keeps that search
+	\param		i_u32Handle handle of the AI entity
 	\param		i_u8NodeID destination node ID
 	\return		NONE
  ****************************************************************************************************
 */
-void GameEngine::AI::UpdateAIDestinationTo( const UINT8 &i_u8Index, const UINT8 &i_u8NodeID )
+void GameEngine::AI::UpdateAIDestinationTo( const UINT32 &i_u32Handle, const UINT8 &i_u8NodeID )
 {
 	FUNCTION_START;
 
-	if( AIEntityDatabase->at(i_u8Index)->m_AIState != E_AI_STATE_DEACTIVATE )
-		AbortAI( i_u8Index );
-
-	if( i_u8Index < AIEntityDatabase->size() )
+	if( AIHandleTable->IsValid(i_u32Handle) )
 	{
+		AIEntity &currAIEntity = *AIEntityDatabase->at( AIHandleTable->GetIndex(i_u32Handle) );
+
+		if( (currAIEntity.m_AIState == E_AI_STATE_PATH_FINDING) && (currAIEntity.m_u32DestinationNodeID == i_u8NodeID) )
+		{
+			FUNCTION_FINISH;
+			return;
+		}
+
+		if( currAIEntity.m_AIState != E_AI_STATE_DEACTIVATE )
+			AbortAI( i_u32Handle );
+
 		UINT32 u32ClosestNodeID = Utilities::MAX_UINT32;
-		D3DXVECTOR3 entityPosition( AIEntityDatabase->at(i_u8Index)->m_entity->m_v3Position.X(),
-			AIEntityDatabase->at(i_u8Index)->m_entity->m_v3Position.Y(),
-			AIEntityDatabase->at(i_u8Index)->m_entity->m_v3Position.Z() );
+		D3DXVECTOR3 entityPosition( currAIEntity.m_entity->m_v3Position.X(),
+			currAIEntity.m_entity->m_v3Position.Y(),
+			currAIEntity.m_entity->m_v3Position.Z() );
 
 		FindClosestNodeIDFromPosition( entityPosition, u32ClosestNodeID );
 		if( u32ClosestNodeID < wayPointList->size() )
 		{
-			AIEntityDatabase->at(i_u8Index)->m_u32TargetNodeID = u32ClosestNodeID;
-			AIEntityDatabase->at(i_u8Index)->m_AIState = E_AI_STATE_GO_TO_TARGET_NODE;
-			FindOptimalPath( u32ClosestNodeID, i_u8NodeID, *(AIEntityDatabase->at(i_u8Index)->m_optimalPath) );
+			currAIEntity.m_u32TargetNodeID = u32ClosestNodeID;
+			currAIEntity.m_u32DestinationNodeID = i_u8NodeID;
+			currAIEntity.m_optimalPath->clear();
+			currAIEntity.m_u32PathRequest = QueuePathRequest( u32ClosestNodeID, i_u8NodeID, NULL, NULL, i_u32Handle );
+
+			// Without a request it only goes to the closest node, same as a path not found
+			if( currAIEntity.m_u32PathRequest != Utilities::INVALID_HANDLE )
+				currAIEntity.m_AIState = E_AI_STATE_PATH_FINDING;
+			else
+				currAIEntity.m_AIState = E_AI_STATE_GO_TO_TARGET_NODE;
 		}
 	}
 
@@ -433,19 +677,22 @@ void GameEngine::AI::UpdateAIDestinationTo( const UINT8 &i_u8Index, const UINT8
 
 /**
  ****************************************************************************************************
-	\fn			void AbortAI( const UINT8 &i_u8Index )
+	\fn			void AbortAI( const UINT32 &i_u32Handle )
 	\brief		Abort AI
-	\param		i_u8Index index of entity in AI entity
+	\param		i_u32Handle handle of the AI entity
 	\return		NONE
  ****************************************************************************************************
 */
-void GameEngine::AI::AbortAI( const UINT8 &i_u8Index )
+void GameEngine::AI::AbortAI( const UINT32 &i_u32Handle )
 {
 	FUNCTION_START;
 
-	if( i_u8Index < AIEntityDatabase->size() )
+	if( AIHandleTable->IsValid(i_u32Handle) )
 	{
-		AIEntityDatabase->at(i_u8Index)->m_AIState = E_AI_STATE_DEACTIVATE;
+		AIEntity &currAIEntity = *AIEntityDatabase->at( AIHandleTable->GetIndex(i_u32Handle) );
+
+		currAIEntity.m_AIState = E_AI_STATE_DEACTIVATE;
+		CancelPathRequest( currAIEntity.m_u32PathRequest );
 	}
 
 	FUNCTION_FINISH;
@@ -453,21 +700,21 @@ void GameEngine::AI::AbortAI( const UINT8 &i_u8Index )
 
 /**
  ****************************************************************************************************
-	\fn			bool GetAIState( const UINT8 &i_u8Index )
+	\fn			bool GetAIState( const UINT32 &i_u32Handle )
 	\brief		Get current AI state
-	\param		i_u8Index index of entity in AI entity
+	\param		i_u32Handle handle of the AI entity
 	\return		BOOLEAN
 	\retval		TRUE if activated
 	\retval		FALSE otherwise
  ****************************************************************************************************
 */
-bool GameEngine::AI::GetAIState( const UINT8 &i_u8Index )
+bool GameEngine::AI::GetAIState( const UINT32 &i_u32Handle )
 {
 	FUNCTION_START;
 
-	if( i_u8Index < AIEntityDatabase->size() )
+	if( AIHandleTable->IsValid(i_u32Handle) )
 	{
-		if( AIEntityDatabase->at(i_u8Index)->m_AIState == E_AI_STATE_DEACTIVATE )
+		if( AIEntityDatabase->at(AIHandleTable->GetIndex(i_u32Handle))->m_AIState == E_AI_STATE_DEACTIVATE )
 			return FALSE;
 		return TRUE;
 	}
@@ -510,17 +757,18 @@ void GameEngine::AI::FindClosestNodeIDFromPosition( const D3DXVECTOR3 &i_vCurrPo
 
 /**
  ****************************************************************************************************
-	\fn			float FindSquaredDistanceToNodeID( const D3DXVECTOR3 &i_vCurrPosition, const UINT32 &i_u32NodeID )
-	\brief		Find squared distance from position to node ID
+	\fn			float FindDistanceToNodeID( const D3DXVECTOR3 &i_vCurrPosition, const UINT32 &i_u32NodeID )
+	\brief		Find the distance from position to node ID along the way points. The distance of every
+				way point to the node is searched once and kept, so asking every frame costs no search
 	\param		*i_vCurrPosition current entity position
 	\param		i_u32NodeID the node ID
 	\return		float
-	\retval		Squared distance to the given node
+	\retval		Distance to the closest node and from there along the shortest path to the given node
  ****************************************************************************************************
 */
 float GameEngine::AI::FindDistanceToNodeID( const D3DXVECTOR3 &i_vCurrPosition, const UINT32 &i_u32NodeID )
 {
-	UINT32 u32ClosestNodeID;
+	UINT32 u32ClosestNodeID = Utilities::MAX_UINT32;
 	float returnDistance = 0.0f;
 
 	FUNCTION_START;
@@ -532,62 +780,412 @@ float GameEngine::AI::FindDistanceToNodeID( const D3DXVECTOR3 &i_vCurrPosition,
 		distance = wayPointList->at(u32ClosestNodeID).centre - i_vCurrPosition;
 		returnDistance = D3DXVec3Length( &distance );
 
-		std::deque<UINT32> path;
-		bool bResult = FindOptimalPath( u32ClosestNodeID, i_u32NodeID, path );
+		S_GOAL_FIELD *field = GetGoalField( i_u32NodeID, TRUE );
+		UINT32 u32From;
+
+		if( field && FindNode(u32ClosestNodeID, u32From) && (field->distance[u32From] != FLT_MAX) )
+			returnDistance += field->distance[u32From];
+	}
+
+	FUNCTION_FINISH;
+	return returnDistance;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			UINT32 RequestPath( const UINT32 &i_u32FromNodeID, const UINT32 &i_u32ToNodeID,
+					PathCallback i_callback, void *i_data )
+	\brief		Queue a path search, it is done by a later AI update which then calls the callback
+	\param		i_u32FromNodeID start node ID
+	\param		i_u32ToNodeID destination node ID
+	\param		i_callback called with the result, may be NULL if the request is only polled
+	\param		i_data passed to the callback
+	\return		UINT32
+	\retval		handle of the request
+	\retval		INVALID_HANDLE if the queue is full
+ ****************************************************************************************************
+*/
+UINT32 GameEngine::AI::RequestPath( const UINT32 &i_u32FromNodeID, const UINT32 &i_u32ToNodeID, PathCallback i_callback,
+	void *i_data )
+{
+	FUNCTION_START;
+
+	UINT32 u32Request = QueuePathRequest( i_u32FromNodeID, i_u32ToNodeID, i_callback, i_data, Utilities::INVALID_HANDLE );
+
+	FUNCTION_FINISH;
+	return u32Request;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void CancelPathRequest( UINT32 &io_u32Request )
+	\brief		Cancel a pending path request, its callback is not called
+	\param		io_u32Request handle of the request, set to INVALID_HANDLE once cancelled
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::AI::CancelPathRequest( UINT32 &io_u32Request )
+{
+	FUNCTION_START;
+
+	// The queue entry is dropped once it comes up
+	if( pathRequestHandleTable->IsValid(io_u32Request) )
+		pathRequestHandleTable->Remove( io_u32Request );
+
+	io_u32Request = Utilities::INVALID_HANDLE;
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool IsPathRequestPending( const UINT32 &i_u32Request )
+	\brief		Check whether a path request has not been searched yet
+	\param		i_u32Request handle of the request
+	\return		BOOLEAN
+	\retval		TRUE if the request is still queued
+	\retval		FALSE if it is done or cancelled
+ ****************************************************************************************************
+*/
+bool GameEngine::AI::IsPathRequestPending( const UINT32 &i_u32Request )
+{
+	return pathRequestHandleTable->IsValid( i_u32Request );
+}
+
+#ifdef _DEBUG
+/**
+ ****************************************************************************************************
+	\fn			void UnitTest( void )
+	\brief		Unit test for the path requests, searched on a line of way points of its own, and of
+				the path searches against a plain Dijkstra on random graphs
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::AI::UnitTest( void )
+{
+	std::map<UINT32, S_WAY_POINT> *savedWayPointList = wayPointList;
+	std::set<S_WAY_POINT_LINK, S_WAY_POINT_COMPARE> *savedWayPointLinkList = wayPointLinkList;
+	S_PATH_TEST_RESULT results[4];
+	UINT32 u32Requests[4];
+	std::vector<UINT32> path;
+	UINT32 u32Seed = 1;
+	float distance;
+
+	FUNCTION_START;
+
+	assert( pathRequestQueue->empty() );
+
+	// Nodes 0 to 3 one apart and linked both ways, node 4 is not linked
+	wayPointList = new std::map<UINT32, S_WAY_POINT>();
+	wayPointLinkList = new std::set<S_WAY_POINT_LINK, S_WAY_POINT_COMPARE>();
+	for( UINT32 i = 0; i < 5; ++i )
+	{
+		S_WAY_POINT wayPoint;
+
+		wayPoint.centre = D3DXVECTOR3( i < 4 ? static_cast<float>(i) : 10.0f, 0.0f, 0.0f );
+		wayPoint.radius = 0.5f;
+		AddWayPoint( i, wayPoint );
+	}
+	for( UINT32 i = 0; i < 3; ++i )
+	{
+		S_WAY_POINT_LINK link;
+
+		link.u32From = i;
+		link.u32To = i + 1;
+		AddWayPointLink( link );
+		link.u32From = i + 1;
+		link.u32To = i;
+		AddWayPointLink( link );
+	}
+
+	for( UINT32 i = 0; i < 4; ++i )
+	{
+		results[i].u32Calls = 0;
+		results[i].bFound = FALSE;
+	}
+	u32Requests[0] = RequestPath( 0, 3, PathTestCallback, &results[0] );
+	u32Requests[1] = RequestPath( 1, 3, PathTestCallback, &results[1] );
+	u32Requests[2] = RequestPath( 2, 3, PathTestCallback, &results[2] );
+	u32Requests[3] = RequestPath( 0, 4, PathTestCallback, &results[3] );
+	for( UINT32 i = 0; i < 4; ++i )
+		assert( IsPathRequestPending(u32Requests[i]) );
+
+	CancelPathRequest( u32Requests[2] );
+	assert( u32Requests[2] == Utilities::INVALID_HANDLE );
+
+	// Nothing is searched until the AI update
+	assert( results[0].u32Calls == 0 );
+	while( !pathRequestQueue->empty() )
+	{
+		u32PathBudgetLeft_us = DEFAULT_PATH_BUDGET_US;
+		ProcessPathRequests();
+	}
+
+	assert( (results[0].u32Calls == 1) && results[0].bFound && (results[0].path.size() == 4) );
+	assert( (results[0].path.front() == 0) && (results[0].path.back() == 3) );
+	assert( (results[1].u32Calls == 1) && results[1].bFound && (results[1].path.size() == 3) );
+	assert( (results[1].path.front() == 1) && (results[1].path.back() == 3) );
+	assert( results[2].u32Calls == 0 );
+	assert( (results[3].u32Calls == 1) && !results[3].bFound && results[3].path.empty() );
+	for( UINT32 i = 0; i < 4; ++i )
+		assert( !IsPathRequestPending(u32Requests[i]) );
+
+	// Both requests for node 3 were answered by one search from node 3, the single one for node 4 by A*
+	assert( GetGoalField(3, FALSE) != NULL );
+	assert( GetGoalField(4, FALSE) == NULL );
+
+	// To the closest node and along the links from there, only to the closest node if it cannot reach
+	distance = FindDistanceToNodeID( D3DXVECTOR3(0.0f, 0.5f, 0.0f), 3 );
+	assert( (distance > 3.499f) && (distance < 3.501f) );
+	distance = FindDistanceToNodeID( D3DXVECTOR3(10.0f, 0.0f, 0.0f), 3 );
+	assert( distance == 0.0f );
+
+	// A* and the searches from the goal give the length of a plain Dijkstra over the lists, on random graphs
+	for( UINT32 u32Graph = 0; u32Graph < 50; ++u32Graph )
+	{
+		u32Seed = u32Seed * 1664525 + 1013904223;
+		const UINT32 u32TotalNodes = 2 + ( u32Seed >> 16 ) % 30;
+
+		wayPointList->clear();
+		wayPointLinkList->clear();
+		for( UINT32 i = 0; i < u32TotalNodes; ++i )
+		{
+			S_WAY_POINT wayPoint;
 
-		if( bResult )
+			u32Seed = u32Seed * 1664525 + 1013904223;
+			wayPoint.centre = D3DXVECTOR3( static_cast<float>((u32Seed >> 16) % 100), static_cast<float>((u32Seed >> 8) % 100), 0.0f );
+			wayPoint.radius = 0.5f;
+			AddWayPoint( i, wayPoint );
+		}
+		for( UINT32 i = 0; i < 3 * u32TotalNodes; ++i )
 		{
-			std::deque<UINT32>::const_iterator pathIter = path.begin();
-			for( ; pathIter != path.end(); ++pathIter )
+			S_WAY_POINT_LINK link;
+
+			u32Seed = u32Seed * 1664525 + 1013904223;
+			link.u32From = ( u32Seed >> 16 ) % u32TotalNodes;
+			link.u32To = ( u32Seed >> 8 ) % u32TotalNodes;
+			if( link.u32From != link.u32To )
+				AddWayPointLink( link );
+		}
+
+		for( UINT32 i = 0; i < 20; ++i )
+		{
+			u32Seed = u32Seed * 1664525 + 1013904223;
+			const UINT32 u32From = ( u32Seed >> 16 ) % u32TotalNodes;
+			const UINT32 u32To = ( u32Seed >> 8 ) % u32TotalNodes;
+			const float shortest = FindTestDistance( u32From, u32To );
+			const float tolerance = 0.001f * ( 1.0f + shortest );
+			S_GOAL_FIELD *field;
+
+			bool bFound = FindOptimalPath( u32From, u32To, path );
+			assert( bFound == (shortest != FLT_MAX) );
+			if( bFound )
 			{
-				D3DXVECTOR3 startPoint = wayPointList->find((*pathIter))->second.centre;
-				D3DXVECTOR3 endPoint = startPoint;
-				++pathIter;
-				if( pathIter != path.end() )
-					endPoint = wayPointList->find((*pathIter))->second.centre;
-				--pathIter;
-				distance = endPoint - startPoint;
-				returnDistance += D3DXVec3Length( &distance );
+				assert( (path.front() == u32From) && (path.back() == u32To) );
+				distance = GetTestPathLength( path );
+				assert( (distance > shortest - tolerance) && (distance < shortest + tolerance) );
+			}
+
+			field = GetGoalField( u32To, TRUE );
+			bFound = field && GetPathToGoal( *field, u32From, path );
+			assert( bFound == (shortest != FLT_MAX) );
+			if( bFound )
+			{
+				assert( (path.front() == u32From) && (path.back() == u32To) );
+				distance = GetTestPathLength( path );
+				assert( (distance > shortest - tolerance) && (distance < shortest + tolerance) );
 			}
 		}
 	}
 
+	delete wayPointList;
+	delete wayPointLinkList;
+	wayPointList = savedWayPointList;
+	wayPointLinkList = savedWayPointLinkList;
+	bWayPointGraphDirty = true;
+
 	FUNCTION_FINISH;
-	return returnDistance;
 }
+#endif	// #ifdef _DEBUG
 
 /****************************************************************************************************
 			Private function implementation
 ****************************************************************************************************/
 /**
  ****************************************************************************************************
-	\fn			void RemoveDeadEntities( void )
-	\brief		Remove dead entities
+	\fn			UINT32 QueuePathRequest( const UINT32 &i_u32FromNodeID, const UINT32 &i_u32ToNodeID,
+					PathCallback i_callback, void *i_data, const UINT32 &i_u32AIEntityHandle )
+	\brief		Add a path request at the end of the queue
+	\param		i_u32FromNodeID start node ID
+	\param		i_u32ToNodeID destination node ID
+	\param		i_callback called with the result, may be NULL
+	\param		i_data passed to the callback
+	\param		i_u32AIEntityHandle AI entity given the path, INVALID_HANDLE for none
+	\return		UINT32
+	\retval		handle of the request
+	\retval		INVALID_HANDLE if the queue is full
+ ****************************************************************************************************
+*/
+UINT32 GameEngine::AI::QueuePathRequest( const UINT32 &i_u32FromNodeID, const UINT32 &i_u32ToNodeID, PathCallback i_callback,
+	void *i_data, const UINT32 &i_u32AIEntityHandle )
+{
+	S_PATH_REQUEST request;
+
+	FUNCTION_START;
+
+	// Only the validity of the handle is used, the queue is searched in order
+	request.u32Handle = pathRequestHandleTable->Add( 0 );
+	if( request.u32Handle == Utilities::INVALID_HANDLE )
+	{
+		DBG_MSG_LEVEL( D_ERR, "Path request queue is full\n" );
+		FUNCTION_FINISH;
+		return Utilities::INVALID_HANDLE;
+	}
+
+	request.u32FromNodeID = i_u32FromNodeID;
+	request.u32ToNodeID = i_u32ToNodeID;
+	request.callback = i_callback;
+	request.data = i_data;
+	request.u32AIEntityHandle = i_u32AIEntityHandle;
+	pathRequestQueue->push_back( request );
+
+	FUNCTION_FINISH;
+	return request.u32Handle;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void ProcessPathRequests( void )
+	\brief		Search the queued paths until the budget of this frame is spent, at least one request
+				is searched per frame. Requests further in the queue for the same destination are taken
+				along: a destination asked for more than once, or already kept, is searched once from
+				the destination and every start reads its path from that search, a single request is
+				searched with A*. In deterministic mode a fixed number of searches is done per step
+				instead, so the result does not depend on the machine
 	\param		NONE
 	\return		NONE
  ****************************************************************************************************
 */
-void GameEngine::AI::RemoveDeadEntities( void )
+void GameEngine::AI::ProcessPathRequests( void )
 {
+	std::vector<UINT32> &path = *foundPath;
+	const TICK startTick = Utilities::Time::GetCurrentTick();
+	UINT32 u32TotalSearched = 0;
+
 	FUNCTION_START;
 
-	for( UINT8 i = 0; i < AIEntityDatabase->size(); ++i )
+	while( !pathRequestQueue->empty() )
 	{
-		if( AIEntityDatabase->at(i)->m_entity->m_isDestroyed )
+		if( IsDeterministic() ? (u32TotalSearched >= DEFAULT_PATH_REQUESTS_PER_STEP) : (u32PathBudgetLeft_us == 0) )
+			break;
+
+		const S_PATH_REQUEST request = pathRequestQueue->front();
+		pathRequestQueue->pop_front();
+
+		// Cancelled
+		if( !pathRequestHandleTable->IsValid(request.u32Handle) )
+			continue;
+
+		// Taken out before any callback, which may queue new requests
+		sameRequests->clear();
+		sameRequests->push_back( request );
+		for( std::deque<S_PATH_REQUEST>::iterator iter = pathRequestQueue->begin(); iter != pathRequestQueue->end(); )
 		{
-			AIEntityDatabase->back()->m_entity->m_u8AIEntityIndex = AIEntityDatabase->at(i)->m_entity->m_u8AIEntityIndex;
-			AIEntityDatabase->at(i) = AIEntityDatabase->back();
-			AIEntityDatabase->pop_back();
+			if( iter->u32ToNodeID == request.u32ToNodeID )
+			{
+				if( pathRequestHandleTable->IsValid(iter->u32Handle) )
+					sameRequests->push_back( *iter );
+				iter = pathRequestQueue->erase( iter );
+			}
+			else
+			{
+				++iter;
+			}
+		}
+		++u32TotalSearched;
+
+		if( (sameRequests->size() == 1) && !GetGoalField(request.u32ToNodeID, FALSE) )
+		{
+			bool bFound = FindOptimalPath( request.u32FromNodeID, request.u32ToNodeID, path );
+			if( !bFound )
+				path.clear();
+			CompletePathRequest( request, bFound, path );
+		}
+		else
+		{
+			for( UINT32 i = 0; i < sameRequests->size(); ++i )
+			{
+				const S_PATH_REQUEST &sameRequest = sameRequests->at( i );
+				// Looked up again for every request, a callback may have used the field for another destination
+				S_GOAL_FIELD *field = GetGoalField( sameRequest.u32ToNodeID, TRUE );
+				bool bFound = field && GetPathToGoal( *field, sameRequest.u32FromNodeID, path );
+				if( !bFound )
+					path.clear();
+				CompletePathRequest( sameRequest, bFound, path );
+			}
+		}
+
+		if( !IsDeterministic() )
+		{
+			UINT32 u32Spent_us = Utilities::Time::GetDifferenceTick_us( startTick, Utilities::Time::GetCurrentTick() );
+			if( u32Spent_us >= u32PathBudgetLeft_us )
+				u32PathBudgetLeft_us = 0;
+		}
+	}
+
+	if( !IsDeterministic() && (u32PathBudgetLeft_us > 0) )
+	{
+		UINT32 u32Spent_us = Utilities::Time::GetDifferenceTick_us( startTick, Utilities::Time::GetCurrentTick() );
+		u32PathBudgetLeft_us = u32Spent_us < u32PathBudgetLeft_us ? u32PathBudgetLeft_us - u32Spent_us : 0;
+	}
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void CompletePathRequest( const S_PATH_REQUEST &i_request, const bool &i_bFound,
+					const std::vector<UINT32> &i_path )
+	\brief		Hand the result to the AI entity and the callback of the request
+	\param		i_request the searched request
+	\param		i_bFound whether a path was found
+	\param		i_path the path found, empty otherwise
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::AI::CompletePathRequest( const S_PATH_REQUEST &i_request, const bool &i_bFound, const std::vector<UINT32> &i_path )
+{
+	FUNCTION_START;
+
+	pathRequestHandleTable->Remove( i_request.u32Handle );
+
+	if( AIHandleTable->IsValid(i_request.u32AIEntityHandle) )
+	{
+		AIEntity &currAIEntity = *AIEntityDatabase->at( AIHandleTable->GetIndex(i_request.u32AIEntityHandle) );
+
+		// A path not found leaves it going to the closest node only
+		if( currAIEntity.m_u32PathRequest == i_request.u32Handle )
+		{
+			// Reversed so the entity takes its next node from the back
+			currAIEntity.m_optimalPath->assign( i_path.rbegin(), i_path.rend() );
+			currAIEntity.m_u32PathRequest = Utilities::INVALID_HANDLE;
+			currAIEntity.m_AIState = E_AI_STATE_GO_TO_TARGET_NODE;
 		}
 	}
 
+	if( i_request.callback )
+		i_request.callback( i_request.u32Handle, i_bFound, i_path, i_request.data );
+
 	FUNCTION_FINISH;
 }
 
 /**
  ****************************************************************************************************
-	\fn			bool FindOptimalPath( const UINT32 &i_u32FromNodeID, const UINT32 &i_u32ToNodeID, std::deque<UINT32> &o_path )
-	\brief		Find optimal path from one node ID to another node ID
+	\fn			bool FindOptimalPath( const UINT32 &i_u32FromNodeID, const UINT32 &i_u32ToNodeID, std::vector<UINT32> &o_path )
+	\brief		Find optimal path from one node ID to another node ID. A* over the way point graph, the
+				straight distance to the destination never overestimates the length of the links left
+				so the first time the destination is taken from the open heap its path is the shortest
 	\param		i_u32FromNodeID start node ID
 	\param		i_u32ToNodeID destination node ID
 	\param		o_path returned path
@@ -596,116 +1194,583 @@ void GameEngine::AI::RemoveDeadEntities( void )
 	\retval		FALSE otherwise
  ****************************************************************************************************
 */
-bool GameEngine::AI::FindOptimalPath( const UINT32 &i_u32FromNodeID, const UINT32 &i_u32ToNodeID, std::deque<UINT32> &o_path )
+bool GameEngine::AI::FindOptimalPath( const UINT32 &i_u32FromNodeID, const UINT32 &i_u32ToNodeID, std::vector<UINT32> &o_path )
 {
-	std::map<UINT32, UINT32> closedList;
-	std::pair<UINT32, UINT32> closedListInsertingPair;
-	std::map<UINT32, UINT32>::const_iterator closedListIter;
+	S_PATH_SEARCH &search = *pathSearch;
+	UINT32 u32From;
+	UINT32 u32To;
 
-	std::set<S_WAY_POINT_OPEN_LIST_NODE, S_WAY_POINT_OPEN_LIST_NODE_BY_F_LESS> openListByF;
-	std::set<S_WAY_POINT_OPEN_LIST_NODE, S_WAY_POINT_OPEN_LIST_NODE_BY_F_LESS>::iterator openListByFIter;
+	FUNCTION_START;
 
-	std::set<S_WAY_POINT_OPEN_LIST_NODE, S_WAY_POINT_OPEN_LIST_NODE_BY_NUMBER_LESS> openListByNumber;
-	std::set<S_WAY_POINT_OPEN_LIST_NODE, S_WAY_POINT_OPEN_LIST_NODE_BY_NUMBER_LESS>::iterator openListByNumberIter;
+	if( bWayPointGraphDirty )
+		CompileWayPointGraph();
 
-	std::map<UINT32, S_WAY_POINT>::const_iterator wayPointIter = wayPointList->find( i_u32FromNodeID );
+	if( !FindNode(i_u32FromNodeID, u32From) || !FindNode(i_u32ToNodeID, u32To) )
+	{
+		FUNCTION_FINISH;
+		return FALSE;
+	}
 
-	FUNCTION_START;
+	const D3DXVECTOR3 &destination = wayPointGraph->centre[u32To];
+	D3DXVECTOR3 distance = destination - wayPointGraph->centre[u32From];
 
-	if( wayPointIter == wayPointList->end() )
+	BeginSearch( u32From, D3DXVec3Length(&distance) );
+	while( !search.u32OpenHeap.empty() )
+	{
+		if( search.u32OpenHeap.front() == u32To )
+			break;
+
+		const UINT32 u32Current = PopOpenNode();
+		for( UINT32 i = wayPointGraph->u32FirstLink[u32Current]; i < wayPointGraph->u32FirstLink[u32Current + 1]; ++i )
+			RelaxLink( wayPointGraph->u32LinkTo[i], u32Current, search.g[u32Current] + wayPointGraph->linkLength[i], &destination );
+	}
+
+	if( search.u32OpenHeap.empty() )
 	{
 		FUNCTION_FINISH;
 		return FALSE;
 	}
 
-	S_WAY_POINT_OPEN_LIST_NODE currentNode;
-	S_WAY_POINT_OPEN_LIST_NODE insertingNode;
-	insertingNode.h = 0.0f;
-	currentNode.g = 0.0f;
-	currentNode.h = 0.0f;
-	currentNode.u32ID = i_u32FromNodeID;
-	currentNode.u32ParentID = Utilities::MAX_UINT32;
-	openListByF.insert( currentNode );
-	openListByNumber.insert( currentNode );
-	std::set<S_WAY_POINT_LINK, S_WAY_POINT_COMPARE>::const_iterator wayPointLinkIter;
-	S_WAY_POINT_LINK link;
-	//std::map<UINT32, UINT32>::iterator locationInHeapIter;
+	// Parents lead back from the destination, reversed in place once the start is reached
+	o_path.clear();
+	for( UINT32 u32Node = u32To; u32Node != Utilities::MAX_UINT32; u32Node = search.u32Parent[u32Node] )
+		o_path.push_back( wayPointGraph->u32NodeID[u32Node] );
+	std::reverse( o_path.begin(), o_path.end() );
+
+	FUNCTION_FINISH;
+	return TRUE;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void CompileWayPointGraph( void )
+	\brief		Compile the way point and link lists into the graph searched by FindOptimalPath and
+				size the search state to it. Links to unknown way points are dropped
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::AI::CompileWayPointGraph( void )
+{
+	std::map<UINT32, S_WAY_POINT>::const_iterator wayPointIter;
+	std::set<S_WAY_POINT_LINK, S_WAY_POINT_COMPARE>::const_iterator linkIter;
+	const UINT32 u32TotalNodes = wayPointList->size();
+	UINT32 u32Node = 0;
+
+	FUNCTION_START;
+
+	wayPointGraph->u32NodeID.clear();
+	wayPointGraph->centre.clear();
+	wayPointGraph->u32FirstLink.clear();
+	wayPointGraph->u32LinkTo.clear();
+	wayPointGraph->linkLength.clear();
+	wayPointGraph->u32NodeID.reserve( u32TotalNodes );
+	wayPointGraph->centre.reserve( u32TotalNodes );
+	wayPointGraph->u32FirstLink.reserve( u32TotalNodes + 1 );
 
-	while( !openListByF.empty() )
+	for( wayPointIter = wayPointList->begin(); wayPointIter != wayPointList->end(); ++wayPointIter )
 	{
-		currentNode = *openListByF.begin();
-		if( currentNode.u32ID == i_u32ToNodeID )
-			break;
-		openListByF.erase( openListByF.begin() );
-		openListByNumber.erase( currentNode );
-		closedListInsertingPair.first = currentNode.u32ID;
-		closedListInsertingPair.second = currentNode.u32ParentID;
-		closedList.insert( closedListInsertingPair );
-		link.u32From = currentNode.u32ID;
-		link.u32To = 0;
+		wayPointGraph->u32NodeID.push_back( wayPointIter->first );
+		wayPointGraph->centre.push_back( wayPointIter->second.centre );
+	}
 
-		wayPointLinkIter = wayPointLinkList->lower_bound( link );
+	// Links are ordered by the node they start from, so the rows are filled one after another
+	for( linkIter = wayPointLinkList->begin(); linkIter != wayPointLinkList->end(); ++linkIter )
+	{
+		UINT32 u32From;
+		UINT32 u32To;
 
-		if( wayPointLinkIter == wayPointLinkList->end() )
+		if( !FindNode(linkIter->u32From, u32From) || !FindNode(linkIter->u32To, u32To) )
 			continue;
 
-		while( wayPointLinkIter->u32From == currentNode.u32ID )
+		while( u32Node <= u32From )
 		{
-			// Is it on the closed list?
-			if( closedList.find(wayPointLinkIter->u32To) != closedList.end() )
-			{
-				++wayPointLinkIter;
-				continue;
-			}
+			wayPointGraph->u32FirstLink.push_back( wayPointGraph->u32LinkTo.size() );
+			++u32Node;
+		}
 
-			insertingNode.u32ID = wayPointLinkIter->u32To;
-			openListByNumberIter = openListByNumber.find( insertingNode );
-			// Not in the open list yet
-			if( openListByNumberIter == openListByNumber.end() )
-			{
-				insertingNode.g = currentNode.g + 0.0f;
-				insertingNode.u32ID = wayPointLinkIter->u32To;
-				insertingNode.u32ParentID = currentNode.u32ID;
-				openListByNumber.insert( insertingNode );
-				openListByF.insert( insertingNode );
-			}
-			// Already in the open list
-			else
-			{
-				if( (currentNode.g + 0.0f + currentNode.h) < (openListByNumberIter->g + openListByNumberIter->h) )
-				{
-					insertingNode = *openListByNumberIter;
-					openListByF.erase( insertingNode );
-					openListByNumber.erase( openListByNumberIter );
-					insertingNode.g = currentNode.g + 0.0f;
-					openListByNumber.insert( insertingNode );
-					openListByF.insert( insertingNode );
-				}
-			}
-			++wayPointLinkIter;
+		D3DXVECTOR3 link = wayPointGraph->centre[u32To] - wayPointGraph->centre[u32From];
+		wayPointGraph->u32LinkTo.push_back( u32To );
+		wayPointGraph->linkLength.push_back( D3DXVec3Length(&link) );
+	}
+
+	while( u32Node <= u32TotalNodes )
+	{
+		wayPointGraph->u32FirstLink.push_back( wayPointGraph->u32LinkTo.size() );
+		++u32Node;
+	}
+
+	// Reversed rows for the searches from a goal, counted per node and then filled in place
+	const UINT32 u32TotalLinks = wayPointGraph->u32LinkTo.size();
+	wayPointGraph->u32FirstLinkIn.assign( u32TotalNodes + 1, 0 );
+	wayPointGraph->u32LinkFrom.resize( u32TotalLinks );
+	wayPointGraph->linkLengthIn.resize( u32TotalLinks );
+	for( UINT32 i = 0; i < u32TotalLinks; ++i )
+		++wayPointGraph->u32FirstLinkIn[wayPointGraph->u32LinkTo[i] + 1];
+	for( u32Node = 0; u32Node < u32TotalNodes; ++u32Node )
+		wayPointGraph->u32FirstLinkIn[u32Node + 1] += wayPointGraph->u32FirstLinkIn[u32Node];
+	for( u32Node = 0; u32Node < u32TotalNodes; ++u32Node )
+	{
+		for( UINT32 i = wayPointGraph->u32FirstLink[u32Node]; i < wayPointGraph->u32FirstLink[u32Node + 1]; ++i )
+		{
+			const UINT32 u32In = wayPointGraph->u32FirstLinkIn[wayPointGraph->u32LinkTo[i]]++;
+			wayPointGraph->u32LinkFrom[u32In] = u32Node;
+			wayPointGraph->linkLengthIn[u32In] = wayPointGraph->linkLength[i];
 		}
 	}
+	// Every start was moved on to the start of the next row
+	for( u32Node = u32TotalNodes; u32Node > 0; --u32Node )
+		wayPointGraph->u32FirstLinkIn[u32Node] = wayPointGraph->u32FirstLinkIn[u32Node - 1];
+	wayPointGraph->u32FirstLinkIn[0] = 0;
+
+	// Distances to the goals of the old graph are meaningless
+	for( std::vector<S_GOAL_FIELD>::iterator iter = goalFields->begin(); iter != goalFields->end(); ++iter )
+	{
+		iter->distance.resize( u32TotalNodes );
+		iter->u32Next.resize( u32TotalNodes );
+		iter->u32Goal = Utilities::MAX_UINT32;
+		iter->u32LastUsed = 0;
+	}
+	u32GoalFieldClock = 0;
+
+	pathSearch->u32Generation.assign( u32TotalNodes, 0 );
+	pathSearch->u32Parent.resize( u32TotalNodes );
+	pathSearch->u32HeapIndex.resize( u32TotalNodes );
+	pathSearch->g.resize( u32TotalNodes );
+	pathSearch->f.resize( u32TotalNodes );
+	pathSearch->u32OpenHeap.reserve( u32TotalNodes );
+	pathSearch->u32CurrentGeneration = 0;
+	foundPath->reserve( u32TotalNodes );
+	bWayPointGraphDirty = false;
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool FindNode( const UINT32 &i_u32NodeID, UINT32 &o_u32Node )
+	\brief		Find the node of a way point ID in the compiled graph
+	\param		i_u32NodeID way point ID
+	\param		o_u32Node node of the way point
+	\return		BOOLEAN
+	\retval		TRUE if the way point is in the graph
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+bool GameEngine::AI::FindNode( const UINT32 &i_u32NodeID, UINT32 &o_u32Node )
+{
+	std::vector<UINT32>::const_iterator iter = std::lower_bound( wayPointGraph->u32NodeID.begin(),
+		wayPointGraph->u32NodeID.end(), i_u32NodeID );
+
+	if( (iter == wayPointGraph->u32NodeID.end()) || (*iter != i_u32NodeID) )
+		return FALSE;
+
+	o_u32Node = iter - wayPointGraph->u32NodeID.begin();
+	return TRUE;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool IsBetterOpenNode( const UINT32 &i_u32NodeA, const UINT32 &i_u32NodeB )
+	\brief		Order of the open heap, lowest f first and lowest ID among equal f
+	\param		i_u32NodeA first node
+	\param		i_u32NodeB second node
+	\return		BOOLEAN
+	\retval		TRUE if the first node has to be expanded before the second one
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+inline bool GameEngine::AI::IsBetterOpenNode( const UINT32 &i_u32NodeA, const UINT32 &i_u32NodeB )
+{
+	if( pathSearch->f[i_u32NodeA] != pathSearch->f[i_u32NodeB] )
+		return pathSearch->f[i_u32NodeA] < pathSearch->f[i_u32NodeB];
+	return i_u32NodeA < i_u32NodeB;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void SiftUp( UINT32 i_u32HeapIndex )
+	\brief		Move a node of the open heap towards the top until its parent is better
+	\param		i_u32HeapIndex position of the node in the heap
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::AI::SiftUp( UINT32 i_u32HeapIndex )
+{
+	std::vector<UINT32> &heap = pathSearch->u32OpenHeap;
+	const UINT32 u32Node = heap[i_u32HeapIndex];
+
+	while( i_u32HeapIndex > 0 )
+	{
+		const UINT32 u32ParentIndex = (i_u32HeapIndex - 1) / 2;
+
+		if( !IsBetterOpenNode(u32Node, heap[u32ParentIndex]) )
+			break;
+
+		heap[i_u32HeapIndex] = heap[u32ParentIndex];
+		pathSearch->u32HeapIndex[heap[i_u32HeapIndex]] = i_u32HeapIndex;
+		i_u32HeapIndex = u32ParentIndex;
+	}
+
+	heap[i_u32HeapIndex] = u32Node;
+	pathSearch->u32HeapIndex[u32Node] = i_u32HeapIndex;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void SiftDown( UINT32 i_u32HeapIndex )
+	\brief		Move a node of the open heap towards the bottom until its children are worse
+	\param		i_u32HeapIndex position of the node in the heap
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::AI::SiftDown( UINT32 i_u32HeapIndex )
+{
+	std::vector<UINT32> &heap = pathSearch->u32OpenHeap;
+	const UINT32 u32Node = heap[i_u32HeapIndex];
+	const UINT32 u32Size = heap.size();
+
+	for( ;; )
+	{
+		UINT32 u32ChildIndex = 2 * i_u32HeapIndex + 1;
+
+		if( u32ChildIndex >= u32Size )
+			break;
+		if( (u32ChildIndex + 1 < u32Size) && IsBetterOpenNode(heap[u32ChildIndex + 1], heap[u32ChildIndex]) )
+			++u32ChildIndex;
+		if( !IsBetterOpenNode(heap[u32ChildIndex], u32Node) )
+			break;
+
+		heap[i_u32HeapIndex] = heap[u32ChildIndex];
+		pathSearch->u32HeapIndex[heap[i_u32HeapIndex]] = i_u32HeapIndex;
+		i_u32HeapIndex = u32ChildIndex;
+	}
+
+	heap[i_u32HeapIndex] = u32Node;
+	pathSearch->u32HeapIndex[u32Node] = i_u32HeapIndex;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void BeginSearch( const UINT32 &i_u32Node, const float &i_h )
+	\brief		Start a new search with only the given node open
+	\param		i_u32Node node the search starts from
+	\param		i_h estimate of the length left from the node
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::AI::BeginSearch( const UINT32 &i_u32Node, const float &i_h )
+{
+	S_PATH_SEARCH &search = *pathSearch;
+
+	// Stamps of the previous generations would be taken as current once it wraps around
+	if( ++search.u32CurrentGeneration == 0 )
+	{
+		std::fill( search.u32Generation.begin(), search.u32Generation.end(), 0 );
+		search.u32CurrentGeneration = 1;
+	}
+
+	search.u32Generation[i_u32Node] = search.u32CurrentGeneration;
+	search.u32Parent[i_u32Node] = Utilities::MAX_UINT32;
+	search.g[i_u32Node] = 0.0f;
+	search.f[i_u32Node] = i_h;
+	search.u32HeapIndex[i_u32Node] = 0;
+	search.u32OpenHeap.clear();
+	search.u32OpenHeap.push_back( i_u32Node );
+}
+
+/**
+ ****************************************************************************************************
+	\fn			UINT32 PopOpenNode( void )
+	\brief		Take the best node from the open heap and close it
+	\param		NONE
+	\return		UINT32
+	\retval		the closed node
+ ****************************************************************************************************
+*/
+UINT32 GameEngine::AI::PopOpenNode( void )
+{
+	S_PATH_SEARCH &search = *pathSearch;
+	const UINT32 u32Node = search.u32OpenHeap.front();
 
-	if( currentNode.u32ID == i_u32ToNodeID )
+	search.u32HeapIndex[u32Node] = PATH_NODE_CLOSED;
+	search.u32OpenHeap.front() = search.u32OpenHeap.back();
+	search.u32OpenHeap.pop_back();
+	if( !search.u32OpenHeap.empty() )
 	{
-		o_path.clear();
-		o_path.push_front( i_u32ToNodeID );
-		closedListIter = closedList.find( currentNode.u32ParentID );
-		while( (closedListIter != closedList.end()) && (closedListIter->second != Utilities::MAX_UINT32) )
+		search.u32HeapIndex[search.u32OpenHeap.front()] = 0;
+		SiftDown( 0 );
+	}
+
+	return u32Node;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void RelaxLink( const UINT32 &i_u32Node, const UINT32 &i_u32Parent, const float &i_g,
+					const D3DXVECTOR3 *i_destination )
+	\brief		Open a node reached for the first time, or shorten the path to a node still open
+	\param		i_u32Node node at the other end of the link
+	\param		i_u32Parent node the link is followed from
+	\param		i_g length of the path to the node through the parent
+	\param		i_destination centre of the destination, NULL when nothing is estimated
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::AI::RelaxLink( const UINT32 &i_u32Node, const UINT32 &i_u32Parent, const float &i_g, const D3DXVECTOR3 *i_destination )
+{
+	S_PATH_SEARCH &search = *pathSearch;
+
+	// Not reached yet in this search
+	if( search.u32Generation[i_u32Node] != search.u32CurrentGeneration )
+	{
+		float h = 0.0f;
+
+		if( i_destination )
 		{
-			o_path.push_front( closedListIter->first );
-			closedListIter = closedList.find( closedListIter->second );
-			if( closedListIter == closedList.end() )
-				return FALSE;
+			D3DXVECTOR3 distance = *i_destination - wayPointGraph->centre[i_u32Node];
+			h = D3DXVec3Length( &distance );
 		}
-		if( i_u32ToNodeID != i_u32FromNodeID )
-			o_path.push_front( i_u32FromNodeID );
-		return TRUE;
+		search.u32Generation[i_u32Node] = search.u32CurrentGeneration;
+		search.u32Parent[i_u32Node] = i_u32Parent;
+		search.g[i_u32Node] = i_g;
+		search.f[i_u32Node] = i_g + h;
+		search.u32HeapIndex[i_u32Node] = search.u32OpenHeap.size();
+		search.u32OpenHeap.push_back( i_u32Node );
+		SiftUp( search.u32HeapIndex[i_u32Node] );
+	}
+	// Already in the open heap, closed nodes are final as the heuristic is consistent
+	else if( (search.u32HeapIndex[i_u32Node] != PATH_NODE_CLOSED) && (i_g < search.g[i_u32Node]) )
+	{
+		search.f[i_u32Node] = i_g + ( search.f[i_u32Node] - search.g[i_u32Node] );
+		search.g[i_u32Node] = i_g;
+		search.u32Parent[i_u32Node] = i_u32Parent;
+		SiftUp( search.u32HeapIndex[i_u32Node] );
+	}
+}
+
+/**
+ ****************************************************************************************************
+	\fn			S_GOAL_FIELD *GetGoalField( const UINT32 &i_u32ToNodeID, const bool &i_bSearch )
+	\brief		Get the kept distances to a destination, searching them in place of the least recently
+				used ones if asked to
+	\param		i_u32ToNodeID destination node ID
+	\param		i_bSearch whether to search the destination when its distances are not kept
+	\return		S_GOAL_FIELD *
+	\retval		distances of every node to the destination
+	\retval		NULL if the destination is unknown, or not kept and not to be searched
+ ****************************************************************************************************
+*/
+GameEngine::AI::S_GOAL_FIELD *GameEngine::AI::GetGoalField( const UINT32 &i_u32ToNodeID, const bool &i_bSearch )
+{
+	std::vector<S_GOAL_FIELD>::iterator iter;
+	S_GOAL_FIELD *oldestField;
+	UINT32 u32To;
+
+	FUNCTION_START;
+
+	if( bWayPointGraphDirty )
+		CompileWayPointGraph();
+
+	if( !FindNode(i_u32ToNodeID, u32To) )
+	{
+		FUNCTION_FINISH;
+		return NULL;
+	}
+
+	oldestField = &goalFields->front();
+	for( iter = goalFields->begin(); iter != goalFields->end(); ++iter )
+	{
+		if( iter->u32Goal == u32To )
+		{
+			iter->u32LastUsed = ++u32GoalFieldClock;
+			FUNCTION_FINISH;
+			return &(*iter);
+		}
+		if( iter->u32LastUsed < oldestField->u32LastUsed )
+			oldestField = &(*iter);
+	}
+
+	if( !i_bSearch )
+	{
+		FUNCTION_FINISH;
+		return NULL;
 	}
 
+	SearchFromGoal( u32To, *oldestField );
+	oldestField->u32LastUsed = ++u32GoalFieldClock;
+
 	FUNCTION_FINISH;
-	return FALSE;
+	return oldestField;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void SearchFromGoal( const UINT32 &i_u32Goal, S_GOAL_FIELD &o_field )
+	\brief		Find the shortest path from every node to the goal. Dijkstra from the goal over the
+				reversed links, the parent of a node in this search is the next node of its path
+	\param		i_u32Goal node of the goal
+	\param		o_field distances and next nodes, FLT_MAX for the nodes which cannot reach the goal
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::AI::SearchFromGoal( const UINT32 &i_u32Goal, S_GOAL_FIELD &o_field )
+{
+	S_PATH_SEARCH &search = *pathSearch;
+
+	FUNCTION_START;
+
+	std::fill( o_field.distance.begin(), o_field.distance.end(), FLT_MAX );
+	std::fill( o_field.u32Next.begin(), o_field.u32Next.end(), Utilities::MAX_UINT32 );
+	o_field.u32Goal = i_u32Goal;
+
+	BeginSearch( i_u32Goal, 0.0f );
+	while( !search.u32OpenHeap.empty() )
+	{
+		const UINT32 u32Current = PopOpenNode();
+
+		o_field.distance[u32Current] = search.g[u32Current];
+		o_field.u32Next[u32Current] = search.u32Parent[u32Current];
+		for( UINT32 i = wayPointGraph->u32FirstLinkIn[u32Current]; i < wayPointGraph->u32FirstLinkIn[u32Current + 1]; ++i )
+			RelaxLink( wayPointGraph->u32LinkFrom[i], u32Current, search.g[u32Current] + wayPointGraph->linkLengthIn[i], NULL );
+	}
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool GetPathToGoal( const S_GOAL_FIELD &i_field, const UINT32 &i_u32FromNodeID, std::vector<UINT32> &o_path )
+	\brief		Follow the next nodes of a goal field from a start node
+	\param		i_field distances to the goal
+	\param		i_u32FromNodeID start node ID
+	\param		o_path returned path
+	\return		BOOLEAN
+	\retval		TRUE if the start reaches the goal
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+bool GameEngine::AI::GetPathToGoal( const S_GOAL_FIELD &i_field, const UINT32 &i_u32FromNodeID, std::vector<UINT32> &o_path )
+{
+	UINT32 u32From;
+
+	FUNCTION_START;
+
+	if( !FindNode(i_u32FromNodeID, u32From) || (i_field.distance[u32From] == FLT_MAX) )
+	{
+		FUNCTION_FINISH;
+		return FALSE;
+	}
+
+	o_path.clear();
+	for( UINT32 u32Node = u32From; u32Node != Utilities::MAX_UINT32; u32Node = i_field.u32Next[u32Node] )
+		o_path.push_back( wayPointGraph->u32NodeID[u32Node] );
+
+	FUNCTION_FINISH;
+	return TRUE;
+}
+
+#ifdef _DEBUG
+/**
+ ****************************************************************************************************
+	\fn			void PathTestCallback( const UINT32 &i_u32Request, const bool &i_bFound,
+					const std::vector<UINT32> &i_path, void *i_data )
+	\brief		Keep the result of a path request of the unit test
+	\param		i_u32Request handle of the request
+	\param		i_bFound whether a path was found
+	\param		i_path the path found
+	\param		i_data the S_PATH_TEST_RESULT of the request
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::AI::PathTestCallback( const UINT32 &i_u32Request, const bool &i_bFound, const std::vector<UINT32> &i_path, void *i_data )
+{
+	S_PATH_TEST_RESULT *result = reinterpret_cast<S_PATH_TEST_RESULT *>( i_data );
+
+	++result->u32Calls;
+	result->bFound = i_bFound;
+	result->path = i_path;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			float FindTestDistance( const UINT32 &i_u32FromNodeID, const UINT32 &i_u32ToNodeID )
+	\brief		Length of the shortest path for the unit test, a plain Dijkstra over the way point and
+				link lists which does not use the compiled graph
+	\param		i_u32FromNodeID start node ID
+	\param		i_u32ToNodeID destination node ID
+	\return		float
+	\retval		length of the shortest path
+	\retval		FLT_MAX if the destination cannot be reached
+ ****************************************************************************************************
+*/
+float GameEngine::AI::FindTestDistance( const UINT32 &i_u32FromNodeID, const UINT32 &i_u32ToNodeID )
+{
+	std::map<UINT32, float> distance;
+	std::set<UINT32> done;
+
+	for( std::map<UINT32, S_WAY_POINT>::const_iterator iter = wayPointList->begin(); iter != wayPointList->end(); ++iter )
+		distance[iter->first] = FLT_MAX;
+	distance[i_u32FromNodeID] = 0.0f;
+
+	while( done.size() < distance.size() )
+	{
+		std::map<UINT32, float>::const_iterator closest = distance.end();
+		for( std::map<UINT32, float>::const_iterator iter = distance.begin(); iter != distance.end(); ++iter )
+		{
+			if( !done.count(iter->first) && ((closest == distance.end()) || (iter->second < closest->second)) )
+				closest = iter;
+		}
+		if( (closest->second == FLT_MAX) || (closest->first == i_u32ToNodeID) )
+			break;
+		done.insert( closest->first );
+
+		std::set<S_WAY_POINT_LINK, S_WAY_POINT_COMPARE>::const_iterator linkIter = wayPointLinkList->begin();
+		for( ; linkIter != wayPointLinkList->end(); ++linkIter )
+		{
+			if( linkIter->u32From != closest->first )
+				continue;
+
+			D3DXVECTOR3 link = wayPointList->at( linkIter->u32To ).centre - wayPointList->at( linkIter->u32From ).centre;
+			const float length = closest->second + D3DXVec3Length( &link );
+			if( length < distance[linkIter->u32To] )
+				distance[linkIter->u32To] = length;
+		}
+	}
+
+	return distance[i_u32ToNodeID];
+}
+
+/**
+ ****************************************************************************************************
+	\fn			float GetTestPathLength( const std::vector<UINT32> &i_path )
+	\brief		Length of a path for the unit test along the way point links
+	\param		i_path the path
+	\return		float
+	\retval		length of the path
+	\retval		FLT_MAX if two nodes in a row are not linked
+ ****************************************************************************************************
+*/
+float GameEngine::AI::GetTestPathLength( const std::vector<UINT32> &i_path )
+{
+	float length = 0.0f;
+
+	for( UINT32 i = 1; i < i_path.size(); ++i )
+	{
+		S_WAY_POINT_LINK link;
+
+		link.u32From = i_path[i - 1];
+		link.u32To = i_path[i];
+		if( wayPointLinkList->find(link) == wayPointLinkList->end() )
+			return FLT_MAX;
+
+		D3DXVECTOR3 distance = wayPointList->at( link.u32To ).centre - wayPointList->at( link.u32From ).centre;
+		length += D3DXVec3Length( &distance );
+	}
+
+	return length;
 }
+#endif	// #ifdef _DEBUG
 
 /****************************************************************************************************
 			AIEntity class implementation
@@ -721,9 +1786,11 @@ bool GameEngine::AI::FindOptimalPath( const UINT32 &i_u32FromNodeID, const UINT3
 GameEngine::AI::AIEntity::AIEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity ) :
 	m_entity( i_entity ),
 	m_AIState(E_AI_STATE_DEACTIVATE),
-	m_u32TargetNodeID(Utilities::MAX_UINT32)
+	m_u32TargetNodeID(Utilities::MAX_UINT32),
+	m_u32DestinationNodeID(Utilities::MAX_UINT32),
+	m_u32PathRequest(Utilities::INVALID_HANDLE)
 {
-	m_optimalPath = new std::deque<UINT32>();
+	m_optimalPath = new std::vector<UINT32>();
 	_optimalPathNodeID = new std::set<UINT32>();
 }
 
@@ -8,6 +8,8 @@
 #ifndef _AI_H_
 #define _AI_H_
 
+#include <vector>
+
 // Utilities header
 #include <UtilitiesTypes.h>
 
@@ -26,14 +28,26 @@ namespace GameEngine
 
 		void AddWayPoint( const UINT32 &i_u32ID, const S_WAY_POINT &i_wayPoint );
 		void AddWayPointLink( const S_WAY_POINT_LINK &i_newWayPointLink );
+		void GetWayPoints( std::vector<UINT32> &o_IDs, std::vector<S_WAY_POINT> &o_wayPoints );
+		void GetWayPointLinks( std::vector<S_WAY_POINT_LINK> &o_wayPointLinks );
 
-		UINT8 AddAIEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity );
-		void RemoveAIEntity( UINT8 &i_u8Index );
-		void UpdateAIDestinationTo( const UINT8 &i_u8Index, const UINT8 &i_u8NodeID );
-		void AbortAI( const UINT8 &i_u8Index );
-		bool GetAIState( const UINT8 &i_u8Index );
+		UINT32 AddAIEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity );
+		void RemoveAIEntity( UINT32 &io_u32Handle );
+		void UpdateAIDestinationTo( const UINT32 &i_u32Handle, const UINT8 &i_u8NodeID );
+		void AbortAI( const UINT32 &i_u32Handle );
+		bool GetAIState( const UINT32 &i_u32Handle );
 		void FindClosestNodeIDFromPosition( const D3DXVECTOR3 &i_vCurrPosition, UINT32 &o_u32NodeID );
 		float FindDistanceToNodeID( const D3DXVECTOR3 &i_vCurrPosition, const UINT32 &i_u32NodeID );
+
+		// Path requests are searched by the AI update, which calls the callback once it is done
+		typedef void (*PathCallback)( const UINT32 &i_u32Request, const bool &i_bFound, const std::vector<UINT32> &i_path, void *i_data );
+		UINT32 RequestPath( const UINT32 &i_u32FromNodeID, const UINT32 &i_u32ToNodeID, PathCallback i_callback, void *i_data );
+		void CancelPathRequest( UINT32 &io_u32Request );
+		bool IsPathRequestPending( const UINT32 &i_u32Request );
+
+#ifdef _DEBUG
+		void UnitTest( void );
+#endif	// #ifdef _DEBUG
 	}
 }
 
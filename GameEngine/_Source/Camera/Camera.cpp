@@ -6,10 +6,12 @@
 */
 
 // Utilities header
+#include <Time/Time.h>
 #include <Debug/Debug.h>
 
 #include "../GameEngine.h"
 #include "../World/World.h"
+#include "../World/EntityStore.h"
 #include "../Renderer/Renderer.h"
 #include "../DebugMenu/DebugMenu.h"
 #include "../Utilities/IDCreator/IDCreator.h"
@@ -249,7 +251,8 @@ void GameEngine::Camera::EndUpdate( void )
 /**
  ****************************************************************************************************
 	\fn			D3DXVECTOR3 GetPosition( void )
-	\brief		Get real camera position in the world
+	\brief		Get real camera position in the world, between the last two simulation steps of the
+				camera entity as the entities are drawn
 	\param		NONE
 	\return		NONE
  ****************************************************************************************************
@@ -266,9 +269,12 @@ const D3DXVECTOR3 GameEngine::Camera::GetPosition( void ) const
 	}
 	else
 	{
-		position.x = _entity->m_v3Position.X();
-		position.y = _entity->m_v3Position.Y();
-		position.z = _entity->m_v3Position.Z();
+		const Math::Vector3 &v3Previous = g_world::Get().GetEntityStore().m_v3PreviousPosition[_entity->m_u32StoreSlot];
+		const Math::Vector3 v3Position = v3Previous + (Utilities::Time::GetInterpolationAlpha() * (_entity->m_v3Position - v3Previous));
+
+		position.x = v3Position.X();
+		position.y = v3Position.Y();
+		position.z = v3Position.Z();
 	}
 
 	FUNCTION_FINISH;
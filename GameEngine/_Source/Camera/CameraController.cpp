@@ -145,9 +145,8 @@ void GameEngine::CameraController::Update( GameEngine::Entity &i_entity )
 // 		}
 // 	}
 
-	i_entity.m_v3Position = m_followEntity->m_v3Position;
-	i_entity.m_v3Position -= i_entity.m_vLookAt * g_world::Get().m_camera->m_backDistance;
-	i_entity.m_v3ProjectedPosition = m_followEntity->m_v3Position;
+	i_entity.SetPosition( m_followEntity->m_v3Position - i_entity.m_vLookAt * g_world::Get().m_camera->m_backDistance );
+	i_entity.SetProjectedPosition( m_followEntity->m_v3Position );
 
 	FUNCTION_FINISH;
 }
@@ -155,19 +154,21 @@ void GameEngine::CameraController::Update( GameEngine::Entity &i_entity )
 /**
  ****************************************************************************************************
 	\fn			CameraCollisionHandler::HandleCollision( Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_entity,
-				Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_other, const float i_collisionTime
-				const GameEngine::Math::Vector3 &i_collisionVector, const Utilities::StringHash &i_hashedTag )
+				Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_other, const Collision::E_COLLISION_HIT i_eHit,
+				const float i_collisionTime, const GameEngine::Math::Vector3 &i_v3PointOrNormal, const Utilities::StringHash &i_hashedTag )
 	\brief		Collision handler of camera
 	\param		i_entity current entity
 	\param		i_other other entity which is collided with
+	\param		i_eHit check which found the collision
 	\param		i_collisionTime time of collision
-	\param		i_collisionVector direction of collision response
+	\param		i_v3PointOrNormal collision point, or the contact normal of a swept hit
+	\param		i_hashedTag tag of the hit triangle
 	\return		NONE
  ****************************************************************************************************
 */
 void GameEngine::CameraCollisionHandler::HandleCollision( Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_entity, \
-	Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_other, const float i_collisionTime, const GameEngine::Math::Vector3 &i_collisionPoint, \
-	const Utilities::StringHash &i_hashedTag )
+	Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_other, const Collision::E_COLLISION_HIT i_eHit, const float i_collisionTime, \
+	const GameEngine::Math::Vector3 &i_v3PointOrNormal, const Utilities::StringHash &i_hashedTag )
 {
 	FUNCTION_START;
 
@@ -215,9 +216,8 @@ void GameEngine::CameraCollisionHandler::HandleCollision( Utilities::Pointer::Sm
 			g_world::Get().m_camera->m_bAngleChanged = false;
 			_u8Ctr++;
 		}
-		i_entity->m_v3Position = i_entity->m_v3ProjectedPosition;
-		i_entity->m_v3Position -= i_entity->m_vLookAt * g_world::Get().m_camera->m_backDistance;
-		i_entity->m_v3ProjectedPosition = i_entity->m_v3Position;
+		i_entity->SetPosition( i_entity->m_v3ProjectedPosition - i_entity->m_vLookAt * g_world::Get().m_camera->m_backDistance );
+		i_entity->SetProjectedPosition( i_entity->m_v3Position );
 	}
 
 	FUNCTION_FINISH;
@@ -53,7 +53,8 @@ namespace GameEngine
 		~CameraCollisionHandler( void ) {}
 
 		void HandleCollision( Utilities::Pointer::SmartPtr<Entity> &i_entity, Utilities::Pointer::SmartPtr<Entity> &i_other,
-			const float i_collisionTime, const Math::Vector3 &i_collisionVector, const Utilities::StringHash &i_hashedTag );
+			const Collision::E_COLLISION_HIT i_eHit, const float i_collisionTime, const Math::Vector3 &i_v3PointOrNormal,
+			const Utilities::StringHash &i_hashedTag );
 		void OnLeavingCollision( Utilities::Pointer::SmartPtr<Entity> &i_entity, Utilities::Pointer::SmartPtr<Entity> &i_other );
 	};
 }
@@ -9,20 +9,28 @@
 #include <vector>
 #include <float.h>
 #include <assert.h>
+#include <algorithm>
 
 // Utilities header
 #include <Time/Time.h>
 #include <SmartPtr/SmartPtr.h>
+#include <JobSystem/JobSystem.h>
+#include <TaskGraph/TaskGraph.h>
+#include <HandleTable/HandleTable.h>
 #include <MemoryPool/MemoryPool.h>
+#include <SweepAndPrune/SweepAndPrune.h>
 #include <Parser/MeshParser/MeshParser.h>
 
 #include "Collision.h"
+#include "../GameEngine.h"
 #include "../World/Entity.h"
+#include "../Physics/Physics.h"
 #include "../Camera/Camera.h"
 #include "../Renderer/Renderer.h"
 #include "../GameEngineDefault.h"
 #include "../Math/Matrix/Matrix.h"
 #include "../DebugMenu/DebugMenu.h"
+#include "../Utilities/BVH/BVH.h"
 #include "../Utilities/Octree/Octree.h"
 #include "../Utilities/GameEngineTypes.h"
 #include "../Utilities/Profiler/Profiler.h"
@@ -42,19 +50,51 @@ namespace GameEngine
 
 			D3DXVECTOR3														m_downCollisionPoint;
 			D3DXVECTOR3														m_forwardCollisionPoint;
+			// Only set for swept entities
+			D3DXVECTOR3														m_forwardCollisionNormal;
+			// Bounds of the collision triangles, they do not move with the entity
+			D3DXVECTOR3														m_vGeometryMin;
+			D3DXVECTOR3														m_vGeometryMax;
+			// Bounds given to the broadphase this step
+			D3DXVECTOR3														m_vBroadphaseMin;
+			D3DXVECTOR3														m_vBroadphaseMax;
+			// Later entities in the database whose bounds overlap, in database order
+			std::vector<UINT32>										m_candidates;
+			// Hashed tags of the triangles of the forward and down hits, only set by the rays this entity casts
+			Utilities::StringHash									m_forwardHashedTag;
+			Utilities::StringHash									m_downHashedTag;
+			// Triangles around the last down hit in the octree of m_downCacheEntity. While the down ray stays
+			// inside the cache box they give the same hit as a full query
+			std::vector<Octree::S_TRIANGLE_SPAN>	m_downCacheSpans;
+			D3DXVECTOR3														m_vDownCacheMin;
+			D3DXVECTOR3														m_vDownCacheMax;
+			const CollisionEntity									*m_downCacheEntity;
 			Utilities::Pointer::SmartPtr<Entity>	m_downCollidedEntity;
 			Utilities::Pointer::SmartPtr<Entity>	m_forwardCollidedEntity;
 			Utilities::Pointer::SmartPtr<Entity>	m_entity;
 			CollisionHandler											*m_collisionHandler;
 			Octree																*m_octree;
+			BVH																		*m_bvh;
 			uint16_t															*m_u16Indices;
 			D3DXVECTOR3														*m_vertices;
 			UINT32																m_u32TotalPrimitives;
 			UINT32																m_u32TotalVertices;
+			UINT32																m_u32Proxy;
+			// Slot in the awake entities, NO_ENTITY while the entity sleeps
+			UINT32																m_u32AwakeSlot;
 			float																	m_downCollisionDistance;
 			float																	m_forwardCollisionDistance;
+			// The forward check sweeps a capsule of this radius when it is not zero, from the position down
+			// to the position minus the height
+			float																	m_sweepRadius;
+			float																	m_sweepHeight;
 
 			CollisionEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity, const char *i_collisionFile );
+#ifdef _DEBUG
+			// Fixture of the unit test, the triangles are traced through a BVH
+			CollisionEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity, const D3DXVECTOR3 *i_vertices,
+				const uint16_t *i_u16Indices, const UINT32 &i_u32TotalTriangles );
+#endif	// #ifdef _DEBUG
 
 			~CollisionEntity( void );
 
@@ -72,14 +112,95 @@ namespace GameEngine
 			bool &operator==( const CollisionEntity &i_other ) const;
 		};
 
+		// Rays traced by one job
+		const UINT32 CAST_RAYS_GRAIN_SIZE = 64;
+		const UINT32 NO_ENTITY = 0xFFFFFFFF;
+		// Larger caches are not worth testing instead of a full query
+		const UINT32 MAX_DOWN_CACHE_TRIANGLES = 128;
+		// Fraction of the node size the cache box is shrunk by, the ray must be strictly inside the node
+		const float DOWN_CACHE_MARGIN = 0.001f;
+
+		typedef struct _s_ray_result_
+		{
+			D3DXVECTOR3 point;
+			float distance;
+			UINT32 u32Entity;
+			Utilities::StringHash hashedTag;
+			// Entities the down ray was traced against the cache or the full octree of
+			UINT32 u32DownCacheHits;
+			UINT32 u32DownCacheMisses;
+		} S_RAY_RESULT;
+
+		typedef struct _s_cast_rays_job_data_
+		{
+			const S_RAY *ray;
+			// Rays in the order they are traced
+			const UINT32 *u32Order;
+			// Parallel to collisionEntityDatabase, zero for destroyed entities
+			const UINT32 *u32EntityBitMask;
+			// Database index of the entity casting each ray, NULL if the rays are not cast by entities
+			const UINT32 *u32Caster;
+			S_RAY_RESULT *result;
+			// Down rays of their casters use and refill the down cache of the caster
+			bool bDownRays;
+			bool bDebugDraw;
+		} S_CAST_RAYS_JOB_DATA;
+
 		bool bShowCollisionWireframe;
 
 		static std::vector< Utilities::Pointer::SmartPtr<CollisionEntity> > *collisionEntityDatabase;
+		static Utilities::HandleTable *collisionHandleTable;
+		static Utilities::SweepAndPrune *broadphase;
+		static std::vector<Utilities::SweepAndPrune::S_OVERLAPPING_PAIR> *overlappingPairs;
+		// Handles of the entities which are not sleeping, only they are updated
+		static std::vector<UINT32> *awakeEntities;
+		// Database index of the awake entities of this step, in database order
+		static std::vector<UINT32> *awakeIndices;
+		// Scratch of the octree queries, collision is only updated by one thread
+		static std::vector<Octree::S_TRIANGLE_SPAN> *triangleSpans;
+		// Rays of the awake entities traced in one batch, the database index of their caster and their results
+		static std::vector<S_RAY> *entityRays;
+		static std::vector<UINT32> *rayCasters;
+		static std::vector<S_RAY_RESULT> *rayResults;
 		static E_COLLISION_BY eCollisionBy = E_COLLISION_MAX;
 		static D3DXVECTOR3 startPoint;
 		static D3DXVECTOR3 endPoint;
-		void RemoveDeadEntities( void );
-		void CheckCollision( CollisionEntity &i_A, CollisionEntity &i_B, const bool i_bForwardDirection, Utilities::StringHash &o_hashedTag = Utilities::StringHash("") );
+		// Down rays traced against the cache or the full octree this frame
+		static UINT32 u32DownCacheHits = 0;
+		static UINT32 u32DownCacheMisses = 0;
+		bool IsIdle( void );
+		void CheckCollision( CollisionEntity &i_A, CollisionEntity &i_B );
+		void UpdateBroadphase( void );
+		void GetAwakeIndices( void );
+		void ClearResults( CollisionEntity &io_entity );
+		void GetQueryBounds( const CollisionEntity &i_entity, D3DXVECTOR3 &o_vMin, D3DXVECTOR3 &o_vMax );
+		void CheckCandidates( const UINT32 &i_u32Index );
+		bool IsCastingRays( const CollisionEntity &i_entity );
+		void AddEntityRay( const UINT32 &i_u32Index, const bool i_bDownRay );
+		void TraceEntityRays( const bool i_bDownRays );
+		void CheckForward( const UINT32 &i_u32Index );
+		void RecordForwardHit( CollisionEntity &io_A, CollisionEntity &io_B, const D3DXVECTOR3 &i_point, const D3DXVECTOR3 &i_normal,
+			const float &i_distance, const Utilities::StringHash &i_hashedTag );
+		void RecordDownHit( CollisionEntity &io_A, CollisionEntity &io_B, const D3DXVECTOR3 &i_point, const float &i_distance,
+			const Utilities::StringHash &i_hashedTag );
+		void TraceRays( const S_RAY *i_rays, const UINT32 *i_u32Casters, const bool i_bDownRays, S_RAY_RESULT *o_results,
+			const UINT32 &i_u32TotalRays );
+		bool TraceSegment( const CollisionEntity &i_entity, const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint,
+			const bool i_bDebugDraw, std::vector<Octree::S_TRIANGLE_SPAN> &io_triangleSpans, D3DXVECTOR3 &o_collisionPoint,
+			float &io_collisionDistance, Utilities::StringHash &o_hashedTag, UINT32 &o_u32Node );
+		bool TraceSpans( const CollisionEntity &i_entity, const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint,
+			const bool i_bDebugDraw, const std::vector<Octree::S_TRIANGLE_SPAN> &i_triangleSpans, D3DXVECTOR3 &o_collisionPoint,
+			float &io_collisionDistance, Utilities::StringHash &o_hashedTag, UINT32 &o_u32Node );
+		bool IsInsideDownCache( const CollisionEntity &i_A, const CollisionEntity &i_B, const D3DXVECTOR3 &i_startPoint,
+			const D3DXVECTOR3 &i_endPoint );
+		void FillDownCache( CollisionEntity &io_A, const CollisionEntity &i_B, const UINT32 &i_u32Node, const D3DXVECTOR3 &i_startPoint,
+			const D3DXVECTOR3 &i_endPoint );
+		bool SweepEntity( const CollisionEntity &i_entity, const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint,
+			const D3DXVECTOR3 &i_axis, const float &i_radius, const bool i_bDebugDraw, std::vector<Octree::S_TRIANGLE_SPAN> &io_triangleSpans,
+			Utilities::Math::S_SWEEP_HIT &io_hit, Utilities::StringHash &o_hashedTag );
+		void HandleForwardCollision( CollisionEntity &i_entity );
+		UINT32 GetRayOrderKey( const S_RAY &i_ray, const D3DXVECTOR3 &i_vMin, const D3DXVECTOR3 &i_vScale );
+		void CastRayRange( void *i_data, const UINT32 &i_u32Begin, const UINT32 &i_u32End );
 	}	// namespace Collision	
 }	// namespace GameEngine
 
@@ -106,8 +227,19 @@ bool GameEngine::Collision::Initialize( void )
 
 	CollisionEntity::m_collisionEntityPool = Utilities::MemoryPool::Create( sizeof(CollisionEntity), Utilities::DEFAULT_MEMORY_POOL_SIZE );
 	collisionEntityDatabase = new std::vector< Utilities::Pointer::SmartPtr<CollisionEntity> >;
+	collisionHandleTable = Utilities::HandleTable::Create( Utilities::DEFAULT_MEMORY_POOL_SIZE );
+	broadphase = Utilities::SweepAndPrune::Create( Utilities::DEFAULT_MEMORY_POOL_SIZE );
+	overlappingPairs = new std::vector<Utilities::SweepAndPrune::S_OVERLAPPING_PAIR>;
+	awakeEntities = new std::vector<UINT32>;
+	awakeIndices = new std::vector<UINT32>;
+	triangleSpans = new std::vector<Octree::S_TRIANGLE_SPAN>;
+	entityRays = new std::vector<S_RAY>;
+	rayCasters = new std::vector<UINT32>;
+	rayResults = new std::vector<S_RAY_RESULT>;
 	
 	assert( CollisionEntity::m_collisionEntityPool );
+	assert( collisionHandleTable );
+	assert( broadphase );
 
 #ifdef ENABLE_COLLISION_WIREFRAME
 	g_debugMenu::Get().AddCheckBox( "Show collision meshes", bShowCollisionWireframe );
@@ -135,7 +267,9 @@ void GameEngine::Collision::BeginUpdate( void )
 /**
  ****************************************************************************************************
 	\fn			void Update( void )
-	\brief		Update collision
+	\brief		Detect the collisions of this step, the forward rays of the awake entities are traced
+				against the moved broadphase. No handler is called, so it can run beside the other
+				detection tasks
 	\param		NONE
 	\return		NONE
  ****************************************************************************************************
@@ -143,20 +277,16 @@ void GameEngine::Collision::BeginUpdate( void )
 void GameEngine::Collision::Update( void )
 {
 	PROFILE_UNSCOPED( "Collision" );
-	float frameTime_ms = Utilities::Time::GetTimeElapsedThisFrame_ms();
+	float frameTime_ms = Utilities::Time::GetFixedTimeStep_ms();
 	std::vector< Utilities::Pointer::SmartPtr<CollisionEntity> >::iterator iterA;
-	std::vector< Utilities::Pointer::SmartPtr<CollisionEntity> >::iterator iterB;
-	Utilities::StringHash hashedTag;
+	std::vector<UINT32>::const_iterator iter;
 
 	FUNCTION_START;
 
-	if( collisionEntityDatabase->size() == 0 )
-	{
-		FUNCTION_FINISH;
-		return;
-	}
+	TASK_CHECK_ACCESS( E_RESOURCE_ENTITY | E_RESOURCE_POSITION | E_RESOURCE_VELOCITY | E_RESOURCE_PROJECTION
+		| E_RESOURCE_CAMERA | E_RESOURCE_DEBUG_MENU, E_RESOURCE_COLLISION | E_RESOURCE_DEBUG_DRAW );
 
-	if( !bShowCollisionWireframe && (collisionEntityDatabase->size() == 1) )
+	if( IsIdle() )
 	{
 		FUNCTION_FINISH;
 		return;
@@ -181,84 +311,141 @@ void GameEngine::Collision::Update( void )
 			g_debugMenu::Get().DrawLine( startPoint, endPoint, Utilities::BLACK );
 	}
 
-	for( iterA = collisionEntityDatabase->begin(); iterA != collisionEntityDatabase->end(); ++iterA )
+	UpdateBroadphase();
+
+	// A sleeping entity stays where its last check left it, an entity woken up by a handler is
+	// checked from the next step. The forward rays of the awake entities are traced in one batch,
+	// swept entities sweep their shape against their candidates instead
+	entityRays->clear();
+	rayCasters->clear();
+	for( iter = awakeIndices->begin(); iter != awakeIndices->end(); ++iter )
 	{
-		if( (*iterA)->m_collisionHandler && !(*iterA)->m_entity->m_isDestroyed )
-		{
-			// Check for forward direction collision
-			iterB = iterA;
-			for( ++iterB; iterB != collisionEntityDatabase->end(); ++iterB )
-				CheckCollision( **iterA, **iterB, true );
+		CollisionEntity &entity = *collisionEntityDatabase->at( *iter );
+		if( !IsCastingRays(entity) )
+			continue;
 
-			// Forward ray casting resolution
-			if( (*iterA)->m_entity->m_u8EntityID == g_IDCreator::Get().GetID("Camera") )
-			{
-				do 
-				{
-					if( (*iterA)->m_forwardCollidedEntity && !Camera::m_bOnDebugCamera )
-						(*iterA)->m_collisionHandler->HandleCollision( (*iterA)->m_entity, (*iterA)->m_forwardCollidedEntity, 0.0f, (*iterA)->m_forwardCollisionPoint );
+		if( entity.m_sweepRadius > 0.0f )
+			CheckCandidates( *iter );
+		else
+			AddEntityRay( *iter, false );
+	}
+	TraceEntityRays( false );
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void HandleCollisions( void )
+	\brief		Give the collisions found by Update to the handlers of the entities. The handlers move
+				the entities, so the down rays are traced from where the forward collisions left them
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Collision::HandleCollisions( void )
+{
+	PROFILE_UNSCOPED( "Collision handlers" );
+	std::vector<UINT32>::const_iterator iter;
 
-					(*iterA)->m_forwardCollidedEntity = NULL;
-					(*iterA)->m_forwardCollisionDistance = 0.0f;
-					(*iterA)->m_forwardCollisionPoint = D3DXVECTOR3_ZERO;
+	FUNCTION_START;
 
-					iterB = iterA;
-					for( ++iterB; iterB != collisionEntityDatabase->end(); ++iterB )
-						CheckCollision( **iterA, **iterB, true );
-				} while( (*iterA)->m_forwardCollidedEntity );
+	if( IsIdle() )
+	{
+		FUNCTION_FINISH;
+		return;
+	}
 
-				(*iterA)->m_collisionHandler->OnLeavingCollision( (*iterA)->m_entity, (*iterA)->m_entity );
-			}
-			else
+	for( iter = awakeIndices->begin(); iter != awakeIndices->end(); ++iter )
+	{
+		CollisionEntity &entity = *collisionEntityDatabase->at( *iter );
+		if( !IsCastingRays(entity) )
+			continue;
+
+		// Forward ray casting resolution
+		if( entity.m_entity->m_u8EntityID == g_IDCreator::Get().GetID("Camera") )
+		{
+			do 
 			{
-				if( (*iterA)->m_forwardCollidedEntity && !Camera::m_bOnDebugCamera )
-					(*iterA)->m_collisionHandler->HandleCollision( (*iterA)->m_entity, (*iterA)->m_forwardCollidedEntity, 0.0f, (*iterA)->m_forwardCollisionPoint );
-			}
+				if( entity.m_forwardCollidedEntity && !Camera::m_bOnDebugCamera )
+					HandleForwardCollision( entity );
+
+				entity.m_forwardCollidedEntity = NULL;
+				entity.m_forwardCollisionDistance = 0.0f;
+				entity.m_forwardCollisionPoint = D3DXVECTOR3_ZERO;
+				entity.m_forwardCollisionNormal = D3DXVECTOR3_ZERO;
+				entity.m_forwardHashedTag = Utilities::StringHash( "" );
+
+				CheckForward( *iter );
+			} while( entity.m_forwardCollidedEntity );
+
+			entity.m_collisionHandler->OnLeavingCollision( entity.m_entity, entity.m_entity );
+		}
+		else if( entity.m_forwardCollidedEntity && !Camera::m_bOnDebugCamera )
+		{
+			HandleForwardCollision( entity );
+		}
+	}
 
-			// Check for down direction collision
-			iterB = iterA;
-			for( ++iterB; iterB != collisionEntityDatabase->end(); ++iterB )
-				CheckCollision( **iterA, **iterB, false, hashedTag );
+	// Check for down direction collision once the forward collisions have moved the entities
+	entityRays->clear();
+	rayCasters->clear();
+	for( iter = awakeIndices->begin(); iter != awakeIndices->end(); ++iter )
+	{
+		if( IsCastingRays(*collisionEntityDatabase->at(*iter)) )
+			AddEntityRay( *iter, true );
+	}
+	TraceEntityRays( true );
 
-			// Do not do collision resolution if in debug-camera-mode
-			if( Camera::m_bOnDebugCamera )
+	// Do not do collision resolution if in debug-camera-mode
+	if( !Camera::m_bOnDebugCamera )
+	{
+		// An entity with nothing below is given to its handler once on its own, its down ray is then traced again
+		entityRays->clear();
+		rayCasters->clear();
+		for( iter = awakeIndices->begin(); iter != awakeIndices->end(); ++iter )
+		{
+			CollisionEntity &entity = *collisionEntityDatabase->at( *iter );
+			if( !IsCastingRays(entity) )
 				continue;
 
-			// If down collision found
-			if( (*iterA)->m_downCollidedEntity )
+			if( entity.m_downCollidedEntity )
 			{
-				(*iterA)->m_collisionHandler->HandleCollision( (*iterA)->m_entity, (*iterA)->m_downCollidedEntity, 1.0f, \
-					(*iterA)->m_downCollisionPoint, hashedTag );
+				entity.m_collisionHandler->HandleCollision( entity.m_entity, entity.m_downCollidedEntity, E_COLLISION_HIT_DOWN, 1.0f, \
+					entity.m_downCollisionPoint, entity.m_downHashedTag );
 			}
 			else
 			{
-				UINT8 ctr = 0;
-				do
-				{
-					(*iterA)->m_collisionHandler->HandleCollision( (*iterA)->m_entity, (*iterA)->m_entity, 1.0f, Math::Vector3::Zero );
-
-					iterB = iterA;
-					for( ++iterB; iterB != collisionEntityDatabase->end(); ++iterB )
-						CheckCollision( **iterA, **iterB, false, hashedTag );
-
-					if( (*iterA)->m_downCollidedEntity )
-					{
-						(*iterA)->m_collisionHandler->HandleCollision( (*iterA)->m_entity, (*iterA)->m_downCollidedEntity, 1.0f, \
-							(*iterA)->m_downCollisionPoint, hashedTag );
-						ctr = 2;
-					}
-				} while( ctr > 2 );
+				entity.m_collisionHandler->HandleCollision( entity.m_entity, entity.m_entity, E_COLLISION_HIT_DOWN, 1.0f, Math::Vector3::Zero );
+				AddEntityRay( *iter, true );
+			}
+		}
+		TraceEntityRays( true );
+
+		for( UINT32 i = 0; i < rayCasters->size(); ++i )
+		{
+			CollisionEntity &entity = *collisionEntityDatabase->at( rayCasters->at(i) );
+			if( entity.m_downCollidedEntity )
+			{
+				entity.m_collisionHandler->HandleCollision( entity.m_entity, entity.m_downCollidedEntity, E_COLLISION_HIT_DOWN, 1.0f, \
+					entity.m_downCollisionPoint, entity.m_downHashedTag );
 			}
 		}
 	}
 
+	PROFILE_COUNTER( "Collision down cache hits", u32DownCacheHits );
+	PROFILE_COUNTER( "Collision down cache misses", u32DownCacheMisses );
+	u32DownCacheHits = 0;
+	u32DownCacheMisses = 0;
+
 	FUNCTION_FINISH;
 }
 
 /**
  ****************************************************************************************************
 	\fn			void EndUpdate( void )
-	\brief		End updating collision
+	\brief		End updating collision, the results of the awake entities are cleared. A sleeping entity
+				hit this frame is cleared when it wakes up
 	\param		NONE
 	\return		NONE
  ****************************************************************************************************
@@ -267,18 +454,9 @@ void GameEngine::Collision::EndUpdate( void )
 {
 	FUNCTION_START;
 
-	RemoveDeadEntities();
-
-	std::vector< Utilities::Pointer::SmartPtr<CollisionEntity> >::iterator iterA;
-	for( iterA = collisionEntityDatabase->begin(); iterA != collisionEntityDatabase->end(); iterA++ )
-	{
-		(*iterA)->m_downCollidedEntity = NULL;
-		(*iterA)->m_downCollisionDistance = 0.0f;
-		(*iterA)->m_downCollisionPoint = D3DXVECTOR3_ZERO;
-		(*iterA)->m_forwardCollidedEntity = NULL;
-		(*iterA)->m_forwardCollisionDistance = 0.0f;
-		(*iterA)->m_forwardCollisionPoint = D3DXVECTOR3_ZERO;
-	}
+	std::vector<UINT32>::const_iterator iter;
+	for( iter = awakeEntities->begin(); iter != awakeEntities->end(); ++iter )
+		ClearResults( *collisionEntityDatabase->at(collisionHandleTable->GetIndex(*iter)) );
 
 	FUNCTION_FINISH;
 }
@@ -301,6 +479,60 @@ void GameEngine::Collision::ShutDown( void )
 		collisionEntityDatabase = NULL;
 	}
 
+	if( collisionHandleTable )
+	{
+		delete collisionHandleTable;
+		collisionHandleTable = NULL;
+	}
+
+	if( broadphase )
+	{
+		delete broadphase;
+		broadphase = NULL;
+	}
+
+	if( overlappingPairs )
+	{
+		delete overlappingPairs;
+		overlappingPairs = NULL;
+	}
+
+	if( awakeEntities )
+	{
+		delete awakeEntities;
+		awakeEntities = NULL;
+	}
+
+	if( awakeIndices )
+	{
+		delete awakeIndices;
+		awakeIndices = NULL;
+	}
+
+	if( triangleSpans )
+	{
+		delete triangleSpans;
+		triangleSpans = NULL;
+	}
+
+	if( entityRays )
+	{
+		delete entityRays;
+		entityRays = NULL;
+	}
+
+	if( rayCasters )
+	{
+		delete rayCasters;
+		rayCasters = NULL;
+	}
+
+	if( rayResults )
+	{
+		delete rayResults;
+		rayResults = NULL;
+	}
+
 	if( CollisionEntity::m_collisionEntityPool )
 	{
 		delete CollisionEntity::m_collisionEntityPool;
@@ -312,83 +544,138 @@ void GameEngine::Collision::ShutDown( void )
 
 /**
  ****************************************************************************************************
-	\fn			UINT8 AddCollisionEntity( Pointer::SmartPtr<Entity> &i_entity, const char *i_collisionFile )
+	\fn			UINT32 AddCollisionEntity( Pointer::SmartPtr<Entity> &i_entity, const char *i_collisionFile )
 	\brief		Add collision entity to collisionEntityDatabase
 	\param		*i_entity entity to be added
-	\return		UINT8
-	\retval		index of the new added collision entity in database
+	\return		UINT32
+	\retval		handle of the new added collision entity
+	\retval		INVALID_HANDLE if the database is full
  ****************************************************************************************************
 */
-UINT8 GameEngine::Collision::AddCollisionEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity, const char *i_collisionFile )
+UINT32 GameEngine::Collision::AddCollisionEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity, const char *i_collisionFile )
 {
 	FUNCTION_START;
 
+	UINT32 u32Handle = collisionHandleTable->Add( collisionEntityDatabase->size() );
+	if( u32Handle == Utilities::INVALID_HANDLE )
+	{
+		DBG_MSG_LEVEL( D_ERR, "Collision entity database is full\n" );
+		FUNCTION_FINISH;
+		return Utilities::INVALID_HANDLE;
+	}
+
 	collisionEntityDatabase->push_back( new CollisionEntity(i_entity, i_collisionFile) );
 	collisionEntityDatabase->at(collisionEntityDatabase->size()-1)->m_collisionHandler = NULL;
 
+	Utilities::Pointer::SmartPtr<CollisionEntity> &newEntity = collisionEntityDatabase->back();
+	newEntity->m_u32Proxy = broadphase->AddProxy( newEntity->m_vGeometryMin, newEntity->m_vGeometryMax, u32Handle );
+	assert( newEntity->m_u32Proxy != Utilities::INVALID_PROXY );
+	SetSleeping( u32Handle, i_entity->m_isSleeping );
+
 	FUNCTION_FINISH;
-	return collisionEntityDatabase->size() - 1;
+	return u32Handle;
 }
 
 /**
  ****************************************************************************************************
-	\fn			void SetCollisionHandle( const UINT8 &i_index, CollisionHandler *i_collisionHandler )
-	\brief		Set collision entity to collisionEntityDatabase
-	\param		*i_entity entity to be added
+	\fn			void RemoveCollisionEntity( UINT32 &io_u32Handle )
+	\brief		Remove collision entity from collisionEntityDatabase
+	\param		io_u32Handle handle of the collision entity, set to INVALID_HANDLE once removed
 	\return		NONE
  ****************************************************************************************************
 */
-void GameEngine::Collision::SetCollisionHandler( const UINT8 &i_index, CollisionHandler *i_collisionHandler )
+void GameEngine::Collision::RemoveCollisionEntity( UINT32 &io_u32Handle )
 {
 	FUNCTION_START;
 
-	if( i_index < collisionEntityDatabase->size() )
-		collisionEntityDatabase->at(i_index)->m_collisionHandler = i_collisionHandler;
+	if( collisionHandleTable->IsValid(io_u32Handle) )
+	{
+		UINT32 u32Index = collisionHandleTable->GetIndex( io_u32Handle );
+		const CollisionEntity *removedEntity = &*collisionEntityDatabase->at( u32Index );
+
+		// Caches must not outlive the octree they point in
+		for( UINT32 i = 0; i < collisionEntityDatabase->size(); ++i )
+		{
+			if( collisionEntityDatabase->at(i)->m_downCacheEntity == removedEntity )
+				collisionEntityDatabase->at(i)->m_downCacheEntity = NULL;
+		}
+
+		SetSleeping( io_u32Handle, true );
+		broadphase->RemoveProxy( collisionEntityDatabase->at(u32Index)->m_u32Proxy );
+		if( IsDeterministic() )
+		{
+			// Keep the order the entities were added in, it decides which entity of a pair casts the rays
+			for( UINT32 i = u32Index + 1; i < collisionEntityDatabase->size(); ++i )
+				collisionHandleTable->SetIndex( collisionEntityDatabase->at(i)->m_entity->m_u32CollisionEntityHandle, i - 1 );
+			collisionHandleTable->Remove( io_u32Handle );
+			collisionEntityDatabase->erase( collisionEntityDatabase->begin() + u32Index );
+		}
+		else
+		{
+			collisionHandleTable->SetIndex( collisionEntityDatabase->back()->m_entity->m_u32CollisionEntityHandle, u32Index );
+			collisionHandleTable->Remove( io_u32Handle );
+			collisionEntityDatabase->at(u32Index) = collisionEntityDatabase->back();
+			collisionEntityDatabase->pop_back();
+		}
+	}
+
+	io_u32Handle = Utilities::INVALID_HANDLE;
 
 	FUNCTION_FINISH;
 }
 
 /**
  ****************************************************************************************************
-	\fn			void SetCollisionType( const E_COLLISION_BY &i_collisionBy )
-	\brief		Set collision detection type
-	\param		i_collisionBy collision detection type
+	\fn			void SetCollisionHandler( const UINT32 &i_u32Handle, CollisionHandler *i_collisionHandler )
+	\brief		Set collision handler of the collision entity
+	\param		i_u32Handle handle of the collision entity
+	\param		i_collisionHandler the collision handler
 	\return		NONE
  ****************************************************************************************************
 */
-void GameEngine::Collision::SetCollisionDetectionType( const E_COLLISION_BY &i_collisionBy )
+void GameEngine::Collision::SetCollisionHandler( const UINT32 &i_u32Handle, CollisionHandler *i_collisionHandler )
 {
-	eCollisionBy = i_collisionBy;
+	FUNCTION_START;
+
+	if( collisionHandleTable->IsValid(i_u32Handle) )
+		collisionEntityDatabase->at( collisionHandleTable->GetIndex(i_u32Handle) )->m_collisionHandler = i_collisionHandler;
+
+	FUNCTION_FINISH;
 }
 
-/****************************************************************************************************
-			Private function implementation
-****************************************************************************************************/
 /**
  ****************************************************************************************************
-	\fn			void RemoveDeadEntities( void )
-	\brief		Remove dead entities
-	\param		*i_entity entity to be added
+	\fn			void SetSleeping( const UINT32 &i_u32Handle, const bool &i_bSleeping )
+	\brief		Set whether the collision entity sleeps. A sleeping entity casts no ray and keeps its
+				broadphase bounds, it is only checked by the awake entities
+	\param		i_u32Handle handle of the collision entity
+	\param		i_bSleeping whether the entity sleeps
 	\return		NONE
  ****************************************************************************************************
 */
-void GameEngine::Collision::RemoveDeadEntities( void )
+void GameEngine::Collision::SetSleeping( const UINT32 &i_u32Handle, const bool &i_bSleeping )
 {
 	FUNCTION_START;
 
-	for( UINT8 i = 0; i < collisionEntityDatabase->size(); ++i )
+	if( collisionHandleTable->IsValid(i_u32Handle) )
 	{
-		collisionEntityDatabase->at(i)->m_downCollisionDistance = 0.0f;
-		collisionEntityDatabase->at(i)->m_forwardCollisionDistance = 0.0f;
-		collisionEntityDatabase->at(i)->m_downCollidedEntity = NULL;
-		collisionEntityDatabase->at(i)->m_forwardCollidedEntity = NULL;
+		CollisionEntity &entity = *collisionEntityDatabase->at( collisionHandleTable->GetIndex(i_u32Handle) );
 
-		if( collisionEntityDatabase->at(i)->m_entity->m_isDestroyed )
+		if( i_bSleeping && (entity.m_u32AwakeSlot != NO_ENTITY) )
 		{
-			collisionEntityDatabase->back()->m_entity->m_u8CollisionEntityIndex = collisionEntityDatabase->at(i)->m_entity->m_u8CollisionEntityIndex;
-			collisionEntityDatabase->at(i) = collisionEntityDatabase->back();
-			collisionEntityDatabase->pop_back();
+			awakeEntities->at( entity.m_u32AwakeSlot ) = awakeEntities->back();
+			collisionEntityDatabase->at( collisionHandleTable->GetIndex(awakeEntities->back()) )->m_u32AwakeSlot = entity.m_u32AwakeSlot;
+			awakeEntities->pop_back();
+			entity.m_u32AwakeSlot = NO_ENTITY;
+		}
+		else if( !i_bSleeping && (entity.m_u32AwakeSlot == NO_ENTITY) )
+		{
+			// Whatever hit it while it slept is stale
+			ClearResults( entity );
+			entity.m_u32AwakeSlot = awakeEntities->size();
+			awakeEntities->push_back( i_u32Handle );
 		}
+		broadphase->SetActive( entity.m_u32Proxy, !i_bSleeping );
 	}
 
 	FUNCTION_FINISH;
@@ -396,263 +683,1422 @@ void GameEngine::Collision::RemoveDeadEntities( void )
 
 /**
  ****************************************************************************************************
-	\fn			void CheckCollision( CollisionEntity &i_A, CollisionEntity &i_B, bool &i_bForwardDirection )
-	\brief		Move entities within boundary
-	\param		i_A first entity
-	\param		i_B second entity
-	\param		i_bForwardDirection
+	\fn			void SetCollisionType( const E_COLLISION_BY &i_collisionBy )
+	\brief		Set collision detection type
+	\param		i_collisionBy collision detection type
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Collision::SetCollisionDetectionType( const E_COLLISION_BY &i_collisionBy )
+{
+	eCollisionBy = i_collisionBy;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void CastRays( const S_RAY *i_rays, S_RAY_HIT *o_hits, const UINT32 &i_u32TotalRays )
+	\brief		Find the closest collision entity hit by every ray of a batch. The rays are sorted by
+				direction and start point, so rays traced by one job visit the same nodes, and the batch
+				is split across the workers
+	\param		i_rays the rays to be traced
+	\param		o_hits closest hit of every ray, in the order of the rays
+	\param		i_u32TotalRays total rays in the batch
 	\return		NONE
  ****************************************************************************************************
 */
-void GameEngine::Collision::CheckCollision( CollisionEntity &i_A, CollisionEntity &i_B, const bool i_bForwardDirection, \
-	Utilities::StringHash &o_hashedTag )
+void GameEngine::Collision::CastRays( const S_RAY *i_rays, S_RAY_HIT *o_hits, const UINT32 &i_u32TotalRays )
 {
-	D3DXVECTOR3 downCollisionPoint;
-	D3DXVECTOR3 forwardCollisionPoint;
-	bool AIsMoving = false;
-	bool BIsMoving = false;
-	float downCollisionDistance;
-	float forwardCollisionDistance;
+	PROFILE_UNSCOPED( "CastRays" );
 
 	FUNCTION_START;
 
-	// If i_A do not have collision with other object or if either of the object is to be destroyed in the end 
-	// of this frame do not do collision detection
-	if( (i_A.m_entity->m_u32CollisionMask == 0) || i_A.m_entity->m_isDestroyed || i_B.m_entity->m_isDestroyed )
+	TASK_CHECK_ACCESS( E_RESOURCE_COLLISION, E_RESOURCE_ENTITY );
+
+	if( i_u32TotalRays == 0 )
 	{
 		FUNCTION_FINISH;
 		return;
 	}
 
-	if( i_A.m_entity->m_v3Velocity.SquaredLength() > 0.0f )
-		AIsMoving = true;
-
-	if( i_B.m_entity->m_v3Velocity.SquaredLength() > 0.0f )
-		BIsMoving = true;
+	std::vector<S_RAY_RESULT> result( i_u32TotalRays );
+	TraceRays( i_rays, NULL, false, &result[0], i_u32TotalRays );
 
-	if( i_A.m_entity->m_u32CollisionMask & g_IDCreator::Get().IDtoBitMask(i_B.m_entity->m_u8EntityID) )
+	// Entity reference counts are not atomic, so the hits are handed out once every job is done
+	for( UINT32 i = 0; i < i_u32TotalRays; ++i )
 	{
-		bool bPrevDownRayCollided = false;
-		bool bPrevForwardRayCollided = false;
-		bool bThisDownRayTracingResult = false;
-		bool bThisForwardRayTracingResult = false;
-
-		D3DXVECTOR3 startPoint;
-		D3DXVECTOR3 endPoint;
-		D3DXVECTOR3 downPoint( i_A.m_entity->m_v3ProjectedPosition.X(),
-			i_A.m_entity->m_v3ProjectedPosition.Y() - i_A.m_entity->m_size.height, i_A.m_entity->m_v3ProjectedPosition.Z() );
-
-		if( i_bForwardDirection )
+		if( result[i].u32Entity != NO_ENTITY )
 		{
-			startPoint = D3DXVECTOR3( i_A.m_entity->m_v3Position.X(), i_A.m_entity->m_v3Position.Y(), i_A.m_entity->m_v3Position.Z() );
-			endPoint = D3DXVECTOR3( i_A.m_entity->m_v3ProjectedPosition.X(), i_A.m_entity->m_v3ProjectedPosition.Y(),
-				i_A.m_entity->m_v3ProjectedPosition.Z() );
-
-			if( !Utilities::Math::AreRelativelyEqual(i_A.m_forwardCollisionDistance, 0.0f) )
-				forwardCollisionDistance = i_A.m_forwardCollisionDistance;
-
-			if( i_A.m_forwardCollidedEntity != NULL )
-				bPrevForwardRayCollided = true;
+			o_hits[i].entity = collisionEntityDatabase->at( result[i].u32Entity )->m_entity;
+			o_hits[i].point = result[i].point;
+			o_hits[i].distance = result[i].distance;
+			o_hits[i].hashedTag = result[i].hashedTag;
 		}
 		else
 		{
-			startPoint = D3DXVECTOR3( i_A.m_entity->m_v3ProjectedPosition.X(), i_A.m_entity->m_v3ProjectedPosition.Y(),
-				i_A.m_entity->m_v3ProjectedPosition.Z() );
-			if( !Utilities::Math::AreRelativelyEqual(i_A.m_downCollisionDistance, 0.0f) )
-				downCollisionDistance = i_A.m_downCollisionDistance;
-
-			if( i_A.m_downCollidedEntity != NULL )
-				bPrevDownRayCollided = true;
+			o_hits[i].entity = NULL;
+			o_hits[i].point = i_rays[i].endPoint;
+			o_hits[i].distance = 1.0f;
+			o_hits[i].hashedTag = Utilities::StringHash( "" );
 		}
+	}
 
-		if( eCollisionBy == E_COLLISION_BY_MESH )
-		{
-			UINT32 u32TotalIndices = i_B.m_u32TotalPrimitives * 3;
-			for( UINT32 i = 0; i < u32TotalIndices; i += 3 )
-			{
-				if( i_bForwardDirection )
-				{
-					bThisForwardRayTracingResult |= Utilities::Math::RayTracing( startPoint, endPoint,
-						i_B.m_vertices[i_B.m_u16Indices[i]], i_B.m_vertices[i_B.m_u16Indices[i+1]], i_B.m_vertices[i_B.m_u16Indices[i+2]],
-						bPrevForwardRayCollided, forwardCollisionPoint, forwardCollisionDistance );
-					if( bThisForwardRayTracingResult )
-					{
-						if( !bPrevForwardRayCollided )
-							bPrevForwardRayCollided = true;
-					}
-				}
-				else
-				{
-					bThisDownRayTracingResult |= Utilities::Math::RayTracing( startPoint, downPoint,
-						i_B.m_vertices[i_B.m_u16Indices[i]], i_B.m_vertices[i_B.m_u16Indices[i+1]], i_B.m_vertices[i_B.m_u16Indices[i+2]],
-						bPrevDownRayCollided, downCollisionPoint, downCollisionDistance );
-					if( bThisDownRayTracingResult )
-					{
-						if( !bPrevDownRayCollided )
-							bPrevDownRayCollided = true;
-					}
-				}
-			}
-		}
-		else
-		{
-			std::vector<Utilities::S_TRIANGLE> collisionTriangle;
-			if( i_bForwardDirection )
-				i_B.m_octree->GetTriangleData( startPoint, endPoint, collisionTriangle );
-			else
-				i_B.m_octree->GetTriangleData( startPoint, downPoint, collisionTriangle );
+	FUNCTION_FINISH;
+}
 
-			UINT32 u32TotalTriangleData = collisionTriangle.size();
-			for( UINT32 i = 0; i < u32TotalTriangleData; ++i )
-			{
-				if( bShowCollisionWireframe )
-				{
-					g_debugMenu::Get().DrawLine( collisionTriangle[i].a, collisionTriangle[i].b );
-					g_debugMenu::Get().DrawLine( collisionTriangle[i].a, collisionTriangle[i].c );
-					g_debugMenu::Get().DrawLine( collisionTriangle[i].b, collisionTriangle[i].c );
-				}
+/**
+ ****************************************************************************************************
+	\fn			bool Sweep( const S_SWEEP &i_sweep, S_SWEEP_HIT &o_hit )
+	\brief		Find the first collision entity touched by a sphere or capsule moved along a segment.
+				Entities are culled by their geometry bounds grown by the size of the shape
+	\param		i_sweep the swept shape
+	\param		o_hit first contact of the sweep
+	\return		boolean
+	\retval		TRUE if the shape touches an entity
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+bool GameEngine::Collision::Sweep( const S_SWEEP &i_sweep, S_SWEEP_HIT &o_hit )
+{
+	PROFILE_UNSCOPED( "Sweep" );
+	D3DXVECTOR3 halfAxis = i_sweep.axis * 0.5f;
+	D3DXVECTOR3 vExtent( fabs(halfAxis.x) + i_sweep.radius, fabs(halfAxis.y) + i_sweep.radius, fabs(halfAxis.z) + i_sweep.radius );
+	Utilities::Math::S_SEGMENT segment;
+	Utilities::Math::S_SWEEP_HIT hit;
+	UINT32 u32Entity = NO_ENTITY;
 
-				if( i_bForwardDirection )
-				{
-					bThisForwardRayTracingResult |= Utilities::Math::RayTracing( startPoint, endPoint,
-						collisionTriangle[i].a, collisionTriangle[i].b, collisionTriangle[i].c,
-						bPrevForwardRayCollided, forwardCollisionPoint, forwardCollisionDistance );
-					if( bThisForwardRayTracingResult )
-					{
-						o_hashedTag = collisionTriangle[i].hashedTag;
-						if( !bPrevForwardRayCollided )
-							bPrevForwardRayCollided = true;
-					}
-				}
-				else
-				{
-					bThisDownRayTracingResult |= Utilities::Math::RayTracing( startPoint, downPoint,
-						collisionTriangle[i].a, collisionTriangle[i].b, collisionTriangle[i].c,
-						bPrevDownRayCollided, downCollisionPoint, downCollisionDistance );
-					if( bThisDownRayTracingResult )
-					{
-						if( collisionTriangle[i].hashedTag != Utilities::StringHash("") )
-							o_hashedTag = collisionTriangle[i].hashedTag;
-						if( !bPrevDownRayCollided )
-							bPrevDownRayCollided = true;
-					}
-				}
-			}
-		}
+	FUNCTION_START;
 
-		// Do not do collision resolution if in debug-camera-mode
-		if( Camera::m_bOnDebugCamera )
-		{
-			FUNCTION_FINISH;
-			return;
-		}
+	TASK_CHECK_ACCESS( E_RESOURCE_COLLISION, E_RESOURCE_ENTITY );
 
-		if( bThisForwardRayTracingResult )
-		{
-			if( (i_A.m_forwardCollidedEntity != i_B.m_entity) || (i_A.m_forwardCollisionDistance > forwardCollisionDistance) )
-			{
-				i_A.m_forwardCollidedEntity = i_B.m_entity;
-				i_A.m_forwardCollisionDistance = forwardCollisionDistance;
-				i_A.m_forwardCollisionPoint = forwardCollisionPoint;
-			}
+	hit.time = 1.0f;
+	Utilities::Math::SetSegment( segment, i_sweep.startPoint + halfAxis, i_sweep.endPoint + halfAxis );
 
-			if( i_B.m_forwardCollidedEntity != i_A.m_entity )
-			{
-				i_B.m_forwardCollidedEntity = i_A.m_entity;
-				i_B.m_forwardCollisionDistance = forwardCollisionDistance;
-				i_B.m_forwardCollisionPoint = forwardCollisionPoint;
-			}
-		}
+	for( UINT32 i = 0; i < collisionEntityDatabase->size(); ++i )
+	{
+		const CollisionEntity &entity = *collisionEntityDatabase->at( i );
+		Utilities::StringHash hashedTag;
+		float tEntry;
 
-		if( bThisDownRayTracingResult )
-		{
-			if( i_A.m_downCollidedEntity != i_B.m_entity )
-			{
-				i_A.m_downCollidedEntity = i_B.m_entity;
-				i_A.m_downCollisionDistance = downCollisionDistance;
-				i_A.m_downCollisionPoint = downCollisionPoint;
-			}
+		if( entity.m_entity->m_isDestroyed || !(i_sweep.u32CollisionMask & g_IDCreator::Get().IDtoBitMask(entity.m_entity->m_u8EntityID)) )
+			continue;
 
-			if( i_B.m_downCollidedEntity != i_A.m_entity )
-			{
-				i_B.m_downCollidedEntity = i_A.m_entity;
-				i_B.m_downCollisionDistance = downCollisionDistance;
-				i_B.m_downCollisionPoint = downCollisionPoint;
-			}
+		if( !Utilities::Math::SegmentBoxEntry(segment, entity.m_vGeometryMin - vExtent, entity.m_vGeometryMax + vExtent, tEntry)
+			|| (tEntry > hit.time) )
+			continue;
+
+		if( SweepEntity(entity, i_sweep.startPoint, i_sweep.endPoint, i_sweep.axis, i_sweep.radius, false, *triangleSpans, hit, hashedTag) )
+		{
+			u32Entity = i;
+			o_hit.hashedTag = hashedTag;
 		}
 	}
 
+	if( u32Entity == NO_ENTITY )
+	{
+		o_hit.entity = NULL;
+		o_hit.point = i_sweep.endPoint;
+		o_hit.normal = D3DXVECTOR3_ZERO;
+		o_hit.time = 1.0f;
+		o_hit.hashedTag = Utilities::StringHash( "" );
+		FUNCTION_FINISH;
+		return false;
+	}
+
+	o_hit.entity = collisionEntityDatabase->at( u32Entity )->m_entity;
+	o_hit.point = hit.point;
+	o_hit.normal = hit.normal;
+	o_hit.time = hit.time;
+
 	FUNCTION_FINISH;
+	return true;
 }
 
-/****************************************************************************************************
-			CollisionEntity class implementation
-****************************************************************************************************/
 /**
  ****************************************************************************************************
-	\fn			CollisionEntity( Pointer::SmartPtr<Entity> &i_entity, const char *i_collisionFile )
-	\brief		Default constructor of CollisionEntity
-	\param		i_entity pointer to common entity data
-	\param		i_collisionFile the file contain the information of the collision
+	\fn			void SetSweptShape( const UINT32 &i_u32Handle, const float &i_radius, const float &i_height )
+	\brief		Make the forward check of the collision entity sweep a capsule instead of tracing a
+				segment. The capsule goes from the position of the entity down by i_height, its handler
+				is then given the time of impact and the contact normal
+	\param		i_u32Handle handle of the collision entity
+	\param		i_radius radius of the capsule, zero goes back to the forward segment
+	\param		i_height distance between the centres of the capsule ends, zero for a sphere
 	\return		NONE
  ****************************************************************************************************
 */
-GameEngine::Collision::CollisionEntity::CollisionEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity,
-	const char *i_collisionFile ) :
-	m_downCollisionPoint( D3DXVECTOR3_ZERO ),
-	m_forwardCollisionPoint( D3DXVECTOR3_ZERO ),
-	m_downCollidedEntity( NULL ),
-	m_forwardCollidedEntity( NULL ),
-	m_entity( i_entity ),
-	m_collisionHandler( NULL ),
-	m_octree( NULL ),
-	m_u16Indices( NULL ),
-	m_vertices( NULL ),
-	m_u32TotalPrimitives( 0 ),
-	m_u32TotalVertices( 0 ),
-	m_downCollisionDistance( 0.0f ),
-	m_forwardCollisionDistance( 0.0f )
+void GameEngine::Collision::SetSweptShape( const UINT32 &i_u32Handle, const float &i_radius, const float &i_height )
 {
-	assert( i_collisionFile != NULL );
-	assert( i_collisionFile[0] != '\0' );
-
-	if( eCollisionBy == E_COLLISION_BY_MESH )
-	{
-		Utilities::S_NORMAL_MAP_VERTEX_DATA* vertexData;
-		Utilities::MeshParser meshData( i_collisionFile );
+	FUNCTION_START;
 
-		m_u32TotalPrimitives = meshData.m_u32TotalPrimitives;
-		m_u32TotalVertices = meshData.m_u32TotalVertices;
-		vertexData = new Utilities::S_NORMAL_MAP_VERTEX_DATA[m_u32TotalVertices];
-		m_u16Indices = new uint16_t[m_u32TotalPrimitives * 3];
-		m_vertices = new D3DXVECTOR3[m_u32TotalVertices];
-		meshData.GetVertexData( vertexData );
-		meshData.GetIndexData( m_u16Indices );
-		for( UINT32 i = 0; i < m_u32TotalVertices; ++i )
-			m_vertices[i] = vertexData[i].position;
+	assert( (i_radius >= 0.0f) && (i_height >= 0.0f) );
 
-		delete [] vertexData;
-	}
-	else
+	if( collisionHandleTable->IsValid(i_u32Handle) )
 	{
-		m_octree = new Octree( i_collisionFile );
+		CollisionEntity &entity = *collisionEntityDatabase->at( collisionHandleTable->GetIndex(i_u32Handle) );
+		entity.m_sweepRadius = i_radius;
+		entity.m_sweepHeight = i_height;
 	}
+
+	FUNCTION_FINISH;
 }
 
+/****************************************************************************************************
+			Private function implementation
+****************************************************************************************************/
 /**
  ****************************************************************************************************
-	\fn			~CollisionEntity( void )
-	\brief		Default destructor of CollisionEntity
+	\fn			bool IsIdle( void )
+	\brief		Check whether there is nothing for collision to update this step
 	\param		NONE
+	\return		boolean
+	\retval		TRUE if there is no entity, or a single one and no collision mesh to draw
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+bool GameEngine::Collision::IsIdle( void )
+{
+	return (collisionEntityDatabase->size() == 0)
+		|| (!bShowCollisionWireframe && (collisionEntityDatabase->size() == 1));
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void CheckCollision( CollisionEntity &i_A, CollisionEntity &i_B )
+	\brief		Sweep the capsule of i_A along its forward move against i_B
+	\param		i_A the swept entity
+	\param		i_B the entity to be hit
 	\return		NONE
  ****************************************************************************************************
 */
-GameEngine::Collision::CollisionEntity::~CollisionEntity( void )
+void GameEngine::Collision::CheckCollision( CollisionEntity &i_A, CollisionEntity &i_B )
 {
 	FUNCTION_START;
 
-	m_entity = NULL;
-	m_forwardCollidedEntity = NULL;
+	// If i_A do not have collision with other object or if either of the object is to be destroyed in the end 
+	// of this frame do not do collision detection
+	if( (i_A.m_entity->m_u32CollisionMask == 0) || i_A.m_entity->m_isDestroyed || i_B.m_entity->m_isDestroyed )
+	{
+		FUNCTION_FINISH;
+		return;
+	}
+
+	if( i_A.m_entity->m_u32CollisionMask & g_IDCreator::Get().IDtoBitMask(i_B.m_entity->m_u8EntityID) )
+	{
+		D3DXVECTOR3 startPoint( i_A.m_entity->m_v3Position.X(), i_A.m_entity->m_v3Position.Y(), i_A.m_entity->m_v3Position.Z() );
+		D3DXVECTOR3 endPoint( i_A.m_entity->m_v3ProjectedPosition.X(), i_A.m_entity->m_v3ProjectedPosition.Y(),
+			i_A.m_entity->m_v3ProjectedPosition.Z() );
+		D3DXVECTOR3 axis( 0.0f, i_A.m_sweepHeight, 0.0f );
+		Utilities::Math::S_SWEEP_HIT sweepHit;
+		Utilities::StringHash hashedTag;
+
+		sweepHit.time = 1.0f;
+		if( i_A.m_forwardCollidedEntity && !Utilities::Math::AreRelativelyEqual(i_A.m_forwardCollisionDistance, 0.0f) )
+			sweepHit.time = i_A.m_forwardCollisionDistance;
+
+		// Do not do collision resolution if in debug-camera-mode
+		if( SweepEntity(i_B, startPoint - axis, endPoint - axis, axis, i_A.m_sweepRadius, true, *triangleSpans, sweepHit, hashedTag)
+			&& !Camera::m_bOnDebugCamera )
+			RecordForwardHit( i_A, i_B, sweepHit.point, sweepHit.normal, sweepHit.time, hashedTag );
+	}
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void UpdateBroadphase( void )
+	\brief		Refresh the broadphase bounds of the awake collision entities and rebuild their candidate
+				lists from the pairs with an awake entity. A sleeping entity overlapped by an awake
+				physics entity is woken up, its pairs with other sleeping entities are then added too
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Collision::UpdateBroadphase( void )
+{
+	std::vector<UINT32>::const_iterator iter;
+	std::vector<Utilities::SweepAndPrune::S_OVERLAPPING_PAIR>::const_iterator iterPair;
+
+	FUNCTION_START;
+
+	// The bounds of a sleeping entity are the ones it was put to sleep with
+	GetAwakeIndices();
+	for( iter = awakeIndices->begin(); iter != awakeIndices->end(); ++iter )
+	{
+		CollisionEntity &entity = *collisionEntityDatabase->at( *iter );
+
+		GetQueryBounds( entity, entity.m_vBroadphaseMin, entity.m_vBroadphaseMax );
+		broadphase->SetBounds( entity.m_u32Proxy, entity.m_vBroadphaseMin, entity.m_vBroadphaseMax );
+	}
+	broadphase->Update();
+
+	broadphase->GetActivePairs( *overlappingPairs );
+	const UINT32 u32TotalAwake = awakeEntities->size();
+	for( iterPair = overlappingPairs->begin(); iterPair != overlappingPairs->end(); ++iterPair )
+	{
+		Utilities::Pointer::SmartPtr<Entity> &entityA = collisionEntityDatabase->at( collisionHandleTable->GetIndex(iterPair->u32UserDataA) )->m_entity;
+		Utilities::Pointer::SmartPtr<Entity> &entityB = collisionEntityDatabase->at( collisionHandleTable->GetIndex(iterPair->u32UserDataB) )->m_entity;
+
+		if( entityA->m_isSleeping && (entityB->m_u32PhysicsEntityHandle != Utilities::INVALID_HANDLE) )
+			Physics::WakeUp( entityA->m_u32PhysicsEntityHandle );
+		else if( entityB->m_isSleeping && (entityA->m_u32PhysicsEntityHandle != Utilities::INVALID_HANDLE) )
+			Physics::WakeUp( entityB->m_u32PhysicsEntityHandle );
+	}
+	if( awakeEntities->size() != u32TotalAwake )
+	{
+		GetAwakeIndices();
+		broadphase->GetActivePairs( *overlappingPairs );
+	}
+
+	for( iter = awakeIndices->begin(); iter != awakeIndices->end(); ++iter )
+		collisionEntityDatabase->at( *iter )->m_candidates.clear();
+
+	for( iterPair = overlappingPairs->begin(); iterPair != overlappingPairs->end(); ++iterPair )
+	{
+		UINT32 u32IndexA = collisionHandleTable->GetIndex( iterPair->u32UserDataA );
+		UINT32 u32IndexB = collisionHandleTable->GetIndex( iterPair->u32UserDataB );
+
+		// Only the later entity is checked by the earlier one, same as the brute force order. A sleeping
+		// entity does not check its candidates
+		if( u32IndexA > u32IndexB )
+			std::swap( u32IndexA, u32IndexB );
+		if( !collisionEntityDatabase->at(u32IndexA)->m_entity->m_isSleeping )
+			collisionEntityDatabase->at( u32IndexA )->m_candidates.push_back( u32IndexB );
+	}
+
+	for( iter = awakeIndices->begin(); iter != awakeIndices->end(); ++iter )
+	{
+		std::vector<UINT32> &candidates = collisionEntityDatabase->at( *iter )->m_candidates;
+		std::sort( candidates.begin(), candidates.end() );
+	}
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void GetAwakeIndices( void )
+	\brief		Get the database index of every awake entity, in database order so the earlier entity of
+				a pair still casts the rays
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Collision::GetAwakeIndices( void )
+{
+	std::vector<UINT32>::const_iterator iter;
+
+	FUNCTION_START;
+
+	awakeIndices->clear();
+	for( iter = awakeEntities->begin(); iter != awakeEntities->end(); ++iter )
+		awakeIndices->push_back( collisionHandleTable->GetIndex(*iter) );
+	std::sort( awakeIndices->begin(), awakeIndices->end() );
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void ClearResults( CollisionEntity &io_entity )
+	\brief		Clear the forward and down collision found for the entity
+	\param		io_entity the collision entity
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Collision::ClearResults( CollisionEntity &io_entity )
+{
+	FUNCTION_START;
+
+	io_entity.m_downCollidedEntity = NULL;
+	io_entity.m_downCollisionDistance = 0.0f;
+	io_entity.m_downCollisionPoint = D3DXVECTOR3_ZERO;
+	io_entity.m_forwardCollidedEntity = NULL;
+	io_entity.m_forwardCollisionDistance = 0.0f;
+	io_entity.m_forwardCollisionPoint = D3DXVECTOR3_ZERO;
+	io_entity.m_forwardCollisionNormal = D3DXVECTOR3_ZERO;
+	io_entity.m_forwardHashedTag = Utilities::StringHash( "" );
+	io_entity.m_downHashedTag = Utilities::StringHash( "" );
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void GetQueryBounds( const CollisionEntity &i_entity, D3DXVECTOR3 &o_vMin, D3DXVECTOR3 &o_vMax )
+	\brief		Get the bounds of the collision geometry of the entity extended by the end points of the
+				forward and down rays it casts and by its swept shape
+	\param		i_entity the collision entity
+	\param		o_vMin minimum corner of the bounds
+	\param		o_vMax maximum corner of the bounds
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Collision::GetQueryBounds( const CollisionEntity &i_entity, D3DXVECTOR3 &o_vMin, D3DXVECTOR3 &o_vMax )
+{
+	FUNCTION_START;
+
+	o_vMin = i_entity.m_vGeometryMin;
+	o_vMax = i_entity.m_vGeometryMax;
+
+	// Entities without handler or mask never cast rays, only their geometry can be hit
+	if( i_entity.m_collisionHandler && (i_entity.m_entity->m_u32CollisionMask != 0) )
+	{
+		D3DXVECTOR3 position( i_entity.m_entity->m_v3Position.X(), i_entity.m_entity->m_v3Position.Y(),
+			i_entity.m_entity->m_v3Position.Z() );
+		D3DXVECTOR3 projectedPosition( i_entity.m_entity->m_v3ProjectedPosition.X(), i_entity.m_entity->m_v3ProjectedPosition.Y(),
+			i_entity.m_entity->m_v3ProjectedPosition.Z() );
+		D3DXVECTOR3 downPoint( projectedPosition.x, projectedPosition.y - i_entity.m_entity->m_size.height, projectedPosition.z );
+
+		D3DXVec3Minimize( &o_vMin, &o_vMin, &position );
+		D3DXVec3Minimize( &o_vMin, &o_vMin, &projectedPosition );
+		D3DXVec3Minimize( &o_vMin, &o_vMin, &downPoint );
+		D3DXVec3Maximize( &o_vMax, &o_vMax, &position );
+		D3DXVec3Maximize( &o_vMax, &o_vMax, &projectedPosition );
+		D3DXVec3Maximize( &o_vMax, &o_vMax, &downPoint );
+
+		// The swept capsule reaches the radius around its path and the height below it
+		if( i_entity.m_sweepRadius > 0.0f )
+		{
+			o_vMin -= D3DXVECTOR3( i_entity.m_sweepRadius, i_entity.m_sweepRadius + i_entity.m_sweepHeight, i_entity.m_sweepRadius );
+			o_vMax += D3DXVECTOR3( i_entity.m_sweepRadius, i_entity.m_sweepRadius, i_entity.m_sweepRadius );
+		}
+	}
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void CheckCandidates( const UINT32 &i_u32Index )
+	\brief		Sweep the shape of an entity against the later entities its broadphase bounds overlap.
+				Collision handling moves the entity between checks, once its sweep leaves the bounds given
+				to the broadphase every later entity with overlapping bounds is checked instead
+	\param		i_u32Index index of the entity in the database
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Collision::CheckCandidates( const UINT32 &i_u32Index )
+{
+	CollisionEntity &entity = *collisionEntityDatabase->at( i_u32Index );
+	D3DXVECTOR3 vMin;
+	D3DXVECTOR3 vMax;
+
+	FUNCTION_START;
+
+	GetQueryBounds( entity, vMin, vMax );
+	if( (vMin.x >= entity.m_vBroadphaseMin.x) && (vMin.y >= entity.m_vBroadphaseMin.y) && (vMin.z >= entity.m_vBroadphaseMin.z)
+		&& (vMax.x <= entity.m_vBroadphaseMax.x) && (vMax.y <= entity.m_vBroadphaseMax.y) && (vMax.z <= entity.m_vBroadphaseMax.z) )
+	{
+		std::vector<UINT32>::const_iterator iter;
+		for( iter = entity.m_candidates.begin(); iter != entity.m_candidates.end(); ++iter )
+			CheckCollision( entity, *collisionEntityDatabase->at(*iter) );
+	}
+	else
+	{
+		for( UINT32 i = i_u32Index + 1; i < collisionEntityDatabase->size(); ++i )
+		{
+			CollisionEntity &other = *collisionEntityDatabase->at( i );
+			if( (vMin.x <= other.m_vBroadphaseMax.x) && (vMax.x >= other.m_vBroadphaseMin.x)
+				&& (vMin.y <= other.m_vBroadphaseMax.y) && (vMax.y >= other.m_vBroadphaseMin.y)
+				&& (vMin.z <= other.m_vBroadphaseMax.z) && (vMax.z >= other.m_vBroadphaseMin.z) )
+				CheckCollision( entity, other );
+		}
+	}
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool IsCastingRays( const CollisionEntity &i_entity )
+	\brief		Check whether the entity casts the forward and down rays this step
+	\param		i_entity the collision entity
+	\return		boolean
+	\retval		TRUE if it has a handler and is not to be destroyed
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+bool GameEngine::Collision::IsCastingRays( const CollisionEntity &i_entity )
+{
+	return i_entity.m_collisionHandler && !i_entity.m_entity->m_isDestroyed;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void AddEntityRay( const UINT32 &i_u32Index, const bool i_bDownRay )
+	\brief		Add the forward or down ray of an entity to the batch of entity rays. The forward ray goes
+				from the position to the projected position, the down ray from the projected position
+				down by the height of the entity
+	\param		i_u32Index index of the entity in the database
+	\param		i_bDownRay whether the down ray is added
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Collision::AddEntityRay( const UINT32 &i_u32Index, const bool i_bDownRay )
+{
+	const Entity &entity = *collisionEntityDatabase->at( i_u32Index )->m_entity;
+	D3DXVECTOR3 projectedPosition( entity.m_v3ProjectedPosition.X(), entity.m_v3ProjectedPosition.Y(), entity.m_v3ProjectedPosition.Z() );
+	S_RAY ray;
+
+	FUNCTION_START;
+
+	if( i_bDownRay )
+	{
+		ray.startPoint = projectedPosition;
+		ray.endPoint = D3DXVECTOR3( projectedPosition.x, projectedPosition.y - entity.m_size.height, projectedPosition.z );
+	}
+	else
+	{
+		ray.startPoint = D3DXVECTOR3( entity.m_v3Position.X(), entity.m_v3Position.Y(), entity.m_v3Position.Z() );
+		ray.endPoint = projectedPosition;
+	}
+	ray.u32CollisionMask = entity.m_u32CollisionMask;
+
+	entityRays->push_back( ray );
+	rayCasters->push_back( i_u32Index );
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void TraceEntityRays( const bool i_bDownRays )
+	\brief		Trace the batch of entity rays and record every hit on both the caster and the entity
+				hit, in the order the rays were added
+	\param		i_bDownRays whether the batch holds down rays
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Collision::TraceEntityRays( const bool i_bDownRays )
+{
+	FUNCTION_START;
+
+	if( entityRays->empty() )
+	{
+		FUNCTION_FINISH;
+		return;
+	}
+
+	rayResults->resize( entityRays->size() );
+	TraceRays( &entityRays->at(0), &rayCasters->at(0), i_bDownRays, &rayResults->at(0), entityRays->size() );
+
+	for( UINT32 i = 0; i < rayResults->size(); ++i )
+	{
+		const S_RAY_RESULT &result = rayResults->at( i );
+
+		u32DownCacheHits += result.u32DownCacheHits;
+		u32DownCacheMisses += result.u32DownCacheMisses;
+
+		// Do not do collision resolution if in debug-camera-mode
+		if( (result.u32Entity == NO_ENTITY) || Camera::m_bOnDebugCamera )
+			continue;
+
+		CollisionEntity &A = *collisionEntityDatabase->at( rayCasters->at(i) );
+		CollisionEntity &B = *collisionEntityDatabase->at( result.u32Entity );
+		if( i_bDownRays )
+			RecordDownHit( A, B, result.point, result.distance, result.hashedTag );
+		else
+			RecordForwardHit( A, B, result.point, D3DXVECTOR3_ZERO, result.distance, result.hashedTag );
+	}
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void CheckForward( const UINT32 &i_u32Index )
+	\brief		Check the forward collision of a single entity again after its handler moved it
+	\param		i_u32Index index of the entity in the database
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Collision::CheckForward( const UINT32 &i_u32Index )
+{
+	FUNCTION_START;
+
+	if( collisionEntityDatabase->at(i_u32Index)->m_sweepRadius > 0.0f )
+	{
+		CheckCandidates( i_u32Index );
+	}
+	else
+	{
+		entityRays->clear();
+		rayCasters->clear();
+		AddEntityRay( i_u32Index, false );
+		TraceEntityRays( false );
+	}
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void RecordForwardHit( CollisionEntity &io_A, CollisionEntity &io_B, const D3DXVECTOR3 &i_point,
+					const D3DXVECTOR3 &i_normal, const float &i_distance, const Utilities::StringHash &i_hashedTag )
+	\brief		Record the forward hit of io_A on io_B. io_A keeps its closest hit, io_B is told it has
+				been hit by io_A unless it already was
+	\param		io_A the entity casting the ray or sweeping its shape
+	\param		io_B the entity that has been hit
+	\param		i_point the collision point
+	\param		i_normal contact normal towards io_A, zero for rays
+	\param		i_distance fraction of the move where io_B is hit
+	\param		i_hashedTag hashed tag of the collided triangle
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Collision::RecordForwardHit( CollisionEntity &io_A, CollisionEntity &io_B, const D3DXVECTOR3 &i_point,
+	const D3DXVECTOR3 &i_normal, const float &i_distance, const Utilities::StringHash &i_hashedTag )
+{
+	FUNCTION_START;
+
+	if( !io_A.m_forwardCollidedEntity || (io_A.m_forwardCollisionDistance > i_distance) )
+	{
+		io_A.m_forwardCollidedEntity = io_B.m_entity;
+		io_A.m_forwardCollisionDistance = i_distance;
+		io_A.m_forwardCollisionPoint = i_point;
+		io_A.m_forwardCollisionNormal = i_normal;
+		io_A.m_forwardHashedTag = i_hashedTag;
+	}
+
+	if( !(io_B.m_forwardCollidedEntity == io_A.m_entity) )
+	{
+		io_B.m_forwardCollidedEntity = io_A.m_entity;
+		io_B.m_forwardCollisionDistance = i_distance;
+		io_B.m_forwardCollisionPoint = i_point;
+		io_B.m_forwardCollisionNormal = -i_normal;
+		io_B.m_forwardHashedTag = Utilities::StringHash( "" );
+	}
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void RecordDownHit( CollisionEntity &io_A, CollisionEntity &io_B, const D3DXVECTOR3 &i_point,
+					const float &i_distance, const Utilities::StringHash &i_hashedTag )
+	\brief		Record the down hit of io_A on io_B. io_A keeps its closest hit, io_B is told it has been
+				hit by io_A unless it already was
+	\param		io_A the entity casting the ray
+	\param		io_B the entity that has been hit
+	\param		i_point the collision point
+	\param		i_distance fraction of the ray where io_B is hit
+	\param		i_hashedTag hashed tag of the collided triangle
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Collision::RecordDownHit( CollisionEntity &io_A, CollisionEntity &io_B, const D3DXVECTOR3 &i_point,
+	const float &i_distance, const Utilities::StringHash &i_hashedTag )
+{
+	FUNCTION_START;
+
+	if( !io_A.m_downCollidedEntity || (io_A.m_downCollisionDistance > i_distance) )
+	{
+		io_A.m_downCollidedEntity = io_B.m_entity;
+		io_A.m_downCollisionDistance = i_distance;
+		io_A.m_downCollisionPoint = i_point;
+		io_A.m_downHashedTag = i_hashedTag;
+	}
+
+	if( !(io_B.m_downCollidedEntity == io_A.m_entity) )
+	{
+		io_B.m_downCollidedEntity = io_A.m_entity;
+		io_B.m_downCollisionDistance = i_distance;
+		io_B.m_downCollisionPoint = i_point;
+		io_B.m_downHashedTag = Utilities::StringHash( "" );
+	}
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void TraceRays( const S_RAY *i_rays, const UINT32 *i_u32Casters, const bool i_bDownRays,
+					S_RAY_RESULT *o_results, const UINT32 &i_u32TotalRays )
+	\brief		Find the closest collision entity hit by every ray of a batch. The rays are sorted by
+				direction and start point, so rays traced by one job visit the same nodes, and the batch
+				is split across the workers. Rays cast by an entity only test the entities after it in
+				the database, the earlier ones have already recorded their hits on it
+	\param		i_rays the rays to be traced
+	\param		i_u32Casters database index of the entity casting each ray, NULL if the rays are not
+				cast by entities
+	\param		i_bDownRays whether the rays are the down rays of their casters
+	\param		o_results closest hit of every ray, in the order of the rays
+	\param		i_u32TotalRays total rays in the batch, not zero
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Collision::TraceRays( const S_RAY *i_rays, const UINT32 *i_u32Casters, const bool i_bDownRays,
+	S_RAY_RESULT *o_results, const UINT32 &i_u32TotalRays )
+{
+	S_CAST_RAYS_JOB_DATA jobData;
+
+	FUNCTION_START;
+
+	assert( i_u32TotalRays > 0 );
+
+	// One spare entry keeps the array valid when the database is empty
+	std::vector<UINT32> entityBitMask( collisionEntityDatabase->size() + 1, 0 );
+	for( UINT32 i = 0; i < collisionEntityDatabase->size(); ++i )
+	{
+		const Entity &entity = *collisionEntityDatabase->at( i )->m_entity;
+		if( !entity.m_isDestroyed )
+			entityBitMask[i] = g_IDCreator::Get().IDtoBitMask( entity.m_u8EntityID );
+	}
+
+	// Quantize the start points inside the bounds of the batch for the order key
+	D3DXVECTOR3 vMin = i_rays[0].startPoint;
+	D3DXVECTOR3 vMax = i_rays[0].startPoint;
+	for( UINT32 i = 1; i < i_u32TotalRays; ++i )
+	{
+		D3DXVec3Minimize( &vMin, &vMin, &i_rays[i].startPoint );
+		D3DXVec3Maximize( &vMax, &vMax, &i_rays[i].startPoint );
+	}
+	D3DXVECTOR3 vScale( 0.0f, 0.0f, 0.0f );
+	for( UINT8 i = 0; i < 3; ++i )
+	{
+		if( vMax[i] > vMin[i] )
+			vScale[i] = 511.0f / (vMax[i] - vMin[i]);
+	}
+
+	std::vector<UINT64> sortKey( i_u32TotalRays );
+	for( UINT32 i = 0; i < i_u32TotalRays; ++i )
+		sortKey[i] = (static_cast<UINT64>( GetRayOrderKey(i_rays[i], vMin, vScale) ) << 32) | i;
+	std::sort( sortKey.begin(), sortKey.end() );
+
+	std::vector<UINT32> order( i_u32TotalRays );
+	for( UINT32 i = 0; i < i_u32TotalRays; ++i )
+		order[i] = static_cast<UINT32>( sortKey[i] );
+
+	jobData.ray = i_rays;
+	jobData.u32Order = &order[0];
+	jobData.u32EntityBitMask = &entityBitMask[0];
+	jobData.u32Caster = i_u32Casters;
+	jobData.result = o_results;
+	jobData.bDownRays = i_bDownRays && (i_u32Casters != NULL);
+	// The octree nodes of the entity rays are drawn with the collision meshes, which only the calling thread can do
+	jobData.bDebugDraw = (i_u32Casters != NULL) && bShowCollisionWireframe;
+	if( jobData.bDebugDraw )
+		CastRayRange( &jobData, 0, i_u32TotalRays );
+	else
+		Utilities::JobSystem::ParallelFor( CastRayRange, &jobData, i_u32TotalRays, CAST_RAYS_GRAIN_SIZE );
+
+	FUNCTION_FINISH;
+}
+
+
+/**
+ ****************************************************************************************************
+	\fn			bool TraceSegment( const CollisionEntity &i_entity, const D3DXVECTOR3 &i_startPoint,
+					const D3DXVECTOR3 &i_endPoint, const bool i_bDebugDraw,
+					std::vector<Octree::S_TRIANGLE_SPAN> &io_triangleSpans, D3DXVECTOR3 &o_collisionPoint,
+					float &io_collisionDistance, Utilities::StringHash &o_hashedTag, UINT32 &o_u32Node )
+	\brief		Find the closest triangle of the entity hit by the segment. It is called from worker
+				threads by CastRays, so it only touches the given scratch and never draws unless asked to
+	\param		i_entity the collision entity to be hit
+	\param		i_startPoint start point of the segment
+	\param		i_endPoint end point of the segment
+	\param		i_bDebugDraw whether the collision wireframe and octree nodes may be drawn
+	\param		io_triangleSpans scratch of the octree query
+	\param		o_collisionPoint collision point, set only on a hit
+	\param		io_collisionDistance only hits closer than this fraction are taken, set to the hit
+	\param		o_hashedTag hashed tag of the collided triangle, set only on a hit in the octree
+	\param		o_u32Node octree node of the collided triangle, set only on a hit in the octree
+	\return		boolean
+	\retval		TRUE if the segment hits the entity
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+bool GameEngine::Collision::TraceSegment( const CollisionEntity &i_entity, const D3DXVECTOR3 &i_startPoint,
+	const D3DXVECTOR3 &i_endPoint, const bool i_bDebugDraw, std::vector<Octree::S_TRIANGLE_SPAN> &io_triangleSpans,
+	D3DXVECTOR3 &o_collisionPoint, float &io_collisionDistance, Utilities::StringHash &o_hashedTag, UINT32 &o_u32Node )
+{
+	FUNCTION_START;
+
+	if( eCollisionBy == E_COLLISION_BY_MESH )
+	{
+		bool bResult = i_entity.m_bvh->RayTracing( i_startPoint, i_endPoint, true, o_collisionPoint, io_collisionDistance );
+		FUNCTION_FINISH;
+		return bResult;
+	}
+
+	io_triangleSpans.clear();
+	i_entity.m_octree->GetTriangleSpans( i_startPoint, i_endPoint, io_triangleSpans, i_bDebugDraw );
+
+	bool bResult = TraceSpans( i_entity, i_startPoint, i_endPoint, i_bDebugDraw, io_triangleSpans, o_collisionPoint,
+		io_collisionDistance, o_hashedTag, o_u32Node );
+
+	FUNCTION_FINISH;
+	return bResult;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool TraceSpans( const CollisionEntity &i_entity, const D3DXVECTOR3 &i_startPoint,
+					const D3DXVECTOR3 &i_endPoint, const bool i_bDebugDraw,
+					const std::vector<Octree::S_TRIANGLE_SPAN> &i_triangleSpans, D3DXVECTOR3 &o_collisionPoint,
+					float &io_collisionDistance, Utilities::StringHash &o_hashedTag, UINT32 &o_u32Node )
+	\brief		Find the closest triangle of the octree spans hit by the segment
+	\param		i_entity the collision entity the spans belong to
+	\param		i_startPoint start point of the segment
+	\param		i_endPoint end point of the segment
+	\param		i_bDebugDraw whether the collision wireframe may be drawn
+	\param		i_triangleSpans the spans, sorted by their entry
+	\param		o_collisionPoint collision point, set only on a hit
+	\param		io_collisionDistance only hits closer than this fraction are taken, set to the hit
+	\param		o_hashedTag hashed tag of the collided triangle, set only on a hit
+	\param		o_u32Node octree node of the collided triangle, set only on a hit
+	\return		boolean
+	\retval		TRUE if the segment hits a triangle
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+bool GameEngine::Collision::TraceSpans( const CollisionEntity &i_entity, const D3DXVECTOR3 &i_startPoint,
+	const D3DXVECTOR3 &i_endPoint, const bool i_bDebugDraw, const std::vector<Octree::S_TRIANGLE_SPAN> &i_triangleSpans,
+	D3DXVECTOR3 &o_collisionPoint, float &io_collisionDistance, Utilities::StringHash &o_hashedTag, UINT32 &o_u32Node )
+{
+	const Octree::S_TRIANGLE_SPAN *collidedSpan = NULL;
+	UINT32 u32CollidedTriangle = 0;
+	Utilities::Math::S_TRIANGLE_PACKET trianglePacket;
+	Utilities::Math::S_RAY_HIT hit;
+
+	FUNCTION_START;
+
+	hit.distance = io_collisionDistance;
+
+	std::vector<Octree::S_TRIANGLE_SPAN>::const_iterator iterSpan;
+	for( iterSpan = i_triangleSpans.begin(); iterSpan != i_triangleSpans.end(); ++iterSpan )
+	{
+		// Spans are sorted by their entry, none of the remaining nodes can be closer
+		if( iterSpan->tEntry > hit.distance )
+			break;
+
+		for( UINT32 i = 0; i < iterSpan->u32TotalData; i += Utilities::Math::TRIANGLE_PACKET_SIZE )
+		{
+			i_entity.m_octree->GetTrianglePacket( *iterSpan, i, trianglePacket );
+
+			if( i_bDebugDraw && bShowCollisionWireframe )
+			{
+				for( UINT32 j = 0; (j < Utilities::Math::TRIANGLE_PACKET_SIZE) && (i + j < iterSpan->u32TotalData); ++j )
+				{
+					D3DXVECTOR3 a;
+					D3DXVECTOR3 b;
+					D3DXVECTOR3 c;
+
+					i_entity.m_octree->GetTriangle( *iterSpan, i + j, a, b, c );
+					g_debugMenu::Get().DrawLine( a, b );
+					g_debugMenu::Get().DrawLine( a, c );
+					g_debugMenu::Get().DrawLine( b, c );
+				}
+			}
+
+			if( Utilities::Math::RayTracing(i_startPoint, i_endPoint, trianglePacket, hit) )
+			{
+				collidedSpan = &*iterSpan;
+				u32CollidedTriangle = i + hit.u32Triangle;
+			}
+		}
+	}
+
+	if( !collidedSpan )
+	{
+		FUNCTION_FINISH;
+		return false;
+	}
+
+	o_collisionPoint = hit.point;
+	io_collisionDistance = hit.distance;
+	o_hashedTag = i_entity.m_octree->GetTag( *collidedSpan, u32CollidedTriangle );
+	o_u32Node = collidedSpan->u32Node;
+
+	FUNCTION_FINISH;
+	return true;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool IsInsideDownCache( const CollisionEntity &i_A, const CollisionEntity &i_B,
+					const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint )
+	\brief		Check whether the down ray of i_A against i_B can be traced against the cached spans
+	\param		i_A the entity casting the ray
+	\param		i_B the entity to be hit
+	\param		i_startPoint start point of the down ray
+	\param		i_endPoint end point of the down ray
+	\return		boolean
+	\retval		TRUE if the cache is of i_B and the ray is inside the cache box
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+bool GameEngine::Collision::IsInsideDownCache( const CollisionEntity &i_A, const CollisionEntity &i_B, const D3DXVECTOR3 &i_startPoint,
+	const D3DXVECTOR3 &i_endPoint )
+{
+	if( (i_A.m_downCacheEntity != &i_B) || (eCollisionBy == E_COLLISION_BY_MESH) )
+		return false;
+
+	// The box is convex, so the ray is inside once both of its ends are
+	for( UINT8 i = 0; i < 3; ++i )
+	{
+		if( (i_startPoint[i] <= i_A.m_vDownCacheMin[i]) || (i_startPoint[i] >= i_A.m_vDownCacheMax[i])
+			|| (i_endPoint[i] <= i_A.m_vDownCacheMin[i]) || (i_endPoint[i] >= i_A.m_vDownCacheMax[i]) )
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void FillDownCache( CollisionEntity &io_A, const CollisionEntity &i_B, const UINT32 &i_u32Node,
+					const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint )
+	\brief		Cache the triangles around the node of the last down hit of io_A. The cache is kept only
+				if it is small and the down ray is inside the node, otherwise it would never be used
+	\param		io_A the entity casting the ray
+	\param		i_B the entity that has been hit
+	\param		i_u32Node octree node of the hit triangle
+	\param		i_startPoint start point of the down ray
+	\param		i_endPoint end point of the down ray
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Collision::FillDownCache( CollisionEntity &io_A, const CollisionEntity &i_B, const UINT32 &i_u32Node,
+	const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint )
+{
+	FUNCTION_START;
+
+	UINT32 u32TotalTriangles = i_B.m_octree->GetLocalSpans( i_u32Node, io_A.m_downCacheSpans, io_A.m_vDownCacheMin, io_A.m_vDownCacheMax );
+	float margin = (io_A.m_vDownCacheMax.x - io_A.m_vDownCacheMin.x) * DOWN_CACHE_MARGIN;
+
+	io_A.m_vDownCacheMin += D3DXVECTOR3( margin, margin, margin );
+	io_A.m_vDownCacheMax -= D3DXVECTOR3( margin, margin, margin );
+	io_A.m_downCacheEntity = &i_B;
+
+	if( (u32TotalTriangles > MAX_DOWN_CACHE_TRIANGLES) || !IsInsideDownCache(io_A, i_B, i_startPoint, i_endPoint) )
+	{
+		io_A.m_downCacheEntity = NULL;
+		io_A.m_downCacheSpans.clear();
+	}
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool SweepEntity( const CollisionEntity &i_entity, const D3DXVECTOR3 &i_startPoint,
+					const D3DXVECTOR3 &i_endPoint, const D3DXVECTOR3 &i_axis, const float &i_radius,
+					const bool i_bDebugDraw, std::vector<Octree::S_TRIANGLE_SPAN> &io_triangleSpans,
+					Utilities::Math::S_SWEEP_HIT &io_hit, Utilities::StringHash &o_hashedTag )
+	\brief		Find the first triangle of the entity touched by a capsule moved along a segment. Nodes
+				are grown by the size of the capsule, so only the triangles near its path are swept
+	\param		i_entity the collision entity to be hit
+	\param		i_startPoint start point of the capsule axis
+	\param		i_endPoint end point of the capsule axis
+	\param		i_axis axis of the capsule, zero for a sphere
+	\param		i_radius radius of the capsule
+	\param		i_bDebugDraw whether the octree nodes may be drawn
+	\param		io_triangleSpans scratch of the octree query
+	\param		io_hit only contacts earlier than its time are taken, set to the contact
+	\param		o_hashedTag hashed tag of the touched triangle, set only on a hit in the octree
+	\return		boolean
+	\retval		TRUE if the capsule touches the entity
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+bool GameEngine::Collision::SweepEntity( const CollisionEntity &i_entity, const D3DXVECTOR3 &i_startPoint,
+	const D3DXVECTOR3 &i_endPoint, const D3DXVECTOR3 &i_axis, const float &i_radius, const bool i_bDebugDraw,
+	std::vector<Octree::S_TRIANGLE_SPAN> &io_triangleSpans, Utilities::Math::S_SWEEP_HIT &io_hit, Utilities::StringHash &o_hashedTag )
+{
+	FUNCTION_START;
+
+	if( eCollisionBy == E_COLLISION_BY_MESH )
+	{
+		bool bResult = i_entity.m_bvh->Sweep( i_startPoint, i_endPoint, i_axis, i_radius, io_hit );
+		FUNCTION_FINISH;
+		return bResult;
+	}
+
+	const Octree::S_TRIANGLE_SPAN *collidedSpan = NULL;
+	UINT32 u32CollidedTriangle = 0;
+	D3DXVECTOR3 halfAxis = i_axis * 0.5f;
+	D3DXVECTOR3 vExtent( fabs(halfAxis.x) + i_radius, fabs(halfAxis.y) + i_radius, fabs(halfAxis.z) + i_radius );
+
+	io_triangleSpans.clear();
+	i_entity.m_octree->GetTriangleSpans( i_startPoint + halfAxis, i_endPoint + halfAxis, vExtent, io_triangleSpans, i_bDebugDraw );
+
+	std::vector<Octree::S_TRIANGLE_SPAN>::const_iterator iterSpan;
+	for( iterSpan = io_triangleSpans.begin(); iterSpan != io_triangleSpans.end(); ++iterSpan )
+	{
+		if( iterSpan->tEntry > io_hit.time )
+			break;
+
+		for( UINT32 i = 0; i < iterSpan->u32TotalData; ++i )
+		{
+			D3DXVECTOR3 a;
+			D3DXVECTOR3 b;
+			D3DXVECTOR3 c;
+
+			i_entity.m_octree->GetTriangle( *iterSpan, i, a, b, c );
+			if( Utilities::Math::SweepCapsule(i_startPoint, i_endPoint, i_axis, i_radius, a, b, c, io_hit) )
+			{
+				collidedSpan = &*iterSpan;
+				u32CollidedTriangle = i;
+			}
+		}
+	}
+
+	if( !collidedSpan )
+	{
+		FUNCTION_FINISH;
+		return false;
+	}
+
+	o_hashedTag = i_entity.m_octree->GetTag( *collidedSpan, u32CollidedTriangle );
+
+	FUNCTION_FINISH;
+	return true;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void HandleForwardCollision( CollisionEntity &i_entity )
+	\brief		Give the forward collision to the handler of the entity. Swept entities get the time of
+				impact and the contact normal, the others keep getting the collision point
+	\param		i_entity the collision entity
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Collision::HandleForwardCollision( CollisionEntity &i_entity )
+{
+	FUNCTION_START;
+
+	if( i_entity.m_sweepRadius > 0.0f )
+	{
+		i_entity.m_collisionHandler->HandleCollision( i_entity.m_entity, i_entity.m_forwardCollidedEntity, E_COLLISION_HIT_SWEPT,
+			i_entity.m_forwardCollisionDistance, i_entity.m_forwardCollisionNormal, i_entity.m_forwardHashedTag );
+	}
+	else
+	{
+		i_entity.m_collisionHandler->HandleCollision( i_entity.m_entity, i_entity.m_forwardCollidedEntity, E_COLLISION_HIT_FORWARD, 0.0f,
+			i_entity.m_forwardCollisionPoint );
+	}
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			UINT32 GetRayOrderKey( const S_RAY &i_ray, const D3DXVECTOR3 &i_vMin, const D3DXVECTOR3 &i_vScale )
+	\brief		Get the key rays of a batch are traced in. The sign of the direction comes first, then
+				the Morton code of the start point quantized to 9 bits per axis
+	\param		i_ray the ray
+	\param		i_vMin minimum corner of the start points of the batch
+	\param		i_vScale scale from the start point to its quantized coordinates
+	\return		UINT32
+	\retval		Key of the ray
+ ****************************************************************************************************
+*/
+UINT32 GameEngine::Collision::GetRayOrderKey( const S_RAY &i_ray, const D3DXVECTOR3 &i_vMin, const D3DXVECTOR3 &i_vScale )
+{
+	UINT32 u32Key = 0;
+
+	for( UINT8 i = 0; i < 3; ++i )
+	{
+		if( i_ray.endPoint[i] < i_ray.startPoint[i] )
+			u32Key |= 1 << (27 + i);
+	}
+
+	for( UINT8 i = 0; i < 3; ++i )
+	{
+		UINT32 u32Coordinate = static_cast<UINT32>( (i_ray.startPoint[i] - i_vMin[i]) * i_vScale[i] );
+		if( u32Coordinate > 511 )
+			u32Coordinate = 511;
+
+		for( UINT8 j = 0; j < 9; ++j )
+			u32Key |= ((u32Coordinate >> j) & 1) << (j * 3 + i);
+	}
+
+	return u32Key;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void CastRayRange( void *i_data, const UINT32 &i_u32Begin, const UINT32 &i_u32End )
+	\brief		Job of TraceRays, trace the rays [i_u32Begin, i_u32End) of the sorted order against every
+				entity they collide with. It only reads the collision database, apart from the down cache
+				of the caster of each down ray, which no other ray of the batch touches
+	\param		i_data the S_CAST_RAYS_JOB_DATA of the batch
+	\param		i_u32Begin first ray in the sorted order
+	\param		i_u32End one past the last ray in the sorted order
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Collision::CastRayRange( void *i_data, const UINT32 &i_u32Begin, const UINT32 &i_u32End )
+{
+	const S_CAST_RAYS_JOB_DATA &jobData = *reinterpret_cast<const S_CAST_RAYS_JOB_DATA *>( i_data );
+	const std::vector< Utilities::Pointer::SmartPtr<CollisionEntity> > &entityDatabase = *collisionEntityDatabase;
+	std::vector<Octree::S_TRIANGLE_SPAN> jobTriangleSpans;
+	Utilities::Math::S_SEGMENT segment;
+
+	FUNCTION_START;
+
+	for( UINT32 i = i_u32Begin; i < i_u32End; ++i )
+	{
+		const UINT32 u32Ray = jobData.u32Order[i];
+		const S_RAY &ray = jobData.ray[u32Ray];
+		S_RAY_RESULT &result = jobData.result[u32Ray];
+		CollisionEntity *caster = NULL;
+		UINT32 u32First = 0;
+
+		if( jobData.u32Caster )
+		{
+			caster = &*collisionEntityDatabase->at( jobData.u32Caster[u32Ray] );
+			u32First = jobData.u32Caster[u32Ray] + 1;
+		}
+
+		result.u32Entity = NO_ENTITY;
+		result.distance = 1.0f;
+		result.u32DownCacheHits = 0;
+		result.u32DownCacheMisses = 0;
+		Utilities::Math::SetSegment( segment, ray.startPoint, ray.endPoint );
+
+		for( UINT32 j = u32First; j < entityDatabase.size(); ++j )
+		{
+			const CollisionEntity &entity = *entityDatabase[j];
+			D3DXVECTOR3 collisionPoint;
+			Utilities::StringHash hashedTag;
+			float distance = result.distance;
+			float tEntry;
+			UINT32 u32Node;
+			bool bHit;
+
+			if( !(ray.u32CollisionMask & jobData.u32EntityBitMask[j]) )
+				continue;
+
+			// Geometry starting beyond the closest hit cannot be closer
+			if( !Utilities::Math::SegmentBoxEntry(segment, entity.m_vGeometryMin, entity.m_vGeometryMax, tEntry)
+				|| (tEntry > result.distance) )
+				continue;
+
+			if( jobData.bDownRays && IsInsideDownCache(*caster, entity, ray.startPoint, ray.endPoint) )
+			{
+				++result.u32DownCacheHits;
+				bHit = TraceSpans( entity, ray.startPoint, ray.endPoint, jobData.bDebugDraw, caster->m_downCacheSpans, collisionPoint,
+					distance, hashedTag, u32Node );
+			}
+			else
+			{
+				bHit = TraceSegment( entity, ray.startPoint, ray.endPoint, jobData.bDebugDraw, jobTriangleSpans, collisionPoint,
+					distance, hashedTag, u32Node );
+				if( jobData.bDownRays && entity.m_octree )
+				{
+					++result.u32DownCacheMisses;
+					if( bHit )
+						FillDownCache( *caster, entity, u32Node, ray.startPoint, ray.endPoint );
+				}
+			}
+
+			if( bHit )
+			{
+				result.point = collisionPoint;
+				result.distance = distance;
+				result.u32Entity = j;
+				result.hashedTag = hashedTag;
+			}
+		}
+	}
+
+	FUNCTION_FINISH;
+}
+
+#ifdef _DEBUG
+/**
+ ****************************************************************************************************
+	\fn			void UnitTest( void )
+	\brief		Check a batch of rays through every collision entity gives the same hits as casting
+				each ray on its own and as tracing it against every entity without the bounds cull. The
+				rays are traced through a fixture of a floor, a ramp and a box of its own
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Collision::UnitTest( void )
+{
+	// Enough rays per entity for the batch to be split across several jobs
+	const UINT32 u32RaysPerAxis = 8;
+	const D3DXVECTOR3 floorVertices[] = {
+		D3DXVECTOR3( -10.0f, 0.0f, -10.0f ), D3DXVECTOR3( -10.0f, 0.0f, 10.0f ),
+		D3DXVECTOR3( 10.0f, 0.0f, 10.0f ), D3DXVECTOR3( 10.0f, 0.0f, -10.0f ) };
+	const D3DXVECTOR3 rampVertices[] = {
+		D3DXVECTOR3( -4.0f, 0.0f, -2.0f ), D3DXVECTOR3( -4.0f, 0.0f, 2.0f ),
+		D3DXVECTOR3( 4.0f, 3.0f, 2.0f ), D3DXVECTOR3( 4.0f, 3.0f, -2.0f ) };
+	const uint16_t u16QuadIndices[] = { 0, 1, 2, 0, 2, 3 };
+	const D3DXVECTOR3 boxVertices[] = {
+		D3DXVECTOR3( 2.0f, 0.0f, 3.0f ), D3DXVECTOR3( 2.0f, 2.0f, 3.0f ), D3DXVECTOR3( 5.0f, 2.0f, 3.0f ), D3DXVECTOR3( 5.0f, 0.0f, 3.0f ),
+		D3DXVECTOR3( 2.0f, 0.0f, 6.0f ), D3DXVECTOR3( 2.0f, 2.0f, 6.0f ), D3DXVECTOR3( 5.0f, 2.0f, 6.0f ), D3DXVECTOR3( 5.0f, 0.0f, 6.0f ) };
+	const uint16_t u16BoxIndices[] = {
+		0, 1, 2, 0, 2, 3,  4, 6, 5, 4, 7, 6,  0, 4, 5, 0, 5, 1,
+		3, 2, 6, 3, 6, 7,  1, 5, 6, 1, 6, 2,  0, 3, 7, 0, 7, 4 };
+	std::vector< Utilities::Pointer::SmartPtr<CollisionEntity> > *savedCollisionEntityDatabase = collisionEntityDatabase;
+	const E_COLLISION_BY savedCollisionBy = eCollisionBy;
+	std::vector<S_RAY> rays;
+
+	FUNCTION_START;
+
+	assert( CollisionEntity::m_collisionEntityPool );
+
+	eCollisionBy = E_COLLISION_BY_MESH;
+	collisionEntityDatabase = new std::vector< Utilities::Pointer::SmartPtr<CollisionEntity> >;
+	{
+		Utilities::Pointer::SmartPtr<Entity> floor = Entity::Create( Math::Vector3::Zero, NULL, "CollisionTestFloor" );
+		Utilities::Pointer::SmartPtr<Entity> ramp = Entity::Create( Math::Vector3::Zero, NULL, "CollisionTestRamp" );
+		Utilities::Pointer::SmartPtr<Entity> box = Entity::Create( Math::Vector3::Zero, NULL, "CollisionTestBox" );
+
+		collisionEntityDatabase->push_back( new CollisionEntity(floor, floorVertices, u16QuadIndices, 2) );
+		collisionEntityDatabase->push_back( new CollisionEntity(ramp, rampVertices, u16QuadIndices, 2) );
+		collisionEntityDatabase->push_back( new CollisionEntity(box, boxVertices, u16BoxIndices, 12) );
+	}
+
+	for( UINT32 i = 0; i < collisionEntityDatabase->size(); ++i )
+	{
+		const CollisionEntity &entity = *collisionEntityDatabase->at( i );
+		D3DXVECTOR3 vMin = entity.m_vGeometryMin - D3DXVECTOR3( 1.0f, 1.0f, 1.0f );
+		D3DXVECTOR3 vMax = entity.m_vGeometryMax + D3DXVECTOR3( 1.0f, 1.0f, 1.0f );
+
+		// Rays straight down through the bounds, and slanted rays from their corners
+		for( UINT32 x = 0; x < u32RaysPerAxis; ++x )
+		{
+			for( UINT32 z = 0; z < u32RaysPerAxis; ++z )
+			{
+				float fractionX = (x + 0.5f) / u32RaysPerAxis;
+				float fractionZ = (z + 0.5f) / u32RaysPerAxis;
+				D3DXVECTOR3 point( vMin.x + (vMax.x - vMin.x) * fractionX, vMax.y, vMin.z + (vMax.z - vMin.z) * fractionZ );
+				S_RAY ray;
+
+				ray.u32CollisionMask = 0xFFFFFFFF;
+				ray.startPoint = point;
+				ray.endPoint = D3DXVECTOR3( point.x, vMin.y, point.z );
+				rays.push_back( ray );
+
+				ray.startPoint = ((x + z) & 1) ? vMin : D3DXVECTOR3( vMax.x, vMin.y, vMax.z );
+				ray.endPoint = point;
+				rays.push_back( ray );
+			}
+		}
+	}
+
+	std::vector<S_RAY_HIT> hits( rays.size() );
+	CastRays( &rays[0], &hits[0], rays.size() );
+
+	for( UINT32 i = 0; i < rays.size(); ++i )
+	{
+		S_RAY_HIT hit;
+		D3DXVECTOR3 collisionPoint;
+		Utilities::StringHash hashedTag( "" );
+		float distance = 1.0f;
+		UINT32 u32Entity = NO_ENTITY;
+
+		CastRays( &rays[i], &hit, 1 );
+		assert( hits[i].entity == hit.entity );
+		assert( Utilities::Math::AreRelativelyEqual(hits[i].distance, hit.distance) );
+		assert( hits[i].hashedTag == hit.hashedTag );
+
+		for( UINT32 j = 0; j < collisionEntityDatabase->size(); ++j )
+		{
+			const CollisionEntity &entity = *collisionEntityDatabase->at( j );
+			UINT32 u32Node;
+
+			if( !entity.m_entity->m_isDestroyed
+				&& TraceSegment(entity, rays[i].startPoint, rays[i].endPoint, false, *triangleSpans, collisionPoint, distance, hashedTag, u32Node) )
+				u32Entity = j;
+		}
+
+		if( u32Entity == NO_ENTITY )
+		{
+			assert( !hits[i].entity );
+		}
+		else
+		{
+			assert( hits[i].entity == collisionEntityDatabase->at(u32Entity)->m_entity );
+			assert( Utilities::Math::AreRelativelyEqual(hits[i].distance, distance) );
+			assert( hits[i].hashedTag == hashedTag );
+		}
+	}
+
+	// The comparison means little if every ray missed
+	UINT32 u32TotalHits = 0;
+	for( UINT32 i = 0; i < hits.size(); ++i )
+	{
+		if( hits[i].entity )
+			++u32TotalHits;
+	}
+	assert( u32TotalHits > 0 );
+
+	hits.clear();
+	delete collisionEntityDatabase;
+	collisionEntityDatabase = savedCollisionEntityDatabase;
+	eCollisionBy = savedCollisionBy;
+
+	FUNCTION_FINISH;
+}
+#endif	// #ifdef _DEBUG
+
+/****************************************************************************************************
+			CollisionEntity class implementation
+****************************************************************************************************/
+/**
+ ****************************************************************************************************
+	\fn			CollisionEntity( Pointer::SmartPtr<Entity> &i_entity, const char *i_collisionFile )
+	\brief		Default constructor of CollisionEntity
+	\param		i_entity pointer to common entity data
+	\param		i_collisionFile the file contain the information of the collision
+	\return		NONE
+ ****************************************************************************************************
+*/
+GameEngine::Collision::CollisionEntity::CollisionEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity,
+	const char *i_collisionFile ) :
+	m_downCollisionPoint( D3DXVECTOR3_ZERO ),
+	m_forwardCollisionPoint( D3DXVECTOR3_ZERO ),
+	m_forwardCollisionNormal( D3DXVECTOR3_ZERO ),
+	m_downCacheEntity( NULL ),
+	m_downCollidedEntity( NULL ),
+	m_forwardCollidedEntity( NULL ),
+	m_entity( i_entity ),
+	m_collisionHandler( NULL ),
+	m_octree( NULL ),
+	m_bvh( NULL ),
+	m_u16Indices( NULL ),
+	m_vertices( NULL ),
+	m_u32TotalPrimitives( 0 ),
+	m_u32TotalVertices( 0 ),
+	m_u32Proxy( Utilities::INVALID_PROXY ),
+	m_u32AwakeSlot( NO_ENTITY ),
+	m_downCollisionDistance( 0.0f ),
+	m_forwardCollisionDistance( 0.0f ),
+	m_sweepRadius( 0.0f ),
+	m_sweepHeight( 0.0f )
+{
+	assert( i_collisionFile != NULL );
+	assert( i_collisionFile[0] != '\0' );
+
+	if( eCollisionBy == E_COLLISION_BY_MESH )
+	{
+		Utilities::S_NORMAL_MAP_VERTEX_DATA* vertexData;
+		Utilities::MeshParser meshData( i_collisionFile );
+
+		m_u32TotalPrimitives = meshData.m_u32TotalPrimitives;
+		m_u32TotalVertices = meshData.m_u32TotalVertices;
+		vertexData = new Utilities::S_NORMAL_MAP_VERTEX_DATA[m_u32TotalVertices];
+		m_u16Indices = new uint16_t[m_u32TotalPrimitives * 3];
+		m_vertices = new D3DXVECTOR3[m_u32TotalVertices];
+		meshData.GetVertexData( vertexData );
+		meshData.GetIndexData( m_u16Indices );
+		for( UINT32 i = 0; i < m_u32TotalVertices; ++i )
+			m_vertices[i] = vertexData[i].position;
+
+		delete [] vertexData;
+
+		m_bvh = new BVH( m_vertices, m_u16Indices, m_u32TotalPrimitives );
+	}
+	else
+	{
+		m_octree = new Octree( i_collisionFile );
+	}
+
+	// Collision geometry is already in world space, so its bounds never change
+	m_vGeometryMin = D3DXVECTOR3( FLT_MAX, FLT_MAX, FLT_MAX );
+	m_vGeometryMax = D3DXVECTOR3( -FLT_MAX, -FLT_MAX, -FLT_MAX );
+	if( m_octree )
+	{
+		m_octree->GetBounds( m_vGeometryMin, m_vGeometryMax );
+	}
+	else
+	{
+		for( UINT32 i = 0; i < m_u32TotalVertices; ++i )
+		{
+			D3DXVec3Minimize( &m_vGeometryMin, &m_vGeometryMin, &m_vertices[i] );
+			D3DXVec3Maximize( &m_vGeometryMax, &m_vGeometryMax, &m_vertices[i] );
+		}
+
+		// The BVH keeps its own copy of the triangles, the mesh is not needed any more
+		delete [] m_u16Indices;
+		m_u16Indices = NULL;
+		delete [] m_vertices;
+		m_vertices = NULL;
+	}
+
+	if( m_vGeometryMin.x > m_vGeometryMax.x )
+	{
+		m_vGeometryMin = D3DXVECTOR3( m_entity->m_v3Position.X(), m_entity->m_v3Position.Y(), m_entity->m_v3Position.Z() );
+		m_vGeometryMax = m_vGeometryMin;
+	}
+	m_vBroadphaseMin = m_vGeometryMin;
+	m_vBroadphaseMax = m_vGeometryMax;
+}
+
+#ifdef _DEBUG
+/**
+ ****************************************************************************************************
+	\fn			CollisionEntity( Pointer::SmartPtr<Entity> &i_entity, const D3DXVECTOR3 *i_vertices,
+					const uint16_t *i_u16Indices, const UINT32 &i_u32TotalTriangles )
+	\brief		Constructor of the collision entities of the unit test, from triangles in world space
+	\param		i_entity pointer to common entity data
+	\param		i_vertices vertices of the triangles
+	\param		i_u16Indices three vertex indices per triangle
+	\param		i_u32TotalTriangles number of triangles
+	\return		NONE
+ ****************************************************************************************************
+*/
+GameEngine::Collision::CollisionEntity::CollisionEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity,
+	const D3DXVECTOR3 *i_vertices, const uint16_t *i_u16Indices, const UINT32 &i_u32TotalTriangles ) :
+	m_downCollisionPoint( D3DXVECTOR3_ZERO ),
+	m_forwardCollisionPoint( D3DXVECTOR3_ZERO ),
+	m_forwardCollisionNormal( D3DXVECTOR3_ZERO ),
+	m_downCacheEntity( NULL ),
+	m_downCollidedEntity( NULL ),
+	m_forwardCollidedEntity( NULL ),
+	m_entity( i_entity ),
+	m_collisionHandler( NULL ),
+	m_octree( NULL ),
+	m_bvh( NULL ),
+	m_u16Indices( NULL ),
+	m_vertices( NULL ),
+	m_u32TotalPrimitives( i_u32TotalTriangles ),
+	m_u32TotalVertices( 0 ),
+	m_u32Proxy( Utilities::INVALID_PROXY ),
+	m_u32AwakeSlot( NO_ENTITY ),
+	m_downCollisionDistance( 0.0f ),
+	m_forwardCollisionDistance( 0.0f ),
+	m_sweepRadius( 0.0f ),
+	m_sweepHeight( 0.0f )
+{
+	assert( i_vertices && i_u16Indices && (i_u32TotalTriangles > 0) );
+
+	m_bvh = new BVH( i_vertices, i_u16Indices, i_u32TotalTriangles );
+
+	m_vGeometryMin = D3DXVECTOR3( FLT_MAX, FLT_MAX, FLT_MAX );
+	m_vGeometryMax = D3DXVECTOR3( -FLT_MAX, -FLT_MAX, -FLT_MAX );
+	for( UINT32 i = 0; i < i_u32TotalTriangles * 3; ++i )
+	{
+		D3DXVec3Minimize( &m_vGeometryMin, &m_vGeometryMin, &i_vertices[i_u16Indices[i]] );
+		D3DXVec3Maximize( &m_vGeometryMax, &m_vGeometryMax, &i_vertices[i_u16Indices[i]] );
+	}
+	m_vBroadphaseMin = m_vGeometryMin;
+	m_vBroadphaseMax = m_vGeometryMax;
+}
+#endif	// #ifdef _DEBUG
+
+/**
+ ****************************************************************************************************
+	\fn			~CollisionEntity( void )
+	\brief		Default destructor of CollisionEntity
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+GameEngine::Collision::CollisionEntity::~CollisionEntity( void )
+{
+	FUNCTION_START;
+
+	m_entity = NULL;
+	m_forwardCollidedEntity = NULL;
 
 	if( m_octree )
 	{
@@ -660,6 +2106,12 @@ GameEngine::Collision::CollisionEntity::~CollisionEntity( void )
 		m_octree = NULL;
 	}
 
+	if( m_bvh )
+	{
+		delete m_bvh;
+		m_bvh = NULL;
+	}
+
 	if( m_u16Indices )
 	{
 		delete [] m_u16Indices;
@@ -26,25 +26,88 @@ namespace GameEngine
 
 	namespace Collision
 	{
+		// Which check found the collision given to a handler, it tells what the vector is
+		typedef enum _e_collision_hit_
+		{
+			// Down ray, the vector is the ground point. The other entity is the entity itself if there
+			// is no ground below it
+			E_COLLISION_HIT_DOWN,
+			// Forward ray, the vector is the point the ray hit
+			E_COLLISION_HIT_FORWARD,
+			// Swept shape, the vector is the contact normal and the time the time of impact
+			E_COLLISION_HIT_SWEPT
+		} E_COLLISION_HIT;
+
 		class CollisionHandler
 		{
 		public:
 			virtual ~CollisionHandler( void ) {}
 			virtual void HandleCollision( Utilities::Pointer::SmartPtr<Entity> &i_entity, \
-				Utilities::Pointer::SmartPtr<Entity> &i_other, \
-				const float i_collisionTime, const Math::Vector3 &i_collisionNormal, const Utilities::StringHash &i_hashedTag = Utilities::StringHash("") ) = 0;
+				Utilities::Pointer::SmartPtr<Entity> &i_other, const E_COLLISION_HIT i_eHit, \
+				const float i_collisionTime, const Math::Vector3 &i_v3PointOrNormal, const Utilities::StringHash &i_hashedTag = Utilities::StringHash("") ) = 0;
 			virtual void OnLeavingCollision( Utilities::Pointer::SmartPtr<Entity> &i_entity, Utilities::Pointer::SmartPtr<Entity> &i_other ) {}
 		};
 
+		typedef struct _s_ray_
+		{
+			D3DXVECTOR3 startPoint;
+			D3DXVECTOR3 endPoint;
+			// Bit mask of the entity IDs the ray collides with
+			UINT32 u32CollisionMask;
+		} S_RAY;
+
+		typedef struct _s_ray_hit_
+		{
+			// NULL if the ray does not hit anything
+			Utilities::Pointer::SmartPtr<Entity> entity;
+			D3DXVECTOR3 point;
+			// Fraction of the ray from its start point
+			float distance;
+			Utilities::StringHash hashedTag;
+		} S_RAY_HIT;
+
+		// Capsule from startPoint to startPoint + axis moved to endPoint, a zero axis is a sphere
+		typedef struct _s_sweep_
+		{
+			D3DXVECTOR3 startPoint;
+			D3DXVECTOR3 endPoint;
+			D3DXVECTOR3 axis;
+			float radius;
+			// Bit mask of the entity IDs the sweep collides with
+			UINT32 u32CollisionMask;
+		} S_SWEEP;
+
+		typedef struct _s_sweep_hit_
+		{
+			// NULL if the sweep does not hit anything
+			Utilities::Pointer::SmartPtr<Entity> entity;
+			D3DXVECTOR3 point;
+			// Unit normal from the hit triangle towards the swept shape
+			D3DXVECTOR3 normal;
+			// Fraction of the sweep where the shape touches the triangle
+			float time;
+			Utilities::StringHash hashedTag;
+		} S_SWEEP_HIT;
+
 		bool Initialize( void );
 		void BeginUpdate( void );
 		void Update( void );
+		void HandleCollisions( void );
 		void EndUpdate( void );
 		void ShutDown( void );
 
-		UINT8 AddCollisionEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity, const char *i_collisionFile );
-		void SetCollisionHandler( const UINT8 &i_index, CollisionHandler *i_collisionHandler );
+		UINT32 AddCollisionEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity, const char *i_collisionFile );
+		void RemoveCollisionEntity( UINT32 &io_u32Handle );
+		void SetCollisionHandler( const UINT32 &i_u32Handle, CollisionHandler *i_collisionHandler );
+		void SetSleeping( const UINT32 &i_u32Handle, const bool &i_bSleeping );
 		void SetCollisionDetectionType( const E_COLLISION_BY &i_collisionBy );
+		void CastRays( const S_RAY *i_rays, S_RAY_HIT *o_hits, const UINT32 &i_u32TotalRays );
+		bool Sweep( const S_SWEEP &i_sweep, S_SWEEP_HIT &o_hit );
+		void SetSweptShape( const UINT32 &i_u32Handle, const float &i_radius, const float &i_height );
+
+#ifdef _DEBUG
+		void UnitTest( void );
+#endif	// #ifdef _DEBUG
 	}	// namespace Collision
 }	// namespace GameEngine
 
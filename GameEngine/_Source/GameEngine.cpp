@@ -5,17 +5,26 @@
  ****************************************************************************************************
 */
 
+#include <float.h>
 #include <assert.h>
 
 // Utilities header
 #include <Utilities.h>
+#include <Time/Time.h>
 #include <Debug/Debug.h>
 #include <UtilitiesDefault.h>
+#include <JobSystem/JobSystem.h>
+#include <TaskGraph/TaskGraph.h>
 #include <SmartPtr/SmartPtr.h>
 #ifdef _DEBUG
 	#include <BitWise/BitWise.h>
 	#include <MemoryPool/MemoryPool.h>
+	#include <HandleTable/HandleTable.h>
+	#include <SweepAndPrune/SweepAndPrune.h>
 #endif	// #ifdef _DEBUG
+#if defined( _DEBUG ) || defined( ENABLE_BENCHMARK )
+	#include <Math/Math.h>
+#endif	// #if defined( _DEBUG ) || defined( ENABLE_BENCHMARK )
 
 #include "AI/AI.h"
 #include "GameEngine.h"
@@ -25,6 +34,8 @@
 #include "Network/Network.h"
 #include "Physics/Physics.h"
 #include "Renderer/Renderer.h"
+#include "GameEngineDefault.h"
+#include "World/EntityStore.h"
 #include "Collision/Collision.h"
 #include "DebugMenu/DebugMenu.h"
 #include "Messaging/Messaging.h"
@@ -48,6 +59,31 @@ namespace GameEngine
 	bool bDebugMenuActivated = false;
 	bool bEngineInitialized = false;
 	bool bInFrame = false;
+
+	// Deterministic simulation for lockstep and replay, set by "deterministic" of the GameEngine
+	// config
+	static bool bDeterministic = false;
+	// x64 has no x87 precision control, its float math is always done in single precision
+#ifdef _M_IX86
+	const unsigned int SIMULATION_FP_CONTROL = _RC_NEAR | _PC_24;
+	const unsigned int SIMULATION_FP_CONTROL_MASK = _MCW_RC | _MCW_PC;
+#else
+	const unsigned int SIMULATION_FP_CONTROL = _RC_NEAR;
+	const unsigned int SIMULATION_FP_CONTROL_MASK = _MCW_RC;
+#endif	// #ifdef _M_IX86
+	static UINT32 u32SimulationTick = 0;
+	static UINT32 u32StateChecksum = 0;
+
+	// One graph per frame phase, built once the subsystems are initialized. The simulation graph
+	// runs once per fixed step, the others once per frame
+	static Utilities::TaskGraph *beginUpdateGraph = NULL;
+	static Utilities::TaskGraph *simulationGraph = NULL;
+	static Utilities::TaskGraph *renderGraph = NULL;
+	static Utilities::TaskGraph *endUpdateGraph = NULL;
+
+	static void LoadSimulationSettings( void );
+	static bool CreateFrameTaskGraphs( void );
+	static void DestroyFrameTaskGraphs( void );
 }
 
 /****************************************************************************************************
@@ -101,6 +137,12 @@ bool GameEngine::Initialize( const char* i_GameName, UINT16 i_u16Width, UINT16 i
 		return FAIL;
 	}
 
+	if( !Utilities::JobSystem::Initialize() )
+	{
+		FUNCTION_FINISH;
+		return FAIL;
+	}
+
 	if( !g_debugMenu::Get().Initialize() )
 	{
 		FUNCTION_FINISH;
@@ -173,15 +215,37 @@ bool GameEngine::Initialize( const char* i_GameName, UINT16 i_u16Width, UINT16 i
 		return FAIL;
 	}
 
+	LoadSimulationSettings();
+
+	if( !CreateFrameTaskGraphs() )
+	{
+		FUNCTION_FINISH;
+		return FAIL;
+	}
+
 #ifdef _DEBUG
 	Math::FastVector3::UnitTest();
 	RingBufferUnitTest();
 	FloatNumberPrecisionTest();
 	Utilities::BitWise::UnitTest();
 	Utilities::MemoryPool::UnitTest();
+	Utilities::HandleTable::UnitTest();
+	Utilities::HashIndex::UnitTest();
+	Utilities::JobSystem::UnitTest();
+	Utilities::TaskGraph::UnitTest();
+	Utilities::SweepAndPrune::UnitTest();
+	Utilities::Math::UnitTest();
 	Math::Matrix::UnitTest();
+	EntityStore::UnitTest();
+	AI::UnitTest();
+	Collision::UnitTest();
 #endif	// #ifdef _DEBUG
 
+#ifdef ENABLE_BENCHMARK
+	Utilities::Math::RayTracingBenchmark();
+	TriggerBox::IntersectionBenchmark();
+#endif	// #ifdef ENABLE_BENCHMARK
+
 	bEngineInitialized = true;
 
 	FUNCTION_FINISH;
@@ -207,14 +271,7 @@ void GameEngine::BeginUpdate( void )
 		UserInput::Update();
 		Utilities::Time::OnNewFrame();
 
-		g_world::Get().BeginUpdate();
-		AI::BeginUpdate();
-		Physics::BeginUpdate();
-		Collision::BeginUpdate();
-		TriggerBox::BeginUpdate();
-		Renderer::BeginUpdate();
-		g_debugMenu::Get().BeginUpdate();
-		Audio::BeginUpdate();
+		beginUpdateGraph->Execute();
 	}
 
 	bInFrame = true;
@@ -249,18 +306,43 @@ void GameEngine::Update( void )
 
 	if( Network::IsServer() || Network::IsConnected() )
 	{
-		g_world::Get().Update();
-		AI::Update();
-		Physics::Update();
-		Collision::Update();
-		TriggerBox::Update();
-		if( g_world::Get().m_camera )
-			g_world::Get().m_camera->Update();
-		Renderer::Update();
-		g_debugMenu::Get().Update();
-		Renderer::UpdateGUI();
-		g_debugMenu::Get().UpdateGUI();
-		Audio::Update();
+		UINT32 u32TotalSteps = Utilities::Time::AdvanceFixedTime();
+
+		unsigned int previousControl = 0;
+		unsigned int control;
+		if( bDeterministic )
+		{
+			// Every simulation task runs on this thread in deterministic mode, so fixing its rounding
+			// and x87 precision makes the float results the same on every peer
+			_controlfp_s( &previousControl, 0, 0 );
+			_controlfp_s( &control, SIMULATION_FP_CONTROL, SIMULATION_FP_CONTROL_MASK );
+		}
+
+		for( UINT32 i = 0; i < u32TotalSteps; ++i )
+		{
+			g_world::Get().GetEntityStore().SavePreviousPositions();
+			simulationGraph->Execute();
+
+			++u32SimulationTick;
+			if( bDeterministic )
+				u32StateChecksum = g_world::Get().GetEntityStore().Checksum();
+		}
+
+		if( bDeterministic )
+			_controlfp_s( &control, previousControl, SIMULATION_FP_CONTROL_MASK );
+
+		renderGraph->Execute();
+
+#ifdef SHOW_CRITICAL_PATH
+		char criticalPath[256];
+		if( u32TotalSteps )
+		{
+			simulationGraph->GetCriticalPath( criticalPath, sizeof(criticalPath) );
+			g_debugMenu::Get().Log( criticalPath );
+		}
+		renderGraph->GetCriticalPath( criticalPath, sizeof(criticalPath) );
+		g_debugMenu::Get().Log( criticalPath );
+#endif	// #ifdef SHOW_CRITICAL_PATH
 	}
 
 	FUNCTION_FINISH;
@@ -283,16 +365,7 @@ void GameEngine::EndUpdate( void )
 
 	if( Network::IsServer() || Network::IsConnected() )
 	{
-		TriggerBox::EndUpdate();
-		Collision::EndUpdate();
-		AI::EndUpdate();
-		g_world::Get().EndUpdate();
-		Physics::EndUpdate();
-		if( g_world::Get().m_camera )
-			g_world::Get().m_camera->EndUpdate();
-		Renderer::EndUpdate();
-		g_debugMenu::Get().EndUpdate();
-		Audio::EndUpdate();
+		endUpdateGraph->Execute();
 	}
 
 	Network::EndUpdate();
@@ -314,6 +387,7 @@ void GameEngine::ShutDown( void )
 
 	if( bEngineInitialized )
 	{
+		DestroyFrameTaskGraphs();
 		Renderer::ShutDown();
 		TriggerBox::ShutDown();
 		Collision::ShutDown();
@@ -324,6 +398,7 @@ void GameEngine::ShutDown( void )
 		Configuration::UnloadMasterConfig();
 		Network::ShutDown();
 		g_debugMenu::Get().ShutDown();
+		Utilities::JobSystem::ShutDown();
 		Utilities::ShutDown();
 		Audio::ShutDown();
 		bEngineInitialized = false;
@@ -365,4 +440,252 @@ bool GameEngine::IsDebugMenuActivated( void )
 void GameEngine::SetDebugMenu( const bool i_state )
 {
 	bDebugMenuActivated = i_state;
-}
\ No newline at end of file
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool IsDeterministic( void )
+	\brief		Check whether the simulation runs in deterministic mode
+	\param		NONE
+	\return		boolean
+	\retval		TRUE if the simulation is deterministic
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+bool GameEngine::IsDeterministic( void )
+{
+	return bDeterministic;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			UINT32 GetSimulationTick( void )
+	\brief		Get the number of simulation steps run so far
+	\param		NONE
+	\return		UINT32
+	\retval		Simulation steps run since the engine was initialized
+ ****************************************************************************************************
+*/
+UINT32 GameEngine::GetSimulationTick( void )
+{
+	return u32SimulationTick;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			UINT32 GetStateChecksum( void )
+	\brief		Get the checksum of the entity state after the last simulation step. Peers running the
+				same inputs have the same checksum at the same tick
+	\param		NONE
+	\return		UINT32
+	\retval		Checksum of the last simulation step, 0 if not in deterministic mode
+ ****************************************************************************************************
+*/
+UINT32 GameEngine::GetStateChecksum( void )
+{
+	return u32StateChecksum;
+}
+
+/****************************************************************************************************
+			Frame task graphs
+****************************************************************************************************/
+namespace GameEngine
+{
+	static void WorldBeginUpdate( void ) { g_world::Get().BeginUpdate(); }
+	static void WorldUpdate( void ) { g_world::Get().Update(); }
+	static void WorldEndUpdate( void ) { g_world::Get().EndUpdate(); }
+	static void DebugMenuBeginUpdate( void ) { g_debugMenu::Get().BeginUpdate(); }
+	static void DebugMenuUpdate( void ) { g_debugMenu::Get().Update(); }
+	static void DebugMenuUpdateGUI( void ) { g_debugMenu::Get().UpdateGUI(); }
+	static void DebugMenuEndUpdate( void ) { g_debugMenu::Get().EndUpdate(); }
+
+	static void CameraUpdate( void )
+	{
+		if( g_world::Get().m_camera )
+			g_world::Get().m_camera->Update();
+	}
+
+	static void CameraEndUpdate( void )
+	{
+		if( g_world::Get().m_camera )
+			g_world::Get().m_camera->EndUpdate();
+	}
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void LoadSimulationSettings( void )
+	\brief		Set the fixed simulation step and the deterministic mode from the GameEngine config, the
+				defaults are kept when the settings are missing
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::LoadSimulationSettings( void )
+{
+	libconfig::Setting *gameEngineSetting = Configuration::GetMasterConfig().lookup( "GameEngine" );
+	UINT32 u32SimulationRate = DEFAULT_SIMULATION_RATE;
+	UINT32 u32MaxSimulationSteps = DEFAULT_MAX_SIMULATION_STEPS;
+
+	FUNCTION_START;
+
+	if( gameEngineSetting )
+	{
+		INT32 temp;
+
+		if( gameEngineSetting->lookupValue("simulationRate", temp) )
+		{
+			if( temp > 0 )
+				u32SimulationRate = static_cast<UINT32>( temp );
+			else
+				DBG_MSG_LEVEL( D_ERR, "Invalid simulation rate %d, using %u\n", temp, u32SimulationRate );
+		}
+
+		if( gameEngineSetting->lookupValue("maxSimulationSteps", temp) )
+		{
+			if( temp > 0 )
+				u32MaxSimulationSteps = static_cast<UINT32>( temp );
+			else
+				DBG_MSG_LEVEL( D_ERR, "Invalid max simulation steps %d, using %u\n", temp, u32MaxSimulationSteps );
+		}
+
+		gameEngineSetting->lookupValue( "deterministic", bDeterministic );
+	}
+
+	Utilities::Time::SetFixedTimeStep( 1000.0f / u32SimulationRate, u32MaxSimulationSteps );
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool CreateFrameTaskGraphs( void )
+	\brief		Build the task graphs of BeginUpdate, Update and EndUpdate. Tasks are added in the order
+				they used to run one by one, a task only overlaps the tasks it shares no written
+				resource with. Controllers and collision/trigger box handlers are game code, so the
+				tasks calling them access every resource on the main thread
+	\param		NONE
+	\return		boolean
+	\retval		1 SUCCESS
+	\retval		0 FAIL
+ ****************************************************************************************************
+*/
+bool GameEngine::CreateFrameTaskGraphs( void )
+{
+	FUNCTION_START;
+
+	beginUpdateGraph = Utilities::TaskGraph::Create();
+	simulationGraph = Utilities::TaskGraph::Create();
+	renderGraph = Utilities::TaskGraph::Create();
+	endUpdateGraph = Utilities::TaskGraph::Create();
+	if( !beginUpdateGraph || !simulationGraph || !renderGraph || !endUpdateGraph )
+	{
+		DBG_MSG_LEVEL( D_ERR, "Failed to create frame task graphs\n" );
+		FUNCTION_FINISH;
+		return FAIL;
+	}
+
+	beginUpdateGraph->AddTask( "World", WorldBeginUpdate, 0, E_RESOURCE_ALL, true );
+	beginUpdateGraph->AddTask( "AI", AI::BeginUpdate, 0, E_RESOURCE_AI );
+	beginUpdateGraph->AddTask( "Physics", Physics::BeginUpdate, 0, E_RESOURCE_PHYSICS );
+	beginUpdateGraph->AddTask( "Collision", Collision::BeginUpdate, 0, E_RESOURCE_COLLISION );
+	beginUpdateGraph->AddTask( "TriggerBox", TriggerBox::BeginUpdate, 0, E_RESOURCE_TRIGGER_BOX );
+	beginUpdateGraph->AddTask( "Renderer", Renderer::BeginUpdate, 0, E_RESOURCE_RENDERER, true );
+	beginUpdateGraph->AddTask( "DebugMenu", DebugMenuBeginUpdate, 0, E_RESOURCE_DEBUG_MENU | E_RESOURCE_RENDERER, true );
+	beginUpdateGraph->AddTask( "Audio", Audio::BeginUpdate, 0, E_RESOURCE_AUDIO );
+
+	// One fixed simulation step, the projection is committed after collision and trigger box
+	// responded to it. In deterministic mode every step runs on the main thread. Setting the
+	// velocity wakes a sleeping body and putting bodies to sleep deactivates their broadphase
+	// proxies, so AI and the commit write the physics, collision and trigger box resources too.
+	// Detection only reads the entities, no other task of the step copies the entity references
+	// collision keeps of what it hit, so trigger box detection runs alongside physics and collision
+	// detection. The game handlers may touch anything, so they take every resource on the main
+	// thread once both detections are done. The controllers apply the input first, once per step
+	// and under the fixed float control word of deterministic mode
+	simulationGraph->AddTask( "World", WorldUpdate, 0, E_RESOURCE_ALL, true );
+	simulationGraph->AddTask( "AI", AI::Update,
+		E_RESOURCE_ENTITY | E_RESOURCE_POSITION | E_RESOURCE_DEBUG_MENU,
+		E_RESOURCE_AI | E_RESOURCE_VELOCITY | E_RESOURCE_DEBUG_DRAW
+		| E_RESOURCE_PHYSICS | E_RESOURCE_COLLISION | E_RESOURCE_TRIGGER_BOX, bDeterministic );
+	simulationGraph->AddTask( "Physics", Physics::Update,
+		E_RESOURCE_POSITION | E_RESOURCE_VELOCITY,
+		E_RESOURCE_ACCELERATION | E_RESOURCE_PROJECTION | E_RESOURCE_PHYSICS, bDeterministic );
+	simulationGraph->AddTask( "Collision", Collision::Update,
+		E_RESOURCE_ENTITY | E_RESOURCE_POSITION | E_RESOURCE_VELOCITY | E_RESOURCE_PROJECTION
+		| E_RESOURCE_CAMERA | E_RESOURCE_DEBUG_MENU,
+		E_RESOURCE_COLLISION | E_RESOURCE_DEBUG_DRAW, bDeterministic );
+	simulationGraph->AddTask( "TriggerBox", TriggerBox::Update,
+		E_RESOURCE_ENTITY | E_RESOURCE_POSITION | E_RESOURCE_VELOCITY,
+		E_RESOURCE_TRIGGER_BOX, bDeterministic );
+	simulationGraph->AddTask( "CollisionHandlers", Collision::HandleCollisions, 0, E_RESOURCE_ALL, true );
+	simulationGraph->AddTask( "TriggerBoxHandlers", TriggerBox::HandleIntersections, 0, E_RESOURCE_ALL, true );
+	simulationGraph->AddTask( "PhysicsCommit", Physics::CommitUpdate,
+		E_RESOURCE_PROJECTION,
+		E_RESOURCE_POSITION | E_RESOURCE_VELOCITY | E_RESOURCE_PHYSICS | E_RESOURCE_COLLISION | E_RESOURCE_TRIGGER_BOX, bDeterministic );
+
+	// Audio only reads the committed position and velocity, so it runs alongside the renderer
+	renderGraph->AddTask( "Audio", Audio::Update,
+		E_RESOURCE_POSITION | E_RESOURCE_VELOCITY | E_RESOURCE_DEBUG_MENU,
+		E_RESOURCE_ENTITY | E_RESOURCE_AUDIO );
+	renderGraph->AddTask( "Camera", CameraUpdate, E_RESOURCE_ENTITY | E_RESOURCE_POSITION, E_RESOURCE_CAMERA, true );
+	renderGraph->AddTask( "Renderer", Renderer::Update,
+		E_RESOURCE_ENTITY | E_RESOURCE_POSITION | E_RESOURCE_CAMERA, E_RESOURCE_RENDERER, true );
+	renderGraph->AddTask( "DebugMenu", DebugMenuUpdate, E_RESOURCE_CAMERA, E_RESOURCE_DEBUG_DRAW | E_RESOURCE_RENDERER, true );
+	renderGraph->AddTask( "RendererGUI", Renderer::UpdateGUI, E_RESOURCE_DEBUG_MENU, E_RESOURCE_RENDERER, true );
+	renderGraph->AddTask( "DebugMenuGUI", DebugMenuUpdateGUI, 0, E_RESOURCE_DEBUG_MENU | E_RESOURCE_RENDERER, true );
+
+	// The world removes the destroyed entities from every subsystem, hence it writes every resource
+	endUpdateGraph->AddTask( "TriggerBox", TriggerBox::EndUpdate, 0, E_RESOURCE_TRIGGER_BOX );
+	endUpdateGraph->AddTask( "Collision", Collision::EndUpdate, 0, E_RESOURCE_ENTITY | E_RESOURCE_COLLISION );
+	endUpdateGraph->AddTask( "AI", AI::EndUpdate, 0, E_RESOURCE_AI );
+	endUpdateGraph->AddTask( "World", WorldEndUpdate, 0, E_RESOURCE_ALL, true );
+	endUpdateGraph->AddTask( "Physics", Physics::EndUpdate, 0, E_RESOURCE_PHYSICS );
+	endUpdateGraph->AddTask( "Camera", CameraEndUpdate, 0, E_RESOURCE_CAMERA, true );
+	endUpdateGraph->AddTask( "Renderer", Renderer::EndUpdate, 0, E_RESOURCE_RENDERER, true );
+	endUpdateGraph->AddTask( "DebugMenu", DebugMenuEndUpdate, 0,
+		E_RESOURCE_DEBUG_MENU | E_RESOURCE_DEBUG_DRAW | E_RESOURCE_RENDERER, true );
+	endUpdateGraph->AddTask( "Audio", Audio::EndUpdate, 0, E_RESOURCE_AUDIO );
+
+	FUNCTION_FINISH;
+	return SUCCESS;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void DestroyFrameTaskGraphs( void )
+	\brief		Destroy the task graphs of BeginUpdate, Update and EndUpdate
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::DestroyFrameTaskGraphs( void )
+{
+	FUNCTION_START;
+
+	if( beginUpdateGraph )
+	{
+		delete beginUpdateGraph;
+		beginUpdateGraph = NULL;
+	}
+
+	if( simulationGraph )
+	{
+		delete simulationGraph;
+		simulationGraph = NULL;
+	}
+
+	if( renderGraph )
+	{
+		delete renderGraph;
+		renderGraph = NULL;
+	}
+
+	if( endUpdateGraph )
+	{
+		delete endUpdateGraph;
+		endUpdateGraph = NULL;
+	}
+
+	FUNCTION_FINISH;
+}
@@ -22,6 +22,10 @@ namespace GameEngine
 
 	bool IsDebugMenuActivated( void );
 	void SetDebugMenu( const bool i_state );
+
+	bool IsDeterministic( void );
+	UINT32 GetSimulationTick( void );
+	UINT32 GetStateChecksum( void );
 }
 
 #endif
\ No newline at end of file
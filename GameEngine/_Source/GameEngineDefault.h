@@ -34,6 +34,17 @@ namespace GameEngine
 	const UINT32 MAX_CONNECTION = 100;
 	const UINT32 NETWORK_PORT = 7000;
 
+	// Simulation, overridden by "simulationRate" and "maxSimulationSteps" of the GameEngine config
+	const UINT32 DEFAULT_SIMULATION_RATE = 60;
+	const UINT32 DEFAULT_MAX_SIMULATION_STEPS = 5;
+	// Simulation steps a body has to be at rest before it is put to sleep
+	const UINT8 DEFAULT_SLEEP_STEPS = 30;
+	// Time spent on path requests per frame, a fixed count per step in deterministic mode
+	const UINT32 DEFAULT_PATH_BUDGET_US = 500;
+	const UINT32 DEFAULT_PATH_REQUESTS_PER_STEP = 4;
+	// Goals whose distance to every way point is kept for FindDistanceToNodeID and the path requests
+	const UINT32 DEFAULT_GOAL_FIELDS = 8;
+
 	const float DEFAULT_FRICTION = 0.009f;
 	const float AUDIO_3D_MIN_DISTANCE = 0.5f;
 	const float AUDIO_3D_MAX_DISTANCE = 0.5f;
@@ -39,6 +39,9 @@ namespace GameEngine
 
 		const D3DXMATRIX GetWorldToViewTransform( void ) const;
 		const D3DXMATRIX GetViewToProjectedTransform( void ) const;
+		inline const D3DXVECTOR3 &GetLookAt( void ) const;
+		inline const float GetNearView( void ) const;
+		inline const Utilities::S_SIZE GetSize( void ) const;
 	};
 }
 
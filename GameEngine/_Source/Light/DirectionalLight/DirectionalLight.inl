@@ -63,4 +63,49 @@ DirectionalLight::DirectionalLight( const D3DXVECTOR3 &i_direction, const D3DXVE
 DirectionalLight::~DirectionalLight( void )
 {
 }
+
+/**
+ ****************************************************************************************************
+	\fn			const D3DXVECTOR3 &GetLookAt( void ) const
+	\brief		Get the look at point of directional light
+	\param		NONE
+	\return		D3DXVECTOR3
+ ****************************************************************************************************
+*/
+const D3DXVECTOR3 &DirectionalLight::GetLookAt( void ) const
+{
+	return _lookAt;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			const float GetNearView( void ) const
+	\brief		Get the near view distance of directional light
+	\param		NONE
+	\return		float
+ ****************************************************************************************************
+*/
+const float DirectionalLight::GetNearView( void ) const
+{
+	return _nearView;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			const Utilities::S_SIZE GetSize( void ) const
+	\brief		Get the size of directional light
+	\param		NONE
+	\return		Utilities::S_SIZE
+ ****************************************************************************************************
+*/
+const Utilities::S_SIZE DirectionalLight::GetSize( void ) const
+{
+	Utilities::S_SIZE size;
+
+	size.width = _width;
+	size.height = _height;
+	size.depth = 0.0f;
+
+	return size;
+}
 }	// namespace GameEngine
\ No newline at end of file
@@ -6,20 +6,66 @@
 */
 
 #include <vector>
+#include <algorithm>
+#include <string.h>
 
 // Utilities header
 #include <Time/Time.h>
 #include <Debug/Debug.h>
+#include <JobSystem/JobSystem.h>
+#include <TaskGraph/TaskGraph.h>
+#include <HandleTable/HandleTable.h>
 #include <MemoryPool/MemoryPool.h>
+#include <Target/Target.h>
+
+#ifdef TARGET_SSE
+	#include <xmmintrin.h>
+#endif	// #ifdef TARGET_SSE
 
 #include "Physics.h"
+#include "../GameEngine.h"
+#include "../World/World.h"
 #include "../World/Entity.h"
+#include "../World/EntityStore.h"
+#include "../Collision/Collision.h"
+#include "../TriggerBox/TriggerBox.h"
 #include "../Utilities/Profiler/Profiler.h"
+#include "../Utilities/GameEngineTypes.h"
 
 namespace GameEngine
 {
 	namespace Physics
 	{
+		// Bodies processed by one job, a multiple of PHYSICS_PACKET_SIZE
+		const UINT32 PHYSICS_GRAIN_SIZE = 1024;
+		// Bodies integrated at once when their store slots follow each other
+		const UINT32 PHYSICS_PACKET_SIZE = 4;
+
+		// One column per field, parallel to physicsEntityDatabase. The awake bodies come first, the
+		// sleeping ones after them
+		typedef struct _s_physics_bodies_
+		{
+			std::vector<UINT32>	u32Handle;
+			std::vector<UINT32>	u32StoreSlot;
+			std::vector<float>	friction;
+			// Simulation steps the body has been at rest
+			std::vector<UINT8>	u8QuietSteps;
+			UINT32							u32TotalAwake;
+		} S_PHYSICS_BODIES;
+
+		typedef struct _s_physics_job_data_
+		{
+			const UINT32 *u32StoreSlot;
+			const float *friction;
+			UINT8 *u8QuietSteps;
+			Math::Vector3 *v3Position;
+			Math::Vector3 *v3Velocity;
+			Math::Vector3 *v3Acceleration;
+			Math::Vector3 *v3ProjectedPosition;
+			Math::Vector3 *v3ProjectedVelocity;
+			float timeStep_ms;
+		} S_PHYSICS_JOB_DATA;
+
 		class PhysicsEntity
 		{
 			PhysicsEntity( void ) {}
@@ -34,7 +80,6 @@ namespace GameEngine
 		public:
 			static Utilities::MemoryPool *_physicsEntityPool;
 
-			float						m_friction;
 			Utilities::Pointer::SmartPtr<Entity>	m_entity;
 
 			PhysicsEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity );
@@ -43,14 +88,20 @@ namespace GameEngine
 
 			void *operator new( size_t i_size );
 			void operator delete( void *i_ptr );
-
-			void MoveTo( const Math::Vector3 &i_newPosition );
-			void Move( void );
-			void FinalizeMovement( void );
 		};
 
 		static std::vector< Utilities::Pointer::SmartPtr<GameEngine::Physics::PhysicsEntity> > *physicsEntityDatabase;
-		void RemoveDeadEntities( void );
+		// Only this is touched by the per-frame loops
+		static S_PHYSICS_BODIES *physicsBodies;
+		static Utilities::HandleTable *physicsHandleTable;
+		void GetPhysicsJobData( S_PHYSICS_JOB_DATA &o_jobData );
+		inline bool IsPacked( const UINT32 *i_u32StoreSlot );
+		void SwapBodies( const UINT32 &i_u32IndexA, const UINT32 &i_u32IndexB );
+		void SetSleeping( const UINT32 &i_u32Index, const bool &i_bSleeping );
+		void WakeBody( const UINT32 &i_u32Index );
+		void PutQuietBodiesToSleep( void );
+		void ProjectBodies( void *i_data, const UINT32 &i_u32Begin, const UINT32 &i_u32End );
+		void FinalizeBodies( void *i_data, const UINT32 &i_u32Begin, const UINT32 &i_u32End );
 	}	// namespace Physics
 }	// namespace GameEngine
 
@@ -77,8 +128,14 @@ bool GameEngine::Physics::Initialize( void )
 
 	PhysicsEntity::_physicsEntityPool = Utilities::MemoryPool::Create( sizeof(PhysicsEntity), Utilities::DEFAULT_MEMORY_POOL_SIZE );
 	physicsEntityDatabase = new std::vector< Utilities::Pointer::SmartPtr<PhysicsEntity> >;
+	physicsBodies = new S_PHYSICS_BODIES;
+	physicsBodies->u32TotalAwake = 0;
+	physicsHandleTable = Utilities::HandleTable::Create( Utilities::DEFAULT_MEMORY_POOL_SIZE );
 
 	assert( PhysicsEntity::_physicsEntityPool );
+	assert( physicsHandleTable );
+	// The store vectors are read as plain floats by the packed loops
+	assert( sizeof(Math::Vector3) == (3 * sizeof(float)) );
 
 	FUNCTION_FINISH;
 	return SUCCESS;
@@ -111,15 +168,50 @@ void GameEngine::Physics::Update( void )
 {
 	PROFILE_UNSCOPED( "Physics" );
 
-	std::vector< Utilities::Pointer::SmartPtr<PhysicsEntity> >::iterator iter;
+	S_PHYSICS_JOB_DATA jobData;
 
 	FUNCTION_START;
 
-	for( iter = physicsEntityDatabase->begin(); iter != physicsEntityDatabase->end(); ++iter )
-	{
-		if( (*iter) != NULL )
-			(*iter)->Move();
-	}
+	TASK_CHECK_ACCESS( E_RESOURCE_POSITION | E_RESOURCE_VELOCITY,
+		E_RESOURCE_ACCELERATION | E_RESOURCE_PROJECTION | E_RESOURCE_PHYSICS );
+
+	// Every body only touches its own store slot, so the awake bodies are split across the workers.
+	// In deterministic mode they stay on this thread, whose float control word is fixed
+	GetPhysicsJobData( jobData );
+	if( IsDeterministic() )
+		ProjectBodies( &jobData, 0, physicsBodies->u32TotalAwake );
+	else
+		Utilities::JobSystem::ParallelFor( ProjectBodies, &jobData, physicsBodies->u32TotalAwake, PHYSICS_GRAIN_SIZE );
+	PROFILE_COUNTER( "Physics awake bodies", physicsBodies->u32TotalAwake );
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void CommitUpdate( void )
+	\brief		Commit the projected position and velocity once collision and trigger box have
+				responded to them, this ends one simulation step. Bodies which have been at rest long
+				enough are put to sleep, collision and trigger box stop updating them
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Physics::CommitUpdate( void )
+{
+	S_PHYSICS_JOB_DATA jobData;
+
+	FUNCTION_START;
+
+	TASK_CHECK_ACCESS( E_RESOURCE_PROJECTION,
+		E_RESOURCE_POSITION | E_RESOURCE_VELOCITY | E_RESOURCE_PHYSICS | E_RESOURCE_COLLISION | E_RESOURCE_TRIGGER_BOX );
+
+	GetPhysicsJobData( jobData );
+	if( IsDeterministic() )
+		FinalizeBodies( &jobData, 0, physicsBodies->u32TotalAwake );
+	else
+		Utilities::JobSystem::ParallelFor( FinalizeBodies, &jobData, physicsBodies->u32TotalAwake, PHYSICS_GRAIN_SIZE );
+	PutQuietBodiesToSleep();
 
 	FUNCTION_FINISH;
 }
@@ -134,17 +226,8 @@ void GameEngine::Physics::Update( void )
 */
 void GameEngine::Physics::EndUpdate( void )
 {
-	std::vector< Utilities::Pointer::SmartPtr<PhysicsEntity> >::iterator iter;
-
 	FUNCTION_START;
 
-	RemoveDeadEntities();
-	for( iter = physicsEntityDatabase->begin(); iter != physicsEntityDatabase->end(); ++iter )
-	{
-		if( (*iter) != NULL )
-			(*iter)->FinalizeMovement();
-	}
-
 	FUNCTION_FINISH;
 }
 
@@ -166,6 +249,18 @@ void GameEngine::Physics::ShutDown( void )
 		physicsEntityDatabase = NULL;
 	}
 
+	if( physicsBodies )
+	{
+		delete physicsBodies;
+		physicsBodies = NULL;
+	}
+
+	if( physicsHandleTable )
+	{
+		delete physicsHandleTable;
+		physicsHandleTable = NULL;
+	}
+
 	if( PhysicsEntity::_physicsEntityPool )
 	{
 		delete PhysicsEntity::_physicsEntityPool;
@@ -177,178 +272,425 @@ void GameEngine::Physics::ShutDown( void )
 
 /**
  ****************************************************************************************************
-	\fn			UINT8 AddPhysicsEntity( Entity *i_entity )
+	\fn			UINT32 AddPhysicsEntity( Entity *i_entity )
 	\brief		Add physics entity to physicsEntityDatabase
 	\param		*i_entity entity to be added
-	\return		UINT8
-	\retval		index of the new added physics entity in database
+	\return		UINT32
+	\retval		handle of the new added physics entity
+	\retval		INVALID_HANDLE if the database is full
  ****************************************************************************************************
 */
-UINT8 GameEngine::Physics::AddPhysicsEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity )
+UINT32 GameEngine::Physics::AddPhysicsEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity )
 {
 	FUNCTION_START;
 
+	UINT32 u32Handle = physicsHandleTable->Add( physicsEntityDatabase->size() );
+	if( u32Handle == Utilities::INVALID_HANDLE )
+	{
+		DBG_MSG_LEVEL( D_ERR, "Physics entity database is full\n" );
+		FUNCTION_FINISH;
+		return Utilities::INVALID_HANDLE;
+	}
+
 	physicsEntityDatabase->push_back( new PhysicsEntity(i_entity) );
+	physicsBodies->u32Handle.push_back( u32Handle );
+	physicsBodies->u32StoreSlot.push_back( i_entity->m_u32StoreSlot );
+	physicsBodies->friction.push_back( DEFAULT_FRICTION );
+	physicsBodies->u8QuietSteps.push_back( 0 );
+
+	// New bodies start awake
+	SwapBodies( physicsBodies->u32TotalAwake, physicsEntityDatabase->size() - 1 );
+	++physicsBodies->u32TotalAwake;
 
 	FUNCTION_FINISH;
-	return physicsEntityDatabase->size() - 1;
+	return u32Handle;
 }
 
 /**
  ****************************************************************************************************
-	\fn			void SetFriction( UINT8 &i_u8Index, const float &i_friction )
-	\brief		Add physics entity to physicsEntityDatabase
-	\param		i_u8Index index of entity in physics entity
+	\fn			void RemovePhysicsEntity( UINT32 &io_u32Handle )
+	\brief		Remove physics entity from physicsEntityDatabase
+	\param		io_u32Handle handle of the physics entity, set to INVALID_HANDLE once removed
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Physics::RemovePhysicsEntity( UINT32 &io_u32Handle )
+{
+	FUNCTION_START;
+
+	if( physicsHandleTable->IsValid(io_u32Handle) )
+	{
+		UINT32 u32Index = physicsHandleTable->GetIndex( io_u32Handle );
+
+		// Move an awake body to the end of the awake ones first, the last body is then a sleeping one
+		if( u32Index < physicsBodies->u32TotalAwake )
+		{
+			SwapBodies( u32Index, --physicsBodies->u32TotalAwake );
+			u32Index = physicsBodies->u32TotalAwake;
+		}
+		SetSleeping( u32Index, false );
+
+		SwapBodies( u32Index, physicsEntityDatabase->size() - 1 );
+		physicsHandleTable->Remove( io_u32Handle );
+		physicsEntityDatabase->pop_back();
+		physicsBodies->u32Handle.pop_back();
+		physicsBodies->u32StoreSlot.pop_back();
+		physicsBodies->friction.pop_back();
+		physicsBodies->u8QuietSteps.pop_back();
+	}
+
+	io_u32Handle = Utilities::INVALID_HANDLE;
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void SetFriction( const UINT32 &i_u32Handle, const float &i_friction )
+	\brief		Set friction of the physics entity
+	\param		i_u32Handle handle of the physics entity
 	\param		i_friction new friction
 	\return		NONE
  ****************************************************************************************************
 */
-void GameEngine::Physics::SetFriction( const UINT8 &i_u8Index, const float &i_friction )
+void GameEngine::Physics::SetFriction( const UINT32 &i_u32Handle, const float &i_friction )
 {
 	FUNCTION_START;
 
-	if( i_u8Index < physicsEntityDatabase->size() )
-		physicsEntityDatabase->at(i_u8Index)->m_friction = i_friction;
+	if( physicsHandleTable->IsValid(i_u32Handle) )
+		physicsBodies->friction.at( physicsHandleTable->GetIndex(i_u32Handle) ) = i_friction;
 
 	FUNCTION_FINISH;
 }
 
-/****************************************************************************************************
-			Private function implementation
-****************************************************************************************************/
 /**
  ****************************************************************************************************
-	\fn			void RemoveDeadEntities( void )
-	\brief		Remove dead entities
-	\param		*im_entity entity to be added
+	\fn			void WakeUp( const UINT32 &i_u32Handle )
+	\brief		Wake up a sleeping physics entity, it is integrated again from the next simulation step
+	\param		i_u32Handle handle of the physics entity
 	\return		NONE
  ****************************************************************************************************
 */
-void GameEngine::Physics::RemoveDeadEntities( void )
+void GameEngine::Physics::WakeUp( const UINT32 &i_u32Handle )
 {
 	FUNCTION_START;
 
-	for( UINT8 i = 0; i < physicsEntityDatabase->size(); ++i )
+	if( physicsHandleTable->IsValid(i_u32Handle) )
 	{
-		if( physicsEntityDatabase->at(i)->m_entity->m_isDestroyed )
-		{
-			physicsEntityDatabase->back()->m_entity->m_u8PhysicsEntityIndex = physicsEntityDatabase->at(i)->m_entity->m_u8PhysicsEntityIndex;
-			physicsEntityDatabase->at(i) = physicsEntityDatabase->back();
-			physicsEntityDatabase->pop_back();
-		}
+		UINT32 u32Index = physicsHandleTable->GetIndex( i_u32Handle );
+
+		if( u32Index >= physicsBodies->u32TotalAwake )
+			WakeBody( u32Index );
 	}
 
 	FUNCTION_FINISH;
 }
 
 /****************************************************************************************************
-			PhysicsEntity class implementation
+			Private function implementation
 ****************************************************************************************************/
 /**
  ****************************************************************************************************
-	\fn			PhysicsEntity( Pointer::SmartPtr<Entity> &im_entity )
-	\brief		Default constructor of PhysicsEntity
-	\param		&im_entity pointer to common entity data
+	\fn			void SwapBodies( const UINT32 &i_u32IndexA, const UINT32 &i_u32IndexB )
+	\brief		Swap two bodies in the database and in the handle table
+	\param		i_u32IndexA index of the first body
+	\param		i_u32IndexB index of the second body
 	\return		NONE
  ****************************************************************************************************
 */
-GameEngine::Physics::PhysicsEntity::PhysicsEntity( Utilities::Pointer::SmartPtr<Entity> &im_entity ) :
-	m_entity( im_entity ),
-	m_friction( DEFAULT_FRICTION )
+void GameEngine::Physics::SwapBodies( const UINT32 &i_u32IndexA, const UINT32 &i_u32IndexB )
 {
+	FUNCTION_START;
+
+	if( i_u32IndexA != i_u32IndexB )
+	{
+		std::swap( physicsEntityDatabase->at(i_u32IndexA), physicsEntityDatabase->at(i_u32IndexB) );
+		std::swap( physicsBodies->u32Handle.at(i_u32IndexA), physicsBodies->u32Handle.at(i_u32IndexB) );
+		std::swap( physicsBodies->u32StoreSlot.at(i_u32IndexA), physicsBodies->u32StoreSlot.at(i_u32IndexB) );
+		std::swap( physicsBodies->friction.at(i_u32IndexA), physicsBodies->friction.at(i_u32IndexB) );
+		std::swap( physicsBodies->u8QuietSteps.at(i_u32IndexA), physicsBodies->u8QuietSteps.at(i_u32IndexB) );
+
+		physicsHandleTable->SetIndex( physicsBodies->u32Handle.at(i_u32IndexA), i_u32IndexA );
+		physicsHandleTable->SetIndex( physicsBodies->u32Handle.at(i_u32IndexB), i_u32IndexB );
+	}
+
+	FUNCTION_FINISH;
 }
 
 /**
  ****************************************************************************************************
-	\fn			void *operator new( size_t i_size )
-	\brief		New operator of PhysicsEntity class
-	\param		i_size size to be created
-	\return		Pointer to allocated memory
+	\fn			void SetSleeping( const UINT32 &i_u32Index, const bool &i_bSleeping )
+	\brief		Set whether the entity of a body sleeps and tell collision and trigger box, they only
+				update the awake entities
+	\param		i_u32Index index of the body
+	\param		i_bSleeping whether the entity sleeps
+	\return		NONE
  ****************************************************************************************************
 */
-void *GameEngine::Physics::PhysicsEntity::operator new( size_t i_size )
+void GameEngine::Physics::SetSleeping( const UINT32 &i_u32Index, const bool &i_bSleeping )
 {
 	FUNCTION_START;
 
-	assert( i_size == sizeof(PhysicsEntity) );
-	assert( _physicsEntityPool );
+	Utilities::Pointer::SmartPtr<Entity> &entity = physicsEntityDatabase->at( i_u32Index )->m_entity;
+
+	g_world::Get().GetEntityStore().m_isSleeping[physicsBodies->u32StoreSlot.at(i_u32Index)] = i_bSleeping;
+	Collision::SetSleeping( entity->m_u32CollisionEntityHandle, i_bSleeping );
+	TriggerBox::SetSleeping( entity->m_u32TriggerBoxEntityHandle, i_bSleeping );
 
 	FUNCTION_FINISH;
-	return _physicsEntityPool->Allocate( sizeof(PhysicsEntity) );
 }
 
 /**
  ****************************************************************************************************
-	\fn			void operator delete( void *i_ptr )
-	\brief		Delete operator of PhysicsEntity class
-	\param		i_ptr pointer to be deleted
+	\fn			void WakeBody( const UINT32 &i_u32Index )
+	\brief		Move a sleeping body to the end of the awake bodies
+	\param		i_u32Index index of the sleeping body
 	\return		NONE
  ****************************************************************************************************
 */
-void GameEngine::Physics::PhysicsEntity::operator delete( void *i_ptr )
+void GameEngine::Physics::WakeBody( const UINT32 &i_u32Index )
 {
-	FUNCTION_START;
+	assert( i_u32Index >= physicsBodies->u32TotalAwake );
 
-	assert( _physicsEntityPool );
+	FUNCTION_START;
 
-	if( i_ptr )
-		_physicsEntityPool->Deallocate( i_ptr );
+	SetSleeping( i_u32Index, false );
+	physicsBodies->u8QuietSteps.at( i_u32Index ) = 0;
+	SwapBodies( i_u32Index, physicsBodies->u32TotalAwake );
+	++physicsBodies->u32TotalAwake;
 
 	FUNCTION_FINISH;
 }
 
 /**
  ****************************************************************************************************
-	\fn			void MoveTo( const Vector3 &i_newPosition )
-	\brief		Move Entity to given position
-	\param		&i_newPosition new _v3Position
+	\fn			void PutQuietBodiesToSleep( void )
+	\brief		Put the bodies which have been at rest for DEFAULT_SLEEP_STEPS to sleep
+	\param		NONE
 	\return		NONE
  ****************************************************************************************************
 */
-void GameEngine::Physics::PhysicsEntity::MoveTo( const Math::Vector3 &i_newPosition )
+void GameEngine::Physics::PutQuietBodiesToSleep( void )
 {
 	FUNCTION_START;
 
-	m_entity->m_v3Position = i_newPosition;
+	// From the back, so the body swapped in has already been checked
+	for( UINT32 i = physicsBodies->u32TotalAwake; i-- > 0; )
+	{
+		if( physicsBodies->u8QuietSteps[i] >= DEFAULT_SLEEP_STEPS )
+		{
+			SetSleeping( i, true );
+			SwapBodies( i, --physicsBodies->u32TotalAwake );
+		}
+	}
 
 	FUNCTION_FINISH;
 }
 
 /**
  ****************************************************************************************************
-	\fn			void Move( void )
-	\brief		Move Entity to given direction
-	\param		NONE
+	\fn			void GetPhysicsJobData( S_PHYSICS_JOB_DATA &o_jobData )
+	\brief		Collect the arrays used by the physics jobs of this simulation step
+	\param		o_jobData the job data
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Physics::GetPhysicsJobData( S_PHYSICS_JOB_DATA &o_jobData )
+{
+	EntityStore &entityStore = g_world::Get().GetEntityStore();
+
+	o_jobData.u32StoreSlot = physicsBodies->u32StoreSlot.empty() ? NULL : &physicsBodies->u32StoreSlot.front();
+	o_jobData.friction = physicsBodies->friction.empty() ? NULL : &physicsBodies->friction.front();
+	o_jobData.u8QuietSteps = physicsBodies->u8QuietSteps.empty() ? NULL : &physicsBodies->u8QuietSteps.front();
+	o_jobData.v3Position = entityStore.m_v3Position;
+	o_jobData.v3Velocity = entityStore.m_v3Velocity;
+	o_jobData.v3Acceleration = entityStore.m_v3Acceleration;
+	o_jobData.v3ProjectedPosition = entityStore.m_v3ProjectedPosition;
+	o_jobData.v3ProjectedVelocity = entityStore.m_v3ProjectedVelocity;
+	o_jobData.timeStep_ms = Utilities::Time::GetFixedTimeStep_ms();
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool IsPacked( const UINT32 *i_u32StoreSlot )
+	\brief		Check whether a packet of bodies lies in consecutive store slots, their vectors are then
+				stored back to back
+	\param		i_u32StoreSlot store slots of the packet
+	\return		bool
+	\retval		TRUE if the store slots follow each other
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+inline bool GameEngine::Physics::IsPacked( const UINT32 *i_u32StoreSlot )
+{
+	for( UINT32 i = 1; i < PHYSICS_PACKET_SIZE; ++i )
+	{
+		if( i_u32StoreSlot[i] != i_u32StoreSlot[0] + i )
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void ProjectBodies( void *i_data, const UINT32 &i_u32Begin, const UINT32 &i_u32End )
+	\brief		Project the position and velocity of a range of bodies to the end of this step. Bodies of
+				consecutive store slots are integrated a packet at a time, the twelve floats of four
+				vectors as three SSE vectors with the friction of every body spread over its components
+	\param		i_data S_PHYSICS_JOB_DATA of this step
+	\param		i_u32Begin first body
+	\param		i_u32End one past the last body
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Physics::ProjectBodies( void *i_data, const UINT32 &i_u32Begin, const UINT32 &i_u32End )
+{
+	const S_PHYSICS_JOB_DATA &jobData = *reinterpret_cast<S_PHYSICS_JOB_DATA *>( i_data );
+	UINT32 i = i_u32Begin;
+
+#ifdef TARGET_SSE
+	const __m128 timeStep = _mm_set1_ps( jobData.timeStep_ms );
+#endif	// #ifdef TARGET_SSE
+
+	while( i < i_u32End )
+	{
+		const UINT32 u32Slot = jobData.u32StoreSlot[i];
+
+#ifdef TARGET_SSE
+		if( (i + PHYSICS_PACKET_SIZE <= i_u32End) && IsPacked(jobData.u32StoreSlot + i) )
+		{
+			const float *position = reinterpret_cast<const float *>( jobData.v3Position + u32Slot );
+			const float *velocity = reinterpret_cast<const float *>( jobData.v3Velocity + u32Slot );
+			float *acceleration = reinterpret_cast<float *>( jobData.v3Acceleration + u32Slot );
+			float *projectedPosition = reinterpret_cast<float *>( jobData.v3ProjectedPosition + u32Slot );
+			float *projectedVelocity = reinterpret_cast<float *>( jobData.v3ProjectedVelocity + u32Slot );
+			const __m128 friction = _mm_loadu_ps( jobData.friction + i );
+			__m128 bodyFriction[3];
+
+			// x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+			bodyFriction[0] = _mm_shuffle_ps( friction, friction, _MM_SHUFFLE(1, 0, 0, 0) );
+			bodyFriction[1] = _mm_shuffle_ps( friction, friction, _MM_SHUFFLE(2, 2, 1, 1) );
+			bodyFriction[2] = _mm_shuffle_ps( friction, friction, _MM_SHUFFLE(3, 3, 3, 2) );
+
+			for( UINT8 j = 0; j < 3; ++j )
+			{
+				const __m128 v = _mm_loadu_ps( velocity + j * 4 );
+				const __m128 a = _mm_mul_ps( _mm_loadu_ps(acceleration + j * 4), bodyFriction[j] );
+
+				_mm_storeu_ps( projectedPosition + j * 4, _mm_add_ps(_mm_loadu_ps(position + j * 4), _mm_mul_ps(timeStep, v)) );
+				_mm_storeu_ps( acceleration + j * 4, a );
+				_mm_storeu_ps( projectedVelocity + j * 4, _mm_add_ps(v, _mm_mul_ps(timeStep, a)) );
+			}
+
+			i += PHYSICS_PACKET_SIZE;
+			continue;
+		}
+#endif	// #ifdef TARGET_SSE
+
+		jobData.v3ProjectedPosition[u32Slot] = jobData.v3Position[u32Slot] + (jobData.timeStep_ms * jobData.v3Velocity[u32Slot]);
+		jobData.v3Acceleration[u32Slot] *= jobData.friction[i];
+		jobData.v3ProjectedVelocity[u32Slot] = jobData.v3Velocity[u32Slot] + (jobData.timeStep_ms * jobData.v3Acceleration[u32Slot]);
+		++i;
+	}
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void FinalizeBodies( void *i_data, const UINT32 &i_u32Begin, const UINT32 &i_u32End )
+	\brief		Commit the projected position and velocity of a range of bodies and count the steps
+				they have been at rest. Bodies of consecutive store slots are committed as one block
+	\param		i_data S_PHYSICS_JOB_DATA of this step
+	\param		i_u32Begin first body
+	\param		i_u32End one past the last body
 	\return		NONE
  ****************************************************************************************************
 */
-void GameEngine::Physics::PhysicsEntity::Move( void )
+void GameEngine::Physics::FinalizeBodies( void *i_data, const UINT32 &i_u32Begin, const UINT32 &i_u32End )
 {
-	float frameTime_ms = Utilities::Time::GetTimeElapsedThisFrame_ms();
+	const S_PHYSICS_JOB_DATA &jobData = *reinterpret_cast<S_PHYSICS_JOB_DATA *>( i_data );
+	UINT32 u32Bodies;
 
+	for( UINT32 i = i_u32Begin; i < i_u32End; i += u32Bodies )
+	{
+		const UINT32 u32Slot = jobData.u32StoreSlot[i];
+
+		for( u32Bodies = 0; i + u32Bodies < i_u32End; ++u32Bodies )
+		{
+			const UINT32 u32BodySlot = u32Slot + u32Bodies;
+			UINT8 &u8QuietSteps = jobData.u8QuietSteps[i + u32Bodies];
+
+			if( jobData.u32StoreSlot[i + u32Bodies] != u32BodySlot )
+				break;
+
+			if( (jobData.v3ProjectedPosition[u32BodySlot] == jobData.v3Position[u32BodySlot])
+				&& (jobData.v3ProjectedVelocity[u32BodySlot] == Math::Vector3::Zero) && (jobData.v3Acceleration[u32BodySlot] == Math::Vector3::Zero) )
+			{
+				if( u8QuietSteps < Utilities::MAX_UINT8 )
+					++u8QuietSteps;
+			}
+			else
+			{
+				u8QuietSteps = 0;
+			}
+		}
+
+		memcpy( jobData.v3Velocity + u32Slot, jobData.v3ProjectedVelocity + u32Slot, sizeof(Math::Vector3) * u32Bodies );
+		memcpy( jobData.v3Position + u32Slot, jobData.v3ProjectedPosition + u32Slot, sizeof(Math::Vector3) * u32Bodies );
+	}
+}
+
+/****************************************************************************************************
+			PhysicsEntity class implementation
+****************************************************************************************************/
+/**
+ ****************************************************************************************************
+	\fn			PhysicsEntity( Pointer::SmartPtr<Entity> &im_entity )
+	\brief		Default constructor of PhysicsEntity
+	\param		&im_entity pointer to common entity data
+	\return		NONE
+ ****************************************************************************************************
+*/
+GameEngine::Physics::PhysicsEntity::PhysicsEntity( Utilities::Pointer::SmartPtr<Entity> &im_entity ) :
+	m_entity( im_entity )
+{
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void *operator new( size_t i_size )
+	\brief		New operator of PhysicsEntity class
+	\param		i_size size to be created
+	\return		Pointer to allocated memory
+ ****************************************************************************************************
+*/
+void *GameEngine::Physics::PhysicsEntity::operator new( size_t i_size )
+{
 	FUNCTION_START;
 
-	m_entity->m_v3ProjectedPosition = m_entity->m_v3Position + (frameTime_ms * m_entity->m_v3Velocity);
-	m_entity->m_v3Acceleration *= m_friction;
-	m_entity->m_v3ProjectedVelocity = m_entity->m_v3Velocity + (frameTime_ms * m_entity->m_v3Acceleration);
+	assert( i_size == sizeof(PhysicsEntity) );
+	assert( _physicsEntityPool );
 
 	FUNCTION_FINISH;
+	return _physicsEntityPool->Allocate( sizeof(PhysicsEntity) );
 }
 
 /**
  ****************************************************************************************************
-	\fn			void FinalizeMovement( void )
-	\brief		Finalize Entity movement to given direction
-	\param		&i_frameTime_ms elapsed frame time (in ms)
+	\fn			void operator delete( void *i_ptr )
+	\brief		Delete operator of PhysicsEntity class
+	\param		i_ptr pointer to be deleted
 	\return		NONE
  ****************************************************************************************************
 */
-void GameEngine::Physics::PhysicsEntity::FinalizeMovement( void )
+void GameEngine::Physics::PhysicsEntity::operator delete( void *i_ptr )
 {
 	FUNCTION_START;
 
-	m_entity->m_v3Velocity = m_entity->m_v3ProjectedVelocity;
-	m_entity->m_v3Position = m_entity->m_v3ProjectedPosition;
+	assert( _physicsEntityPool );
+
+	if( i_ptr )
+		_physicsEntityPool->Deallocate( i_ptr );
 
 	FUNCTION_FINISH;
 }
\ No newline at end of file
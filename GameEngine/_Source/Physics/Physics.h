@@ -22,11 +22,14 @@ namespace GameEngine
 		bool Initialize( void );
 		void BeginUpdate( void );
 		void Update( void );
+		void CommitUpdate( void );
 		void EndUpdate( void );
 		void ShutDown( void );
 
-		UINT8 AddPhysicsEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity );
-		void SetFriction( const UINT8 &i_u8Index, const float &i_friction );
+		UINT32 AddPhysicsEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity );
+		void RemovePhysicsEntity( UINT32 &io_u32Handle );
+		void SetFriction( const UINT32 &i_u32Handle, const float &i_friction );
+		void WakeUp( const UINT32 &i_u32Handle );
 	}
 }	// namespace GameEngine
 
@@ -9,8 +9,10 @@
 #include <vector>
 
 // Utilities header
+#include <Time/Time.h>
 #include <Parser/ParserHelper.h>
 #include <MemoryPool/MemoryPool.h>
+#include <HandleTable/HandleTable.h>
 #include <Parser/EntityParser/EntityParser.h>
 #include <Parser/EffectParser/EffectParser.h>
 #include <Parser/MaterialParser/MaterialParser.h>
@@ -24,6 +26,7 @@
 #include "../Camera/Camera.h"
 #include "../World/Entity.h"
 #include "../GameEngineDefault.h"
+#include "../World/EntityStore.h"
 #include "../DebugMenu/DebugMenu.h"
 #include "../Math/Vector3/Vector3.h"
 #include "../Utilities/GameEngineTypes.h"
@@ -77,9 +80,9 @@ namespace GameEngine
 
 		Utilities::S_SIZE g_windowSize;
 		static std::vector<Utilities::Pointer::SmartPtr<Sprite>> *spriteDatabase;
+		static Utilities::HandleTable *spriteHandleTable;
 		static std::vector<RendererEngine::S_QUAD_TO_DRAW> *quadToDraw;
 		static std::vector<RendererEngine::S_TEXT_TO_DRAW> *textToDraw;
-		void RemoveDeadSprites( void );
 
 		class Mesh
 		{
@@ -101,6 +104,8 @@ namespace GameEngine
 			static Utilities::MemoryPool *m_meshPool;
 
 			UINT32 m_u32EntityIndex;
+			// Handle of this mesh, an entity may own several meshes
+			UINT32 m_u32Handle;
  			Utilities::StringHash m_meshName;
 			Utilities::Pointer::SmartPtr<Entity> m_entity;
 
@@ -113,11 +118,13 @@ namespace GameEngine
 
 		static bool bReadyToRender = false;
 		static std::vector<Utilities::Pointer::SmartPtr<Mesh>> *meshDatabase;
+		static Utilities::HandleTable *meshHandleTable;
+		// Parallel to meshDatabase
 		static std::vector<RendererEngine::S_ENTITY_TO_DRAW> *entityDatabase;
+		// Entity store slot of each entityDatabase element
+		static std::vector<UINT32> *entityStoreSlot;
 		static std::vector<RendererEngine::S_LINE_TO_DRAW> *linesToDraw;
 		static std::vector<RendererEngine::S_SPHERE_TO_DRAW> *sphereToDraw;
-
-		void RemoveDeadAssets( void );
 	}	// namespace Renderer
 }	// namespace GameEngine
 
@@ -164,7 +171,9 @@ bool GameEngine::Renderer::Initialize( const char* i_GameName, const UINT16 &i_u
 	assert( Sprite::m_spritePool == NULL );
 	Sprite::m_spritePool = Utilities::MemoryPool::Create( sizeof(Sprite), Utilities::DEFAULT_MEMORY_POOL_SIZE );
 	spriteDatabase = new std::vector< Utilities::Pointer::SmartPtr<Sprite> >;
+	spriteHandleTable = Utilities::HandleTable::Create( Utilities::DEFAULT_MEMORY_POOL_SIZE );
 	assert( Sprite::m_spritePool );
+	assert( spriteHandleTable );
 
 	linesToDraw = new std::vector< RendererEngine::S_LINE_TO_DRAW >;
 	sphereToDraw = new std::vector< RendererEngine::S_SPHERE_TO_DRAW >;
@@ -174,9 +183,12 @@ bool GameEngine::Renderer::Initialize( const char* i_GameName, const UINT16 &i_u
 	assert( Mesh::m_meshPool == NULL );
 	Mesh::m_meshPool = Utilities::MemoryPool::Create( sizeof(Mesh), Utilities::DEFAULT_MEMORY_POOL_SIZE );
 	meshDatabase = new std::vector< Utilities::Pointer::SmartPtr<Mesh> >;
+	meshHandleTable = Utilities::HandleTable::Create( Utilities::DEFAULT_MEMORY_POOL_SIZE );
 	assert( Mesh::m_meshPool );
+	assert( meshHandleTable );
 
 	entityDatabase = new std::vector< RendererEngine::S_ENTITY_TO_DRAW >;
+	entityStoreSlot = new std::vector<UINT32>;
 
 	FUNCTION_FINISH;
 	return SUCCESS;
@@ -193,8 +205,6 @@ bool GameEngine::Renderer::Initialize( const char* i_GameName, const UINT16 &i_u
 void GameEngine::Renderer::BeginUpdate( void )
 {
 	FUNCTION_START;
-	
-	RemoveDeadSprites();
 
 	// The actual function calls that draw geometry must be made between paired calls to
 	// BeginScene() and EndScene()
@@ -229,13 +239,24 @@ void GameEngine::Renderer::Update( void )
 		return;
 	}
 
-	for( UINT32 i = 0; i < entityDatabase->size(); ++i )
+	EntityStore &entityStore = g_world::Get().GetEntityStore();
+	const UINT32 u32TotalEntities = entityDatabase->size();
+	const float alpha = Utilities::Time::GetInterpolationAlpha();
+
+	for( UINT32 i = 0; i < u32TotalEntities; ++i )
 	{
-		entityDatabase->at(i).position.x = meshDatabase->at(i)->m_entity->m_v3Position.X();
-		entityDatabase->at(i).position.y = meshDatabase->at(i)->m_entity->m_v3Position.Y();
-		entityDatabase->at(i).position.z = meshDatabase->at(i)->m_entity->m_v3Position.Z();
-		entityDatabase->at(i).orientation = meshDatabase->at(i)->m_entity->m_orientation;
-		entityDatabase->at(i).scale = meshDatabase->at(i)->m_entity->m_vScale;
+		const UINT32 u32Slot = (*entityStoreSlot)[i];
+		RendererEngine::S_ENTITY_TO_DRAW &entityToDraw = (*entityDatabase)[i];
+
+		// The simulation runs at a fixed step, draw the entity between its last two steps
+		const Math::Vector3 &v3Previous = entityStore.m_v3PreviousPosition[u32Slot];
+		const Math::Vector3 v3Position = v3Previous + (alpha * (entityStore.m_v3Position[u32Slot] - v3Previous));
+
+		entityToDraw.position.x = v3Position.X();
+		entityToDraw.position.y = v3Position.Y();
+		entityToDraw.position.z = v3Position.Z();
+		entityToDraw.orientation = entityStore.m_orientation[u32Slot];
+		entityToDraw.scale = entityStore.m_vScale[u32Slot];
 	}
 
 	RendererEngine::Draw3D( *entityDatabase, *linesToDraw, *sphereToDraw,
@@ -317,6 +338,12 @@ void GameEngine::Renderer::ShutDown( void )
 		spriteDatabase = NULL;
 	}
 
+	if( spriteHandleTable )
+	{
+		delete spriteHandleTable;
+		spriteHandleTable = NULL;
+	}
+
 	if( linesToDraw )
 	{
 		delete linesToDraw;
@@ -347,12 +374,24 @@ void GameEngine::Renderer::ShutDown( void )
 		meshDatabase = NULL;
 	}
 
+	if( meshHandleTable )
+	{
+		delete meshHandleTable;
+		meshHandleTable = NULL;
+	}
+
 	if( entityDatabase )
 	{
 		delete entityDatabase;
 		entityDatabase = NULL;
 	}
 
+	if( entityStoreSlot )
+	{
+		delete entityStoreSlot;
+		entityStoreSlot = NULL;
+	}
+
 	if( textToDraw )
 	{
 		delete textToDraw;
@@ -373,19 +412,57 @@ void GameEngine::Renderer::ShutDown( void )
 
 /**
  ****************************************************************************************************
-	\fn			void AddSprite( Pointer::SmartPtr<Entity> i_entity, const D3DCOLOR &i_colour, const std::string &i_textureFile )
+	\fn			UINT32 AddSprite( Pointer::SmartPtr<Entity> i_entity, const D3DCOLOR &i_colour, const std::string &i_textureFile )
 	\brief		Add renderer sprite
 	\param		*i_entity pointer to entity
 	\param		i_colour colour of sprite
-	\return		NONE
+	\return		UINT32
+	\retval		handle of the new added sprite
+	\retval		INVALID_HANDLE if the database is full
  ****************************************************************************************************
 */
-void GameEngine::Renderer::AddSprite( Utilities::Pointer::SmartPtr<Entity> &i_entity, const D3DCOLOR &i_colour, const char *i_textureFile )
+UINT32 GameEngine::Renderer::AddSprite( Utilities::Pointer::SmartPtr<Entity> &i_entity, const D3DCOLOR &i_colour, const char *i_textureFile )
 {
 	FUNCTION_START;
 
+	UINT32 u32Handle = spriteHandleTable->Add( spriteDatabase->size() );
+	if( u32Handle == Utilities::INVALID_HANDLE )
+	{
+		DBG_MSG_LEVEL( D_ERR, "Sprite database is full\n" );
+		FUNCTION_FINISH;
+		return Utilities::INVALID_HANDLE;
+	}
+
 	spriteDatabase->push_back( new Sprite(i_entity, i_colour, i_textureFile) );
 
+	FUNCTION_FINISH;
+	return u32Handle;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void RemoveSprite( UINT32 &io_u32Handle )
+	\brief		Remove sprite from spriteDatabase
+	\param		io_u32Handle handle of the sprite, set to INVALID_HANDLE once removed
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Renderer::RemoveSprite( UINT32 &io_u32Handle )
+{
+	FUNCTION_START;
+
+	if( spriteHandleTable->IsValid(io_u32Handle) )
+	{
+		UINT32 u32Index = spriteHandleTable->GetIndex( io_u32Handle );
+
+		spriteHandleTable->SetIndex( spriteDatabase->back()->m_entity->m_u32SpriteHandle, u32Index );
+		spriteHandleTable->Remove( io_u32Handle );
+		spriteDatabase->at(u32Index) = spriteDatabase->back();
+		spriteDatabase->pop_back();
+	}
+
+	io_u32Handle = Utilities::INVALID_HANDLE;
+
 	FUNCTION_FINISH;
 }
 
@@ -461,101 +538,87 @@ void GameEngine::Renderer::DrawSlider( const D3DXVECTOR2 &i_position,  const UIN
 
 /**
  ****************************************************************************************************
-	\fn			void AddAsset( Pointer::SmartPtr<Entity> &i_entity, const std::string &i_entityFile, const D3DXVECTOR3 &i_position, const float &i_orientation )
+	\fn			UINT32 AddMesh( Pointer::SmartPtr<Entity> &i_entity, const char *i_entityFile )
 	\brief		Add renderer asset
 	\param		*i_entity pointer to entity
 	\param		i_entityFile the file entity
-	\param		i_position the position of the asset in the world
-	\param		i_orientation the orientation of the asset in the world
-	\return		NONE
+	\return		UINT32
+	\retval		handle of the new added mesh
+	\retval		INVALID_HANDLE if the database is full
  ****************************************************************************************************
 */
-void GameEngine::Renderer::AddMesh( Utilities::Pointer::SmartPtr<Entity> &i_entity, const char*i_entityFile )
+UINT32 GameEngine::Renderer::AddMesh( Utilities::Pointer::SmartPtr<Entity> &i_entity, const char*i_entityFile )
 {
 	FUNCTION_START;
 
-	meshDatabase->push_back( new Mesh(i_entity, i_entityFile) );
+	UINT32 u32Handle = meshHandleTable->Add( meshDatabase->size() );
+	if( u32Handle == Utilities::INVALID_HANDLE )
+	{
+		DBG_MSG_LEVEL( D_ERR, "Mesh database is full\n" );
+		FUNCTION_FINISH;
+		return Utilities::INVALID_HANDLE;
+	}
 
-	FUNCTION_FINISH;
-}
+	meshDatabase->push_back( new Mesh(i_entity, i_entityFile) );
+	meshDatabase->back()->m_u32Handle = u32Handle;
 
-/**
- ****************************************************************************************************
-	\fn			S_SIZE GetWindowSize( void )
-	\brief		Get the size of current window
-	\param		NONE
-	\return		S_SIZE
- ****************************************************************************************************
-*/
-Utilities::S_SIZE &GameEngine::Renderer::GetWindowSize( void )
-{
-	FUNCTION_START;
 	FUNCTION_FINISH;
-
-	return g_windowSize;
+	return u32Handle;
 }
 
-/****************************************************************************************************
-			Private function implementation
-****************************************************************************************************/
 /**
  ****************************************************************************************************
-	\fn			void RemoveDeadSprites( void )
-	\brief		Removes dead sprites from database
-	\param		NONE
+	\fn			void RemoveMesh( UINT32 &io_u32Handle )
+	\brief		Remove mesh from meshDatabase together with its entry in entityDatabase
+	\param		io_u32Handle handle of the mesh, set to INVALID_HANDLE once removed
 	\return		NONE
  ****************************************************************************************************
 */
-void GameEngine::Renderer::RemoveDeadSprites( void )
+void GameEngine::Renderer::RemoveMesh( UINT32 &io_u32Handle )
 {
 	FUNCTION_START;
 
-	for( UINT32 i = 0; i < spriteDatabase->size(); ++i )
+	if( meshHandleTable->IsValid(io_u32Handle) )
 	{
-		if( spriteDatabase->at(i)->m_entity->m_isDestroyed )
-		{
-			UINT32 u32QuadIndex = spriteDatabase->at(i)->m_u32QuadIndex;
-			spriteDatabase->back()->m_u32QuadIndex = u32QuadIndex;
-			quadToDraw->at(u32QuadIndex) = quadToDraw->back();
-			quadToDraw->pop_back();
-
-			spriteDatabase->at(i) = spriteDatabase->back();
-			spriteDatabase->pop_back();
-		}
+		UINT32 u32Index = meshHandleTable->GetIndex( io_u32Handle );
+
+		assert( meshDatabase->at(u32Index)->m_u32EntityIndex == u32Index );
+
+		meshHandleTable->SetIndex( meshDatabase->back()->m_u32Handle, u32Index );
+		meshHandleTable->Remove( io_u32Handle );
+		meshDatabase->back()->m_u32EntityIndex = u32Index;
+		meshDatabase->at(u32Index) = meshDatabase->back();
+		meshDatabase->pop_back();
+		entityDatabase->at(u32Index) = entityDatabase->back();
+		entityDatabase->pop_back();
+		entityStoreSlot->at(u32Index) = entityStoreSlot->back();
+		entityStoreSlot->pop_back();
 	}
 
+	io_u32Handle = Utilities::INVALID_HANDLE;
+
 	FUNCTION_FINISH;
 }
 
 /**
  ****************************************************************************************************
-	\fn			void RemoveDeadAssets( void )
-	\brief		Removes dead assets from database
+	\fn			S_SIZE GetWindowSize( void )
+	\brief		Get the size of current window
 	\param		NONE
-	\return		NONE
+	\return		S_SIZE
  ****************************************************************************************************
 */
-void GameEngine::Renderer::RemoveDeadAssets( void )
+Utilities::S_SIZE &GameEngine::Renderer::GetWindowSize( void )
 {
 	FUNCTION_START;
-
-	for( UINT32 i = 0; i < meshDatabase->size(); ++i )
-	{
-		if( meshDatabase->at(i)->m_entity->m_isDestroyed )
-		{
-			UINT32 u32EntityIndex = meshDatabase->at(i)->m_u32EntityIndex;
-			meshDatabase->back()->m_u32EntityIndex = u32EntityIndex;
-			entityDatabase->at(u32EntityIndex) = entityDatabase->back();
-			entityDatabase->pop_back();
-
-			meshDatabase->at(i) = meshDatabase->back();
-			meshDatabase->pop_back();
-		}
-	}
-
 	FUNCTION_FINISH;
+
+	return g_windowSize;
 }
 
+/****************************************************************************************************
+			Private function implementation
+****************************************************************************************************/
 /****************************************************************************************************
 			Public sprite class implementation
 ****************************************************************************************************/
@@ -580,6 +643,8 @@ GameEngine::Renderer::Sprite::Sprite( Utilities::Pointer::SmartPtr<Entity> &i_en
 		RendererEngine::CreateTexture( i_textureFile );
 	}
 
+	// Placed once from the entity and not moved with it afterwards, so unlike the meshes it is not
+	// drawn between the last two simulation steps
 	RendererEngine::S_QUAD_TO_DRAW newQuad;
 	newQuad.size = m_entity->m_size;
 	newQuad.position.x = m_entity->m_v3Position.X();
@@ -654,6 +719,7 @@ void GameEngine::Renderer::Sprite::operator delete( void *i_ptr )
  ****************************************************************************************************
 */
 GameEngine::Renderer::Mesh::Mesh( Utilities::Pointer::SmartPtr<Entity> &i_entity, const std::string &i_fileName ) :
+	m_u32Handle( Utilities::INVALID_HANDLE ),
 	m_entity( i_entity ),
 	_entityInput( i_fileName ),
 	m_meshName( Utilities::StringHash(i_fileName.c_str()) )
@@ -756,6 +822,7 @@ void GameEngine::Renderer::Mesh::Load( void )
 	newEntity.orientation = m_entity->m_orientation;
 	m_u32EntityIndex = entityDatabase->size();
 	entityDatabase->push_back( newEntity );
+	entityStoreSlot->push_back( m_entity->m_u32StoreSlot );
 
 	FUNCTION_FINISH;
 }
@@ -29,8 +29,9 @@ namespace GameEngine
 		void ShutDown( void );
 
 		// 2D objects
-		void AddSprite( Utilities::Pointer::SmartPtr<Entity> &i_entity, const D3DCOLOR &i_colour,
+		UINT32 AddSprite( Utilities::Pointer::SmartPtr<Entity> &i_entity, const D3DCOLOR &i_colour,
 			const char *i_textureFile );
+		void RemoveSprite( UINT32 &io_u32Handle );
 		void DrawText( const D3DXVECTOR2 &i_position, const D3DXVECTOR2 &i_size, D3DCOLOR i_colour, \
 			const std::string &i_text, UINT32 i_hAlign );
 		void DrawSlider( const D3DXVECTOR2 &i_position, const UINT32 &i_u32CurrValue, const UINT32 &i_u32MinValue, \
@@ -38,7 +39,8 @@ namespace GameEngine
 			const D3DCOLOR &i_backgroundColour = Utilities::BLACK, const D3DCOLOR &i_foregroundColour = Utilities::GREEN );
 
 		// 3D objects using RendererEngine
-		void AddMesh( Utilities::Pointer::SmartPtr<Entity> &i_entity, const char *i_entityFile );
+		UINT32 AddMesh( Utilities::Pointer::SmartPtr<Entity> &i_entity, const char *i_entityFile );
+		void RemoveMesh( UINT32 &io_u32Handle );
 
 		Utilities::S_SIZE &GetWindowSize( void );
 	}
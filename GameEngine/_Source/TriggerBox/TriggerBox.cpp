@@ -5,14 +5,21 @@
  ****************************************************************************************************
 */
 
+#include <map>
+#include <algorithm>
+
 // Utilities header
 #include <Time/Time.h>
+#include <Math/Math.h>
 #include <Debug/Debug.h>
 #include <SmartPtr/SmartPtr.h>
+#include <HandleTable/HandleTable.h>
 #include <MemoryPool/MemoryPool.h>
+#include <SweepAndPrune/SweepAndPrune.h>
 
 #include "TriggerBox.h"
 #include "BoundingBox.h"
+#include "../GameEngine.h"
 #include "../World/Entity.h"
 #include "../Utilities/Profiler/Profiler.h"
 #include "../Utilities/IDCreator/IDCreator.h"
@@ -31,8 +38,16 @@ namespace GameEngine
 			Utilities::Pointer::SmartPtr<Entity>	m_intersectedEntity;
 			Utilities::Pointer::SmartPtr<Entity>	m_entity;
 			TriggerBoxHandler											*m_triggerBoxHandler;
+			// Bounds swept by the velocity over this frame, given to the broadphase
+			D3DXVECTOR3														m_vBroadphaseMin;
+			D3DXVECTOR3														m_vBroadphaseMax;
+			UINT32																m_u32Proxy;
+			// Slot in the awake entities, NO_SLOT while the entity sleeps
+			UINT32																m_u32AwakeSlot;
 			float																	m_triggerBoxDistance;
 			float																	m_enterTime;
+			// Whether the broadphase bounds changed this frame
+			bool																	m_bMoved;
 
 			TriggerBoxEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity );
 			~TriggerBoxEntity( void );
@@ -51,9 +66,66 @@ namespace GameEngine
 			bool &operator==( const TriggerBoxEntity &i_other ) const;
 		};
 
+		typedef struct _s_trigger_pair_
+		{
+			// Result of the last check, the overlap test is reused while neither box moves
+			bool bIntersecting;
+			bool bTested;
+			// Whether both entities sleep intersecting, the pair is then in the resting pairs
+			bool bResting;
+			// Last step the pair was checked in
+			UINT32 u32Step;
+		} S_TRIGGER_PAIR;
+
+		typedef struct _s_trigger_candidate_
+		{
+			// Database index of the earlier and the later entity
+			UINT32 u32IndexA;
+			UINT32 u32IndexB;
+			S_TRIGGER_PAIR *pair;
+			// Result of the check, reported once every candidate of the earlier entity is checked
+			D3DXVECTOR3 vEnterNormal;
+			float enterTime;
+			// Whether the earlier entity was checked at all, its handler is not notified otherwise
+			bool bChecked;
+			bool bTested;
+			bool bIntersection;
+		} S_TRIGGER_CANDIDATE;
+
+		const UINT32 NO_SLOT = 0xFFFFFFFF;
+
 		static std::vector< Utilities::Pointer::SmartPtr<TriggerBoxEntity> > *triggerBoxEntityDatabase;
-		void RemoveDeadEntities( void );
-		void CheckIntersection( TriggerBoxEntity &i_A, TriggerBoxEntity &i_B );
+		static Utilities::HandleTable *triggerBoxHandleTable;
+		static Utilities::SweepAndPrune *broadphase;
+		static std::vector<Utilities::SweepAndPrune::S_OVERLAPPING_PAIR> *overlappingPairs;
+		// Pairs whose swept bounds overlap or which are still to leave, keyed by the handles of both entities
+		static std::map<UINT64, S_TRIGGER_PAIR> *triggerPairs;
+		// Overlapping pairs of this frame, sorted by the earlier and then the later entity
+		static std::vector<S_TRIGGER_CANDIDATE> *triggerCandidates;
+		// Handles of the entities which are not sleeping, only they are moved in the broadphase
+		static std::vector<UINT32> *awakeEntities;
+		// Keys of the pairs whose entities both sleep intersecting, they are checked every step without the broadphase
+		static std::vector<UINT64> *restingPairs;
+		// Keys of the pairs checked in the last and in this step, a pair not checked again has left
+		static std::vector<UINT64> *lastPairs;
+		static std::vector<UINT64> *currentPairs;
+		static std::vector<Utilities::SweepAndPrune::S_OVERLAPPING_PAIR> *proxyPairs;
+		static UINT32 u32CurrentStep;
+		void SetAwake( TriggerBoxEntity &io_entity, const UINT32 &i_u32Handle, const bool &i_bAwake );
+		void UpdateBroadphase( const float &i_frameTime_ms );
+		void GetSweptBounds( const TriggerBoxEntity &i_entity, const float &i_frameTime_ms, D3DXVECTOR3 &o_vMin, D3DXVECTOR3 &o_vMax );
+		inline UINT64 PairKey( const UINT32 &i_u32HandleA, const UINT32 &i_u32HandleB );
+		bool CompareCandidates( const S_TRIGGER_CANDIDATE &i_lhs, const S_TRIGGER_CANDIDATE &i_rhs );
+		UINT32 GetCandidateGroupEnd( const UINT32 &i_u32First );
+		void CheckIntersections( S_TRIGGER_CANDIDATE *io_candidates, const UINT32 &i_u32TotalCandidates, const float &i_frameTime_ms );
+		void NotifyIntersections( S_TRIGGER_CANDIDATE *io_candidates, const UINT32 &i_u32TotalCandidates );
+		void CheckBoxes( const TriggerBoxEntity &i_A, S_TRIGGER_CANDIDATE *io_candidates, const UINT32 *i_u32Slots,
+			const Utilities::Math::S_BOX_PACKET &i_packet, const UINT32 &i_u32TotalBoxes, const float &i_frameTime_ms );
+		void SetBox( Utilities::Math::S_BOX_PACKET &io_packet, const UINT32 &i_u32Slot, const BoundingBox &i_box,
+			const Math::Vector3 &i_v3Velocity );
+		bool SweepPair( const BoundingBox &i_A, const Math::Vector3 &i_v3VelocityA, const BoundingBox &i_B,
+			const Math::Vector3 &i_v3VelocityB, float &o_enterTime, Math::Vector3 &o_v3EnterNormal );
+		void OnSeparation( TriggerBoxEntity &i_A, TriggerBoxEntity &i_B );
 
 		// BoundingBox calculation
 		float SeparationX( const BoundingBox &i_A, const BoundingBox &i_B );
@@ -95,8 +167,21 @@ bool GameEngine::TriggerBox::Initialize( void )
 	
 	TriggerBoxEntity::m_triggerBoxEntityPool = Utilities::MemoryPool::Create( sizeof(TriggerBoxEntity), Utilities::DEFAULT_MEMORY_POOL_SIZE );
 	triggerBoxEntityDatabase = new std::vector< Utilities::Pointer::SmartPtr<TriggerBoxEntity> >;
+	triggerBoxHandleTable = Utilities::HandleTable::Create( Utilities::DEFAULT_MEMORY_POOL_SIZE );
+	broadphase = Utilities::SweepAndPrune::Create( Utilities::DEFAULT_MEMORY_POOL_SIZE );
+	overlappingPairs = new std::vector<Utilities::SweepAndPrune::S_OVERLAPPING_PAIR>;
+	triggerPairs = new std::map<UINT64, S_TRIGGER_PAIR>;
+	triggerCandidates = new std::vector<S_TRIGGER_CANDIDATE>;
+	awakeEntities = new std::vector<UINT32>;
+	restingPairs = new std::vector<UINT64>;
+	lastPairs = new std::vector<UINT64>;
+	currentPairs = new std::vector<UINT64>;
+	proxyPairs = new std::vector<Utilities::SweepAndPrune::S_OVERLAPPING_PAIR>;
+	u32CurrentStep = 0;
 	
 	assert( TriggerBoxEntity::m_triggerBoxEntityPool );
+	assert( triggerBoxHandleTable );
+	assert( broadphase );
 
 	FUNCTION_FINISH;
 	return SUCCESS;
@@ -120,7 +205,8 @@ void GameEngine::TriggerBox::BeginUpdate( void )
 /**
  ****************************************************************************************************
 	\fn			void Update( void )
-	\brief		Update trigger box
+	\brief		Check which trigger boxes intersect this step. The results are kept in the candidates
+				until HandleIntersections gives them to the handlers
 	\param		NONE
 	\return		NONE
  ****************************************************************************************************
@@ -128,30 +214,152 @@ void GameEngine::TriggerBox::BeginUpdate( void )
 void GameEngine::TriggerBox::Update( void )
 {
 	PROFILE_UNSCOPED( "Trigger box" );
-	std::vector< Utilities::Pointer::SmartPtr<TriggerBoxEntity> >::iterator iterA;
-	float frameTime_ms = static_cast<float>( Utilities::Time::GetTimeElapsedThisFrame_ms() );
+	std::vector<Utilities::SweepAndPrune::S_OVERLAPPING_PAIR>::const_iterator iterPair;
+	std::map<UINT64, S_TRIGGER_PAIR>::iterator iter;
+	float frameTime_ms = Utilities::Time::GetFixedTimeStep_ms();
+	UINT32 u32First;
+	UINT32 u32Last;
 
 	FUNCTION_START;
 
+	TASK_CHECK_ACCESS( E_RESOURCE_ENTITY | E_RESOURCE_POSITION | E_RESOURCE_VELOCITY, E_RESOURCE_TRIGGER_BOX );
+
+	// Nothing is left from the last step for the handlers when there is nothing to check
+	triggerCandidates->clear();
+	currentPairs->clear();
+	++u32CurrentStep;
 	if( triggerBoxEntityDatabase->size() == 1 )
 	{
 		FUNCTION_FINISH;
 		return;
 	}
 
-	std::vector< Utilities::Pointer::SmartPtr<TriggerBoxEntity> >::iterator iterB;
-	for( iterA = triggerBoxEntityDatabase->begin(); iterA != triggerBoxEntityDatabase->end(); ++iterA )
+	UpdateBroadphase( frameTime_ms );
+
+	// Boxes can only meet this frame if their swept bounds overlap, pairs of two sleeping entities are not reported
+	for( iterPair = overlappingPairs->begin(); iterPair != overlappingPairs->end(); ++iterPair )
 	{
-		iterB = iterA;
-		for( ++iterB; iterB != triggerBoxEntityDatabase->end(); ++iterB )
+		UINT32 u32IndexA = triggerBoxHandleTable->GetIndex( iterPair->u32UserDataA );
+		UINT32 u32IndexB = triggerBoxHandleTable->GetIndex( iterPair->u32UserDataB );
+		UINT64 u64Key = PairKey( iterPair->u32UserDataA, iterPair->u32UserDataB );
+		S_TRIGGER_CANDIDATE candidate;
+
+		// The earlier entity is checked against the later one, same as the brute force order
+		candidate.u32IndexA = u32IndexA < u32IndexB ? u32IndexA : u32IndexB;
+		candidate.u32IndexB = u32IndexA < u32IndexB ? u32IndexB : u32IndexA;
+		candidate.pair = &(*triggerPairs)[u64Key];
+		candidate.pair->u32Step = u32CurrentStep;
+		currentPairs->push_back( u64Key );
+		triggerCandidates->push_back( candidate );
+	}
+
+	// Two entities which fell asleep intersecting are still notified, with the result they slept with
+	for( UINT32 i = 0; i < restingPairs->size(); )
+	{
+		UINT64 u64Key = restingPairs->at( i );
+		UINT32 u32HandleA = static_cast<UINT32>( u64Key >> 32 );
+		UINT32 u32HandleB = static_cast<UINT32>( u64Key );
+		iter = triggerPairs->find( u64Key );
+		assert( iter != triggerPairs->end() );
+
+		if( !triggerBoxHandleTable->IsValid(u32HandleA) || !triggerBoxHandleTable->IsValid(u32HandleB) )
 		{
-			CheckIntersection( **iterA, **iterB );
+			triggerPairs->erase( iter );
 		}
+		else
+		{
+			UINT32 u32IndexA = triggerBoxHandleTable->GetIndex( u32HandleA );
+			UINT32 u32IndexB = triggerBoxHandleTable->GetIndex( u32HandleB );
+
+			if( (triggerBoxEntityDatabase->at(u32IndexA)->m_u32AwakeSlot == NO_SLOT)
+				&& (triggerBoxEntityDatabase->at(u32IndexB)->m_u32AwakeSlot == NO_SLOT) )
+			{
+				S_TRIGGER_CANDIDATE candidate;
+
+				candidate.u32IndexA = u32IndexA < u32IndexB ? u32IndexA : u32IndexB;
+				candidate.u32IndexB = u32IndexA < u32IndexB ? u32IndexB : u32IndexA;
+				candidate.pair = &iter->second;
+				candidate.pair->u32Step = u32CurrentStep;
+				currentPairs->push_back( u64Key );
+				triggerCandidates->push_back( candidate );
+				++i;
+				continue;
+			}
+
+			// One of them woke up, the broadphase reports the pair again while it overlaps
+			iter->second.bResting = false;
+		}
+		restingPairs->at( i ) = restingPairs->back();
+		restingPairs->pop_back();
+	}
+	std::sort( triggerCandidates->begin(), triggerCandidates->end(), CompareCandidates );
+
+	// Every entity is checked against all its later candidates at once
+	for( u32First = 0; u32First < triggerCandidates->size(); u32First = u32Last )
+	{
+		u32Last = GetCandidateGroupEnd( u32First );
+		CheckIntersections( &triggerCandidates->at(u32First), u32Last - u32First, frameTime_ms );
 	}
 
 	FUNCTION_FINISH;
 }
 
+/**
+ ****************************************************************************************************
+	\fn			void HandleIntersections( void )
+	\brief		Notify the handlers of the intersections found by Update, and of the pairs which are
+				no longer checked and have left each other
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::TriggerBox::HandleIntersections( void )
+{
+	PROFILE_UNSCOPED( "Trigger box handlers" );
+	std::vector<UINT64>::const_iterator iterKey;
+	std::map<UINT64, S_TRIGGER_PAIR>::iterator iter;
+	UINT32 u32First;
+	UINT32 u32Last;
+
+	FUNCTION_START;
+
+	for( u32First = 0; u32First < triggerCandidates->size(); u32First = u32Last )
+	{
+		u32Last = GetCandidateGroupEnd( u32First );
+		NotifyIntersections( &triggerCandidates->at(u32First), u32Last - u32First );
+	}
+
+	// Pairs which are no longer checked cannot intersect, only those which did have to leave
+	for( iterKey = lastPairs->begin(); iterKey != lastPairs->end(); ++iterKey )
+	{
+		iter = triggerPairs->find( *iterKey );
+		if( (iter == triggerPairs->end()) || (iter->second.u32Step == u32CurrentStep) )
+			continue;
+
+		UINT32 u32HandleA = static_cast<UINT32>( iter->first >> 32 );
+		UINT32 u32HandleB = static_cast<UINT32>( iter->first );
+		if( iter->second.bIntersecting && triggerBoxHandleTable->IsValid(u32HandleA) && triggerBoxHandleTable->IsValid(u32HandleB) )
+		{
+			UINT32 u32IndexA = triggerBoxHandleTable->GetIndex( u32HandleA );
+			UINT32 u32IndexB = triggerBoxHandleTable->GetIndex( u32HandleB );
+			TriggerBoxEntity &first = *triggerBoxEntityDatabase->at( u32IndexA < u32IndexB ? u32IndexA : u32IndexB );
+			TriggerBoxEntity &second = *triggerBoxEntityDatabase->at( u32IndexA < u32IndexB ? u32IndexB : u32IndexA );
+
+			// Kept until it can be checked, as the brute force check skipped it as well
+			if( (first.m_entity->m_u32CollisionMask == 0) || first.m_entity->m_isDestroyed || second.m_entity->m_isDestroyed )
+			{
+				currentPairs->push_back( *iterKey );
+				continue;
+			}
+			OnSeparation( first, second );
+		}
+		triggerPairs->erase( iter );
+	}
+	std::swap( lastPairs, currentPairs );
+
+	FUNCTION_FINISH;
+}
+
 /**
  ****************************************************************************************************
 	\fn			void EndUpdate( void )
@@ -164,8 +372,6 @@ void GameEngine::TriggerBox::EndUpdate( void )
 {
 	FUNCTION_START;
 
-	RemoveDeadEntities();
-
 	FUNCTION_FINISH;
 }
 
@@ -187,6 +393,66 @@ void GameEngine::TriggerBox::ShutDown( void )
 		triggerBoxEntityDatabase = NULL;
 	}
 
+	if( triggerBoxHandleTable )
+	{
+		delete triggerBoxHandleTable;
+		triggerBoxHandleTable = NULL;
+	}
+
+	if( broadphase )
+	{
+		delete broadphase;
+		broadphase = NULL;
+	}
+
+	if( overlappingPairs )
+	{
+		delete overlappingPairs;
+		overlappingPairs = NULL;
+	}
+
+	if( triggerPairs )
+	{
+		delete triggerPairs;
+		triggerPairs = NULL;
+	}
+
+	if( triggerCandidates )
+	{
+		delete triggerCandidates;
+		triggerCandidates = NULL;
+	}
+
+	if( awakeEntities )
+	{
+		delete awakeEntities;
+		awakeEntities = NULL;
+	}
+
+	if( restingPairs )
+	{
+		delete restingPairs;
+		restingPairs = NULL;
+	}
+
+	if( lastPairs )
+	{
+		delete lastPairs;
+		lastPairs = NULL;
+	}
+
+	if( currentPairs )
+	{
+		delete currentPairs;
+		currentPairs = NULL;
+	}
+
+	if( proxyPairs )
+	{
+		delete proxyPairs;
+		proxyPairs = NULL;
+	}
+
 	if( TriggerBoxEntity::m_triggerBoxEntityPool )
 	{
 		delete TriggerBoxEntity::m_triggerBoxEntityPool;
@@ -198,39 +464,247 @@ void GameEngine::TriggerBox::ShutDown( void )
 
 /**
  ****************************************************************************************************
-	\fn			UINT8 AddTriggerBoxEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity )
+	\fn			UINT32 AddTriggerBoxEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity )
 	\brief		Add trigger box entity to triggerBoxEntityDatabase
 	\param		*i_entity entity to be added
-	\param		i_centre the center of the bounding box
-	\return		UINT8
-	\retval		index of the new added trigger box entity in database
+	\return		UINT32
+	\retval		handle of the new added trigger box entity
+	\retval		INVALID_HANDLE if the database is full
  ****************************************************************************************************
 */
-UINT8 GameEngine::TriggerBox::AddTriggerBoxEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity )
+UINT32 GameEngine::TriggerBox::AddTriggerBoxEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity )
 {
 	FUNCTION_START;
 
+	UINT32 u32Handle = triggerBoxHandleTable->Add( triggerBoxEntityDatabase->size() );
+	if( u32Handle == Utilities::INVALID_HANDLE )
+	{
+		DBG_MSG_LEVEL( D_ERR, "Trigger box entity database is full\n" );
+		FUNCTION_FINISH;
+		return Utilities::INVALID_HANDLE;
+	}
+
 	triggerBoxEntityDatabase->push_back( new TriggerBoxEntity(i_entity) );
 	triggerBoxEntityDatabase->at(triggerBoxEntityDatabase->size()-1)->m_triggerBoxHandler = NULL;
 
+	Utilities::Pointer::SmartPtr<TriggerBoxEntity> &newEntity = triggerBoxEntityDatabase->back();
+	GetSweptBounds( *newEntity, 0.0f, newEntity->m_vBroadphaseMin, newEntity->m_vBroadphaseMax );
+	newEntity->m_u32Proxy = broadphase->AddProxy( newEntity->m_vBroadphaseMin, newEntity->m_vBroadphaseMax, u32Handle );
+	assert( newEntity->m_u32Proxy != Utilities::INVALID_PROXY );
+	SetAwake( *newEntity, u32Handle, !i_entity->m_isSleeping );
+
 	FUNCTION_FINISH;
-	return triggerBoxEntityDatabase->size() - 1;
+	return u32Handle;
 }
 
 /**
  ****************************************************************************************************
-	\fn			void SetTriggerBoxHandle( const UINT8 &i_index, TriggerBoxHandler *i_TriggerBoxHandler )
-	\brief		Set TriggerBox entity to triggerBoxEntityDatabase
-	\param		*i_entity entity to be added
+	\fn			void RemoveTriggerBoxEntity( UINT32 &io_u32Handle )
+	\brief		Remove trigger box entity from triggerBoxEntityDatabase
+	\param		io_u32Handle handle of the trigger box entity, set to INVALID_HANDLE once removed
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::TriggerBox::RemoveTriggerBoxEntity( UINT32 &io_u32Handle )
+{
+	FUNCTION_START;
+
+	if( triggerBoxHandleTable->IsValid(io_u32Handle) )
+	{
+		UINT32 u32Index = triggerBoxHandleTable->GetIndex( io_u32Handle );
+
+		SetAwake( *triggerBoxEntityDatabase->at(u32Index), io_u32Handle, false );
+		broadphase->RemoveProxy( triggerBoxEntityDatabase->at(u32Index)->m_u32Proxy );
+		if( IsDeterministic() )
+		{
+			// Keep the order the entities were added in, it decides which entity of a pair is checked first
+			for( UINT32 i = u32Index + 1; i < triggerBoxEntityDatabase->size(); ++i )
+				triggerBoxHandleTable->SetIndex( triggerBoxEntityDatabase->at(i)->m_entity->m_u32TriggerBoxEntityHandle, i - 1 );
+			triggerBoxHandleTable->Remove( io_u32Handle );
+			triggerBoxEntityDatabase->erase( triggerBoxEntityDatabase->begin() + u32Index );
+		}
+		else
+		{
+			triggerBoxHandleTable->SetIndex( triggerBoxEntityDatabase->back()->m_entity->m_u32TriggerBoxEntityHandle, u32Index );
+			triggerBoxHandleTable->Remove( io_u32Handle );
+			triggerBoxEntityDatabase->at(u32Index) = triggerBoxEntityDatabase->back();
+			triggerBoxEntityDatabase->pop_back();
+		}
+	}
+
+	io_u32Handle = Utilities::INVALID_HANDLE;
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void SetTriggerBoxHandler( const UINT32 &i_u32Handle, TriggerBoxHandler *i_TriggerBoxHandler )
+	\brief		Set trigger box handler of the trigger box entity
+	\param		i_u32Handle handle of the trigger box entity
+	\param		i_TriggerBoxHandler the trigger box handler
 	\return		NONE
  ****************************************************************************************************
 */
-void GameEngine::TriggerBox::SetTriggerBoxHandler( const UINT8 &i_index, TriggerBoxHandler *i_TriggerBoxHandler )
+void GameEngine::TriggerBox::SetTriggerBoxHandler( const UINT32 &i_u32Handle, TriggerBoxHandler *i_TriggerBoxHandler )
 {
 	FUNCTION_START;
 
-	if( i_index < triggerBoxEntityDatabase->size() )
-		triggerBoxEntityDatabase->at(i_index)->m_triggerBoxHandler = i_TriggerBoxHandler;
+	if( triggerBoxHandleTable->IsValid(i_u32Handle) )
+		triggerBoxEntityDatabase->at( triggerBoxHandleTable->GetIndex(i_u32Handle) )->m_triggerBoxHandler = i_TriggerBoxHandler;
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void SetSleeping( const UINT32 &i_u32Handle, const bool &i_bSleeping )
+	\brief		Set whether the trigger box entity sleeps. A sleeping entity keeps its broadphase bounds
+				and is only checked by the awake entities, a pair left intersecting by two sleeping
+				entities is kept in the resting pairs so both are still notified every step
+	\param		i_u32Handle handle of the trigger box entity
+	\param		i_bSleeping whether the entity sleeps
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::TriggerBox::SetSleeping( const UINT32 &i_u32Handle, const bool &i_bSleeping )
+{
+	std::vector<Utilities::SweepAndPrune::S_OVERLAPPING_PAIR>::const_iterator iterPair;
+	std::map<UINT64, S_TRIGGER_PAIR>::iterator iter;
+
+	FUNCTION_START;
+
+	if( !triggerBoxHandleTable->IsValid(i_u32Handle) )
+	{
+		FUNCTION_FINISH;
+		return;
+	}
+
+	TriggerBoxEntity &entity = *triggerBoxEntityDatabase->at( triggerBoxHandleTable->GetIndex(i_u32Handle) );
+	bool bWasAwake = entity.m_u32AwakeSlot != NO_SLOT;
+
+	SetAwake( entity, i_u32Handle, !i_bSleeping );
+	if( i_bSleeping && bWasAwake )
+	{
+		// The broadphase no longer reports pairs of two sleeping entities
+		broadphase->GetProxyPairs( entity.m_u32Proxy, *proxyPairs );
+		for( iterPair = proxyPairs->begin(); iterPair != proxyPairs->end(); ++iterPair )
+		{
+			if( triggerBoxEntityDatabase->at(triggerBoxHandleTable->GetIndex(iterPair->u32UserDataB))->m_u32AwakeSlot != NO_SLOT )
+				continue;
+
+			iter = triggerPairs->find( PairKey(iterPair->u32UserDataA, iterPair->u32UserDataB) );
+			if( (iter != triggerPairs->end()) && iter->second.bIntersecting && !iter->second.bResting )
+			{
+				iter->second.bResting = true;
+				restingPairs->push_back( iter->first );
+			}
+		}
+	}
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void IntersectionBenchmark( void )
+	\brief		Compare the time taken to check every pair of a set of moving boxes one pair at a time
+				and one packet at a time
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::TriggerBox::IntersectionBenchmark( void )
+{
+	const UINT32 u32TotalBoxes = 1024;
+	float frameTime_ms = Utilities::Time::GetFixedTimeStep_ms();
+	std::vector<BoundingBox> boxes( u32TotalBoxes );
+	std::vector<Math::Vector3> velocities( u32TotalBoxes );
+	UINT32 u32ScalarHits = 0;
+	UINT32 u32PacketHits = 0;
+	UINT32 u32Mismatches = 0;
+
+	FUNCTION_START;
+
+	srand( 0 );
+	for( UINT32 i = 0; i < u32TotalBoxes; ++i )
+	{
+		boxes[i] = BoundingBox( Math::Vector3(static_cast<float>(rand() % 100), static_cast<float>(rand() % 100), static_cast<float>(rand() % 100)),
+			0.5f + (rand() % 20) * 0.1f, 0.5f + (rand() % 20) * 0.1f, 0.5f + (rand() % 20) * 0.1f );
+		// A third of the boxes stay still
+		if( i % 3 )
+			velocities[i] = Math::Vector3( (rand() % 21 - 10) * 0.01f, (rand() % 21 - 10) * 0.01f, (rand() % 21 - 10) * 0.01f );
+		else
+			velocities[i] = Math::Vector3::Zero;
+	}
+
+	Utilities::TICK startTick = Utilities::Time::GetCurrentTick();
+	for( UINT32 i = 0; i < u32TotalBoxes; ++i )
+	{
+		for( UINT32 j = i + 1; j < u32TotalBoxes; ++j )
+		{
+			float enterTime;
+			Math::Vector3 v3EnterNormal;
+
+			if( SweepPair(boxes[i], velocities[i], boxes[j], velocities[j], enterTime, v3EnterNormal) )
+				++u32ScalarHits;
+		}
+	}
+	Utilities::TICK scalarTick = Utilities::Time::GetCurrentTick();
+
+	for( UINT32 i = 0; i < u32TotalBoxes; ++i )
+	{
+		const Math::Vector3 &center = boxes[i].Center();
+		Utilities::Math::S_BOX_PACKET packet;
+		Utilities::Math::S_BOX_SWEEP_HIT hit;
+
+		for( UINT32 j = i + 1; j < u32TotalBoxes; j += Utilities::Math::BOX_PACKET_SIZE )
+		{
+			UINT32 u32Boxes = u32TotalBoxes - j;
+
+			if( u32Boxes > Utilities::Math::BOX_PACKET_SIZE )
+				u32Boxes = Utilities::Math::BOX_PACKET_SIZE;
+
+			for( UINT32 k = 0; k < u32Boxes; ++k )
+				SetBox( packet, k, boxes[j + k], velocities[j + k] );
+
+			UINT32 u32HitMask = Utilities::Math::SweepBoxes( D3DXVECTOR3(center.X(), center.Y(), center.Z()),
+				D3DXVECTOR3(boxes[i].m_halfW, boxes[i].m_halfH, boxes[i].m_halfD),
+				D3DXVECTOR3(velocities[i].X(), velocities[i].Y(), velocities[i].Z()), packet, u32Boxes, frameTime_ms, hit );
+			for( UINT32 k = 0; k < u32Boxes; ++k )
+			{
+				if( u32HitMask & (1 << k) )
+					++u32PacketHits;
+			}
+		}
+	}
+	Utilities::TICK packetTick = Utilities::Time::GetCurrentTick();
+
+	// Check the results apart from the timing
+	for( UINT32 i = 0; i < u32TotalBoxes; ++i )
+	{
+		Utilities::Math::S_BOX_PACKET packet;
+		Utilities::Math::S_BOX_SWEEP_HIT hit;
+
+		for( UINT32 j = i + 1; j < u32TotalBoxes; ++j )
+		{
+			float enterTime;
+			Math::Vector3 v3EnterNormal;
+			bool bIntersection = SweepPair( boxes[i], velocities[i], boxes[j], velocities[j], enterTime, v3EnterNormal );
+
+			SetBox( packet, 0, boxes[j], velocities[j] );
+			UINT32 u32HitMask = Utilities::Math::SweepBoxes( D3DXVECTOR3(boxes[i].Center().X(), boxes[i].Center().Y(), boxes[i].Center().Z()),
+				D3DXVECTOR3(boxes[i].m_halfW, boxes[i].m_halfH, boxes[i].m_halfD),
+				D3DXVECTOR3(velocities[i].X(), velocities[i].Y(), velocities[i].Z()), packet, 1, frameTime_ms, hit );
+			if( bIntersection != (u32HitMask != 0) )
+				++u32Mismatches;
+		}
+	}
+
+	DBG_MSG_LEVEL( D_INFO, "Trigger box check of %d moving boxes, %d pairs\n", u32TotalBoxes, u32TotalBoxes * (u32TotalBoxes - 1) / 2 );
+	DBG_MSG_LEVEL( D_INFO, "Per pair: %d ms, %d hits\n", Utilities::Time::GetDifferenceTick_ms(startTick, scalarTick), u32ScalarHits );
+	DBG_MSG_LEVEL( D_INFO, "Per packet: %d ms, %d hits, %d mismatches\n", Utilities::Time::GetDifferenceTick_ms(scalarTick, packetTick),
+		u32PacketHits, u32Mismatches );
 
 	FUNCTION_FINISH;
 }
@@ -240,29 +714,124 @@ void GameEngine::TriggerBox::SetTriggerBoxHandler( const UINT8 &i_index, Trigger
 ****************************************************************************************************/
 /**
  ****************************************************************************************************
-	\fn			void RemoveDeadEntities( void )
-	\brief		Remove dead entities
-	\param		*i_entity entity to be added
+	\fn			void SetAwake( TriggerBoxEntity &io_entity, const UINT32 &i_u32Handle, const bool &i_bAwake )
+	\brief		Add the entity to or remove it from the awake entities and the active broadphase proxies
+	\param		io_entity the trigger box entity
+	\param		i_u32Handle handle of the trigger box entity
+	\param		i_bAwake whether the entity is awake
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::TriggerBox::SetAwake( TriggerBoxEntity &io_entity, const UINT32 &i_u32Handle, const bool &i_bAwake )
+{
+	FUNCTION_START;
+
+	if( !i_bAwake && (io_entity.m_u32AwakeSlot != NO_SLOT) )
+	{
+		awakeEntities->at( io_entity.m_u32AwakeSlot ) = awakeEntities->back();
+		triggerBoxEntityDatabase->at( triggerBoxHandleTable->GetIndex(awakeEntities->back()) )->m_u32AwakeSlot = io_entity.m_u32AwakeSlot;
+		awakeEntities->pop_back();
+		io_entity.m_u32AwakeSlot = NO_SLOT;
+		io_entity.m_bMoved = false;
+	}
+	else if( i_bAwake && (io_entity.m_u32AwakeSlot == NO_SLOT) )
+	{
+		io_entity.m_u32AwakeSlot = awakeEntities->size();
+		awakeEntities->push_back( i_u32Handle );
+	}
+	broadphase->SetActive( io_entity.m_u32Proxy, i_bAwake );
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void UpdateBroadphase( const float &i_frameTime_ms )
+	\brief		Refresh the swept bounds of every awake trigger box entity and get the overlapping pairs
+	\param		i_frameTime_ms time step of this frame
 	\return		NONE
  ****************************************************************************************************
 */
-void GameEngine::TriggerBox::RemoveDeadEntities( void )
+void GameEngine::TriggerBox::UpdateBroadphase( const float &i_frameTime_ms )
 {
+	std::vector<UINT32>::const_iterator iter;
+	D3DXVECTOR3 vMin;
+	D3DXVECTOR3 vMax;
+
 	FUNCTION_START;
 
-	for( UINT8 i = 0; i < triggerBoxEntityDatabase->size(); i++ )
+	// A sleeping entity neither moves nor has velocity, its bounds are kept
+	for( iter = awakeEntities->begin(); iter != awakeEntities->end(); ++iter )
 	{
-		if( triggerBoxEntityDatabase->at(i)->m_entity->m_isDestroyed )
+		TriggerBoxEntity &entity = *triggerBoxEntityDatabase->at( triggerBoxHandleTable->GetIndex(*iter) );
+
+		GetSweptBounds( entity, i_frameTime_ms, vMin, vMax );
+		entity.m_bMoved = (vMin != entity.m_vBroadphaseMin) || (vMax != entity.m_vBroadphaseMax);
+		if( entity.m_bMoved )
 		{
-			triggerBoxEntityDatabase->back()->m_entity->m_u8TriggerBoxEntityIndex = triggerBoxEntityDatabase->at(i)->m_entity->m_u8TriggerBoxEntityIndex;
-			triggerBoxEntityDatabase->at(i) = triggerBoxEntityDatabase->back();
-			triggerBoxEntityDatabase->pop_back();
+			entity.m_vBroadphaseMin = vMin;
+			entity.m_vBroadphaseMax = vMax;
+			broadphase->SetBounds( entity.m_u32Proxy, vMin, vMax );
 		}
 	}
+	broadphase->Update();
+
+	broadphase->GetActivePairs( *overlappingPairs );
 
 	FUNCTION_FINISH;
 }
 
+/**
+ ****************************************************************************************************
+	\fn			void GetSweptBounds( const TriggerBoxEntity &i_entity, const float &i_frameTime_ms,
+					D3DXVECTOR3 &o_vMin, D3DXVECTOR3 &o_vMax )
+	\brief		Get the bounds of the box of the entity over the frame. Two boxes found intersecting by
+				CheckIntersection overlap at some time of the frame, so their swept bounds overlap too
+	\param		i_entity the trigger box entity
+	\param		i_frameTime_ms time step of this frame
+	\param		o_vMin minimum corner of the bounds
+	\param		o_vMax maximum corner of the bounds
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::TriggerBox::GetSweptBounds( const TriggerBoxEntity &i_entity, const float &i_frameTime_ms,
+	D3DXVECTOR3 &o_vMin, D3DXVECTOR3 &o_vMax )
+{
+	FUNCTION_START;
+
+	BoundingBox::S_EXTENDS extends = BoundingBox( i_entity.m_entity->m_v3Position, i_entity.m_entity->m_size ).GetExtends();
+	Math::Vector3 v3Move = i_entity.m_entity->m_v3Velocity * i_frameTime_ms;
+	D3DXVECTOR3 vMove( v3Move.X(), v3Move.Y(), v3Move.Z() );
+
+	o_vMin = D3DXVECTOR3( extends.minX, extends.minY, extends.minZ );
+	o_vMax = D3DXVECTOR3( extends.maxX, extends.maxY, extends.maxZ );
+	D3DXVECTOR3 vMovedMin = o_vMin + vMove;
+	D3DXVECTOR3 vMovedMax = o_vMax + vMove;
+
+	D3DXVec3Minimize( &o_vMin, &o_vMin, &vMovedMin );
+	D3DXVec3Maximize( &o_vMax, &o_vMax, &vMovedMax );
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			UINT64 PairKey( const UINT32 &i_u32HandleA, const UINT32 &i_u32HandleB )
+	\brief		Get the key of a pair of trigger box entities, the same for either order
+	\param		i_u32HandleA handle of one entity
+	\param		i_u32HandleB handle of the other entity
+	\return		UINT64
+	\retval		the smaller handle in the upper half and the larger one in the lower half
+ ****************************************************************************************************
+*/
+inline UINT64 GameEngine::TriggerBox::PairKey( const UINT32 &i_u32HandleA, const UINT32 &i_u32HandleB )
+{
+	if( i_u32HandleA < i_u32HandleB )
+		return (static_cast<UINT64>( i_u32HandleA ) << 32) | i_u32HandleB;
+	else
+		return (static_cast<UINT64>( i_u32HandleB ) << 32) | i_u32HandleA;
+}
+
 /**
  ****************************************************************************************************
 	\fn			float SeparationX( const BoundingBox &i_A, const BoundingBox &i_B )
@@ -410,86 +979,317 @@ bool GameEngine::TriggerBox::Overlap( const BoundingBox &i_A, const BoundingBox
 
 /**
  ****************************************************************************************************
-	\fn			void CheckTriggerBox( TriggerBoxEntity &i_A, TriggerBoxEntity &i_B )
-	\brief		Move entities within boundary
-	\param		i_index index of entity in interest
+	\fn			bool CompareCandidates( const S_TRIGGER_CANDIDATE &i_lhs, const S_TRIGGER_CANDIDATE &i_rhs )
+	\brief		Order candidates by the earlier entity and then by the later one
+	\param		i_lhs first candidate
+	\param		i_rhs second candidate
+	\return		bool
+	\retval		TRUE if i_lhs comes first
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+bool GameEngine::TriggerBox::CompareCandidates( const S_TRIGGER_CANDIDATE &i_lhs, const S_TRIGGER_CANDIDATE &i_rhs )
+{
+	if( i_lhs.u32IndexA != i_rhs.u32IndexA )
+		return i_lhs.u32IndexA < i_rhs.u32IndexA;
+	return i_lhs.u32IndexB < i_rhs.u32IndexB;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			UINT32 GetCandidateGroupEnd( const UINT32 &i_u32First )
+	\brief		Find the end of the candidates of the same earlier entity
+	\param		i_u32First first candidate of the group
+	\return		UINT32 one past the last candidate of the group
+ ****************************************************************************************************
+*/
+UINT32 GameEngine::TriggerBox::GetCandidateGroupEnd( const UINT32 &i_u32First )
+{
+	UINT32 u32Last;
+
+	for( u32Last = i_u32First + 1; u32Last < triggerCandidates->size(); ++u32Last )
+	{
+		if( triggerCandidates->at(u32Last).u32IndexA != triggerCandidates->at(i_u32First).u32IndexA )
+			break;
+	}
+
+	return u32Last;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void CheckIntersections( S_TRIGGER_CANDIDATE *io_candidates, const UINT32 &i_u32TotalCandidates,
+					const float &i_frameTime_ms )
+	\brief		Check whether an entity intersects its candidates this frame. The boxes which have to be
+				swept are checked a packet at a time
+	\param		io_candidates candidates of the same earlier entity, it keeps the result of the check
+	\param		i_u32TotalCandidates number of candidates
+	\param		i_frameTime_ms time step of this frame
 	\return		NONE
  ****************************************************************************************************
 */
-void GameEngine::TriggerBox::CheckIntersection( TriggerBoxEntity &i_A, TriggerBoxEntity &i_B )
+void GameEngine::TriggerBox::CheckIntersections( S_TRIGGER_CANDIDATE *io_candidates, const UINT32 &i_u32TotalCandidates,
+	const float &i_frameTime_ms )
 {
-	bool bIntersection = false;
-	float enterTime = 0.0f;
-	Math::Vector3 enterNormal = Math::Vector3::Zero;
-	BoundingBox i_ABB( i_A.m_entity->m_v3Position, i_A.m_entity->m_size );
-	BoundingBox i_BBB( i_B.m_entity->m_v3Position, i_B.m_entity->m_size );
+	TriggerBoxEntity &A = *triggerBoxEntityDatabase->at( io_candidates[0].u32IndexA );
+	Utilities::Math::S_BOX_PACKET packet;
+	UINT32 u32Slots[Utilities::Math::BOX_PACKET_SIZE];
+	UINT32 u32TotalBoxes = 0;
 
 	FUNCTION_START;
 
-	// If i_A do not have collision with other object or if either of the object is to be destroyed in the end 
-	// of this frame do not do collision detection
-	if( (i_A.m_entity->m_u32CollisionMask == 0) || i_A.m_entity->m_isDestroyed || i_B.m_entity->m_isDestroyed )
+	// If A do not have collision with other object or if it is to be destroyed in the end of this frame
+	// do not do collision detection
+	if( (A.m_entity->m_u32CollisionMask == 0) || A.m_entity->m_isDestroyed )
 	{
+		for( UINT32 i = 0; i < i_u32TotalCandidates; ++i )
+			io_candidates[i].bChecked = false;
+
 		FUNCTION_FINISH;
 		return;
 	}
 
-	if( i_A.m_entity->m_u32CollisionMask & g_IDCreator::Get().IDtoBitMask(i_B.m_entity->m_u8EntityID) )
+	for( UINT32 i = 0; i <= i_u32TotalCandidates; ++i )
 	{
-		// Both objects are moving
-		if( (i_A.m_entity->m_v3Velocity.SquaredLength() > 0.0f) && (i_B.m_entity->m_v3Velocity.SquaredLength() > 0.0f) )
+		if( i < i_u32TotalCandidates )
 		{
-			Math::Vector3 velocityBA = i_B.m_entity->m_v3Velocity - i_A.m_entity->m_v3Velocity;
+			S_TRIGGER_CANDIDATE &candidate = io_candidates[i];
+			TriggerBoxEntity &B = *triggerBoxEntityDatabase->at( candidate.u32IndexB );
+
+			candidate.vEnterNormal = D3DXVECTOR3( 0.0f, 0.0f, 0.0f );
+			candidate.enterTime = 0.0f;
+			candidate.bChecked = true;
+			candidate.bTested = false;
+			candidate.bIntersection = false;
+
+			if( B.m_entity->m_isDestroyed || !(A.m_entity->m_u32CollisionMask & g_IDCreator::Get().IDtoBitMask(B.m_entity->m_u8EntityID)) )
+				continue;
+			candidate.bTested = true;
+
+			// Neither box has moved and neither moves, the last overlap test still holds
+			if( candidate.pair->bTested && !A.m_bMoved && !B.m_bMoved
+				&& (A.m_entity->m_v3Velocity.SquaredLength() == 0.0f) && (B.m_entity->m_v3Velocity.SquaredLength() == 0.0f) )
+			{
+				candidate.bIntersection = candidate.pair->bIntersecting;
+				continue;
+			}
 
-			if( Utilities::Math::AreRelativelyEqual(velocityBA.SquaredLength(), 0.0f) )
-				bIntersection = Overlap( i_ABB, i_BBB );
-			else
-				bIntersection = MovingToStationary( i_ABB, i_BBB, velocityBA, enterTime, enterNormal );
-		
+			SetBox( packet, u32TotalBoxes, BoundingBox(B.m_entity->m_v3Position, B.m_entity->m_size), B.m_entity->m_v3Velocity );
+			u32Slots[u32TotalBoxes++] = i;
+			if( u32TotalBoxes < Utilities::Math::BOX_PACKET_SIZE )
+				continue;
 		}
-		// A is moving, B is stationary
-		else if( i_A.m_entity->m_v3Velocity.SquaredLength() > 0.0f )
+
+		if( u32TotalBoxes > 0 )
 		{
-			bIntersection = MovingToStationary( i_BBB, i_ABB, i_A.m_entity->m_v3Velocity, enterTime, enterNormal );
+			CheckBoxes( A, io_candidates, u32Slots, packet, u32TotalBoxes, i_frameTime_ms );
+			u32TotalBoxes = 0;
 		}
-		// B is moving, A is stationary
-		else if( i_B.m_entity->m_v3Velocity.SquaredLength() > 0.0f )
+	}
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void NotifyIntersections( S_TRIGGER_CANDIDATE *io_candidates, const UINT32 &i_u32TotalCandidates )
+	\brief		Notify the handlers of an entity and its candidates of the result of their check
+	\param		io_candidates candidates of the same earlier entity, their pairs keep the result
+	\param		i_u32TotalCandidates number of candidates
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::TriggerBox::NotifyIntersections( S_TRIGGER_CANDIDATE *io_candidates, const UINT32 &i_u32TotalCandidates )
+{
+	TriggerBoxEntity &A = *triggerBoxEntityDatabase->at( io_candidates[0].u32IndexA );
+
+	FUNCTION_START;
+
+	for( UINT32 i = 0; i < i_u32TotalCandidates; ++i )
+	{
+		S_TRIGGER_CANDIDATE &candidate = io_candidates[i];
+		TriggerBoxEntity &B = *triggerBoxEntityDatabase->at( candidate.u32IndexB );
+
+		// A handler notified earlier may have destroyed either of them
+		if( !candidate.bChecked || (A.m_entity->m_u32CollisionMask == 0) || A.m_entity->m_isDestroyed
+			|| B.m_entity->m_isDestroyed )
+			continue;
+
+		candidate.pair->bTested = candidate.bTested;
+		candidate.pair->bIntersecting = candidate.bIntersection;
+
+		if( candidate.bIntersection )
 		{
-			bIntersection = MovingToStationary( i_ABB, i_BBB, i_B.m_entity->m_v3Velocity, enterTime, enterNormal );
+			if( A.m_triggerBoxHandler )
+			{
+				A.m_intersectedEntity = B.m_entity;
+				A.m_triggerBoxHandler->HandleIntersection( A.m_entity, B.m_entity, candidate.enterTime, Math::Vector3(candidate.vEnterNormal) );
+			}
 		}
-		// Both are stationary
 		else
 		{
-			bIntersection = Overlap( i_ABB, i_BBB );
+			OnSeparation( A, B );
 		}
 	}
 
-	if( bIntersection )
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void CheckBoxes( const TriggerBoxEntity &i_A, S_TRIGGER_CANDIDATE *io_candidates, const UINT32 *i_u32Slots,
+					const Utilities::Math::S_BOX_PACKET &i_packet, const UINT32 &i_u32TotalBoxes, const float &i_frameTime_ms )
+	\brief		Sweep the box of an entity against a packet of candidate boxes
+	\param		i_A the earlier entity
+	\param		io_candidates candidates of the entity, it keeps the result of the check
+	\param		i_u32Slots candidate stored in each slot of the packet
+	\param		i_packet the box packet
+	\param		i_u32TotalBoxes boxes stored in the packet
+	\param		i_frameTime_ms time step of this frame
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::TriggerBox::CheckBoxes( const TriggerBoxEntity &i_A, S_TRIGGER_CANDIDATE *io_candidates, const UINT32 *i_u32Slots,
+	const Utilities::Math::S_BOX_PACKET &i_packet, const UINT32 &i_u32TotalBoxes, const float &i_frameTime_ms )
+{
+	BoundingBox box( i_A.m_entity->m_v3Position, i_A.m_entity->m_size );
+	const Math::Vector3 &v3Velocity = i_A.m_entity->m_v3Velocity;
+	Utilities::Math::S_BOX_SWEEP_HIT hit;
+	UINT32 u32HitMask;
+
+	FUNCTION_START;
+
+	u32HitMask = Utilities::Math::SweepBoxes( D3DXVECTOR3(box.Center().X(), box.Center().Y(), box.Center().Z()),
+		D3DXVECTOR3(box.m_halfW, box.m_halfH, box.m_halfD), D3DXVECTOR3(v3Velocity.X(), v3Velocity.Y(), v3Velocity.Z()),
+		i_packet, i_u32TotalBoxes, i_frameTime_ms, hit );
+
+	for( UINT32 i = 0; i < i_u32TotalBoxes; ++i )
 	{
-		if( i_A.m_triggerBoxHandler && !i_A.m_entity->m_isDestroyed && !i_B.m_entity->m_isDestroyed )
+		S_TRIGGER_CANDIDATE &candidate = io_candidates[i_u32Slots[i]];
+
+		candidate.bIntersection = (u32HitMask & (1 << i)) != 0;
+		candidate.enterTime = hit.enterTime[i];
+		candidate.vEnterNormal = D3DXVECTOR3( hit.enterNormal[0][i], hit.enterNormal[1][i], hit.enterNormal[2][i] );
+
+		// A moving into a stationary B always reported the face of A
+		if( (v3Velocity.SquaredLength() > 0.0f) && (i_packet.velocity[0][i] == 0.0f)
+			&& (i_packet.velocity[1][i] == 0.0f) && (i_packet.velocity[2][i] == 0.0f) )
 		{
-			i_A.m_intersectedEntity = i_B.m_entity;
-			i_A.m_triggerBoxHandler->HandleIntersection( i_A.m_entity, i_B.m_entity, enterTime, enterNormal );
+			candidate.vEnterNormal = -candidate.vEnterNormal;
 		}
 	}
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void SetBox( Utilities::Math::S_BOX_PACKET &io_packet, const UINT32 &i_u32Slot, const BoundingBox &i_box,
+					const Math::Vector3 &i_v3Velocity )
+	\brief		Store a bounding box and its velocity in a slot of a box packet
+	\param		io_packet the box packet
+	\param		i_u32Slot slot of the box
+	\param		i_box the bounding box
+	\param		i_v3Velocity velocity of the box
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::TriggerBox::SetBox( Utilities::Math::S_BOX_PACKET &io_packet, const UINT32 &i_u32Slot, const BoundingBox &i_box,
+	const Math::Vector3 &i_v3Velocity )
+{
+	FUNCTION_START;
+
+	Utilities::Math::SetBox( io_packet, i_u32Slot, D3DXVECTOR3(i_box.Center().X(), i_box.Center().Y(), i_box.Center().Z()),
+		D3DXVECTOR3(i_box.m_halfW, i_box.m_halfH, i_box.m_halfD), D3DXVECTOR3(i_v3Velocity.X(), i_v3Velocity.Y(), i_v3Velocity.Z()) );
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool SweepPair( const BoundingBox &i_A, const Math::Vector3 &i_v3VelocityA, const BoundingBox &i_B,
+					const Math::Vector3 &i_v3VelocityB, float &o_enterTime, Math::Vector3 &o_v3EnterNormal )
+	\brief		Check whether two moving boxes intersect this frame one pair at a time, the scalar
+				counterpart of CheckBoxes
+	\param		i_A first bounding box
+	\param		i_v3VelocityA velocity of the first box
+	\param		i_B second bounding box
+	\param		i_v3VelocityB velocity of the second box
+	\param		o_enterTime enter time
+	\param		o_v3EnterNormal normal of enter plane
+	\return		bool
+	\retval		TRUE if both boxes intersect
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+bool GameEngine::TriggerBox::SweepPair( const BoundingBox &i_A, const Math::Vector3 &i_v3VelocityA, const BoundingBox &i_B,
+	const Math::Vector3 &i_v3VelocityB, float &o_enterTime, Math::Vector3 &o_v3EnterNormal )
+{
+	bool bIntersection;
+
+	FUNCTION_START;
+
+	o_enterTime = 0.0f;
+	o_v3EnterNormal = Math::Vector3::Zero;
+
+	// Both objects are moving
+	if( (i_v3VelocityA.SquaredLength() > 0.0f) && (i_v3VelocityB.SquaredLength() > 0.0f) )
+	{
+		Math::Vector3 velocityBA = i_v3VelocityB - i_v3VelocityA;
+
+		if( Utilities::Math::AreRelativelyEqual(velocityBA.SquaredLength(), 0.0f) )
+			bIntersection = Overlap( i_A, i_B );
+		else
+			bIntersection = MovingToStationary( i_A, i_B, velocityBA, o_enterTime, o_v3EnterNormal );
+	}
+	// A is moving, B is stationary
+	else if( i_v3VelocityA.SquaredLength() > 0.0f )
+	{
+		bIntersection = MovingToStationary( i_B, i_A, i_v3VelocityA, o_enterTime, o_v3EnterNormal );
+	}
+	// B is moving, A is stationary
+	else if( i_v3VelocityB.SquaredLength() > 0.0f )
+	{
+		bIntersection = MovingToStationary( i_A, i_B, i_v3VelocityB, o_enterTime, o_v3EnterNormal );
+	}
+	// Both are stationary
 	else
 	{
-		if( i_A.m_intersectedEntity && (i_A.m_intersectedEntity == i_B.m_entity) )
-		{
-			if( i_A.m_triggerBoxHandler != NULL )
-				i_A.m_triggerBoxHandler->OnLeavingTriggerBox( i_A.m_entity, i_B.m_entity );
-			i_A.m_intersectedEntity = NULL;
-		}
-		i_A.m_enterTime = 0.0f;
+		bIntersection = Overlap( i_A, i_B );
+	}
 
-		if( i_B.m_intersectedEntity && (i_B.m_intersectedEntity == i_A.m_entity) )
-		{
-			if( i_B.m_triggerBoxHandler != NULL )
-				i_B.m_triggerBoxHandler->OnLeavingTriggerBox( i_B.m_entity, i_A.m_entity );
-			i_B.m_intersectedEntity = NULL;
-		}
-		i_B.m_enterTime = 0.0f;
+	FUNCTION_FINISH;
+	return bIntersection;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void OnSeparation( TriggerBoxEntity &i_A, TriggerBoxEntity &i_B )
+	\brief		Notify the handlers of two trigger box entities which are not intersecting any more
+	\param		i_A the earlier entity in the database
+	\param		i_B the later entity in the database
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::TriggerBox::OnSeparation( TriggerBoxEntity &i_A, TriggerBoxEntity &i_B )
+{
+	FUNCTION_START;
+
+	if( i_A.m_intersectedEntity && (i_A.m_intersectedEntity == i_B.m_entity) )
+	{
+		if( i_A.m_triggerBoxHandler != NULL )
+			i_A.m_triggerBoxHandler->OnLeavingTriggerBox( i_A.m_entity, i_B.m_entity );
+		i_A.m_intersectedEntity = NULL;
+	}
+	i_A.m_enterTime = 0.0f;
+
+	if( i_B.m_intersectedEntity && (i_B.m_intersectedEntity == i_A.m_entity) )
+	{
+		if( i_B.m_triggerBoxHandler != NULL )
+			i_B.m_triggerBoxHandler->OnLeavingTriggerBox( i_B.m_entity, i_A.m_entity );
+		i_B.m_intersectedEntity = NULL;
 	}
+	i_B.m_enterTime = 0.0f;
 
 	FUNCTION_FINISH;
 }
@@ -594,7 +1394,7 @@ bool GameEngine::TriggerBox::MovingCheckInAxis( const float &i_min, const float
 {
 	o_enterTime = 0.0f;
 	float leaveTime = 0.0f;
-	float frameTime_ms = static_cast<float>( Utilities::Time::GetTimeElapsedThisFrame_ms() );
+	float frameTime_ms = Utilities::Time::GetFixedTimeStep_ms();
 
 	//DEBUG_MSG( DBG_TriggerBox, D_INFO, "Time %.5f\n", frameTime_ms );
 
@@ -712,8 +1512,13 @@ GameEngine::TriggerBox::TriggerBoxEntity::TriggerBoxEntity( Utilities::Pointer::
 	m_intersectedEntity( NULL ),
 	m_entity( i_entity ),
 	m_triggerBoxHandler( NULL ),
+	m_vBroadphaseMin( 0.0f, 0.0f, 0.0f ),
+	m_vBroadphaseMax( 0.0f, 0.0f, 0.0f ),
+	m_u32Proxy( Utilities::INVALID_PROXY ),
+	m_u32AwakeSlot( NO_SLOT ),
 	m_triggerBoxDistance( 0.0f ),
-	m_enterTime( 0.0f )
+	m_enterTime( 0.0f ),
+	m_bMoved( true )
 {
 }
 
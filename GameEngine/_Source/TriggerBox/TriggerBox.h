@@ -42,11 +42,15 @@ namespace GameEngine
 		bool Initialize( void );
 		void BeginUpdate( void );
 		void Update( void );
+		void HandleIntersections( void );
 		void EndUpdate( void );
 		void ShutDown( void );
 
-		UINT8 AddTriggerBoxEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity );
-		void SetTriggerBoxHandler( const UINT8 &i_index, TriggerBoxHandler *i_triggerBoxHandler );
+		UINT32 AddTriggerBoxEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity );
+		void RemoveTriggerBoxEntity( UINT32 &io_u32Handle );
+		void SetTriggerBoxHandler( const UINT32 &i_u32Handle, TriggerBoxHandler *i_triggerBoxHandler );
+		void SetSleeping( const UINT32 &i_u32Handle, const bool &i_bSleeping );
+		void IntersectionBenchmark( void );
 	}	// namespace Collision
 }	// namespace GameEngine
 
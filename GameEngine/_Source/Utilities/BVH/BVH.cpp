@@ -0,0 +1,409 @@
+#include <math.h>
+#include <float.h>
+#include <assert.h>
+#include <algorithm>
+
+// Utilities header
+#include <Math/Math.h>
+#include <Debug/Debug.h>
+
+#include "BVH.h"
+
+namespace GameEngine
+{
+	namespace BVHHelper
+	{
+		static const UINT32 TOTAL_BINS = 12;
+
+		typedef struct _s_bin_
+		{
+			D3DXVECTOR3 vMin;
+			D3DXVECTOR3 vMax;
+			UINT32 u32Total;
+		} S_BIN;
+
+		typedef struct _s_stack_entry_
+		{
+			UINT32 u32Node;
+			float tEntry;
+		} S_STACK_ENTRY;
+
+		static inline float HalfSurfaceArea( const D3DXVECTOR3 &i_vMin, const D3DXVECTOR3 &i_vMax )
+		{
+			D3DXVECTOR3 extent = i_vMax - i_vMin;
+			return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+		}
+
+		static inline void ResetBounds( D3DXVECTOR3 &o_vMin, D3DXVECTOR3 &o_vMax )
+		{
+			o_vMin = D3DXVECTOR3( FLT_MAX, FLT_MAX, FLT_MAX );
+			o_vMax = D3DXVECTOR3( -FLT_MAX, -FLT_MAX, -FLT_MAX );
+		}
+
+		static inline void GrowBounds( D3DXVECTOR3 &io_vMin, D3DXVECTOR3 &io_vMax, const D3DXVECTOR3 &i_vMin, const D3DXVECTOR3 &i_vMax )
+		{
+			D3DXVec3Minimize( &io_vMin, &io_vMin, &i_vMin );
+			D3DXVec3Maximize( &io_vMax, &io_vMax, &i_vMax );
+		}
+
+		static inline UINT32 GetBin( const float &i_centroid, const float &i_min, const float &i_scale )
+		{
+			UINT32 u32Bin = static_cast<UINT32>( (i_centroid - i_min) * i_scale );
+			return u32Bin < TOTAL_BINS ? u32Bin : TOTAL_BINS - 1;
+		}
+
+		// Only the first i_u32TotalTriangles slots of the packet are used, the cleared slots must not be swept
+		static bool SweepPacket( const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint, const D3DXVECTOR3 &i_axis,
+			const float &i_radius, const Utilities::Math::S_TRIANGLE_PACKET &i_packet, const UINT32 &i_u32TotalTriangles,
+			Utilities::Math::S_SWEEP_HIT &io_hit )
+		{
+			bool bSweepResult = false;
+
+			for( UINT32 i = 0; i < i_u32TotalTriangles; ++i )
+			{
+				D3DXVECTOR3 vertex0( i_packet.vertex0[0][i], i_packet.vertex0[1][i], i_packet.vertex0[2][i] );
+				D3DXVECTOR3 vertex1( vertex0.x + i_packet.edge1[0][i], vertex0.y + i_packet.edge1[1][i], vertex0.z + i_packet.edge1[2][i] );
+				D3DXVECTOR3 vertex2( vertex0.x + i_packet.edge2[0][i], vertex0.y + i_packet.edge2[1][i], vertex0.z + i_packet.edge2[2][i] );
+
+				bSweepResult |= Utilities::Math::SweepCapsule( i_startPoint, i_endPoint, i_axis, i_radius, vertex0, vertex1, vertex2, io_hit );
+			}
+
+			return bSweepResult;
+		}
+	}	// namespace BVHHelper
+}	// namespace GameEngine
+
+/****************************************************************************************************
+			BVH class public functions implementation
+****************************************************************************************************/
+GameEngine::BVH::BVH( const D3DXVECTOR3 *i_vertices, const uint16_t *i_u16Indices, const UINT32 &i_u32TotalTriangles )
+{
+	FUNCTION_START;
+
+	if( i_u32TotalTriangles == 0 )
+	{
+		FUNCTION_FINISH;
+		return;
+	}
+
+	assert( i_vertices && i_u16Indices );
+
+	std::vector<S_BUILD_DATA> buildData( i_u32TotalTriangles );
+	for( UINT32 i = 0; i < i_u32TotalTriangles; ++i )
+	{
+		const D3DXVECTOR3 &a = i_vertices[i_u16Indices[i * 3]];
+		const D3DXVECTOR3 &b = i_vertices[i_u16Indices[i * 3 + 1]];
+		const D3DXVECTOR3 &c = i_vertices[i_u16Indices[i * 3 + 2]];
+
+		BVHHelper::ResetBounds( buildData[i].vMin, buildData[i].vMax );
+		BVHHelper::GrowBounds( buildData[i].vMin, buildData[i].vMax, a, a );
+		BVHHelper::GrowBounds( buildData[i].vMin, buildData[i].vMax, b, b );
+		BVHHelper::GrowBounds( buildData[i].vMin, buildData[i].vMax, c, c );
+		buildData[i].vCentroid = (buildData[i].vMin + buildData[i].vMax) * 0.5f;
+		buildData[i].u32Triangle = i;
+	}
+
+	// A binary tree has less than twice as many nodes as leaves
+	_nodes.reserve( 2 * i_u32TotalTriangles );
+	Build( 0, i_u32TotalTriangles, 0, buildData, i_vertices, i_u16Indices );
+
+	FUNCTION_FINISH;
+}
+
+GameEngine::BVH::~BVH( void )
+{
+}
+
+bool GameEngine::BVH::RayTracing( const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint, const bool &i_bCollisionHasDetected,
+	D3DXVECTOR3 &o_collisionPoint, float &o_collisionDistance ) const
+{
+	BVHHelper::S_STACK_ENTRY stack[MAX_DEPTH * 2];
+	UINT32 u32StackSize = 0;
+	Utilities::Math::S_SEGMENT segment;
+	Utilities::Math::S_RAY_HIT hit;
+	bool bRayTracingResult = false;
+	float tEntry;
+
+	FUNCTION_START;
+
+	if( _nodes.empty() )
+	{
+		FUNCTION_FINISH;
+		return false;
+	}
+
+	Utilities::Math::SetSegment( segment, i_startPoint, i_endPoint );
+	if( !Utilities::Math::SegmentBoxEntry(segment, _nodes[0].vMin, _nodes[0].vMax, tEntry) )
+	{
+		FUNCTION_FINISH;
+		return false;
+	}
+
+	hit.distance = i_bCollisionHasDetected ? o_collisionDistance : 1.0f;
+	stack[u32StackSize].u32Node = 0;
+	stack[u32StackSize++].tEntry = tEntry;
+	while( u32StackSize > 0 )
+	{
+		const BVHHelper::S_STACK_ENTRY entry = stack[--u32StackSize];
+
+		// Closer collision has been found after this node was pushed
+		if( entry.tEntry > hit.distance )
+			continue;
+
+		const S_NODE &node = _nodes[entry.u32Node];
+		if( node.u32TotalTriangles > 0 )
+		{
+			const UINT32 u32End = node.u32Offset + (node.u32TotalTriangles + Utilities::Math::TRIANGLE_PACKET_SIZE - 1) / Utilities::Math::TRIANGLE_PACKET_SIZE;
+			for( UINT32 i = node.u32Offset; i < u32End; ++i )
+				bRayTracingResult |= Utilities::Math::RayTracing( i_startPoint, i_endPoint, _trianglePackets[i], hit );
+		}
+		else
+		{
+			UINT32 u32Near = entry.u32Node + 1;
+			UINT32 u32Far = node.u32Offset;
+			float tNear = 0.0f;
+			float tFar = 0.0f;
+			bool bHitNear = Utilities::Math::SegmentBoxEntry( segment, _nodes[u32Near].vMin, _nodes[u32Near].vMax, tNear );
+			bool bHitFar = Utilities::Math::SegmentBoxEntry( segment, _nodes[u32Far].vMin, _nodes[u32Far].vMax, tFar );
+
+			if( bHitNear && bHitFar && (tFar < tNear) )
+			{
+				std::swap( u32Near, u32Far );
+				std::swap( tNear, tFar );
+			}
+
+			// Push the far child first so the near child is visited first
+			if( bHitFar )
+			{
+				stack[u32StackSize].u32Node = u32Far;
+				stack[u32StackSize++].tEntry = tFar;
+			}
+			if( bHitNear )
+			{
+				stack[u32StackSize].u32Node = u32Near;
+				stack[u32StackSize++].tEntry = tNear;
+			}
+			assert( u32StackSize <= MAX_DEPTH * 2 );
+		}
+	}
+
+	if( bRayTracingResult )
+	{
+		o_collisionPoint = hit.point;
+		o_collisionDistance = hit.distance;
+	}
+
+	FUNCTION_FINISH;
+	return bRayTracingResult;
+}
+
+// The capsule is bounded by a box around the middle of its axis, the nodes are grown by the half size of
+// that box and traversed with the path of the middle point
+bool GameEngine::BVH::Sweep( const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint, const D3DXVECTOR3 &i_axis,
+	const float &i_radius, Utilities::Math::S_SWEEP_HIT &io_hit ) const
+{
+	BVHHelper::S_STACK_ENTRY stack[MAX_DEPTH * 2];
+	UINT32 u32StackSize = 0;
+	Utilities::Math::S_SEGMENT segment;
+	D3DXVECTOR3 halfAxis = i_axis * 0.5f;
+	D3DXVECTOR3 vExtent( fabs(halfAxis.x) + i_radius, fabs(halfAxis.y) + i_radius, fabs(halfAxis.z) + i_radius );
+	bool bSweepResult = false;
+	float tEntry;
+
+	FUNCTION_START;
+
+	if( _nodes.empty() )
+	{
+		FUNCTION_FINISH;
+		return false;
+	}
+
+	Utilities::Math::SetSegment( segment, i_startPoint + halfAxis, i_endPoint + halfAxis );
+	if( !Utilities::Math::SegmentBoxEntry(segment, _nodes[0].vMin - vExtent, _nodes[0].vMax + vExtent, tEntry) )
+	{
+		FUNCTION_FINISH;
+		return false;
+	}
+
+	stack[u32StackSize].u32Node = 0;
+	stack[u32StackSize++].tEntry = tEntry;
+	while( u32StackSize > 0 )
+	{
+		const BVHHelper::S_STACK_ENTRY entry = stack[--u32StackSize];
+
+		if( entry.tEntry > io_hit.time )
+			continue;
+
+		const S_NODE &node = _nodes[entry.u32Node];
+		if( node.u32TotalTriangles > 0 )
+		{
+			for( UINT32 i = 0; i * Utilities::Math::TRIANGLE_PACKET_SIZE < node.u32TotalTriangles; ++i )
+			{
+				UINT32 u32Total = node.u32TotalTriangles - i * Utilities::Math::TRIANGLE_PACKET_SIZE;
+				if( u32Total > Utilities::Math::TRIANGLE_PACKET_SIZE )
+					u32Total = Utilities::Math::TRIANGLE_PACKET_SIZE;
+				bSweepResult |= BVHHelper::SweepPacket( i_startPoint, i_endPoint, i_axis, i_radius, _trianglePackets[node.u32Offset + i],
+					u32Total, io_hit );
+			}
+		}
+		else
+		{
+			UINT32 u32Near = entry.u32Node + 1;
+			UINT32 u32Far = node.u32Offset;
+			float tNear = 0.0f;
+			float tFar = 0.0f;
+			bool bHitNear = Utilities::Math::SegmentBoxEntry( segment, _nodes[u32Near].vMin - vExtent, _nodes[u32Near].vMax + vExtent, tNear );
+			bool bHitFar = Utilities::Math::SegmentBoxEntry( segment, _nodes[u32Far].vMin - vExtent, _nodes[u32Far].vMax + vExtent, tFar );
+
+			if( bHitNear && bHitFar && (tFar < tNear) )
+			{
+				std::swap( u32Near, u32Far );
+				std::swap( tNear, tFar );
+			}
+
+			if( bHitFar )
+			{
+				stack[u32StackSize].u32Node = u32Far;
+				stack[u32StackSize++].tEntry = tFar;
+			}
+			if( bHitNear )
+			{
+				stack[u32StackSize].u32Node = u32Near;
+				stack[u32StackSize++].tEntry = tNear;
+			}
+			assert( u32StackSize <= MAX_DEPTH * 2 );
+		}
+	}
+
+	FUNCTION_FINISH;
+	return bSweepResult;
+}
+
+/****************************************************************************************************
+			BVH class private functions implementation
+****************************************************************************************************/
+void GameEngine::BVH::Build( const UINT32 &i_u32Begin, const UINT32 &i_u32End, const UINT32 &i_u32Depth,
+	std::vector<S_BUILD_DATA> &io_buildData, const D3DXVECTOR3 *i_vertices, const uint16_t *i_u16Indices )
+{
+	const UINT32 u32Node = _nodes.size();
+	const UINT32 u32Total = i_u32End - i_u32Begin;
+	D3DXVECTOR3 vCentroidMin;
+	D3DXVECTOR3 vCentroidMax;
+	UINT32 u32BestAxis = 0;
+	UINT32 u32BestSplit = 0;
+	float bestCost = FLT_MAX;
+
+	FUNCTION_START;
+
+	_nodes.push_back( S_NODE() );
+	BVHHelper::ResetBounds( _nodes[u32Node].vMin, _nodes[u32Node].vMax );
+	BVHHelper::ResetBounds( vCentroidMin, vCentroidMax );
+	for( UINT32 i = i_u32Begin; i < i_u32End; ++i )
+	{
+		BVHHelper::GrowBounds( _nodes[u32Node].vMin, _nodes[u32Node].vMax, io_buildData[i].vMin, io_buildData[i].vMax );
+		BVHHelper::GrowBounds( vCentroidMin, vCentroidMax, io_buildData[i].vCentroid, io_buildData[i].vCentroid );
+	}
+
+	// Find the cheapest split plane between the bins of every axis
+	if( (u32Total > MAX_LEAF_SIZE) && (i_u32Depth < MAX_DEPTH - 1) )
+	{
+		for( UINT32 u32Axis = 0; u32Axis < 3; ++u32Axis )
+		{
+			const float min = (&vCentroidMin.x)[u32Axis];
+			const float extent = (&vCentroidMax.x)[u32Axis] - min;
+			if( extent <= FLT_EPSILON )
+				continue;
+
+			BVHHelper::S_BIN bins[BVHHelper::TOTAL_BINS];
+			const float scale = BVHHelper::TOTAL_BINS / extent;
+			for( UINT32 i = 0; i < BVHHelper::TOTAL_BINS; ++i )
+			{
+				BVHHelper::ResetBounds( bins[i].vMin, bins[i].vMax );
+				bins[i].u32Total = 0;
+			}
+			for( UINT32 i = i_u32Begin; i < i_u32End; ++i )
+			{
+				BVHHelper::S_BIN &bin = bins[BVHHelper::GetBin( (&io_buildData[i].vCentroid.x)[u32Axis], min, scale )];
+				BVHHelper::GrowBounds( bin.vMin, bin.vMax, io_buildData[i].vMin, io_buildData[i].vMax );
+				++bin.u32Total;
+			}
+
+			// Sweep from the right to get the cost of every right side, then from the left
+			float rightCost[BVHHelper::TOTAL_BINS];
+			D3DXVECTOR3 vMin;
+			D3DXVECTOR3 vMax;
+			UINT32 u32Count = 0;
+			BVHHelper::ResetBounds( vMin, vMax );
+			for( UINT32 i = BVHHelper::TOTAL_BINS - 1; i > 0; --i )
+			{
+				BVHHelper::GrowBounds( vMin, vMax, bins[i].vMin, bins[i].vMax );
+				u32Count += bins[i].u32Total;
+				rightCost[i] = u32Count > 0 ? BVHHelper::HalfSurfaceArea( vMin, vMax ) * u32Count : 0.0f;
+			}
+
+			u32Count = 0;
+			BVHHelper::ResetBounds( vMin, vMax );
+			for( UINT32 i = 0; i < BVHHelper::TOTAL_BINS - 1; ++i )
+			{
+				BVHHelper::GrowBounds( vMin, vMax, bins[i].vMin, bins[i].vMax );
+				u32Count += bins[i].u32Total;
+				if( (u32Count == 0) || (u32Count == u32Total) )
+					continue;
+
+				float cost = BVHHelper::HalfSurfaceArea( vMin, vMax ) * u32Count + rightCost[i + 1];
+				if( cost < bestCost )
+				{
+					bestCost = cost;
+					u32BestAxis = u32Axis;
+					u32BestSplit = i + 1;
+				}
+			}
+		}
+
+		// Splitting costs a node visit, keep small sets as a leaf when that is cheaper
+		if( bestCost < FLT_MAX )
+		{
+			float splitCost = 1.0f + bestCost / BVHHelper::HalfSurfaceArea( _nodes[u32Node].vMin, _nodes[u32Node].vMax );
+			if( (splitCost >= u32Total) && (u32Total <= MAX_LEAF_SIZE * 4) )
+				bestCost = FLT_MAX;
+		}
+	}
+
+	if( bestCost == FLT_MAX )
+	{
+		_nodes[u32Node].u32Offset = _trianglePackets.size();
+		_nodes[u32Node].u32TotalTriangles = u32Total;
+		for( UINT32 i = 0; i < u32Total; ++i )
+		{
+			const uint16_t *indices = &i_u16Indices[io_buildData[i_u32Begin + i].u32Triangle * 3];
+
+			if( (i % Utilities::Math::TRIANGLE_PACKET_SIZE) == 0 )
+			{
+				_trianglePackets.push_back( Utilities::Math::S_TRIANGLE_PACKET() );
+				Utilities::Math::ClearTrianglePacket( _trianglePackets.back() );
+			}
+			Utilities::Math::SetTriangle( _trianglePackets.back(), i % Utilities::Math::TRIANGLE_PACKET_SIZE,
+				i_vertices[indices[0]], i_vertices[indices[1]], i_vertices[indices[2]] );
+		}
+
+		FUNCTION_FINISH;
+		return;
+	}
+
+	const float min = (&vCentroidMin.x)[u32BestAxis];
+	const float scale = BVHHelper::TOTAL_BINS / ((&vCentroidMax.x)[u32BestAxis] - min);
+	UINT32 u32Middle = i_u32Begin;
+	for( UINT32 i = i_u32Begin; i < i_u32End; ++i )
+	{
+		if( BVHHelper::GetBin((&io_buildData[i].vCentroid.x)[u32BestAxis], min, scale) < u32BestSplit )
+			std::swap( io_buildData[i], io_buildData[u32Middle++] );
+	}
+	assert( (u32Middle > i_u32Begin) && (u32Middle < i_u32End) );
+
+	_nodes[u32Node].u32TotalTriangles = 0;
+	Build( i_u32Begin, u32Middle, i_u32Depth + 1, io_buildData, i_vertices, i_u16Indices );
+	_nodes[u32Node].u32Offset = _nodes.size();
+	Build( u32Middle, i_u32End, i_u32Depth + 1, io_buildData, i_vertices, i_u16Indices );
+
+	FUNCTION_FINISH;
+}
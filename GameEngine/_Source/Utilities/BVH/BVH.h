@@ -0,0 +1,61 @@
+#ifndef _BVH_H_
+#define _BVH_H_
+
+#include <vector>
+
+// Utilities header
+#include <Math/Math.h>
+
+#include "../GameEngineTypes.h"
+
+namespace GameEngine
+{
+	// Bounding volume hierarchy over an indexed triangle mesh, built with binned SAH and stored as a
+	// flat array of nodes in depth first order
+	class BVH
+	{
+		typedef struct _s_node_
+		{
+			D3DXVECTOR3 vMin;
+			// First triangle packet of a leaf, second child of an inner node. The first child follows its parent
+			UINT32 u32Offset;
+			D3DXVECTOR3 vMax;
+			// Zero for an inner node
+			UINT32 u32TotalTriangles;
+		} S_NODE;
+
+		typedef struct _s_build_data_
+		{
+			D3DXVECTOR3 vMin;
+			D3DXVECTOR3 vMax;
+			D3DXVECTOR3 vCentroid;
+			UINT32 u32Triangle;
+		} S_BUILD_DATA;
+
+		static const UINT32 MAX_LEAF_SIZE = 4;
+		static const UINT32 MAX_DEPTH = 32;
+
+		std::vector<S_NODE> _nodes;
+		// Every leaf starts a new packet
+		std::vector<Utilities::Math::S_TRIANGLE_PACKET> _trianglePackets;
+
+		void Build( const UINT32 &i_u32Begin, const UINT32 &i_u32End, const UINT32 &i_u32Depth,
+			std::vector<S_BUILD_DATA> &io_buildData, const D3DXVECTOR3 *i_vertices, const uint16_t *i_u16Indices );
+
+		BVH( const BVH &i_other );
+		BVH &operator=( const BVH &i_other );
+
+	public:
+		BVH( const D3DXVECTOR3 *i_vertices, const uint16_t *i_u16Indices, const UINT32 &i_u32TotalTriangles );
+		~BVH( void );
+
+		bool RayTracing( const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint, const bool &i_bCollisionHasDetected,
+			D3DXVECTOR3 &o_collisionPoint, float &o_collisionDistance ) const;
+		// Capsule from i_startPoint to i_startPoint + i_axis swept to i_endPoint, a zero axis sweeps a sphere.
+		// Only a contact earlier than io_hit.time is taken
+		bool Sweep( const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint, const D3DXVECTOR3 &i_axis,
+			const float &i_radius, Utilities::Math::S_SWEEP_HIT &io_hit ) const;
+	};
+}
+
+#endif	// _BVH_H_
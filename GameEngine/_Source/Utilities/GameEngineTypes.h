@@ -22,6 +22,27 @@ namespace GameEngine
 		E_COLLISION_BY_OCTREE,
 		E_COLLISION_MAX
 	} E_COLLISION_BY;
+
+	// Engine state declared by the tasks of the frame task graphs
+	typedef enum _e_engine_resource_
+	{
+		E_RESOURCE_ENTITY				= 0x0001,	// Entity database, controllers and entity reference counts
+		E_RESOURCE_POSITION			= 0x0002,	// Position, orientation and scale
+		E_RESOURCE_VELOCITY			= 0x0004,
+		E_RESOURCE_ACCELERATION	= 0x0008,
+		E_RESOURCE_PROJECTION		= 0x0010,	// Projected position and velocity
+		E_RESOURCE_AI						= 0x0020,
+		E_RESOURCE_PHYSICS			= 0x0040,
+		E_RESOURCE_COLLISION		= 0x0080,
+		E_RESOURCE_TRIGGER_BOX	= 0x0100,
+		E_RESOURCE_CAMERA				= 0x0200,
+		E_RESOURCE_RENDERER			= 0x0400,
+		E_RESOURCE_DEBUG_MENU		= 0x0800,	// Debug menu state and the settings it controls
+		E_RESOURCE_DEBUG_DRAW		= 0x1000,
+		E_RESOURCE_AUDIO				= 0x2000,
+		E_RESOURCE_PROFILER			= 0x4000,
+		E_RESOURCE_ALL					= 0xFFFF
+	} E_ENGINE_RESOURCE;
 }
 
 #endif	// #ifndef _GAME_ENGINE_TYPES_H_
\ No newline at end of file
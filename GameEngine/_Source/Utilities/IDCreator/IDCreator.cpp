@@ -20,6 +20,20 @@
  ****************************************************************************************************
 */
 UINT8 GameEngine::IDCreator::GetID( const char* i_entityType )
+{
+	return GetID( Utilities::StringHash(i_entityType) );
+}
+
+/**
+ ****************************************************************************************************
+	\fn			UINT8 GetID( const Utilities::StringHash &i_hashedType )
+	\brief		Get the ID of the hashed entity type
+	\param		i_hashedType hashed type of the entity
+	\return		UINT8
+	\retval		The ID of the entity type
+ ****************************************************************************************************
+*/
+UINT8 GameEngine::IDCreator::GetID( const Utilities::StringHash &i_hashedType )
 {
 	INT8 firstFree = -1;
 
@@ -27,7 +41,7 @@ UINT8 GameEngine::IDCreator::GetID( const char* i_entityType )
 
 	for( UINT32 i = 0; i < Utilities::DEFAULT_ID_SIZE; ++i )
 	{
-		if( _IDs[i]._hash == Utilities::StringHash(i_entityType) )
+		if( _IDs[i]._hash == i_hashedType )
 		{
 			FUNCTION_FINISH;
 			return i + 1;
@@ -37,13 +51,33 @@ UINT8 GameEngine::IDCreator::GetID( const char* i_entityType )
 			firstFree = i;
 	}
 
-	_IDs[firstFree]._hash = Utilities::StringHash( i_entityType );
+	_IDs[firstFree]._hash = i_hashedType;
 	_IDs[firstFree]._inUse = true;
 
 	FUNCTION_FINISH;
 	return firstFree + 1;
 }
 
+/**
+ ****************************************************************************************************
+	\fn			bool GetHashedType( const UINT8 &i_ID, Utilities::StringHash &o_hashedType ) const
+	\brief		Get the hashed entity type of given ID
+	\param		i_ID input ID
+	\param		o_hashedType the hashed entity type
+	\return		boolean
+	\retval		TRUE the ID is in use
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+bool GameEngine::IDCreator::GetHashedType( const UINT8 &i_ID, Utilities::StringHash &o_hashedType ) const
+{
+	if( (i_ID == 0) || !_IDs[i_ID - 1]._inUse )
+		return false;
+
+	o_hashedType = _IDs[i_ID - 1]._hash;
+	return true;
+}
+
 /**
  ****************************************************************************************************
 	\fn			void ReleaseID( const UINT32 &i_ID )
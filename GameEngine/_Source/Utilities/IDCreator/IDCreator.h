@@ -38,6 +38,8 @@ class IDCreator
 public:
 	void ReleaseID( const UINT32 &i_ID );
 	UINT8 GetID( const char* i_entityType );
+	UINT8 GetID( const Utilities::StringHash &i_hashedType );
+	bool GetHashedType( const UINT8 &i_ID, Utilities::StringHash &o_hashedType ) const;
 	UINT32 IDtoBitMask( const UINT32 &i_ID );
 };
 }	// namespace GameEngine
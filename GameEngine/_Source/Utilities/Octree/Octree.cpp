@@ -1,28 +1,119 @@
+#include <float.h>
 #include <assert.h>
-#include <fstream>
+#include <algorithm>
 
 // Utilities header
 #include <Math/Math.h>
 #include <Debug/Debug.h>
+#include <Target/Target.h>
 #include <Parser/TagList.h>
 
+#ifdef TARGET_SSE2
+	#include <emmintrin.h>
+#endif	// #ifdef TARGET_SSE2
+
 #include "Octree.h"
 #include "../../DebugMenu/DebugMenu.h"
 
 bool GameEngine::Octree::_bShowOctree = false;
 
+namespace GameEngine
+{
+	namespace OctreeHelper
+	{
+		static inline bool IsCloser( const Octree::S_TRIANGLE_SPAN &i_lhs, const Octree::S_TRIANGLE_SPAN &i_rhs )
+		{
+			return i_lhs.tEntry < i_rhs.tEntry;
+		}
+
+		static inline void DecodeVertex( const Utilities::OctreeFile::S_NODE &i_node, const Utilities::OctreeFile::S_VERTEX &i_vertex,
+			D3DXVECTOR3 &o_vertex )
+		{
+			o_vertex.x = i_node.vertexOrigin.x + i_vertex.u16Position[0] * i_node.vertexScale.x;
+			o_vertex.y = i_node.vertexOrigin.y + i_vertex.u16Position[1] * i_node.vertexScale.y;
+			o_vertex.z = i_node.vertexOrigin.z + i_vertex.u16Position[2] * i_node.vertexScale.z;
+		}
+
+		static inline bool IsValidRange( const UINT32 &i_u32First, const UINT32 &i_u32Count, const UINT32 &i_u32Total )
+		{
+			return (i_u32First <= i_u32Total) && (i_u32Count <= i_u32Total - i_u32First);
+		}
+
+		static bool IsValidSection( const Utilities::OctreeFile::S_SECTION &i_section, const UINT32 &i_u32RecordSize,
+			const UINT32 &i_u32FileSize )
+		{
+			if( (i_section.u32Offset < sizeof(Utilities::OctreeFile::S_HEADER)) || (i_section.u32Offset > i_u32FileSize)
+				|| (i_section.u32Offset % Utilities::OctreeFile::ALIGNMENT) )
+				return false;
+
+			return i_section.u32Total <= ((i_u32FileSize - i_section.u32Offset) / i_u32RecordSize);
+		}
+
+		// Check every offset and index before the mapped file is used, children must come after their parent so
+		// a query always terminates
+		static bool IsValid( const Utilities::MappedFile &i_file )
+		{
+			const UINT32 u32FileSize = i_file.GetSize();
+
+			if( u32FileSize < sizeof(Utilities::OctreeFile::S_HEADER) )
+				return false;
+
+			const Utilities::OctreeFile::S_HEADER &header = *reinterpret_cast<const Utilities::OctreeFile::S_HEADER *>( i_file.GetData() );
+			if( (header.u32Magic != Utilities::OctreeFile::MAGIC) || (header.u32Version != Utilities::OctreeFile::VERSION)
+				|| (header.u32Alignment != Utilities::OctreeFile::ALIGNMENT) || (header.u32FileSize != u32FileSize) )
+				return false;
+
+			if( !IsValidSection(header.node, sizeof(Utilities::OctreeFile::S_NODE), u32FileSize)
+				|| !IsValidSection(header.vertex, sizeof(Utilities::OctreeFile::S_VERTEX), u32FileSize)
+				|| !IsValidSection(header.triangle, sizeof(Utilities::OctreeFile::S_TRIANGLE), u32FileSize)
+				|| !IsValidSection(header.tag, sizeof(Utilities::StringHash), u32FileSize) )
+				return false;
+
+			const Utilities::OctreeFile::S_NODE *nodes = reinterpret_cast<const Utilities::OctreeFile::S_NODE *>( i_file.GetData() + header.node.u32Offset );
+			const Utilities::OctreeFile::S_TRIANGLE *triangles = reinterpret_cast<const Utilities::OctreeFile::S_TRIANGLE *>( i_file.GetData() + header.triangle.u32Offset );
+			for( UINT32 i = 0; i < header.node.u32Total; ++i )
+			{
+				if( !IsValidRange(nodes[i].u32StartIndex, nodes[i].u32TotalData, header.triangle.u32Total)
+					|| !IsValidRange(nodes[i].u32FirstVertex, nodes[i].u32TotalVertices, header.vertex.u32Total)
+					|| !IsValidRange(nodes[i].u32FirstTag, nodes[i].u32TotalTags, header.tag.u32Total) )
+					return false;
+
+				// Triangles may only use the vertices and tags of their own node
+				for( UINT32 j = nodes[i].u32StartIndex; j < nodes[i].u32StartIndex + nodes[i].u32TotalData; ++j )
+				{
+					if( (triangles[j].u16Vertices[0] >= nodes[i].u32TotalVertices) || (triangles[j].u16Vertices[1] >= nodes[i].u32TotalVertices)
+						|| (triangles[j].u16Vertices[2] >= nodes[i].u32TotalVertices) || (triangles[j].u16Tag >= nodes[i].u32TotalTags) )
+						return false;
+				}
+
+				for( UINT8 j = 0; j < Utilities::E_OCTANT_TOTAL; ++j )
+				{
+					UINT32 u32Child = nodes[i].u32Children[j];
+					if( (u32Child != Utilities::OctreeFile::NO_NODE) && ((u32Child <= i) || (u32Child >= header.node.u32Total)) )
+						return false;
+				}
+			}
+
+			return true;
+		}
+	}	// namespace OctreeHelper
+}	// namespace GameEngine
+
 /****************************************************************************************************
 			Octree class public functions implementation
 ****************************************************************************************************/
 GameEngine::Octree::Octree( const char *i_filename ) :
-	_root( NULL ),
-	m_triangleDatabase( NULL )
+	_file( NULL ),
+	_nodes( NULL ),
+	_vertices( NULL ),
+	_triangles( NULL ),
+	_tags( NULL ),
+	_u32TotalNodes( 0 ),
+	m_u32TotalTriangles( 0 )
 {
 	assert( i_filename != NULL );
 	assert( i_filename[0] != '\0' );
 
-	std::ifstream in;
-	UINT32 u32StartAddress = 0;
 	char fileName[MAX_FILENAME_INPUT];
 
 	FUNCTION_START;
@@ -30,9 +121,18 @@ GameEngine::Octree::Octree( const char *i_filename ) :
 	strcpy_s( fileName, MAX_FILENAME_INPUT, "../../External/Data/Scenes/" );
 	strcat_s( fileName, MAX_FILENAME_INPUT, i_filename );
 
-	in.open( fileName, std::ios::binary );
-	if( in.fail() )
+	_file = Utilities::MappedFile::Create( fileName );
+	if( !_file )
+	{
+		FUNCTION_FINISH;
+		return;
+	}
+
+	if( !OctreeHelper::IsValid(*_file) )
 	{
+		DBG_MSG_LEVEL( D_ERR, "%s is not a valid octree file, generate it again\n", fileName );
+		delete _file;
+		_file = NULL;
 		FUNCTION_FINISH;
 		return;
 	}
@@ -41,223 +141,240 @@ GameEngine::Octree::Octree( const char *i_filename ) :
 	g_debugMenu::Get().AddCheckBox( "Show octree", _bShowOctree );
 #endif	// #ifdef ENABLE_OCTREE
 
-	if( !m_triangleDatabase )
-		m_triangleDatabase = new std::vector<Utilities::S_TRIANGLE>;
-
-	in.seekg( u32StartAddress, std::ios::beg );
+	const UINT8 *data = _file->GetData();
+	const Utilities::OctreeFile::S_HEADER &header = *reinterpret_cast<const Utilities::OctreeFile::S_HEADER *>( data );
 
-	_root = new OctreeNode();
-	_root->Load( this, in, u32StartAddress );
-
-	in.close();
+	_nodes = reinterpret_cast<const Utilities::OctreeFile::S_NODE *>( data + header.node.u32Offset );
+	_u32TotalNodes = header.node.u32Total;
+	_vertices = reinterpret_cast<const Utilities::OctreeFile::S_VERTEX *>( data + header.vertex.u32Offset );
+	_triangles = reinterpret_cast<const Utilities::OctreeFile::S_TRIANGLE *>( data + header.triangle.u32Offset );
+	_tags = reinterpret_cast<const Utilities::StringHash *>( data + header.tag.u32Offset );
+	m_u32TotalTriangles = header.triangle.u32Total;
 
 	FUNCTION_FINISH;
 }
 
 GameEngine::Octree::~Octree( void )
 {
-	if( _root )
+	if( _file )
 	{
-		delete _root;
-		_root = NULL;
+		delete _file;
+		_file = NULL;
 	}
+}
 
-	if( m_triangleDatabase )
-	{
-		delete m_triangleDatabase;
-		m_triangleDatabase = NULL;
-	}
+// The spans are appended to o_triangleSpans sorted from the nearest node, so the caller can stop once
+// it has a collision closer than the entry of the next span
+void GameEngine::Octree::GetTriangleSpans( const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint,
+	std::vector<S_TRIANGLE_SPAN> &o_triangleSpans, const bool &i_bDrawNodes ) const
+{
+	GetTriangleSpans( i_startPoint, i_endPoint, D3DXVECTOR3(0.0f, 0.0f, 0.0f), o_triangleSpans, i_bDrawNodes );
 }
 
-void GameEngine::Octree::GetTriangleData( const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint,
-	std::vector<Utilities::S_TRIANGLE> &o_triangleData )
+void GameEngine::Octree::GetTriangleSpans( const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint, const D3DXVECTOR3 &i_vExtent,
+	std::vector<S_TRIANGLE_SPAN> &o_triangleSpans, const bool &i_bDrawNodes ) const
 {
-	for( UINT32 i = 0; i < _root->m_u32TotalData; ++i )
-		o_triangleData.push_back( m_triangleDatabase->at(_root->m_u32StartIndex+i) );
+	Utilities::Math::S_SEGMENT segment;
+	UINT32 u32FirstSpan = o_triangleSpans.size();
 
-	if( _bShowOctree )
-		g_debugMenu::Get().DrawBox( _root->m_maxDimension, _root->m_size * 2 );
+	if( _u32TotalNodes == 0 )
+		return;
 
-	if( _root->m_bHasChildren )
-	{
-		for( UINT8 i = 0; i < Utilities::E_OCTANT_TOTAL; ++i )
-		{
-			if( _root->m_children[i] != NULL )
-				_root->m_children[i]->GetTriangleData( this, i_startPoint, i_endPoint, o_triangleData );
-		}
-	}
-}
+	Utilities::Math::SetSegment( segment, i_startPoint, i_endPoint );
+	GetTriangleSpans( 0, segment, i_vExtent, i_bDrawNodes && _bShowOctree, o_triangleSpans );
 
-/****************************************************************************************************
-			OctreeNode class public functions implementation
-****************************************************************************************************/
-GameEngine::Octree::OctreeNode::OctreeNode( void ) :
-	m_u32StartIndex( 0 ),
-	m_u32TotalData( 0 ),
-	m_size( 0.0f ),
-	m_parent( NULL ),
-	m_bHasChildren( false )
-{
-	for( UINT8 i = 0; i < Utilities::E_OCTANT_TOTAL; ++i )
-		m_children[i] = NULL;
+	std::sort( o_triangleSpans.begin() + u32FirstSpan, o_triangleSpans.end(), OctreeHelper::IsCloser );
 }
 
-GameEngine::Octree::OctreeNode::OctreeNode( OctreeNode *i_parent ) :
-	m_u32StartIndex( 0 ),
-	m_u32TotalData( 0 ),
-	m_size( 0.0f ),
-	m_parent( i_parent ),
-	m_bHasChildren( false )
+UINT32 GameEngine::Octree::GetLocalSpans( const UINT32 &i_u32Node, std::vector<S_TRIANGLE_SPAN> &o_triangleSpans,
+	D3DXVECTOR3 &o_vMin, D3DXVECTOR3 &o_vMax ) const
 {
-	for( UINT8 i = 0; i < Utilities::E_OCTANT_TOTAL; ++i )
-		m_children[i] = NULL;
-}
+	UINT32 u32Node = 0;
+	UINT32 u32TotalTriangles = 0;
 
-GameEngine::Octree::OctreeNode::OctreeNode( OctreeNode *i_parent,
-	const D3DXVECTOR3& i_maxDimension, const float &i_size,
-	const UINT32 i_u32StartIndex, const UINT32 i_u32TotalData, const bool &i_bHasChildren) :
-	m_maxDimension( i_maxDimension ),
-	m_u32StartIndex( i_u32StartIndex ),
-	m_u32TotalData( i_u32TotalData ),
-	m_size( i_size ),
-	m_parent( i_parent ),
-	m_bHasChildren( i_bHasChildren )
-{
-	for( UINT8 i = 0; i < Utilities::E_OCTANT_TOTAL; ++i )
-		m_children[i] = NULL;
-}
+	assert( i_u32Node < _u32TotalNodes );
 
-GameEngine::Octree::OctreeNode::OctreeNode( const D3DXVECTOR3& i_maxDimension, const float &i_size,
-	const UINT32 i_u32StartIndex, const UINT32 i_u32TotalData, const bool &i_bHasChildren ) :
-	m_maxDimension( i_maxDimension ),
-	m_u32StartIndex( i_u32StartIndex ),
-	m_u32TotalData( i_u32TotalData ),
-	m_size( i_size ),
-	m_parent( NULL ),
-	m_bHasChildren( i_bHasChildren )
-{
-	for( UINT8 i = 0; i < Utilities::E_OCTANT_TOTAL; ++i )
-		m_children[i] = NULL;
-}
+	o_triangleSpans.clear();
 
-GameEngine::Octree::OctreeNode::~OctreeNode( void )
-{
-	if( m_bHasChildren )
+	// The subtree of a child runs up to the next child, so the ancestor on the way down is the last child
+	// that is not after the node
+	while( u32Node != i_u32Node )
 	{
+		const Utilities::OctreeFile::S_NODE &node = _nodes[u32Node];
+		UINT32 u32Next = u32Node;
+
+		if( node.u32TotalData > 0 )
+		{
+			S_TRIANGLE_SPAN span = { node.u32StartIndex, node.u32TotalData, u32Node, 0.0f };
+			o_triangleSpans.push_back( span );
+			u32TotalTriangles += node.u32TotalData;
+		}
+
 		for( UINT8 i = 0; i < Utilities::E_OCTANT_TOTAL; ++i )
 		{
-			if( m_children[i] )
-			{
-				delete m_children[i];
-				m_children[i] = NULL;
-			}
+			UINT32 u32Child = node.u32Children[i];
+			if( (u32Child != Utilities::OctreeFile::NO_NODE) && (u32Child <= i_u32Node) && ((u32Next == u32Node) || (u32Child > u32Next)) )
+				u32Next = u32Child;
 		}
+		assert( u32Next != u32Node );
+		u32Node = u32Next;
 	}
-}
 
-void GameEngine::Octree::OctreeNode::AddChildren( const UINT8 &i_u8Octant,
-	const D3DXVECTOR3& i_maxDimension, const float &i_size,
-	const UINT32 i_u32StartIndex, const UINT32 i_u32TotalData, const bool &i_bHasChildren )
-{
-	m_children[i_u8Octant] = new OctreeNode( this, i_maxDimension, i_size,
-		i_u32StartIndex, i_u32TotalData, i_bHasChildren );
-}
+	u32TotalTriangles += GetSubtreeSpans( i_u32Node, o_triangleSpans );
 
-void GameEngine::Octree::OctreeNode::Load( Octree *i_octree, std::ifstream &i_inputStream, UINT32 &io_u32StartAddress )
-{
-	Utilities::S_TRIANGLE *triangle;
+	float boxSize = 2 * _nodes[i_u32Node].size;
+	o_vMax = _nodes[i_u32Node].maxDimension;
+	o_vMin = D3DXVECTOR3( o_vMax.x - boxSize, o_vMax.y - boxSize, o_vMax.z - boxSize );
 
-	FUNCTION_START;
-
-	i_inputStream.seekg( io_u32StartAddress, std::ios::beg );
+	return u32TotalTriangles;
+}
 
-	i_inputStream.read( (char*) &m_size, sizeof(float) );
-	io_u32StartAddress += sizeof( float );
-	i_inputStream.read( (char*) &m_maxDimension, sizeof(D3DXVECTOR3) );
-	io_u32StartAddress += sizeof( D3DXVECTOR3 );
-	i_inputStream.read( (char*) &m_u32TotalData, sizeof(UINT32) );
-	io_u32StartAddress += sizeof( UINT32 );
-	i_inputStream.read( (char*) &m_bHasChildren, sizeof(bool) );
-	io_u32StartAddress += sizeof( bool );
+// Every vertex of the packet is decoded with one 64 bit load, then the vertices are transposed to the
+// layout of the packet
+void GameEngine::Octree::GetTrianglePacket( const S_TRIANGLE_SPAN &i_span, const UINT32 &i_u32First,
+	Utilities::Math::S_TRIANGLE_PACKET &o_packet ) const
+{
+	const Utilities::OctreeFile::S_NODE &node = _nodes[i_span.u32Node];
+	const Utilities::OctreeFile::S_TRIANGLE *triangles = _triangles + i_span.u32StartIndex + i_u32First;
+	const Utilities::OctreeFile::S_VERTEX *vertices = _vertices + node.u32FirstVertex;
+	UINT32 u32Total = i_span.u32TotalData - i_u32First;
 
-	char *tempTriangle = new char[m_u32TotalData * sizeof(Utilities::S_TRIANGLE)];
-	i_inputStream.read( tempTriangle, m_u32TotalData*sizeof(Utilities::S_TRIANGLE) );
-	io_u32StartAddress += m_u32TotalData * sizeof( Utilities::S_TRIANGLE );
-	triangle = new Utilities::S_TRIANGLE[m_u32TotalData];
-	memcpy( triangle, tempTriangle, m_u32TotalData * sizeof(Utilities::S_TRIANGLE) );
+	assert( i_u32First < i_span.u32TotalData );
 
-	m_u32StartIndex = i_octree->m_triangleDatabase->size();
+	if( u32Total > Utilities::Math::TRIANGLE_PACKET_SIZE )
+		u32Total = Utilities::Math::TRIANGLE_PACKET_SIZE;
 
-	// Push the data to Octree's triangle list
-	for( UINT32 i = 0; i < m_u32TotalData; ++i )
-		i_octree->m_triangleDatabase->push_back( triangle[i] );
+#ifdef TARGET_SSE2
+	const __m128 origin = _mm_setr_ps( node.vertexOrigin.x, node.vertexOrigin.y, node.vertexOrigin.z, 0.0f );
+	const __m128 scale = _mm_setr_ps( node.vertexScale.x, node.vertexScale.y, node.vertexScale.z, 0.0f );
+	const __m128i zero = _mm_setzero_si128();
+	__m128 vertex[3][Utilities::Math::TRIANGLE_PACKET_SIZE];
 
-	if( m_bHasChildren )
+	for( UINT32 i = 0; i < Utilities::Math::TRIANGLE_PACKET_SIZE; ++i )
 	{
-		for( UINT8 i = 0; i < Utilities::E_OCTANT_TOTAL; ++i )
+		for( UINT8 j = 0; j < 3; ++j )
 		{
-			float temp;
-			i_inputStream.read( (char*) &temp, sizeof(float) );
-			if( !Utilities::Math::AreRelativelyEqual(temp, 0.0f) )
+			if( i < u32Total )
 			{
-				m_children[i] = new OctreeNode( this );
-				m_children[i]->Load( i_octree, i_inputStream, io_u32StartAddress );
+				__m128i quantized = _mm_loadl_epi64( reinterpret_cast<const __m128i *>(&vertices[triangles[i].u16Vertices[j]]) );
+				vertex[j][i] = _mm_add_ps( origin, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(quantized, zero)), scale) );
 			}
 			else
 			{
-				io_u32StartAddress += sizeof( float );
+				vertex[j][i] = _mm_setzero_ps();
 			}
 		}
 	}
 
-	FUNCTION_FINISH;
+	for( UINT8 j = 0; j < 3; ++j )
+		_MM_TRANSPOSE4_PS( vertex[j][0], vertex[j][1], vertex[j][2], vertex[j][3] );
 
-	delete [] tempTriangle;
-	delete [] triangle;
+	for( UINT8 i = 0; i < 3; ++i )
+	{
+		_mm_storeu_ps( o_packet.vertex0[i], vertex[0][i] );
+		_mm_storeu_ps( o_packet.edge1[i], _mm_sub_ps(vertex[1][i], vertex[0][i]) );
+		_mm_storeu_ps( o_packet.edge2[i], _mm_sub_ps(vertex[2][i], vertex[0][i]) );
+	}
+#else
+	Utilities::Math::ClearTrianglePacket( o_packet );
+	for( UINT32 i = 0; i < u32Total; ++i )
+	{
+		D3DXVECTOR3 a;
+		D3DXVECTOR3 b;
+		D3DXVECTOR3 c;
+
+		OctreeHelper::DecodeVertex( node, vertices[triangles[i].u16Vertices[0]], a );
+		OctreeHelper::DecodeVertex( node, vertices[triangles[i].u16Vertices[1]], b );
+		OctreeHelper::DecodeVertex( node, vertices[triangles[i].u16Vertices[2]], c );
+		Utilities::Math::SetTriangle( o_packet, i, a, b, c );
+	}
+#endif	// #ifdef TARGET_SSE2
 }
 
-void GameEngine::Octree::OctreeNode::GetTriangleData( const Octree *i_octree, const D3DXVECTOR3 &i_startPoint,
-	const D3DXVECTOR3 &i_endPoint, std::vector<Utilities::S_TRIANGLE> &o_triangleData )
+void GameEngine::Octree::GetTriangle( const S_TRIANGLE_SPAN &i_span, const UINT32 &i_u32Triangle,
+	D3DXVECTOR3 &o_a, D3DXVECTOR3 &o_b, D3DXVECTOR3 &o_c ) const
 {
-	float boxSize = 2 * m_size;
-	D3DXVECTOR3 boxMax = m_maxDimension;
-	D3DXVECTOR3 boxMin( boxMax.x - boxSize, boxMax.y - boxSize, boxMax.z - boxSize );
+	const Utilities::OctreeFile::S_NODE &node = _nodes[i_span.u32Node];
+	const Utilities::OctreeFile::S_TRIANGLE &triangle = _triangles[i_span.u32StartIndex + i_u32Triangle];
 
-	D3DXVECTOR3 d = (i_endPoint - i_startPoint) * 0.5f;
-	D3DXVECTOR3 e = (boxMax - boxMin) * 0.5f;
-	D3DXVECTOR3 c = i_startPoint + d - (boxMin + boxMax) * 0.5f;
-	D3DXVECTOR3 ad( abs(d.x), abs(d.y), abs(d.z) );
+	assert( i_u32Triangle < i_span.u32TotalData );
 
-	if( fabsf(c.x) > (e.x + ad.x) )
-		return;
+	OctreeHelper::DecodeVertex( node, _vertices[node.u32FirstVertex + triangle.u16Vertices[0]], o_a );
+	OctreeHelper::DecodeVertex( node, _vertices[node.u32FirstVertex + triangle.u16Vertices[1]], o_b );
+	OctreeHelper::DecodeVertex( node, _vertices[node.u32FirstVertex + triangle.u16Vertices[2]], o_c );
+}
 
-	if( fabsf(c.y) > (e.y + ad.y) )
-		return;
+const Utilities::StringHash &GameEngine::Octree::GetTag( const S_TRIANGLE_SPAN &i_span, const UINT32 &i_u32Triangle ) const
+{
+	assert( i_u32Triangle < i_span.u32TotalData );
 
-	if( fabsf(c.z) > (e.z + ad.z) )
-		return;
+	return _tags[_nodes[i_span.u32Node].u32FirstTag + _triangles[i_span.u32StartIndex + i_u32Triangle].u16Tag];
+}
 
-	if( fabsf(d.y * c.z - d.z * c.y) > (e.y * ad.z + e.z * ad.y + FLT_EPSILON) )
-		return;
+// Union of the vertex bounds of every node
+void GameEngine::Octree::GetBounds( D3DXVECTOR3 &o_vMin, D3DXVECTOR3 &o_vMax ) const
+{
+	const float steps = static_cast<float>( Utilities::OctreeFile::MAX_QUANTIZED );
 
-	if( fabsf(d.z * c.x - d.x * c.z) > (e.z * ad.x + e.x * ad.z + FLT_EPSILON) )
-		return;
+	o_vMin = D3DXVECTOR3( FLT_MAX, FLT_MAX, FLT_MAX );
+	o_vMax = D3DXVECTOR3( -FLT_MAX, -FLT_MAX, -FLT_MAX );
+	for( UINT32 i = 0; i < _u32TotalNodes; ++i )
+	{
+		if( _nodes[i].u32TotalVertices == 0 )
+			continue;
+
+		D3DXVECTOR3 vMax = _nodes[i].vertexOrigin + _nodes[i].vertexScale * steps;
+		D3DXVec3Minimize( &o_vMin, &o_vMin, &_nodes[i].vertexOrigin );
+		D3DXVec3Maximize( &o_vMax, &o_vMax, &vMax );
+	}
+}
+
+/****************************************************************************************************
+			Octree class private functions implementation
+****************************************************************************************************/
+void GameEngine::Octree::GetTriangleSpans( const UINT32 &i_u32Node, const Utilities::Math::S_SEGMENT &i_segment, const D3DXVECTOR3 &i_vExtent,
+	const bool &i_bDrawNodes, std::vector<S_TRIANGLE_SPAN> &o_triangleSpans ) const
+{
+	const Utilities::OctreeFile::S_NODE &node = _nodes[i_u32Node];
+	float boxSize = 2 * node.size;
+	D3DXVECTOR3 boxMin( node.maxDimension.x - boxSize, node.maxDimension.y - boxSize, node.maxDimension.z - boxSize );
+	float tEntry;
 
-	if( fabsf(d.x * c.y - d.y * c.x) > (e.x * ad.y + e.y * ad.x + FLT_EPSILON) )
+	if( !Utilities::Math::SegmentBoxEntry(i_segment, boxMin - i_vExtent, node.maxDimension + i_vExtent, tEntry) )
 		return;
 
-	if( _bShowOctree )
-		g_debugMenu::Get().DrawBox( m_maxDimension, m_size * 2 );
+	if( i_bDrawNodes )
+		g_debugMenu::Get().DrawBox( node.maxDimension, boxSize );
 
-	for( UINT32 i = 0; i < m_u32TotalData; ++i )
-		o_triangleData.push_back( i_octree->m_triangleDatabase->at(m_u32StartIndex + i) );
+	if( node.u32TotalData > 0 )
+	{
+		S_TRIANGLE_SPAN span = { node.u32StartIndex, node.u32TotalData, i_u32Node, tEntry };
+		o_triangleSpans.push_back( span );
+	}
 
-	if( m_bHasChildren )
+	for( UINT8 i = 0; i < Utilities::E_OCTANT_TOTAL; ++i )
 	{
-		for( UINT8 i = 0; i < Utilities::E_OCTANT_TOTAL; ++i )
-		{
-			if( m_children[i] != NULL )
-				m_children[i]->GetTriangleData( i_octree, i_startPoint, i_endPoint, o_triangleData );
-		}
+		if( node.u32Children[i] != Utilities::OctreeFile::NO_NODE )
+			GetTriangleSpans( node.u32Children[i], i_segment, i_vExtent, i_bDrawNodes, o_triangleSpans );
+	}
+}
+
+UINT32 GameEngine::Octree::GetSubtreeSpans( const UINT32 &i_u32Node, std::vector<S_TRIANGLE_SPAN> &o_triangleSpans ) const
+{
+	const Utilities::OctreeFile::S_NODE &node = _nodes[i_u32Node];
+	UINT32 u32TotalTriangles = node.u32TotalData;
+
+	if( node.u32TotalData > 0 )
+	{
+		S_TRIANGLE_SPAN span = { node.u32StartIndex, node.u32TotalData, i_u32Node, 0.0f };
+		o_triangleSpans.push_back( span );
 	}
-}
\ No newline at end of file
+
+	for( UINT8 i = 0; i < Utilities::E_OCTANT_TOTAL; ++i )
+	{
+		if( node.u32Children[i] != Utilities::OctreeFile::NO_NODE )
+			u32TotalTriangles += GetSubtreeSpans( node.u32Children[i], o_triangleSpans );
+	}
+
+	return u32TotalTriangles;
+}
@@ -3,52 +3,72 @@
 
 #include <vector>
 
+// Utilities header
+#include <Math/Math.h>
+#include <MappedFile/MappedFile.h>
+#include <OctreeFile/OctreeFile.h>
+
 #include "../GameEngineTypes.h"
 
 namespace GameEngine
 {
+	// Collision octree used in place from the mapped octree file, it is shared read only between every
+	// process that loads the same file
 	class Octree
 	{
-		class OctreeNode
+	public:
+		// Triangles of a node, they are stored contiguously in the triangle block of the file
+		typedef struct _s_triangle_span_
 		{
-		public:
-			D3DXVECTOR3 m_maxDimension;
-			UINT32 m_u32StartIndex;
-			UINT32 m_u32TotalData;
-			float m_size;
-			OctreeNode *m_parent;
-			OctreeNode *m_children[Utilities::E_OCTANT_TOTAL];
-			bool m_bHasChildren;
-
-			OctreeNode( void );
-			OctreeNode( OctreeNode *i_parent );
-			OctreeNode( OctreeNode *i_parent, const D3DXVECTOR3& i_maxDimension, const float &i_size,
-				const UINT32 i_u32StartIndex, const UINT32 i_u32TotalData, const bool &i_bHasChildren );
-			OctreeNode( const D3DXVECTOR3& i_maxDimension, const float &i_size,
-				const UINT32 i_u32StartIndex, const UINT32 i_u32TotalData, const bool &i_bHasChildren );
-			~OctreeNode( void );
-
-			void AddChildren( const UINT8 &i_u8Octant,
-				const D3DXVECTOR3& i_maxDimension, const float &i_size,
-				const UINT32 i_u32StartIndex, const UINT32 i_u32TotalData, const bool &i_bHasChildren );
-
-			void Load( Octree *i_octree, std::ifstream &i_inputStream, UINT32 &io_u32StartAddress );
-			void GetTriangleData( const Octree *i_octree, const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint,
-				std::vector<Utilities::S_TRIANGLE> &o_triangleData );
-		};
-
-		OctreeNode *_root;
+			UINT32 u32StartIndex;
+			UINT32 u32TotalData;
+			UINT32 u32Node;
+			// Fraction of the segment where it enters the node
+			float tEntry;
+		} S_TRIANGLE_SPAN;
+
+	private:
+		Utilities::MappedFile *_file;
+		const Utilities::OctreeFile::S_NODE *_nodes;
+		const Utilities::OctreeFile::S_VERTEX *_vertices;
+		const Utilities::OctreeFile::S_TRIANGLE *_triangles;
+		const Utilities::StringHash *_tags;
+		UINT32 _u32TotalNodes;
 		static bool _bShowOctree;
 
+		void GetTriangleSpans( const UINT32 &i_u32Node, const Utilities::Math::S_SEGMENT &i_segment, const D3DXVECTOR3 &i_vExtent,
+			const bool &i_bDrawNodes, std::vector<S_TRIANGLE_SPAN> &o_triangleSpans ) const;
+		UINT32 GetSubtreeSpans( const UINT32 &i_u32Node, std::vector<S_TRIANGLE_SPAN> &o_triangleSpans ) const;
+
+		Octree( const Octree &i_other );
+		Octree &operator=( const Octree &i_other );
+
 	public:
-		std::vector<Utilities::S_TRIANGLE> *m_triangleDatabase;
+		UINT32 m_u32TotalTriangles;
 
 		Octree( const char *i_filename );
 		~Octree( void );
 
-		void GetTriangleData( const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint,
-			std::vector<Utilities::S_TRIANGLE> &o_triangleData );
+		// Queries from worker threads must not draw the nodes, the debug menu is not thread safe
+		void GetTriangleSpans( const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint,
+			std::vector<S_TRIANGLE_SPAN> &o_triangleSpans, const bool &i_bDrawNodes = true ) const;
+		// Nodes are grown by i_vExtent on each side, so a swept shape with that half size is not missed
+		void GetTriangleSpans( const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint, const D3DXVECTOR3 &i_vExtent,
+			std::vector<S_TRIANGLE_SPAN> &o_triangleSpans, const bool &i_bDrawNodes = true ) const;
+		// Spans of the node, its ancestors and its descendants. A segment strictly inside the node box cannot
+		// enter any other node, so these give the same hit as a full query. Returns the total triangles
+		UINT32 GetLocalSpans( const UINT32 &i_u32Node, std::vector<S_TRIANGLE_SPAN> &o_triangleSpans,
+			D3DXVECTOR3 &o_vMin, D3DXVECTOR3 &o_vMax ) const;
+
+		// Triangles are decoded from the quantized vertices of their node. The packet gets the triangles
+		// from i_u32First of the span, slots past the end of the span are cleared
+		void GetTrianglePacket( const S_TRIANGLE_SPAN &i_span, const UINT32 &i_u32First,
+			Utilities::Math::S_TRIANGLE_PACKET &o_packet ) const;
+		void GetTriangle( const S_TRIANGLE_SPAN &i_span, const UINT32 &i_u32Triangle,
+			D3DXVECTOR3 &o_a, D3DXVECTOR3 &o_b, D3DXVECTOR3 &o_c ) const;
+		const Utilities::StringHash &GetTag( const S_TRIANGLE_SPAN &i_span, const UINT32 &i_u32Triangle ) const;
+		void GetBounds( D3DXVECTOR3 &o_vMin, D3DXVECTOR3 &o_vMax ) const;
 	};
 }
 
-#endif	// _OCTREE_H_
\ No newline at end of file
+#endif	// _OCTREE_H_
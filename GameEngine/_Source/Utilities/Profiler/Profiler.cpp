@@ -5,6 +5,8 @@
  ****************************************************************************************************
 */
 
+#include <windows.h>
+
 // Utilities header
 #include <Debug/Debug.h>
 
@@ -20,17 +22,31 @@
 */
 void GameEngine::Profiler::AddTiming( const char * i_name, UINT32 i_u32Ms )
 {
-	S_ACCUMULATOR &myAccumulator = _accumulators[i_name];
-
 	FUNCTION_START;
 
-	if( i_u32Ms < myAccumulator.m_Min )
-		myAccumulator.m_Min = i_u32Ms;
-	if( i_u32Ms > myAccumulator.m_Max )
-		myAccumulator.m_Max = i_u32Ms;
+	Lock();
+	Accumulate( _accumulators[i_name], i_u32Ms );
+	Unlock();
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void AddCounter( const char *i_name, UINT32 i_u32Count )
+	\brief		Add the count of an event in this frame, kept apart from the timings
+	\param		i_name name of the counter
+	\param		i_u32Count count of this frame
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Profiler::AddCounter( const char *i_name, UINT32 i_u32Count )
+{
+	FUNCTION_START;
 
-	myAccumulator.m_Count++;
-	myAccumulator.m_Sum += i_u32Ms;
+	Lock();
+	Accumulate( _counters[i_name], i_u32Count );
+	Unlock();
 
 	FUNCTION_FINISH;
 }
@@ -49,15 +65,74 @@ void GameEngine::Profiler::PrintAccumulators( void )
 
 	FUNCTION_START;
 
+	Lock();
 	for( iter = _accumulators.begin(); iter != _accumulators.end(); ++iter )
 	{
 		float average = iter->second.m_Count ? ((float) iter->second.m_Sum ) / iter->second.m_Count : 0.0f;
 		DBG_MSG_LEVEL( D_PROFILER, "[%s] Count: %d Sum: %d Min: %d Max: %d Ave: %f\n", iter->first.c_str(), iter->second.m_Count, iter->second.m_Sum, iter->second.m_Min, iter->second.m_Max, average );
 	}
 
+	for( iter = _counters.begin(); iter != _counters.end(); ++iter )
+	{
+		float average = iter->second.m_Count ? ((float) iter->second.m_Sum ) / iter->second.m_Count : 0.0f;
+		DBG_MSG_LEVEL( D_PROFILER, "[%s] Frames: %d Events: %d Min/frame: %d Max/frame: %d Ave/frame: %f\n", iter->first.c_str(), iter->second.m_Count, iter->second.m_Sum, iter->second.m_Min, iter->second.m_Max, average );
+	}
+	Unlock();
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void Accumulate( S_ACCUMULATOR &io_accumulator, UINT32 i_u32Value )
+	\brief		Add a value of this frame to an accumulator
+	\param		io_accumulator the accumulator
+	\param		i_u32Value value of this frame
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Profiler::Accumulate( S_ACCUMULATOR &io_accumulator, UINT32 i_u32Value )
+{
+	FUNCTION_START;
+
+	if( i_u32Value < io_accumulator.m_Min )
+		io_accumulator.m_Min = i_u32Value;
+	if( i_u32Value > io_accumulator.m_Max )
+		io_accumulator.m_Max = i_u32Value;
+
+	io_accumulator.m_Count++;
+	io_accumulator.m_Sum += i_u32Value;
+
 	FUNCTION_FINISH;
 }
 
+/**
+ ****************************************************************************************************
+	\fn			void Lock( void )
+	\brief		Acquire the lock of the accumulators
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Profiler::Lock( void )
+{
+	while( InterlockedCompareExchange(&_lock, 1, 0) != 0 )
+		YieldProcessor();
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void Unlock( void )
+	\brief		Release the lock of the accumulators
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Profiler::Unlock( void )
+{
+	InterlockedExchange( &_lock, 0 );
+}
+
 /**
  ****************************************************************************************************
 	\fn			ScopedTimer( const char *i_name )
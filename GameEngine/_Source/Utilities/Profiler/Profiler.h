@@ -41,12 +41,21 @@ namespace GameEngine
 		} S_ACCUMULATOR;
 
 		std::map<std::string, S_ACCUMULATOR> _accumulators;
+		// Counts of events per frame, kept apart from the timings so they are not printed as time
+		std::map<std::string, S_ACCUMULATOR> _counters;
+		// Spin lock of the accumulators, the detection tasks are timed on the worker threads
+		volatile long _lock;
 
-		Profiler(){}
+		Profiler() : _lock( 0 ) {}
 		~Profiler(){}
 
+		void Accumulate( S_ACCUMULATOR &io_accumulator, UINT32 i_u32Value );
+		void Lock( void );
+		void Unlock( void );
+
 	public:
 		void AddTiming( const char *i_pName, UINT32 i_ms );
+		void AddCounter( const char *i_pName, UINT32 i_u32Count );
 		void PrintAccumulators( void );
 	};
 
@@ -68,11 +77,13 @@ typedef Utilities::Singleton<GameEngine::Profiler> g_Profiler;
 	#define PROFILE_SCOPE_END()			}
 
 	#define PROFILE_UNSCOPED(str)		GameEngine::ScopedTimer __Timer( str );
+	#define PROFILE_COUNTER(str, count)	g_Profiler::Get().AddCounter( str, count );
 	#define PROFILE_PRINT_RESULTS()		g_Profiler::Get().PrintAccumulators();
 #else
 	#define PROFILE_SCOPE_BEGIN(str)	__noop
 	#define PROFILE_SCOPE_END			__noop
 	#define PROFILE_UNSCOPED(str)		__noop
+	#define PROFILE_COUNTER(str, count)	__noop
 	#define PROFILE_PRINT_RESULTS()		__noop
 #endif // ENABLE_PROFILING
 
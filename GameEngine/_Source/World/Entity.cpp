@@ -10,7 +10,10 @@
 // Utilities header
 #include <MemoryPool/MemoryPool.h>
 
+#include "World.h"
 #include "Entity.h"
+#include "EntityStore.h"
+#include "../Physics/Physics.h"
 #include "../Renderer/Renderer.h"
 #include "../Utilities/GameEngineTypes.h"
 
@@ -133,12 +136,172 @@ GameEngine::Entity::~Entity( void )
 	/*if( _name )
 		delete _name;*/
 
+	g_world::Get().GetEntityStore().Deallocate( m_u32StoreSlot );
+
 	FUNCTION_FINISH;
 }
 
+/**
+ ****************************************************************************************************
+	\fn			void SetName( const char *i_name )
+	\brief		Set the value of _name of Entity class
+	\param		*i_name new _name value
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Entity::SetName( const char *i_name )
+{
+	assert( i_name );
+	assert( strlen(i_name) != 0 );
+	assert( i_name[0] != '\0' );
+
+	SetName( Utilities::StringHash(i_name) );
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void SetName( const Utilities::StringHash &i_hashedName )
+	\brief		Set the hashed name of Entity class
+	\param		i_hashedName new hashed name
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Entity::SetName( const Utilities::StringHash &i_hashedName )
+{
+	m_hashedName = i_hashedName;
+
+	// Keep the world's name index in sync
+	g_world::Get().UpdateEntityName( *this );
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void SetPosition( const Math::Vector3 &i_v3Position )
+	\brief		Set the position of the entity, a sleeping entity is woken up if it moves
+	\param		i_v3Position new position
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Entity::SetPosition( const Math::Vector3 &i_v3Position )
+{
+	if( m_isSleeping && (i_v3Position != m_v3Position) )
+		Physics::WakeUp( m_u32PhysicsEntityHandle );
+
+	g_world::Get().GetEntityStore().m_v3Position[m_u32StoreSlot] = i_v3Position;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void SetProjectedPosition( const Math::Vector3 &i_v3ProjectedPosition )
+	\brief		Set the position the entity is projected to this simulation step, a sleeping entity is
+				woken up if it changes
+	\param		i_v3ProjectedPosition new projected position
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Entity::SetProjectedPosition( const Math::Vector3 &i_v3ProjectedPosition )
+{
+	if( m_isSleeping && (i_v3ProjectedPosition != m_v3ProjectedPosition) )
+		Physics::WakeUp( m_u32PhysicsEntityHandle );
+
+	g_world::Get().GetEntityStore().m_v3ProjectedPosition[m_u32StoreSlot] = i_v3ProjectedPosition;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void SetVelocity( const Math::Vector3 &i_v3Velocity )
+	\brief		Set the velocity of the entity, a sleeping entity is woken up if it changes
+	\param		i_v3Velocity new velocity
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Entity::SetVelocity( const Math::Vector3 &i_v3Velocity )
+{
+	if( m_isSleeping && (i_v3Velocity != m_v3Velocity) )
+		Physics::WakeUp( m_u32PhysicsEntityHandle );
+
+	g_world::Get().GetEntityStore().m_v3Velocity[m_u32StoreSlot] = i_v3Velocity;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void SetProjectedVelocity( const Math::Vector3 &i_v3ProjectedVelocity )
+	\brief		Set the velocity the entity is projected to this simulation step, a sleeping entity is
+				woken up if it changes
+	\param		i_v3ProjectedVelocity new projected velocity
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Entity::SetProjectedVelocity( const Math::Vector3 &i_v3ProjectedVelocity )
+{
+	if( m_isSleeping && (i_v3ProjectedVelocity != m_v3ProjectedVelocity) )
+		Physics::WakeUp( m_u32PhysicsEntityHandle );
+
+	g_world::Get().GetEntityStore().m_v3ProjectedVelocity[m_u32StoreSlot] = i_v3ProjectedVelocity;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void Destroy( void )
+	\brief		Destroy the entity, it is removed from the world and every subsystem at the end of
+				the frame
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::Entity::Destroy( void )
+{
+	g_world::Get().DestroyEntity( *this );
+}
+
 /****************************************************************************************************
 			Private functions implementation
 ****************************************************************************************************/
+/**
+ ****************************************************************************************************
+	\fn			Entity( const Vector3 &i_position, EntityController *i_controller, const char *i_name )
+	\brief		Construct Entity class and bind its per-frame data to a slot in the world's EntityStore
+	\param		&i_position initial _v3Position value
+	\param		*i_controller the pointer to initial _controller value
+	\param		*i_name name of entity
+	\return		NONE
+ ****************************************************************************************************
+*/
+GameEngine::Entity::Entity( const Math::Vector3 &i_position, EntityController *i_controller, const char* i_name ):
+	_controller( i_controller ),
+	m_u32StoreSlot( g_world::Get().GetEntityStore().Allocate(this) ),
+	m_hashedName( i_name ),
+	m_vLookAt( D3DXVECTOR3_FORWARD ),
+	m_vScale( g_world::Get().GetEntityStore().m_vScale[m_u32StoreSlot] ),
+	m_v3Acceleration( g_world::Get().GetEntityStore().m_v3Acceleration[m_u32StoreSlot] ),
+	m_v3Position( g_world::Get().GetEntityStore().m_v3Position[m_u32StoreSlot] ),
+	m_v3ProjectedPosition( g_world::Get().GetEntityStore().m_v3ProjectedPosition[m_u32StoreSlot] ),
+	m_v3Velocity( g_world::Get().GetEntityStore().m_v3Velocity[m_u32StoreSlot] ),
+	m_v3ProjectedVelocity( g_world::Get().GetEntityStore().m_v3ProjectedVelocity[m_u32StoreSlot] ),
+	m_tag( NULL ),
+	m_orientation( g_world::Get().GetEntityStore().m_orientation[m_u32StoreSlot] ),
+	m_u32CollisionMask( g_world::Get().GetEntityStore().m_u32CollisionMask[m_u32StoreSlot] ),
+	m_u32AIEntityHandle( Utilities::INVALID_HANDLE ),
+	m_u32PhysicsEntityHandle( Utilities::INVALID_HANDLE ),
+	m_u32CollisionEntityHandle( Utilities::INVALID_HANDLE ),
+	m_u32TriggerBoxEntityHandle( Utilities::INVALID_HANDLE ),
+	m_u32SpriteHandle( Utilities::INVALID_HANDLE ),
+	m_u8EntityID( Utilities::MAX_UINT8 ),
+	m_isDestroyed( g_world::Get().GetEntityStore().m_isDestroyed[m_u32StoreSlot] ),
+	m_applyPhysics( g_world::Get().GetEntityStore().m_applyPhysics[m_u32StoreSlot] ),
+	m_isSleeping( g_world::Get().GetEntityStore().m_isSleeping[m_u32StoreSlot] )
+{
+	SetName( i_name );
+
+	// The store resets the rest of the slot when it is allocated, the entity starts at rest so the
+	// renderer does not interpolate it in from the origin
+	g_world::Get().GetEntityStore().m_v3Position[m_u32StoreSlot] = i_position;
+	g_world::Get().GetEntityStore().m_v3PreviousPosition[m_u32StoreSlot] = i_position;
+
+	m_size.width = DEFAULT_SPRITE_WIDTH;
+	m_size.height = DEFAULT_SPRITE_HEIGHT;
+}
+
 /**
  ****************************************************************************************************
 	\fn			void *operator new( size_t i_size )
@@ -8,8 +8,11 @@
 #ifndef _ENTITY_H_
 #define _ENTITY_H_
 
+#include <vector>
+
 // Utilities header
 #include <SmartPtr/SmartPtr.h>
+#include <HandleTable/HandleTable.h>
 #include <StringHash/StringHash.h>
 
 #include "../GameEngineDefault.h"
@@ -29,7 +32,7 @@ namespace GameEngine
 
 		// Default constructor
 		inline Entity( void );
-		inline Entity( const Math::Vector3 &i_position, EntityController *i_controller = 0, const char* i_name = DEFAULT_NAME );
+		Entity( const Math::Vector3 &i_position, EntityController *i_controller = 0, const char* i_name = DEFAULT_NAME );
 
 		void *operator new( size_t i_size );
 
@@ -41,25 +44,37 @@ namespace GameEngine
 		bool &operator==( const Entity &i_other ) const;
 
 	public:
+		// Slot of this entity in the world's EntityStore. The per-frame data below are views into
+		// the store arrays, so it has to be initialized first. Position, velocity and their projection
+		// are written through the setters, which wake the entity up
+		const UINT32							m_u32StoreSlot;
 		Utilities::StringHash			m_hashedName;
 		Utilities::S_SIZE					m_size;
 		D3DXVECTOR3								m_vLookAt;
-		D3DXVECTOR3								m_vScale;
-		Math::Vector3							m_v3Acceleration;
-		Math::Vector3							m_v3Position;
-		Math::Vector3							m_v3ProjectedPosition;
-		Math::Vector3							m_v3Velocity;
-		Math::Vector3							m_v3ProjectedVelocity;
+		D3DXVECTOR3								&m_vScale;
+		const Math::Vector3				&m_v3Acceleration;
+		const Math::Vector3				&m_v3Position;
+		const Math::Vector3				&m_v3ProjectedPosition;
+		const Math::Vector3				&m_v3Velocity;
+		const Math::Vector3				&m_v3ProjectedVelocity;
 		std::string*							m_tag;
-		float											m_orientation;
-		UINT32										m_u32CollisionMask;
-		UINT8											m_u8AIEntityIndex;
-		UINT8											m_u8PhysicsEntityIndex;
-		UINT8											m_u8CollisionEntityIndex;
-		UINT8											m_u8TriggerBoxEntityIndex;
+		float											&m_orientation;
+		UINT32										&m_u32CollisionMask;
+		UINT32										m_u32AIEntityHandle;
+		UINT32										m_u32PhysicsEntityHandle;
+		UINT32										m_u32CollisionEntityHandle;
+		UINT32										m_u32TriggerBoxEntityHandle;
+		UINT32										m_u32SpriteHandle;
+		// One handle per mesh file of the entity
+		std::vector<UINT32>				m_u32MeshHandles;
+		// Indexed by the world, it must not change once the entity is added to the world
 		UINT8											m_u8EntityID;
-		bool											m_isDestroyed : 1;
-		bool											m_applyPhysics : 1;
+		// Set through Destroy() so the world can queue the entity for removal
+		const bool								&m_isDestroyed;
+		bool											&m_applyPhysics;
+		// Set by the physics once the body has been at rest for a while, a setter changing its position,
+		// velocity or their projection wakes it up
+		const bool								&m_isSleeping;
 
 		// Standard constructor
 		static Utilities::Pointer::SmartPtr<Entity> Create( const Math::Vector3 &i_position, EntityController *i_controller = 0, const char* i_name = DEFAULT_NAME );
@@ -67,7 +82,13 @@ namespace GameEngine
 		~Entity( void );
 
 		inline void SetController( EntityController *i_newController );
-		inline void SetName( const char *i_name );
+		void SetName( const char *i_name );
+		void SetName( const Utilities::StringHash &i_hashedName );
+		void SetPosition( const Math::Vector3 &i_v3Position );
+		void SetProjectedPosition( const Math::Vector3 &i_v3ProjectedPosition );
+		void SetVelocity( const Math::Vector3 &i_v3Velocity );
+		void SetProjectedVelocity( const Math::Vector3 &i_v3ProjectedVelocity );
+		void Destroy( void );
 		void operator delete( void *i_ptr );
 
 		static bool Initialize( void );
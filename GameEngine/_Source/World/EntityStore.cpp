@@ -0,0 +1,324 @@
+/**
+ ****************************************************************************************************
+ * \file		EntityStore.cpp
+ * \brief		Implementation of non-inline functions of EntityStore class
+ ****************************************************************************************************
+*/
+
+#include <malloc.h>
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+#include <functional>
+
+// Utilities header
+#include <Debug/Debug.h>
+#include <StringHash/StringHash.h>
+
+#include "Entity.h"
+#include "EntityStore.h"
+
+/****************************************************************************************************
+			Public functions implementation
+****************************************************************************************************/
+/**
+ ****************************************************************************************************
+	\fn			EntityStore *Create( const UINT32 &i_u32Capacity )
+	\brief		Create EntityStore
+	\param		i_u32Capacity total slots to be created
+	\return		Pointer to the created entity store
+ ****************************************************************************************************
+*/
+GameEngine::EntityStore *GameEngine::EntityStore::Create( const UINT32 &i_u32Capacity )
+{
+	assert( i_u32Capacity );
+
+	FUNCTION_START;
+
+	EntityStore *newStore = new EntityStore( i_u32Capacity );
+
+	if( !newStore->m_v3Position || !newStore->m_v3PreviousPosition || !newStore->m_v3ProjectedPosition || !newStore->m_v3Velocity
+		|| !newStore->m_v3ProjectedVelocity || !newStore->m_v3Acceleration || !newStore->m_vScale
+		|| !newStore->m_orientation || !newStore->m_u32CollisionMask || !newStore->m_isDestroyed
+		|| !newStore->m_applyPhysics || !newStore->m_isSleeping || !newStore->m_entity || !newStore->_u32FreeSlots )
+	{
+		delete newStore;
+		newStore = NULL;
+	}
+
+	FUNCTION_FINISH;
+	return newStore;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			~EntityStore( void )
+	\brief		Destroy EntityStore class
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+GameEngine::EntityStore::~EntityStore( void )
+{
+	FUNCTION_START;
+
+	_aligned_free( m_v3Position );
+	_aligned_free( m_v3PreviousPosition );
+	_aligned_free( m_v3ProjectedPosition );
+	_aligned_free( m_v3Velocity );
+	_aligned_free( m_v3ProjectedVelocity );
+	_aligned_free( m_v3Acceleration );
+	_aligned_free( m_vScale );
+	_aligned_free( m_orientation );
+	_aligned_free( m_u32CollisionMask );
+	_aligned_free( m_isDestroyed );
+	_aligned_free( m_applyPhysics );
+	_aligned_free( m_isSleeping );
+	_aligned_free( m_entity );
+	_aligned_free( _u32FreeSlots );
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			UINT32 Allocate( Entity *i_entity )
+	\brief		Reserve a slot for the entity and reset its data
+	\param		i_entity the entity who owns the slot
+	\return		UINT32
+	\retval		The slot of the entity in the store
+ ****************************************************************************************************
+*/
+UINT32 GameEngine::EntityStore::Allocate( Entity *i_entity )
+{
+	assert( i_entity );
+	assert( !IsFull() );
+
+	FUNCTION_START;
+
+	std::pop_heap( _u32FreeSlots, _u32FreeSlots + _u32TotalFreeSlots, std::greater<UINT32>() );
+	UINT32 u32Slot = _u32FreeSlots[--_u32TotalFreeSlots];
+
+	if( u32Slot >= _u32HighWaterMark )
+		_u32HighWaterMark = u32Slot + 1;
+
+	m_v3Position[u32Slot] = Math::Vector3::Zero;
+	m_v3PreviousPosition[u32Slot] = Math::Vector3::Zero;
+	m_v3ProjectedPosition[u32Slot] = Math::Vector3::Zero;
+	m_v3Velocity[u32Slot] = Math::Vector3::Zero;
+	m_v3ProjectedVelocity[u32Slot] = Math::Vector3::Zero;
+	m_v3Acceleration[u32Slot] = Math::Vector3::Zero;
+	m_vScale[u32Slot] = D3DXVECTOR3( 1.0f, 1.0f, 1.0f );
+	m_orientation[u32Slot] = 0.0f;
+	m_u32CollisionMask[u32Slot] = 0;
+	m_isDestroyed[u32Slot] = false;
+	m_applyPhysics[u32Slot] = true;
+	m_isSleeping[u32Slot] = false;
+	m_entity[u32Slot] = i_entity;
+
+	FUNCTION_FINISH;
+	return u32Slot;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void Deallocate( const UINT32 &i_u32Slot )
+	\brief		Release the slot so it can be recycled. The free slots are kept in a min-heap, so the
+				lowest free slot is recycled first and the arrays stay packed at the front
+	\param		i_u32Slot the slot to be released
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::EntityStore::Deallocate( const UINT32 &i_u32Slot )
+{
+	assert( i_u32Slot < _u32HighWaterMark );
+	assert( m_entity[i_u32Slot] );
+
+	FUNCTION_START;
+
+	m_entity[i_u32Slot] = NULL;
+	m_isDestroyed[i_u32Slot] = false;
+	m_applyPhysics[i_u32Slot] = false;
+	m_isSleeping[i_u32Slot] = false;
+
+	_u32FreeSlots[_u32TotalFreeSlots++] = i_u32Slot;
+	std::push_heap( _u32FreeSlots, _u32FreeSlots + _u32TotalFreeSlots, std::greater<UINT32>() );
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void SavePreviousPositions( void )
+	\brief		Keep the positions of the last simulation step so the renderer can interpolate
+				between them and the positions of the coming step
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::EntityStore::SavePreviousPositions( void )
+{
+	FUNCTION_START;
+
+	memcpy( m_v3PreviousPosition, m_v3Position, sizeof(Math::Vector3) * _u32HighWaterMark );
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			UINT32 Checksum( void ) const
+	\brief		Hash the simulated state of every entity in slot order, the bits of the floats are
+				hashed so any divergence shows up
+	\param		NONE
+	\return		UINT32
+	\retval		Checksum of the store
+ ****************************************************************************************************
+*/
+UINT32 GameEngine::EntityStore::Checksum( void ) const
+{
+	UINT32 u32Checksum = 0;
+
+	FUNCTION_START;
+
+	for( UINT32 i = 0; i < _u32HighWaterMark; ++i )
+	{
+		struct
+		{
+			UINT32 u32Slot;
+			Math::Vector3 v3Position;
+			Math::Vector3 v3Velocity;
+			float orientation;
+		} state;
+
+		if( !m_entity[i] )
+			continue;
+
+		// Padding is zeroed so it does not change the hash
+		memset( &state, 0, sizeof(state) );
+		state.u32Slot = i;
+		state.v3Position = m_v3Position[i];
+		state.v3Velocity = m_v3Velocity[i];
+		state.orientation = m_orientation[i];
+		u32Checksum = 16777619 * ( u32Checksum ^ Utilities::StringHash::Hash(&state, sizeof(state)) );
+	}
+
+	FUNCTION_FINISH;
+	return u32Checksum;
+}
+
+#ifdef _DEBUG
+/**
+ ****************************************************************************************************
+	\fn			void UnitTest( void )
+	\brief		Unit test for EntityStore class
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::EntityStore::UnitTest( void )
+{
+	Entity *dummy = reinterpret_cast<Entity *>( 0x4 );
+
+	FUNCTION_START;
+
+	EntityStore *entityStoreTest = EntityStore::Create( 4 );
+
+	assert( entityStoreTest->IsEmpty() );
+	assert( entityStoreTest->Capacity() == 4 );
+	assert( entityStoreTest->HighWaterMark() == 0 );
+
+	UINT32 u32SlotA = entityStoreTest->Allocate( dummy );
+	UINT32 u32SlotB = entityStoreTest->Allocate( dummy );
+	assert( (u32SlotA == 0) && (u32SlotB == 1) );
+	assert( entityStoreTest->HighWaterMark() == 2 );
+
+	entityStoreTest->m_v3Position[u32SlotB] = Math::Vector3( 1.0f, 2.0f, 3.0f );
+	entityStoreTest->SavePreviousPositions();
+	assert( entityStoreTest->m_v3PreviousPosition[u32SlotB].Y() == 2.0f );
+
+	// Checksum follows the state only
+	UINT32 u32Checksum = entityStoreTest->Checksum();
+	assert( entityStoreTest->Checksum() == u32Checksum );
+	entityStoreTest->m_v3Velocity[u32SlotA] = Math::Vector3( 0.0f, 1.0f, 0.0f );
+	assert( entityStoreTest->Checksum() != u32Checksum );
+	entityStoreTest->m_v3Velocity[u32SlotA] = Math::Vector3::Zero;
+	assert( entityStoreTest->Checksum() == u32Checksum );
+
+	entityStoreTest->Deallocate( u32SlotA );
+	assert( entityStoreTest->m_entity[u32SlotA] == NULL );
+	assert( entityStoreTest->m_v3Position[u32SlotB].Z() == 3.0f );
+
+	// Released slot is recycled before the store grows
+	assert( entityStoreTest->Allocate(dummy) == u32SlotA );
+	assert( entityStoreTest->HighWaterMark() == 2 );
+
+	entityStoreTest->Allocate( dummy );
+	entityStoreTest->Allocate( dummy );
+	assert( entityStoreTest->IsFull() );
+
+	// The lowest released slot is recycled first, whatever order the slots are released in
+	entityStoreTest->Deallocate( 0 );
+	entityStoreTest->Deallocate( 2 );
+	assert( entityStoreTest->Allocate(dummy) == 0 );
+	assert( entityStoreTest->Allocate(dummy) == 2 );
+	entityStoreTest->Deallocate( 3 );
+	entityStoreTest->Deallocate( 1 );
+	entityStoreTest->Deallocate( 2 );
+	assert( entityStoreTest->Allocate(dummy) == 1 );
+	assert( entityStoreTest->Allocate(dummy) == 2 );
+	assert( entityStoreTest->Allocate(dummy) == 3 );
+
+	delete entityStoreTest;
+
+	FUNCTION_FINISH;
+}
+#endif	// #ifdef _DEBUG
+
+/****************************************************************************************************
+			Private functions implementation
+****************************************************************************************************/
+/**
+ ****************************************************************************************************
+	\fn			EntityStore( const UINT32 &i_u32Capacity )
+	\brief		EntityStore constructor
+	\param		i_u32Capacity total slots to be created
+	\return		NONE
+ ****************************************************************************************************
+*/
+GameEngine::EntityStore::EntityStore( const UINT32 &i_u32Capacity ) :
+	_u32TotalFreeSlots( i_u32Capacity ),
+	_u32Capacity( i_u32Capacity ),
+	_u32HighWaterMark( 0 )
+{
+	m_v3Position = reinterpret_cast<Math::Vector3 *>( _aligned_malloc(sizeof(Math::Vector3) * i_u32Capacity, CACHE_LINE) );
+	m_v3PreviousPosition = reinterpret_cast<Math::Vector3 *>( _aligned_malloc(sizeof(Math::Vector3) * i_u32Capacity, CACHE_LINE) );
+	m_v3ProjectedPosition = reinterpret_cast<Math::Vector3 *>( _aligned_malloc(sizeof(Math::Vector3) * i_u32Capacity, CACHE_LINE) );
+	m_v3Velocity = reinterpret_cast<Math::Vector3 *>( _aligned_malloc(sizeof(Math::Vector3) * i_u32Capacity, CACHE_LINE) );
+	m_v3ProjectedVelocity = reinterpret_cast<Math::Vector3 *>( _aligned_malloc(sizeof(Math::Vector3) * i_u32Capacity, CACHE_LINE) );
+	m_v3Acceleration = reinterpret_cast<Math::Vector3 *>( _aligned_malloc(sizeof(Math::Vector3) * i_u32Capacity, CACHE_LINE) );
+	m_vScale = reinterpret_cast<D3DXVECTOR3 *>( _aligned_malloc(sizeof(D3DXVECTOR3) * i_u32Capacity, CACHE_LINE) );
+	m_orientation = reinterpret_cast<float *>( _aligned_malloc(sizeof(float) * i_u32Capacity, CACHE_LINE) );
+	m_u32CollisionMask = reinterpret_cast<UINT32 *>( _aligned_malloc(sizeof(UINT32) * i_u32Capacity, CACHE_LINE) );
+	m_isDestroyed = reinterpret_cast<bool *>( _aligned_malloc(sizeof(bool) * i_u32Capacity, CACHE_LINE) );
+	m_applyPhysics = reinterpret_cast<bool *>( _aligned_malloc(sizeof(bool) * i_u32Capacity, CACHE_LINE) );
+	m_isSleeping = reinterpret_cast<bool *>( _aligned_malloc(sizeof(bool) * i_u32Capacity, CACHE_LINE) );
+	m_entity = reinterpret_cast<Entity **>( _aligned_malloc(sizeof(Entity *) * i_u32Capacity, CACHE_LINE) );
+	_u32FreeSlots = reinterpret_cast<UINT32 *>( _aligned_malloc(sizeof(UINT32) * i_u32Capacity, CACHE_LINE) );
+
+	if( m_isDestroyed && m_applyPhysics && m_isSleeping && m_entity )
+	{
+		memset( m_isDestroyed, 0, sizeof(bool) * i_u32Capacity );
+		memset( m_applyPhysics, 0, sizeof(bool) * i_u32Capacity );
+		memset( m_isSleeping, 0, sizeof(bool) * i_u32Capacity );
+		memset( m_entity, 0, sizeof(Entity *) * i_u32Capacity );
+	}
+
+	// Free slots are kept in a min-heap, so the lowest slot is handed out first and the arrays stay
+	// packed at the front. Ascending order is already a valid heap
+	if( _u32FreeSlots )
+	{
+		for( UINT32 i = 0; i < i_u32Capacity; ++i )
+			_u32FreeSlots[i] = i;
+	}
+}
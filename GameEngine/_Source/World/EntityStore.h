@@ -0,0 +1,75 @@
+/**
+ ****************************************************************************************************
+ * \file		EntityStore.h
+ * \brief		The header of EntityStore class. The store keeps the per-frame entity data in
+ *          contiguous arrays so the world, physics and renderer loops can stream them
+ ****************************************************************************************************
+*/
+
+#ifndef _ENTITY_STORE_H_
+#define _ENTITY_STORE_H_
+
+// Utilities header
+#include <Target/Target.h>
+
+#include "../Math/Vector3/Vector3.h"
+#include "../Utilities/GameEngineTypes.h"
+
+namespace GameEngine
+{
+	class Entity;
+
+	class EntityStore
+	{
+		UINT32	*_u32FreeSlots;
+		UINT32	_u32TotalFreeSlots;
+		UINT32	_u32Capacity;
+		UINT32	_u32HighWaterMark;
+
+		EntityStore( const UINT32 &i_u32Capacity );
+
+		// Make it non-copyable
+		EntityStore( const EntityStore &i_other );
+		EntityStore &operator=( const EntityStore &i_other );
+
+		// Make it incomparable
+		bool &operator==( const EntityStore &i_other ) const;
+
+	public:
+		Math::Vector3	*m_v3Position;
+		Math::Vector3	*m_v3PreviousPosition;
+		Math::Vector3	*m_v3ProjectedPosition;
+		Math::Vector3	*m_v3Velocity;
+		Math::Vector3	*m_v3ProjectedVelocity;
+		Math::Vector3	*m_v3Acceleration;
+		D3DXVECTOR3		*m_vScale;
+		float			*m_orientation;
+		UINT32			*m_u32CollisionMask;
+		bool			*m_isDestroyed;
+		bool			*m_applyPhysics;
+		// Set by the physics for bodies put to sleep, they are skipped by the per-frame loops
+		bool			*m_isSleeping;
+		Entity			**m_entity;
+
+		static EntityStore *Create( const UINT32 &i_u32Capacity );
+		~EntityStore( void );
+
+		UINT32 Allocate( Entity *i_entity );
+		void Deallocate( const UINT32 &i_u32Slot );
+		void SavePreviousPositions( void );
+		UINT32 Checksum( void ) const;
+
+		inline bool IsFull( void ) const;
+		inline bool IsEmpty( void ) const;
+		inline const UINT32 Capacity( void ) const;
+		inline const UINT32 HighWaterMark( void ) const;
+
+#ifdef _DEBUG
+		static void UnitTest( void );
+#endif	// #ifdef _DEBUG
+	};
+}
+
+#include "EntityStore.inl"
+
+#endif	// #ifndef _ENTITY_STORE_H_
@@ -0,0 +1,61 @@
+/**
+ ****************************************************************************************************
+ * \file		EntityStore.inl
+ * \brief		The inline functions implementation of EntityStore.h
+ ****************************************************************************************************
+*/
+
+/****************************************************************************************************
+			Public functions implementation
+****************************************************************************************************/
+/**
+ ****************************************************************************************************
+	\fn			bool IsFull( void ) const
+	\brief		Check whether all slots of the store are used
+	\param		NONE
+	\return		boolean
+ ****************************************************************************************************
+*/
+bool GameEngine::EntityStore::IsFull( void ) const
+{
+	return _u32TotalFreeSlots == 0;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool IsEmpty( void ) const
+	\brief		Check whether no slot of the store is used
+	\param		NONE
+	\return		boolean
+ ****************************************************************************************************
+*/
+bool GameEngine::EntityStore::IsEmpty( void ) const
+{
+	return _u32TotalFreeSlots == _u32Capacity;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			const UINT32 Capacity( void ) const
+	\brief		Get the total slots of the store
+	\param		NONE
+	\return		UINT32
+ ****************************************************************************************************
+*/
+const UINT32 GameEngine::EntityStore::Capacity( void ) const
+{
+	return _u32Capacity;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			const UINT32 HighWaterMark( void ) const
+	\brief		Get one past the highest slot ever used. Loops over the arrays stop here
+	\param		NONE
+	\return		UINT32
+ ****************************************************************************************************
+*/
+const UINT32 GameEngine::EntityStore::HighWaterMark( void ) const
+{
+	return _u32HighWaterMark;
+}
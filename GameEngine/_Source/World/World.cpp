@@ -6,24 +6,47 @@
 */
 
 #include <vector>
+#include <fstream>
+#include <stdio.h>
+#include <string.h>
 
 // Utilities header
 #include <Time/Time.h>
+#include <MappedFile/MappedFile.h>
 
 #include "AI/AI.h"
 #include "World.h"
 #include "Entity.h"
+#include "EntityStore.h"
+#include "WorldSnapshot.h"
+#include "../GameEngine.h"
 #include "../Camera/Camera.h"
 #include "../Physics/Physics.h"
 #include "../Renderer/Renderer.h"
 #include "../Collision/Collision.h"
 #include "../Utilities/GameEngineTypes.h"
 #include "../Light/PointLight/PointLight.h"
+#include "../Utilities/IDCreator/IDCreator.h"
 #include "../Light/DirectionalLight/DirectionalLight.h"
 
 /****************************************************************************************************
 			Helper functions
 ****************************************************************************************************/
+namespace GameEngine
+{
+	namespace WorldSnapshot
+	{
+		static UINT32 AddString( std::vector<char> &io_stringTable, const char *i_string );
+		static void AddSection( S_SECTION &o_section, UINT32 &io_u32Offset, const UINT32 &i_u32Total,
+			const UINT32 &i_u32RecordSize );
+		template<typename T>
+		static void WriteSection( std::ofstream &o_file, const std::vector<T> &i_records );
+		static bool IsValidSection( const S_SECTION &i_section, const UINT32 &i_u32RecordSize,
+			const UINT32 &i_u32FileSize );
+		static bool IsValidString( const S_HEADER &i_header, const UINT32 &i_u32String, const bool &i_bOptional );
+		static bool IsValid( const Utilities::MappedFile &i_file );
+	}	// namespace WorldSnapshot
+}	// namespace GameEngine
 
 /****************************************************************************************************
 			Global functions implementation
@@ -42,6 +65,10 @@ bool GameEngine::World::Initialize( void )
 {
 	FUNCTION_START;
 
+	_entityStore = EntityStore::Create( Utilities::DEFAULT_MEMORY_POOL_SIZE );
+	if( !_entityStore )
+		return FAIL;
+
 	if( !Entity::Initialize() )
 		return FAIL;
 
@@ -50,6 +77,15 @@ bool GameEngine::World::Initialize( void )
 	m_pointLight = NULL;
 
 	_entityDatabase = new std::vector< Utilities::Pointer::SmartPtr<Entity> >;
+	_entityIndexEntry = new std::vector<S_ENTITY_INDEX_ENTRY>;
+	_slotsByID = new std::vector<UINT32>[Utilities::MAX_UINT8 + 1];
+	_destructionQueue = new std::vector<UINT32>;
+	_entityAsset = new std::vector<S_ENTITY_ASSET>;
+	_collisionBy = E_COLLISION_MAX;
+
+	_nameIndex = Utilities::HashIndex::Create( Utilities::DEFAULT_MEMORY_POOL_SIZE );
+	if( !_nameIndex )
+		return FAIL;
 
 	FUNCTION_FINISH;
 	return SUCCESS;
@@ -121,7 +157,7 @@ void GameEngine::World::EndUpdate( void )
 
 	FUNCTION_START;
 
-	RemoveDeadEntities();
+	RemoveDestroyedEntities();
 
 	for( iter = _entityDatabase->begin(); iter != _entityDatabase->end(); ++iter )
 	{
@@ -171,8 +207,49 @@ void GameEngine::World::ShutDown( void )
 		_entityDatabase = NULL;
 	}
 
+	if( _entityIndexEntry )
+	{
+		delete _entityIndexEntry;
+		_entityIndexEntry = NULL;
+	}
+
+	if( _slotsByID )
+	{
+		delete [] _slotsByID;
+		_slotsByID = NULL;
+	}
+
+	if( _destructionQueue )
+	{
+		delete _destructionQueue;
+		_destructionQueue = NULL;
+	}
+
+	if( _entityAsset )
+	{
+		delete _entityAsset;
+		_entityAsset = NULL;
+	}
+
+	if( _nameIndex )
+	{
+		delete _nameIndex;
+		_nameIndex = NULL;
+	}
+
 	Entity::ShutDown();
 
+	if( _entityStore )
+	{
+		if( _entityStore->IsEmpty() )
+		{
+			delete _entityStore;
+			_entityStore = NULL;
+		}
+		else
+			DBG_MSG_LEVEL( D_ERR, "Entity store is not empty\n" );
+	}
+
 	FUNCTION_FINISH;
 }
 
@@ -188,38 +265,210 @@ void GameEngine::World::AddEntity( Utilities::Pointer::SmartPtr<Entity> &i_entit
 {
 	FUNCTION_START;
 
-	_entityDatabase->push_back( i_entity );
+	const UINT32 u32Slot = i_entity->m_u32StoreSlot;
+
+	if( u32Slot >= _entityDatabase->size() )
+	{
+		_entityDatabase->resize( u32Slot + 1 );
+		_entityIndexEntry->resize( u32Slot + 1 );
+	}
+
+	if( _entityDatabase->at(u32Slot) != NULL )
+		UnindexEntity( u32Slot );
+	_entityDatabase->at( u32Slot ) = i_entity;
+	IndexEntity( u32Slot );
 
-	if( (i_entity->m_u8PhysicsEntityIndex == Utilities::MAX_UINT8) && i_entity->m_applyPhysics )
-		i_entity->m_u8PhysicsEntityIndex = Physics::AddPhysicsEntity( i_entity );
+	if( (i_entity->m_u32PhysicsEntityHandle == Utilities::INVALID_HANDLE) && i_entity->m_applyPhysics )
+		i_entity->m_u32PhysicsEntityHandle = Physics::AddPhysicsEntity( i_entity );
 
 	FUNCTION_FINISH;
 }
 
 /**
  ****************************************************************************************************
-	\fn			void RemoveDeadEntities( void )
-	\brief		Removes dead entities from database
+	\fn			void DestroyEntity( Entity &i_entity )
+	\brief		Mark the entity as destroyed and queue it, the world removes it from every subsystem
+				at the end of the frame. It has to be called from the main thread
+	\param		i_entity the entity to be destroyed
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::World::DestroyEntity( Entity &i_entity )
+{
+	const UINT32 u32Slot = i_entity.m_u32StoreSlot;
+
+	FUNCTION_START;
+
+	if( _entityStore->m_isDestroyed[u32Slot] )
+	{
+		FUNCTION_FINISH;
+		return;
+	}
+
+	_entityStore->m_isDestroyed[u32Slot] = true;
+
+	// An entity that was never added to the world is not known by any subsystem
+	if( (u32Slot < _entityDatabase->size()) && (_entityDatabase->at(u32Slot) != NULL) )
+		_destructionQueue->push_back( u32Slot );
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			EntityStore &GetEntityStore( void )
+	\brief		Get the store holding the per-frame data of every entity
 	\param		NONE
+	\return		EntityStore
+ ****************************************************************************************************
+*/
+GameEngine::EntityStore &GameEngine::World::GetEntityStore( void )
+{
+	assert( _entityStore );
+
+	return *_entityStore;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void UpdateEntityName( const Entity &i_entity )
+	\brief		Reindex the entity after its name has been changed
+	\param		i_entity the renamed entity
 	\return		NONE
  ****************************************************************************************************
 */
-void GameEngine::World::RemoveDeadEntities( void )
+void GameEngine::World::UpdateEntityName( const Entity &i_entity )
+{
+	const UINT32 u32Slot = i_entity.m_u32StoreSlot;
+
+	// Entities are named before they are added to the world
+	if( !_entityDatabase || (u32Slot >= _entityDatabase->size()) || !(_entityDatabase->at(u32Slot) == &i_entity) )
+		return;
+
+	S_ENTITY_INDEX_ENTRY &indexEntry = _entityIndexEntry->at( u32Slot );
+
+	_nameIndex->Remove( indexEntry.u32HashedName, u32Slot );
+	indexEntry.u32HashedName = i_entity.m_hashedName;
+	_nameIndex->Insert( indexEntry.u32HashedName, u32Slot );
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void RemoveDestroyedEntities( void )
+	\brief		Remove the entities destroyed this frame from every subsystem in one batch. Each
+				subsystem removes by handle, so the cost only depends on the number of destroyed
+				entities. The slot only becomes reusable once the last reference to the entity is
+				released
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::World::RemoveDestroyedEntities( void )
 {
 	FUNCTION_START;
 
-	for( UINT32 i = 0; i < _entityDatabase->size(); ++i )
+	if( _destructionQueue->empty() )
 	{
-		if( _entityDatabase->at(i)->m_isDestroyed )
-		{
-			_entityDatabase->at(i) = _entityDatabase->back();
-			_entityDatabase->pop_back();
-		}
+		FUNCTION_FINISH;
+		return;
+	}
+
+	for( UINT32 i = 0; i < _destructionQueue->size(); ++i )
+	{
+		const UINT32 u32Slot = (*_destructionQueue)[i];
+		Utilities::Pointer::SmartPtr<Entity> &entity = _entityDatabase->at( u32Slot );
+
+		AI::RemoveAIEntity( entity->m_u32AIEntityHandle );
+		Physics::RemovePhysicsEntity( entity->m_u32PhysicsEntityHandle );
+		Collision::RemoveCollisionEntity( entity->m_u32CollisionEntityHandle );
+		TriggerBox::RemoveTriggerBoxEntity( entity->m_u32TriggerBoxEntityHandle );
+		Renderer::RemoveSprite( entity->m_u32SpriteHandle );
+		for( UINT32 j = 0; j < entity->m_u32MeshHandles.size(); ++j )
+			Renderer::RemoveMesh( entity->m_u32MeshHandles[j] );
+		entity->m_u32MeshHandles.clear();
+
+		if( u32Slot < _entityAsset->size() )
+			_entityAsset->at( u32Slot ) = S_ENTITY_ASSET();
+
+		UnindexEntity( u32Slot );
+		entity = NULL;
 	}
 
+	_destructionQueue->clear();
+
 	FUNCTION_FINISH;
 }
 
+/**
+ ****************************************************************************************************
+	\fn			void IndexEntity( const UINT32 &i_u32Slot )
+	\brief		Add the entity in the slot to the name and ID indices
+	\param		i_u32Slot the entity store slot of the entity
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::World::IndexEntity( const UINT32 &i_u32Slot )
+{
+	const Entity &entity = *_entityDatabase->at( i_u32Slot );
+	S_ENTITY_INDEX_ENTRY &indexEntry = _entityIndexEntry->at( i_u32Slot );
+	std::vector<UINT32> &slotList = _slotsByID[entity.m_u8EntityID];
+
+	indexEntry.u32HashedName = entity.m_hashedName;
+	indexEntry.u8EntityID = entity.m_u8EntityID;
+	indexEntry.u32PositionInIDList = slotList.size();
+
+	_nameIndex->Insert( indexEntry.u32HashedName, i_u32Slot );
+	slotList.push_back( i_u32Slot );
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void UnindexEntity( const UINT32 &i_u32Slot )
+	\brief		Remove the entity in the slot from the name and ID indices
+	\param		i_u32Slot the entity store slot of the entity
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::World::UnindexEntity( const UINT32 &i_u32Slot )
+{
+	const S_ENTITY_INDEX_ENTRY &indexEntry = _entityIndexEntry->at( i_u32Slot );
+	std::vector<UINT32> &slotList = _slotsByID[indexEntry.u8EntityID];
+
+	_nameIndex->Remove( indexEntry.u32HashedName, i_u32Slot );
+
+	if( IsDeterministic() )
+	{
+		// Keep the order the entities of the ID were added in
+		const UINT32 u32Position = indexEntry.u32PositionInIDList;
+		for( UINT32 i = u32Position + 1; i < slotList.size(); ++i )
+			_entityIndexEntry->at( slotList[i] ).u32PositionInIDList = i - 1;
+		slotList.erase( slotList.begin() + u32Position );
+	}
+	else
+	{
+		// Swap with the last entity of the same ID and pop
+		_entityIndexEntry->at( slotList.back() ).u32PositionInIDList = indexEntry.u32PositionInIDList;
+		slotList[indexEntry.u32PositionInIDList] = slotList.back();
+		slotList.pop_back();
+	}
+}
+
+/**
+ ****************************************************************************************************
+	\fn			S_ENTITY_ASSET &GetEntityAsset( const UINT32 &i_u32Slot )
+	\brief		Get the assets recorded for the entity in the slot
+	\param		i_u32Slot the entity store slot of the entity
+	\return		S_ENTITY_ASSET
+ ****************************************************************************************************
+*/
+GameEngine::World::S_ENTITY_ASSET &GameEngine::World::GetEntityAsset( const UINT32 &i_u32Slot )
+{
+	if( i_u32Slot >= _entityAsset->size() )
+		_entityAsset->resize( i_u32Slot + 1 );
+
+	return _entityAsset->at( i_u32Slot );
+}
+
 /**
  ****************************************************************************************************
 	\fn			void SetFriction( Pointer::SmartPtr<Entity> &i_entity, const float i_friction )
@@ -233,8 +482,8 @@ void GameEngine::World::SetFriction( Utilities::Pointer::SmartPtr<Entity> &i_ent
 {
 	FUNCTION_START;
 
-	if( i_entity->m_u8PhysicsEntityIndex != Utilities::MAX_UINT8 )
-		Physics::SetFriction( i_entity->m_u8PhysicsEntityIndex, i_friction );
+	if( i_entity->m_u32PhysicsEntityHandle != Utilities::INVALID_HANDLE )
+		Physics::SetFriction( i_entity->m_u32PhysicsEntityHandle, i_friction );
 
 	FUNCTION_FINISH;
 }
@@ -249,6 +498,7 @@ void GameEngine::World::SetFriction( Utilities::Pointer::SmartPtr<Entity> &i_ent
 */
 void GameEngine::World::SetCollisionDetectionType( E_COLLISION_BY i_collisionBy )
 {
+	_collisionBy = i_collisionBy;
 	Collision::SetCollisionDetectionType( i_collisionBy );
 }
 
@@ -263,7 +513,8 @@ void GameEngine::World::SetCollisionDetectionType( E_COLLISION_BY i_collisionBy
 */
 void GameEngine::World::CreateCollisionEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity, const char *i_collisionFile )
 {
-	i_entity->m_u8CollisionEntityIndex = Collision::AddCollisionEntity( i_entity, i_collisionFile );
+	i_entity->m_u32CollisionEntityHandle = Collision::AddCollisionEntity( i_entity, i_collisionFile );
+	GetEntityAsset( i_entity->m_u32StoreSlot ).collisionFile = i_collisionFile;
 }
 
 /**
@@ -279,14 +530,35 @@ void GameEngine::World::SetCollisionHandler( Utilities::Pointer::SmartPtr<Entity
 {
 	FUNCTION_START;
 
-	if( (i_entity->m_u32CollisionMask != 0) && (i_entity->m_u8CollisionEntityIndex != Utilities::MAX_UINT8) )
-		Collision::SetCollisionHandler( i_entity->m_u8CollisionEntityIndex, i_collisionHandler );
+	if( (i_entity->m_u32CollisionMask != 0) && (i_entity->m_u32CollisionEntityHandle != Utilities::INVALID_HANDLE) )
+		Collision::SetCollisionHandler( i_entity->m_u32CollisionEntityHandle, i_collisionHandler );
 	else
 		delete i_collisionHandler;
 
 	FUNCTION_FINISH;
 }
 
+/**
+ ****************************************************************************************************
+	\fn			void SetSweptShape( Utilities::Pointer::SmartPtr<Entity> &i_entity, const float &i_radius,
+					const float &i_height )
+	\brief		Make the forward collision of the entity sweep a capsule hanging from its position
+	\param		i_entity the entity whose collision is swept
+	\param		i_radius radius of the capsule, zero goes back to the forward ray
+	\param		i_height distance between the centres of the capsule ends
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::World::SetSweptShape( Utilities::Pointer::SmartPtr<Entity> &i_entity, const float &i_radius, const float &i_height )
+{
+	FUNCTION_START;
+
+	if( i_entity->m_u32CollisionEntityHandle != Utilities::INVALID_HANDLE )
+		Collision::SetSweptShape( i_entity->m_u32CollisionEntityHandle, i_radius, i_height );
+
+	FUNCTION_FINISH;
+}
+
 /**
  ****************************************************************************************************
 	\fn			void CreateTriggerBoxEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity )
@@ -300,7 +572,8 @@ void GameEngine::World::CreateTriggerBoxEntity( Utilities::Pointer::SmartPtr<Ent
 {
 	FUNCTION_START;
 
-	i_entity->m_u8TriggerBoxEntityIndex = TriggerBox::AddTriggerBoxEntity( i_entity );
+	i_entity->m_u32TriggerBoxEntityHandle = TriggerBox::AddTriggerBoxEntity( i_entity );
+	GetEntityAsset( i_entity->m_u32StoreSlot ).bTriggerBox = true;
 
 	FUNCTION_FINISH;
 }
@@ -318,8 +591,8 @@ void GameEngine::World::SetTriggerBoxHandler( Utilities::Pointer::SmartPtr<Entit
 {
 	FUNCTION_START;
 
-	if( (i_entity->m_u32CollisionMask != 0) && (i_entity->m_u8CollisionEntityIndex != Utilities::MAX_UINT8) )
-		TriggerBox::SetTriggerBoxHandler( i_entity->m_u8TriggerBoxEntityIndex, i_triggerBoxHandler );
+	if( (i_entity->m_u32CollisionMask != 0) && (i_entity->m_u32TriggerBoxEntityHandle != Utilities::INVALID_HANDLE) )
+		TriggerBox::SetTriggerBoxHandler( i_entity->m_u32TriggerBoxEntityHandle, i_triggerBoxHandler );
 	else
 		delete i_triggerBoxHandler;
 
@@ -339,62 +612,62 @@ void GameEngine::World::CreateAIEntity( Utilities::Pointer::SmartPtr<Entity> &i_
 {
 	FUNCTION_START;
 
-	i_entity->m_u8AIEntityIndex = AI::AddAIEntity( i_entity );
+	i_entity->m_u32AIEntityHandle = AI::AddAIEntity( i_entity );
 
 	FUNCTION_FINISH;
 }
 
 /**
  ****************************************************************************************************
-	\fn			void UpdateAIDestinationTo( const UINT32 &i_u32AIEntityIndex,, const UINT8 &i_u8NodeID )
+	\fn			void UpdateAIDestinationTo( const UINT32 &i_u32AIEntityHandle,, const UINT8 &i_u8NodeID )
 	\brief		Update current AI destination to given node ID
-	\param		i_u32AIEntityIndex the index of AI entity
+	\param		i_u32AIEntityHandle the handle of AI entity
 	\param		i_u8NodeID the ID of the destination node
 	\return		NONE
  ****************************************************************************************************
 */
-void GameEngine::World::UpdateAIDestinationTo( const UINT32 &i_u32AIEntityIndex, const UINT8 &i_u8NodeID )
+void GameEngine::World::UpdateAIDestinationTo( const UINT32 &i_u32AIEntityHandle, const UINT8 &i_u8NodeID )
 {
 	FUNCTION_START;
 
-	AI::UpdateAIDestinationTo( i_u32AIEntityIndex, i_u8NodeID );
+	AI::UpdateAIDestinationTo( i_u32AIEntityHandle, i_u8NodeID );
 
 	FUNCTION_FINISH;
 }
 
 /**
  ****************************************************************************************************
-	\fn			void AbortAI( const UINT32 &i_u32AIEntityIndex )
+	\fn			void AbortAI( const UINT32 &i_u32AIEntityHandle )
 	\brief		Abort AI operation
-	\param		i_u32AIEntityIndex the index of AI entity
+	\param		i_u32AIEntityHandle the handle of AI entity
 	\return		NONE
  ****************************************************************************************************
 */
-void GameEngine::World::AbortAI( const UINT32 &i_u32AIEntityIndex )
+void GameEngine::World::AbortAI( const UINT32 &i_u32AIEntityHandle )
 {
 	FUNCTION_START;
 
-	AI::AbortAI( i_u32AIEntityIndex );
+	AI::AbortAI( i_u32AIEntityHandle );
 
 	FUNCTION_FINISH;
 }
 
 /**
  ****************************************************************************************************
-	\fn			bool GetAIState( const UINT32 &i_u32AIEntityIndex )
+	\fn			bool GetAIState( const UINT32 &i_u32AIEntityHandle )
 	\brief		Get current AI state of the entity
-	\param		i_u32AIEntityIndex the index of AI entity
+	\param		i_u32AIEntityHandle the handle of AI entity
 	\return		BOOLEAN
 	\retval		TRUE if activated
 	\retval		FALSE otherwise
  ****************************************************************************************************
 */
-bool GameEngine::World::GetAIState( const UINT32 &i_u32AIEntityIndex )
+bool GameEngine::World::GetAIState( const UINT32 &i_u32AIEntityHandle )
 {
 	FUNCTION_START;
 
 	FUNCTION_FINISH;
-	return AI::GetAIState( i_u32AIEntityIndex );
+	return AI::GetAIState( i_u32AIEntityHandle );
 }
 
 /**
@@ -413,7 +686,7 @@ void GameEngine::World::CreateSprite( Utilities::Pointer::SmartPtr<Entity> &i_en
 {
 	FUNCTION_START;
 
-	GameEngine::Renderer::AddSprite( i_entity, i_colour, i_textureFile );
+	i_entity->m_u32SpriteHandle = Renderer::AddSprite( i_entity, i_colour, i_textureFile );
 
 	FUNCTION_FINISH;
 }
@@ -431,7 +704,12 @@ void GameEngine::World::CreateMesh( Utilities::Pointer::SmartPtr<Entity> &i_enti
 {
 	FUNCTION_START;
 
-	Renderer::AddMesh( i_entity, i_entityFile );
+	UINT32 u32Handle = Renderer::AddMesh( i_entity, i_entityFile );
+	if( u32Handle != Utilities::INVALID_HANDLE )
+	{
+		i_entity->m_u32MeshHandles.push_back( u32Handle );
+		GetEntityAsset( i_entity->m_u32StoreSlot ).meshFile.push_back( i_entityFile );
+	}
 
 	FUNCTION_FINISH;
 }
@@ -521,47 +799,484 @@ void GameEngine::World::CreateDirectionalLight( const D3DXVECTOR3 &i_direction,
 */
 const UINT32 GameEngine::World::GetTotalEntityInWorldByID( UINT8 &i_ID )
 {
-	UINT32 u32Total = 0;
-	std::vector< Utilities::Pointer::SmartPtr<Entity> >::iterator iter;
+	return _slotsByID[i_ID].size();
+}
 
+/**
+ ****************************************************************************************************
+	\fn			Entity *GetEntityByName( const char *i_name )
+	\brief		Get entity with i_name
+	\param		i_name name of Entity
+	\return		Address of entity with the required name
+ ****************************************************************************************************
+*/
+Utilities::Pointer::SmartPtr<GameEngine::Entity> GameEngine::World::GetEntityByName( const Utilities::StringHash &i_name )
+{
 	FUNCTION_START;
 
-	for( iter = _entityDatabase->begin(); iter != _entityDatabase->end(); ++iter )
+	UINT32 u32Slot = _nameIndex->Find( i_name );
+
+	FUNCTION_FINISH;
+
+	if( u32Slot == Utilities::INVALID_HASH_INDEX_VALUE )
+		return Utilities::Pointer::SmartPtr<Entity>();
+
+	return _entityDatabase->at( u32Slot );
+}
+
+/**
+ ****************************************************************************************************
+	\fn			const UINT32 GetTotalEntitySlots( void ) const
+	\brief		Get total entity store slots the world has seen, entities created from now on get a
+				slot at or above it until an entity is removed
+	\param		NONE
+	\return		UINT32
+ ****************************************************************************************************
+*/
+const UINT32 GameEngine::World::GetTotalEntitySlots( void ) const
+{
+	return _entityDatabase->size();
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool SaveSnapshot( const char *i_filename, const UINT32 &i_u32FirstSlot ) const
+	\brief		Write the entities, their collision and trigger boxes, the AI way point graph, the
+				lights and the collision detection type to a binary snapshot
+	\param		i_filename name of the snapshot file
+	\param		i_u32FirstSlot entities in the slots below it are not written
+	\return		boolean
+	\retval		1 SUCCESS
+	\retval		0 FAIL
+ ****************************************************************************************************
+*/
+bool GameEngine::World::SaveSnapshot( const char *i_filename, const UINT32 &i_u32FirstSlot ) const
+{
+	WorldSnapshot::S_HEADER header;
+	std::vector<WorldSnapshot::S_ENTITY_TYPE> entityType;
+	std::vector<WorldSnapshot::S_ENTITY> entity;
+	std::vector<WorldSnapshot::S_MESH> mesh;
+	std::vector<WorldSnapshot::S_WAY_POINT_ENTRY> wayPoint;
+	std::vector<AI::S_WAY_POINT_LINK> wayPointLink;
+	std::vector<char> stringTable;
+	std::ofstream outFile;
+
+	FUNCTION_START;
+
+	memset( &header, 0, sizeof(header) );
+	header.u32Magic = WorldSnapshot::MAGIC;
+	header.u32Version = WorldSnapshot::VERSION;
+	header.u32CollisionBy = _collisionBy;
+
+	if( m_pointLight )
+	{
+		header.u32Flags |= WorldSnapshot::HAS_POINT_LIGHT;
+		header.pointLight.position = m_pointLight->m_position;
+		header.pointLight.colour = m_pointLight->m_colour;
+		header.pointLight.ambient = m_pointLight->m_ambient;
+		header.pointLight.intensity = m_pointLight->m_intensity;
+		header.pointLight.attenuator = m_pointLight->m_attentuator;
+		header.pointLight.radius = m_pointLight->m_radius;
+	}
+
+	if( m_directionalLight )
+	{
+		header.u32Flags |= WorldSnapshot::HAS_DIRECTIONAL_LIGHT;
+		header.directionalLight.direction = m_directionalLight->m_direction;
+		header.directionalLight.lookAt = m_directionalLight->GetLookAt();
+		header.directionalLight.colour = m_directionalLight->m_colour;
+		header.directionalLight.size = m_directionalLight->GetSize();
+		header.directionalLight.nearView = m_directionalLight->GetNearView();
+		header.directionalLight.farView = m_directionalLight->m_farView;
+		header.directionalLight.intensity = m_directionalLight->m_intensity;
+	}
+
+	for( UINT32 i = 1; i <= Utilities::MAX_UINT8; ++i )
+	{
+		Utilities::StringHash hashedType;
+
+		if( g_IDCreator::Get().GetHashedType(static_cast<UINT8>(i), hashedType) )
+		{
+			WorldSnapshot::S_ENTITY_TYPE newEntityType;
+			newEntityType.u32ID = i;
+			newEntityType.u32HashedType = hashedType;
+			entityType.push_back( newEntityType );
+		}
+	}
+
+	for( UINT32 i = i_u32FirstSlot; i < _entityDatabase->size(); ++i )
+	{
+		const Utilities::Pointer::SmartPtr<Entity> &currEntity = _entityDatabase->at( i );
+		if( !currEntity || currEntity->m_isDestroyed )
+			continue;
+
+		const S_ENTITY_ASSET *asset = (i < _entityAsset->size()) ? &_entityAsset->at( i ) : NULL;
+		WorldSnapshot::S_ENTITY newEntity;
+
+		newEntity.position = D3DXVECTOR3( currEntity->m_v3Position.X(), currEntity->m_v3Position.Y(), currEntity->m_v3Position.Z() );
+		newEntity.scale = currEntity->m_vScale;
+		newEntity.lookAt = currEntity->m_vLookAt;
+		newEntity.size = currEntity->m_size;
+		newEntity.orientation = currEntity->m_orientation;
+		newEntity.u32HashedName = currEntity->m_hashedName;
+		newEntity.u32CollisionMask = currEntity->m_u32CollisionMask;
+		newEntity.u32ID = currEntity->m_u8EntityID;
+		newEntity.u32Tag = currEntity->m_tag ? WorldSnapshot::AddString( stringTable, currEntity->m_tag->c_str() ) : WorldSnapshot::NO_STRING;
+		newEntity.u32CollisionFile = WorldSnapshot::NO_STRING;
+		newEntity.u32Flags = 0;
+
+		if( currEntity->m_applyPhysics )
+			newEntity.u32Flags |= WorldSnapshot::ENTITY_APPLY_PHYSICS;
+
+		if( currEntity->GetEntityController() )
+			newEntity.u32Flags |= WorldSnapshot::ENTITY_HAS_CONTROLLER;
+
+		if( asset )
+		{
+			if( !asset->collisionFile.empty() )
+				newEntity.u32CollisionFile = WorldSnapshot::AddString( stringTable, asset->collisionFile.c_str() );
+
+			if( asset->bTriggerBox )
+				newEntity.u32Flags |= WorldSnapshot::ENTITY_TRIGGER_BOX;
+
+			for( UINT32 j = 0; j < asset->meshFile.size(); ++j )
+			{
+				WorldSnapshot::S_MESH newMesh;
+				newMesh.u32Entity = entity.size();
+				newMesh.u32File = WorldSnapshot::AddString( stringTable, asset->meshFile[j].c_str() );
+				mesh.push_back( newMesh );
+			}
+		}
+
+		entity.push_back( newEntity );
+	}
+
+	std::vector<UINT32> wayPointID;
+	std::vector<AI::S_WAY_POINT> wayPointList;
+	AI::GetWayPoints( wayPointID, wayPointList );
+	for( UINT32 i = 0; i < wayPointID.size(); ++i )
+	{
+		WorldSnapshot::S_WAY_POINT_ENTRY newWayPoint;
+		newWayPoint.u32ID = wayPointID[i];
+		newWayPoint.wayPoint = wayPointList[i];
+		wayPoint.push_back( newWayPoint );
+	}
+	AI::GetWayPointLinks( wayPointLink );
+
+	UINT32 u32Offset = sizeof( header );
+	WorldSnapshot::AddSection( header.entityType, u32Offset, entityType.size(), sizeof(WorldSnapshot::S_ENTITY_TYPE) );
+	WorldSnapshot::AddSection( header.entity, u32Offset, entity.size(), sizeof(WorldSnapshot::S_ENTITY) );
+	WorldSnapshot::AddSection( header.mesh, u32Offset, mesh.size(), sizeof(WorldSnapshot::S_MESH) );
+	WorldSnapshot::AddSection( header.wayPoint, u32Offset, wayPoint.size(), sizeof(WorldSnapshot::S_WAY_POINT_ENTRY) );
+	WorldSnapshot::AddSection( header.wayPointLink, u32Offset, wayPointLink.size(), sizeof(AI::S_WAY_POINT_LINK) );
+	WorldSnapshot::AddSection( header.string, u32Offset, stringTable.size(), sizeof(char) );
+	header.u32FileSize = u32Offset;
+
+	outFile.open( i_filename, std::ios::binary | std::ios::trunc );
+	if( outFile.fail() )
+	{
+		DBG_MSG_LEVEL( D_ERR, "Cannot create world snapshot %s\n", i_filename );
+		FUNCTION_FINISH;
+		return FAIL;
+	}
+
+	outFile.write( reinterpret_cast<const char *>(&header), sizeof(header) );
+	WorldSnapshot::WriteSection( outFile, entityType );
+	WorldSnapshot::WriteSection( outFile, entity );
+	WorldSnapshot::WriteSection( outFile, mesh );
+	WorldSnapshot::WriteSection( outFile, wayPoint );
+	WorldSnapshot::WriteSection( outFile, wayPointLink );
+	WorldSnapshot::WriteSection( outFile, stringTable );
+	outFile.close();
+
+	if( outFile.fail() )
 	{
-		if( (*iter)->m_u8EntityID == i_ID )
-		u32Total++;
+		DBG_MSG_LEVEL( D_ERR, "Cannot write world snapshot %s\n", i_filename );
+		remove( i_filename );
+		FUNCTION_FINISH;
+		return FAIL;
 	}
 
 	FUNCTION_FINISH;
-	return u32Total;
+	return SUCCESS;
 }
 
 /**
  ****************************************************************************************************
-	\fn			Entity *GetEntityByName( const char *i_name )
-	\brief		Get entity with i_name
-	\param		i_name name of Entity
-	\return		Address of entity with the required name
+	\fn			bool LoadSnapshot( const char *i_filename, SnapshotControllerFactory i_controllerFactory )
+	\brief		Map a snapshot written by SaveSnapshot and rebuild the world from it in place. Entity
+				IDs and collision masks are remapped through the hashed entity types, so the snapshot
+				does not depend on the order IDs are handed out
+	\param		i_filename name of the snapshot file
+	\param		i_controllerFactory creates the controllers of the entities saved with one
+	\return		boolean
+	\retval		1 SUCCESS
+	\retval		0 FAIL if the snapshot is missing or invalid, nothing has been created
  ****************************************************************************************************
 */
-Utilities::Pointer::SmartPtr<GameEngine::Entity> GameEngine::World::GetEntityByName( const Utilities::StringHash &i_name )
+bool GameEngine::World::LoadSnapshot( const char *i_filename, SnapshotControllerFactory i_controllerFactory )
 {
-	std::vector< Utilities::Pointer::SmartPtr<Entity> >::iterator iter;
-
 	FUNCTION_START;
 
-	for( iter = _entityDatabase->begin(); iter != _entityDatabase->end(); ++iter )
+	Utilities::MappedFile *file = Utilities::MappedFile::Create( i_filename );
+	if( !file )
 	{
-		if( (*iter) != NULL )
+		FUNCTION_FINISH;
+		return FAIL;
+	}
+
+	if( !WorldSnapshot::IsValid(*file) )
+	{
+		DBG_MSG_LEVEL( D_ERR, "%s is not a valid world snapshot\n", i_filename );
+		delete file;
+		FUNCTION_FINISH;
+		return FAIL;
+	}
+
+	const UINT8 *data = file->GetData();
+	const WorldSnapshot::S_HEADER &header = *reinterpret_cast<const WorldSnapshot::S_HEADER *>( data );
+	const WorldSnapshot::S_ENTITY_TYPE *entityType = reinterpret_cast<const WorldSnapshot::S_ENTITY_TYPE *>( data + header.entityType.u32Offset );
+	const WorldSnapshot::S_ENTITY *entity = reinterpret_cast<const WorldSnapshot::S_ENTITY *>( data + header.entity.u32Offset );
+	const WorldSnapshot::S_MESH *mesh = reinterpret_cast<const WorldSnapshot::S_MESH *>( data + header.mesh.u32Offset );
+	const WorldSnapshot::S_WAY_POINT_ENTRY *wayPoint = reinterpret_cast<const WorldSnapshot::S_WAY_POINT_ENTRY *>( data + header.wayPoint.u32Offset );
+	const AI::S_WAY_POINT_LINK *wayPointLink = reinterpret_cast<const AI::S_WAY_POINT_LINK *>( data + header.wayPointLink.u32Offset );
+	const char *stringTable = reinterpret_cast<const char *>( data + header.string.u32Offset );
+
+	// Saved ID to the ID of this run
+	UINT8 u8IDMap[Utilities::MAX_UINT8 + 1];
+	for( UINT32 i = 0; i <= Utilities::MAX_UINT8; ++i )
+		u8IDMap[i] = static_cast<UINT8>( i );
+	for( UINT32 i = 0; i < header.entityType.u32Total; ++i )
+		u8IDMap[entityType[i].u32ID] = g_IDCreator::Get().GetID( Utilities::StringHash::FromHash(entityType[i].u32HashedType) );
+
+	if( header.u32CollisionBy < E_COLLISION_MAX )
+		SetCollisionDetectionType( static_cast<E_COLLISION_BY>(header.u32CollisionBy) );
+
+	std::vector< Utilities::Pointer::SmartPtr<Entity> > loadedEntity( header.entity.u32Total );
+	for( UINT32 i = 0; i < header.entity.u32Total; ++i )
+	{
+		const WorldSnapshot::S_ENTITY &currEntity = entity[i];
+		const char *tag = (currEntity.u32Tag != WorldSnapshot::NO_STRING) ? stringTable + currEntity.u32Tag : NULL;
+		EntityController *controller = NULL;
+		UINT32 u32CollisionMask = 0;
+
+		if( (currEntity.u32Flags & WorldSnapshot::ENTITY_HAS_CONTROLLER) && i_controllerFactory )
+			controller = i_controllerFactory( Utilities::StringHash::FromHash(currEntity.u32HashedName), tag );
+
+		// Masks are built from IDtoBitMask, move every bit to its remapped ID
+		for( UINT32 j = 0; j < 32; ++j )
 		{
-			if( (*iter)->IsName(i_name) )
-				return (*iter);
-			/*if( strcmp((*iter)->GetName(), i_name) == 0 )
-				return (*iter);*/
+			if( currEntity.u32CollisionMask & (1 << j) )
+				u32CollisionMask |= g_IDCreator::Get().IDtoBitMask( u8IDMap[j] );
 		}
+
+		Utilities::Pointer::SmartPtr<Entity> newEntity = Entity::Create( currEntity.position, controller );
+		newEntity->SetName( Utilities::StringHash::FromHash(currEntity.u32HashedName) );
+		newEntity->m_vScale = currEntity.scale;
+		newEntity->m_vLookAt = currEntity.lookAt;
+		newEntity->m_size = currEntity.size;
+		newEntity->m_orientation = currEntity.orientation;
+		newEntity->m_u32CollisionMask = u32CollisionMask;
+		newEntity->m_u8EntityID = u8IDMap[currEntity.u32ID];
+		newEntity->m_applyPhysics = (currEntity.u32Flags & WorldSnapshot::ENTITY_APPLY_PHYSICS) != 0;
+		if( tag )
+			newEntity->m_tag = new std::string( tag );
+
+		AddEntity( newEntity );
+
+		if( currEntity.u32CollisionFile != WorldSnapshot::NO_STRING )
+			CreateCollisionEntity( newEntity, stringTable + currEntity.u32CollisionFile );
+
+		if( currEntity.u32Flags & WorldSnapshot::ENTITY_TRIGGER_BOX )
+			CreateTriggerBoxEntity( newEntity );
+
+		loadedEntity[i] = newEntity;
+	}
+
+	for( UINT32 i = 0; i < header.mesh.u32Total; ++i )
+		CreateMesh( loadedEntity[mesh[i].u32Entity], stringTable + mesh[i].u32File );
+
+	for( UINT32 i = 0; i < header.wayPoint.u32Total; ++i )
+		AI::AddWayPoint( wayPoint[i].u32ID, wayPoint[i].wayPoint );
+
+	for( UINT32 i = 0; i < header.wayPointLink.u32Total; ++i )
+		AI::AddWayPointLink( wayPointLink[i] );
+
+	if( header.u32Flags & WorldSnapshot::HAS_POINT_LIGHT )
+	{
+		const WorldSnapshot::S_POINT_LIGHT &pointLight = header.pointLight;
+		CreatePointLight( pointLight.position, pointLight.colour, pointLight.ambient,
+			pointLight.intensity, pointLight.attenuator, pointLight.radius );
+	}
+
+	if( header.u32Flags & WorldSnapshot::HAS_DIRECTIONAL_LIGHT )
+	{
+		const WorldSnapshot::S_DIRECTIONAL_LIGHT &directionalLight = header.directionalLight;
+		CreateDirectionalLight( directionalLight.direction, directionalLight.lookAt, directionalLight.colour,
+			directionalLight.size, directionalLight.nearView, directionalLight.farView, directionalLight.intensity );
 	}
 
+	delete file;
+
 	FUNCTION_FINISH;
+	return SUCCESS;
+}
+
+/****************************************************************************************************
+			Helper functions implementation
+****************************************************************************************************/
+/**
+ ****************************************************************************************************
+	\fn			UINT32 AddString( std::vector<char> &io_stringTable, const char *i_string )
+	\brief		Append a string to the string table
+	\param		io_stringTable the string table
+	\param		i_string the string to be added
+	\return		UINT32
+	\retval		Offset of the string in the table
+ ****************************************************************************************************
+*/
+UINT32 GameEngine::WorldSnapshot::AddString( std::vector<char> &io_stringTable, const char *i_string )
+{
+	const UINT32 u32Offset = io_stringTable.size();
+
+	io_stringTable.insert( io_stringTable.end(), i_string, i_string + strlen(i_string) + 1 );
+
+	return u32Offset;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void AddSection( S_SECTION &o_section, UINT32 &io_u32Offset, const UINT32 &i_u32Total,
+					const UINT32 &i_u32RecordSize )
+	\brief		Place a section right after the previous one
+	\param		o_section the section to be placed
+	\param		io_u32Offset offset of the section, moved to the end of the section
+	\param		i_u32Total total records in the section
+	\param		i_u32RecordSize size of one record
+	\return		NONE
+ ****************************************************************************************************
+*/
+void GameEngine::WorldSnapshot::AddSection( S_SECTION &o_section, UINT32 &io_u32Offset, const UINT32 &i_u32Total,
+	const UINT32 &i_u32RecordSize )
+{
+	o_section.u32Offset = io_u32Offset;
+	o_section.u32Total = i_u32Total;
+	io_u32Offset += i_u32Total * i_u32RecordSize;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void WriteSection( std::ofstream &o_file, const std::vector<T> &i_records )
+	\brief		Write every record of a section
+	\param		o_file the snapshot file
+	\param		i_records the records to be written
+	\return		NONE
+ ****************************************************************************************************
+*/
+template<typename T>
+void GameEngine::WorldSnapshot::WriteSection( std::ofstream &o_file, const std::vector<T> &i_records )
+{
+	if( !i_records.empty() )
+		o_file.write( reinterpret_cast<const char *>(&i_records[0]), i_records.size() * sizeof(T) );
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool IsValidSection( const S_SECTION &i_section, const UINT32 &i_u32RecordSize,
+					const UINT32 &i_u32FileSize )
+	\brief		Check the section lies inside the file
+	\param		i_section the section to be checked
+	\param		i_u32RecordSize size of one record
+	\param		i_u32FileSize size of the snapshot file
+	\return		boolean
+	\retval		TRUE if valid
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+bool GameEngine::WorldSnapshot::IsValidSection( const S_SECTION &i_section, const UINT32 &i_u32RecordSize,
+	const UINT32 &i_u32FileSize )
+{
+	if( (i_section.u32Offset < sizeof(S_HEADER)) || (i_section.u32Offset > i_u32FileSize) )
+		return false;
 
-	return Utilities::Pointer::SmartPtr<Entity>();
-}
\ No newline at end of file
+	return i_section.u32Total <= ((i_u32FileSize - i_section.u32Offset) / i_u32RecordSize);
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool IsValidString( const S_HEADER &i_header, const UINT32 &i_u32String, const bool &i_bOptional )
+	\brief		Check the string offset lies inside the string table
+	\param		i_header header of the snapshot
+	\param		i_u32String offset of the string
+	\param		i_bOptional whether NO_STRING is allowed
+	\return		boolean
+	\retval		TRUE if valid
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+bool GameEngine::WorldSnapshot::IsValidString( const S_HEADER &i_header, const UINT32 &i_u32String, const bool &i_bOptional )
+{
+	if( i_u32String == NO_STRING )
+		return i_bOptional;
+
+	return i_u32String < i_header.string.u32Total;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool IsValid( const Utilities::MappedFile &i_file )
+	\brief		Check the snapshot header and every offset it holds before the snapshot is used
+	\param		i_file the mapped snapshot
+	\return		boolean
+	\retval		TRUE if valid
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+bool GameEngine::WorldSnapshot::IsValid( const Utilities::MappedFile &i_file )
+{
+	const UINT32 u32FileSize = i_file.GetSize();
+
+	if( u32FileSize < sizeof(S_HEADER) )
+		return false;
+
+	const S_HEADER &header = *reinterpret_cast<const S_HEADER *>( i_file.GetData() );
+
+	if( (header.u32Magic != MAGIC) || (header.u32Version != VERSION) || (header.u32FileSize != u32FileSize) )
+		return false;
+
+	if( !IsValidSection(header.entityType, sizeof(S_ENTITY_TYPE), u32FileSize)
+		|| !IsValidSection(header.entity, sizeof(S_ENTITY), u32FileSize)
+		|| !IsValidSection(header.mesh, sizeof(S_MESH), u32FileSize)
+		|| !IsValidSection(header.wayPoint, sizeof(S_WAY_POINT_ENTRY), u32FileSize)
+		|| !IsValidSection(header.wayPointLink, sizeof(AI::S_WAY_POINT_LINK), u32FileSize)
+		|| !IsValidSection(header.string, sizeof(char), u32FileSize) )
+		return false;
+
+	// Every string has to be terminated inside the table
+	if( header.string.u32Total && (i_file.GetData()[header.string.u32Offset + header.string.u32Total - 1] != '\0') )
+		return false;
+
+	const S_ENTITY_TYPE *entityType = reinterpret_cast<const S_ENTITY_TYPE *>( i_file.GetData() + header.entityType.u32Offset );
+	for( UINT32 i = 0; i < header.entityType.u32Total; ++i )
+	{
+		if( entityType[i].u32ID > Utilities::MAX_UINT8 )
+			return false;
+	}
+
+	const S_ENTITY *entity = reinterpret_cast<const S_ENTITY *>( i_file.GetData() + header.entity.u32Offset );
+	for( UINT32 i = 0; i < header.entity.u32Total; ++i )
+	{
+		if( (entity[i].u32ID > Utilities::MAX_UINT8) || !IsValidString(header, entity[i].u32Tag, true)
+			|| !IsValidString(header, entity[i].u32CollisionFile, true) )
+			return false;
+	}
+
+	const S_MESH *mesh = reinterpret_cast<const S_MESH *>( i_file.GetData() + header.mesh.u32Offset );
+	for( UINT32 i = 0; i < header.mesh.u32Total; ++i )
+	{
+		if( (mesh[i].u32Entity >= header.entity.u32Total) || !IsValidString(header, mesh[i].u32File, false) )
+			return false;
+	}
+
+	return true;
+}
@@ -9,10 +9,12 @@
 #ifndef _WORLD_H_
 #define _WORLD_H_
 
+#include <string>
 #include <vector>
 
 // Utilities header
 #include <SmartPtr/SmartPtr.h>
+#include <HashIndex/HashIndex.h>
 #include <Singleton/Singleton.h>
 #include <StringHash/StringHash.h>
 
@@ -23,6 +25,8 @@
 namespace GameEngine
 {
 	class Entity;
+	class EntityStore;
+	class EntityController;
 	class Camera;
 	class PointLight;
 	class DirectionalLight;
@@ -35,14 +39,49 @@ namespace GameEngine
 	class World
 	{
 		friend Utilities::Singleton<World>;
+
+		// What an entity was indexed with, so it can be unindexed after its members have changed
+		typedef struct _s_entity_index_entry_
+		{
+			UINT32 u32HashedName;
+			UINT32 u32PositionInIDList;
+			UINT8 u8EntityID;
+		} S_ENTITY_INDEX_ENTRY;
+
+		// Indexed by the entity store slot, empty slots hold NULL
 		std::vector< Utilities::Pointer::SmartPtr<Entity> > *_entityDatabase;
+		std::vector<S_ENTITY_INDEX_ENTRY> *_entityIndexEntry;
+		EntityStore *_entityStore;
+		// Hashed name to slot
+		Utilities::HashIndex *_nameIndex;
+		// Slots of the entities of each ID
+		std::vector<UINT32> *_slotsByID;
+		// What an entity was built from, so the world can be written to a snapshot
+		typedef struct _s_entity_asset_
+		{
+			std::vector<std::string> meshFile;
+			std::string collisionFile;
+			bool bTriggerBox;
+		} S_ENTITY_ASSET;
+
+		// Slots of the entities destroyed this frame
+		std::vector<UINT32> *_destructionQueue;
+		// Indexed by the entity store slot
+		std::vector<S_ENTITY_ASSET> *_entityAsset;
+		E_COLLISION_BY _collisionBy;
 
 		World( void ){ }
 		~World( void ){ }
 
-		void RemoveDeadEntities( void );
+		void RemoveDestroyedEntities( void );
+		void IndexEntity( const UINT32 &i_u32Slot );
+		void UnindexEntity( const UINT32 &i_u32Slot );
+		S_ENTITY_ASSET &GetEntityAsset( const UINT32 &i_u32Slot );
 
 	public:
+		// Create the controller of an entity loaded from a snapshot, i_tag is NULL if it has no tag
+		typedef EntityController *(*SnapshotControllerFactory)( const Utilities::StringHash &i_hashedName, const char *i_tag );
+
 		Camera *m_camera;
 		PointLight *m_pointLight;
 		DirectionalLight *m_directionalLight;
@@ -54,10 +93,18 @@ namespace GameEngine
 		void ShutDown( void );
 
 		void AddEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity );
+		void DestroyEntity( Entity &i_entity );
+		EntityStore &GetEntityStore( void );
+		void UpdateEntityName( const Entity &i_entity );
 
 		const UINT32 GetTotalEntityInWorldByID( UINT8 &i_ID );
 		Utilities::Pointer::SmartPtr<Entity> GetEntityByName( const Utilities::StringHash &i_name );
 
+		// Snapshot related
+		const UINT32 GetTotalEntitySlots( void ) const;
+		bool SaveSnapshot( const char *i_filename, const UINT32 &i_u32FirstSlot = 0 ) const;
+		bool LoadSnapshot( const char *i_filename, SnapshotControllerFactory i_controllerFactory = NULL );
+
 		// Physics related
 		void SetFriction( Utilities::Pointer::SmartPtr<Entity> &i_entity, const float i_friction );
 
@@ -65,6 +112,7 @@ namespace GameEngine
 		void SetCollisionDetectionType( E_COLLISION_BY i_collisionBy );
 		void CreateCollisionEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity, const char *i_collisionFile );
 		void SetCollisionHandler( Utilities::Pointer::SmartPtr<Entity> &i_entity, Collision::CollisionHandler *i_collisionHandler );
+		void SetSweptShape( Utilities::Pointer::SmartPtr<Entity> &i_entity, const float &i_radius, const float &i_height );
 
 		// TriggerBox related
 		void CreateTriggerBoxEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity );
@@ -72,9 +120,9 @@ namespace GameEngine
 
 		// AI related
 		void CreateAIEntity( Utilities::Pointer::SmartPtr<Entity> &i_entity );
-		void UpdateAIDestinationTo( const UINT32 &i_u32AIEntityIndex, const UINT8 &i_u8NodeID );
-		void AbortAI( const UINT32 &i_u32AIEntityIndex );
-		bool GetAIState( const UINT32 &i_u32AIEntityIndex );
+		void UpdateAIDestinationTo( const UINT32 &i_u32AIEntityHandle, const UINT8 &i_u8NodeID );
+		void AbortAI( const UINT32 &i_u32AIEntityHandle );
+		bool GetAIState( const UINT32 &i_u32AIEntityHandle );
 
 		// 2D graphics related
 		void CreateSprite( Utilities::Pointer::SmartPtr<Entity> &i_entity, const D3DCOLOR &i_colour, const char *i_textureFile );
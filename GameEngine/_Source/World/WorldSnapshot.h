@@ -0,0 +1,119 @@
+/**
+ ****************************************************************************************************
+ * \file		WorldSnapshot.h
+ * \brief		The binary world snapshot layout. The file is a header followed by flat arrays of
+ *          fixed size records and a string table, every section is addressed by its offset from the
+ *          start of the file so the snapshot can be used straight from a mapped view
+ ****************************************************************************************************
+*/
+
+#ifndef _WORLD_SNAPSHOT_H_
+#define _WORLD_SNAPSHOT_H_
+
+// Utilities header
+#include <UtilitiesTypes.h>
+
+#include "../AI/WayPoint.h"
+#include "../Utilities/GameEngineTypes.h"
+
+namespace GameEngine
+{
+	namespace WorldSnapshot
+	{
+		// "WSNP"
+		const UINT32 MAGIC = 0x504E5357;
+		// Bump it whenever a record changes, old snapshots are rejected and rebuilt
+		const UINT32 VERSION = 1;
+		const UINT32 NO_STRING = 0xFFFFFFFF;
+
+		// Header flags
+		const UINT32 HAS_POINT_LIGHT = 1 << 0;
+		const UINT32 HAS_DIRECTIONAL_LIGHT = 1 << 1;
+
+		// Entity flags
+		const UINT32 ENTITY_APPLY_PHYSICS = 1 << 0;
+		const UINT32 ENTITY_TRIGGER_BOX = 1 << 1;
+		const UINT32 ENTITY_HAS_CONTROLLER = 1 << 2;
+
+		typedef struct _s_section_
+		{
+			UINT32 u32Offset;
+			UINT32 u32Total;
+		} S_SECTION;
+
+		typedef struct _s_point_light_
+		{
+			D3DXVECTOR3 position;
+			D3DCOLOR colour;
+			D3DCOLOR ambient;
+			float intensity;
+			float attenuator;
+			float radius;
+		} S_POINT_LIGHT;
+
+		typedef struct _s_directional_light_
+		{
+			D3DXVECTOR3 direction;
+			D3DXVECTOR3 lookAt;
+			D3DCOLOR colour;
+			Utilities::S_SIZE size;
+			float nearView;
+			float farView;
+			float intensity;
+		} S_DIRECTIONAL_LIGHT;
+
+		// Entity IDs are handed out at run time, they are remapped through their hashed type
+		typedef struct _s_entity_type_
+		{
+			UINT32 u32ID;
+			UINT32 u32HashedType;
+		} S_ENTITY_TYPE;
+
+		typedef struct _s_entity_
+		{
+			D3DXVECTOR3 position;
+			D3DXVECTOR3 scale;
+			D3DXVECTOR3 lookAt;
+			Utilities::S_SIZE size;
+			float orientation;
+			UINT32 u32HashedName;
+			UINT32 u32CollisionMask;
+			UINT32 u32ID;
+			UINT32 u32Tag;
+			UINT32 u32CollisionFile;
+			UINT32 u32Flags;
+		} S_ENTITY;
+
+		typedef struct _s_mesh_
+		{
+			UINT32 u32Entity;
+			UINT32 u32File;
+		} S_MESH;
+
+		typedef struct _s_way_point_entry_
+		{
+			UINT32 u32ID;
+			AI::S_WAY_POINT wayPoint;
+		} S_WAY_POINT_ENTRY;
+
+		typedef struct _s_header_
+		{
+			UINT32 u32Magic;
+			UINT32 u32Version;
+			UINT32 u32FileSize;
+			UINT32 u32CollisionBy;
+			UINT32 u32Flags;
+			S_POINT_LIGHT pointLight;
+			S_DIRECTIONAL_LIGHT directionalLight;
+			S_SECTION entityType;
+			S_SECTION entity;
+			S_SECTION mesh;
+			S_SECTION wayPoint;
+			S_SECTION wayPointLink;
+			// Null terminated strings, records refer to them by their offset in the table
+			S_SECTION string;
+		} S_HEADER;
+	}	// namespace WorldSnapshot
+}	// namespace GameEngine
+
+#endif	// #ifndef _WORLD_SNAPSHOT_H_
@@ -31,8 +31,7 @@ void CameraController::Update( GameEngine::Entity &i_entity )
 {
 	FUNCTION_START;
 
-	i_entity.m_v3ProjectedPosition = m_followEntity->m_v3Position;
-	i_entity.m_v3ProjectedPosition -= g_world::Get().m_camera->m_viewDirection * g_world::Get().m_camera->m_backDistance;
+	i_entity.SetProjectedPosition( m_followEntity->m_v3Position - g_world::Get().m_camera->m_viewDirection * g_world::Get().m_camera->m_backDistance );
 
 	FUNCTION_FINISH;
 }
@@ -40,23 +39,27 @@ void CameraController::Update( GameEngine::Entity &i_entity )
 /**
  ****************************************************************************************************
 	\fn			CameraCollisionHandler::HandleCollision( Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_entity,
-				Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_other, const float i_collisionTime, const GameEngine::Math::Vector3 &i_collisionVector )
+				Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_other, const GameEngine::Collision::E_COLLISION_HIT i_eHit,
+				const float i_collisionTime, const GameEngine::Math::Vector3 &i_v3PointOrNormal, const Utilities::StringHash &i_hashedTag )
 	\brief		Collision handler of camera
 	\param		i_entity current entity
 	\param		i_other other entity which is collided with
+	\param		i_eHit check which found the collision
 	\param		i_collisionTime time of collision
-	\param		i_collisionVector direction of collision response
+	\param		i_v3PointOrNormal collision point, or the contact normal of a swept hit
+	\param		i_hashedTag tag of the hit triangle
 	\return		NONE
  ****************************************************************************************************
 */
 void CameraCollisionHandler::HandleCollision( Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_entity, Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_other,
-	const float i_collisionTime, const GameEngine::Math::Vector3 &i_collisionPoint )
+	const GameEngine::Collision::E_COLLISION_HIT i_eHit, const float i_collisionTime, const GameEngine::Math::Vector3 &i_v3PointOrNormal,
+	const Utilities::StringHash &i_hashedTag )
 {
 	FUNCTION_START;
 
 	if( i_other->m_u8EntityID == g_IDCreator::Get().GetID("COL") )
 	{
-		i_entity->m_v3ProjectedPosition = i_entity->m_v3Position;
+		i_entity->SetProjectedPosition( i_entity->m_v3Position );
 	}
 
 	FUNCTION_FINISH;
@@ -45,7 +45,8 @@ public:
 	~CameraCollisionHandler( void ) {}
 
 	void HandleCollision( Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_entity, Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_other,
-		const float i_collisionTime, const GameEngine::Math::Vector3 &i_collisionVector );
+		const GameEngine::Collision::E_COLLISION_HIT i_eHit, const float i_collisionTime, const GameEngine::Math::Vector3 &i_v3PointOrNormal,
+		const Utilities::StringHash &i_hashedTag );
 };
 
 #endif	// #ifndef _CAMERA_CONTROLLER_H_
\ No newline at end of file
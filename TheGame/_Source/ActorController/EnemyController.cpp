@@ -66,9 +66,9 @@ void EnemyController::Update( GameEngine::Entity &i_entity )
 	{
 	case E_ENEMY_IDLE:
 		if( g_captureTheFlag::Get().m_playerTeam == Utilities::StringHash("BlueFlag") )
-			g_world::Get().UpdateAIDestinationTo( i_entity.m_u8AIEntityIndex, GlobalConstant::BLUE_FLAG_NODE_ID );
+			g_world::Get().UpdateAIDestinationTo( i_entity.m_u32AIEntityHandle, GlobalConstant::BLUE_FLAG_NODE_ID );
 		else
-			g_world::Get().UpdateAIDestinationTo( i_entity.m_u8AIEntityIndex, GlobalConstant::RED_FLAG_NODE_ID );
+			g_world::Get().UpdateAIDestinationTo( i_entity.m_u32AIEntityHandle, GlobalConstant::RED_FLAG_NODE_ID );
 		_prevState = _enemyState;
 		_enemyState = E_ENEMY_SEARCH_FLAG;
 		break;
@@ -76,7 +76,7 @@ void EnemyController::Update( GameEngine::Entity &i_entity )
 	case E_ENEMY_SEARCH_FLAG:
 		if( g_captureTheFlag::Get().m_bEnemyHasFlag == true )
 		{
-			g_world::Get().UpdateAIDestinationTo( i_entity.m_u8AIEntityIndex, GlobalConstant::GOAL_NODE_ID );
+			g_world::Get().UpdateAIDestinationTo( i_entity.m_u32AIEntityHandle, GlobalConstant::GOAL_NODE_ID );
 			_prevState = _enemyState;
 			_enemyState = E_ENEMY_SEARCH_GOAL;
 		}
@@ -101,7 +101,7 @@ void EnemyController::Update( GameEngine::Entity &i_entity )
 
 			// If player moved to other area
 			if( u32NodeID != _u32NewTargetNode )
-				g_world::Get().UpdateAIDestinationTo( i_entity.m_u8AIEntityIndex, _u32NewTargetNode );
+				g_world::Get().UpdateAIDestinationTo( i_entity.m_u32AIEntityHandle, _u32NewTargetNode );
 		}
 		_bSprint = true;
 		break;
@@ -129,7 +129,7 @@ void EnemyController::Update( GameEngine::Entity &i_entity )
 */
 void EnemyController::EndUpdate( GameEngine::Entity &i_entity )
 {
-	float frameTime_ms = Utilities::Time::GetTimeElapsedThisFrame_ms();
+	float frameTime_ms = Utilities::Time::GetFixedTimeStep_ms();
 
 	FUNCTION_START;
 
@@ -210,7 +210,7 @@ void EnemyController::EndUpdate( GameEngine::Entity &i_entity )
 		D3DXVECTOR3 runToPosition( v3RunToPosition.X(), v3RunToPosition.Y(), v3RunToPosition.Z() );
 
 		GameEngine::AI::FindClosestNodeIDFromPosition( runToPosition, _u32NewTargetNode );
-		g_world::Get().UpdateAIDestinationTo( i_entity.m_u8AIEntityIndex, _u32NewTargetNode );
+		g_world::Get().UpdateAIDestinationTo( i_entity.m_u32AIEntityHandle, _u32NewTargetNode );
 		_enemyState = E_ENEMY_ESCAPE;
 	}
 	else if( _enemyState == E_ENEMY_TAG_PLAYER )
@@ -219,19 +219,19 @@ void EnemyController::EndUpdate( GameEngine::Entity &i_entity )
 		if( _enemyState == E_ENEMY_SEARCH_FLAG )
 		{
 			if( g_captureTheFlag::Get().m_playerTeam == Utilities::StringHash("BlueFlag") )
-				g_world::Get().UpdateAIDestinationTo( i_entity.m_u8AIEntityIndex, GlobalConstant::BLUE_FLAG_NODE_ID );
+				g_world::Get().UpdateAIDestinationTo( i_entity.m_u32AIEntityHandle, GlobalConstant::BLUE_FLAG_NODE_ID );
 			else
-				g_world::Get().UpdateAIDestinationTo( i_entity.m_u8AIEntityIndex, GlobalConstant::RED_FLAG_NODE_ID );
+				g_world::Get().UpdateAIDestinationTo( i_entity.m_u32AIEntityHandle, GlobalConstant::RED_FLAG_NODE_ID );
 		}
 		else if( _enemyState == E_ENEMY_SEARCH_GOAL )
 		{
-			g_world::Get().UpdateAIDestinationTo( i_entity.m_u8AIEntityIndex, GlobalConstant::GOAL_NODE_ID );
+			g_world::Get().UpdateAIDestinationTo( i_entity.m_u32AIEntityHandle, GlobalConstant::GOAL_NODE_ID );
 		}
 	}
 
 	if( _bSprint && (_u32Power > GlobalConstant::SPRINT_POWER_PER_FRAME) )
 	{
-		i_entity.m_v3Velocity *= GlobalConstant::DEFAULT_SPRINT_SPEED;
+		i_entity.SetVelocity( i_entity.m_v3Velocity * GlobalConstant::DEFAULT_SPRINT_SPEED );
 		_u32Power -= GlobalConstant::SPRINT_POWER_PER_FRAME;
 	}
 
@@ -241,42 +241,57 @@ void EnemyController::EndUpdate( GameEngine::Entity &i_entity )
 /**
  ****************************************************************************************************
 	\fn			EnemyCollisionHandler::HandleCollision( Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_entity,
-				Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_other, const float i_collisionTime,
-				const GameEngine::Math::Vector3 &i_collisionVector, const Utilities::StringHash &i_hashedTag )
+				Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_other, const GameEngine::Collision::E_COLLISION_HIT i_eHit,
+				const float i_collisionTime, const GameEngine::Math::Vector3 &i_v3PointOrNormal, const Utilities::StringHash &i_hashedTag )
 	\brief		Collision handler of Enemy
 	\param		i_entity current entity
-	\param		i_other other entity which is collided with
-	\param		i_collisionTime time of collision
-	\param		i_collisionVector direction of collision response
+	\param		i_other other entity which is collided with, the entity itself if there is no ground below it
+	\param		i_eHit check which found the collision
+	\param		i_collisionTime time of impact of a swept hit
+	\param		i_v3PointOrNormal ground point of a down hit, hit point of a forward ray, contact normal of a swept hit
+	\param		i_hashedTag tag of the hit triangle
 	\return		NONE
  ****************************************************************************************************
 */
 void EnemyCollisionHandler::HandleCollision( Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_entity, \
-	Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_other, const float i_collisionTime, \
-	const GameEngine::Math::Vector3 &i_collisionPoint, const Utilities::StringHash &i_hashedTag )
+	Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_other, const GameEngine::Collision::E_COLLISION_HIT i_eHit, \
+	const float i_collisionTime, const GameEngine::Math::Vector3 &i_v3PointOrNormal, const Utilities::StringHash &i_hashedTag )
 {
 	FUNCTION_START;
 
+	GameEngine::Math::Vector3 v3ProjectedPosition = i_entity->m_v3ProjectedPosition;
+
 	if( i_other->m_u8EntityID == g_IDCreator::Get().GetID("COL") )
 	{
-		if( Utilities::Math::AreRelativelyEqual(i_collisionTime, 1.0f) )
+		if( i_eHit == GameEngine::Collision::E_COLLISION_HIT_DOWN )
+		{
+			float newHeight = i_v3PointOrNormal.Y() + i_entity->m_size.height;
+			v3ProjectedPosition.Y( newHeight );
+		}
+		else if( i_eHit == GameEngine::Collision::E_COLLISION_HIT_SWEPT )
 		{
-			float newHeight = i_collisionPoint.Y() + i_entity->m_size.height;
-			i_entity->m_v3ProjectedPosition.Y( newHeight );
+			// The swept capsule gives the time of impact and the contact normal. The enemy stops at the
+			// contact and the rest of the move slides along it
+			GameEngine::Math::Vector3 v3Move = v3ProjectedPosition - i_entity->m_v3Position;
+			GameEngine::Math::Vector3 v3Slide = v3Move * (1.0f - i_collisionTime);
+			v3Slide -= i_v3PointOrNormal * v3Slide.DotProduct( i_v3PointOrNormal );
+			v3ProjectedPosition = i_entity->m_v3Position + v3Move * i_collisionTime + v3Slide
+				+ i_v3PointOrNormal * GlobalConstant::COLLISION_SKIN;
 		}
 		else
 		{
-			i_entity->m_v3ProjectedPosition -= ((i_entity->m_v3Velocity) * 2.0f);
-			i_entity->m_v3ProjectedPosition.Y( i_entity->m_v3ProjectedPosition.Y() - 20.0f );
+			// A forward ray only gives the point it hit, the enemy stays where it was
+			v3ProjectedPosition = i_entity->m_v3Position;
 		}
 	}
 	// Gravity
 	else if( i_other->m_u8EntityID == i_entity->m_u8EntityID )
 	{
-		float newHeight = i_entity->m_v3ProjectedPosition.Y() - 20.0f;
-		i_entity->m_v3ProjectedPosition.Y( newHeight );
+		float newHeight = v3ProjectedPosition.Y() - 20.0f;
+		v3ProjectedPosition.Y( newHeight );
 	}
-	i_entity->m_v3ProjectedVelocity = GameEngine::Math::Vector3::Zero;
+	i_entity->SetProjectedPosition( v3ProjectedPosition );
+	i_entity->SetProjectedVelocity( GameEngine::Math::Vector3::Zero );
 
 	FUNCTION_FINISH;
 }
@@ -303,7 +318,7 @@ void EnemyTriggerBoxHandler::OnEnter( Utilities::Pointer::SmartPtr<GameEngine::E
 			Utilities::Pointer::SmartPtr<GameEngine::Entity> blueFlag = g_world::Get().GetEntityByName( g_captureTheFlag::Get().m_playerTeam );
 			Utilities::Pointer::SmartPtr<GameEngine::Entity> enemy = g_world::Get().GetEntityByName( "Enemy" );
 			if( blueFlag && enemy )
-				blueFlag->m_v3Position = enemy->m_v3Position - i_other->m_v3Position;
+				blueFlag->SetPosition( enemy->m_v3Position - i_other->m_v3Position );
 
 			GameEngine::Audio::Play2DSoundEffect( g_captureTheFlag::Get().m_u32EnemyPickUpSfxID, "enemyPickFlag.wav" );
 			g_networkManager::Get().SendFlagEvent( false );
@@ -23,7 +23,7 @@ void FlagController::EndUpdate( GameEngine::Entity &i_entity )
 	{
 		Utilities::Pointer::SmartPtr<GameEngine::Entity> player = g_world::Get().GetEntityByName( _playerName );
 		Utilities::Pointer::SmartPtr<GameEngine::Entity> triggerBox = g_world::Get().GetEntityByName( _flagAreaName );
-		i_entity.m_v3Position = player->m_v3Position - triggerBox->m_v3Position;
+		i_entity.SetPosition( player->m_v3Position - triggerBox->m_v3Position );
 	}
 
 	FUNCTION_FINISH;
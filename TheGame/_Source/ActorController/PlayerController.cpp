@@ -53,13 +53,13 @@ PlayerController::PlayerController( void ) :
 void PlayerController::Update( GameEngine::Entity &i_entity )
 {
 	D3DXVECTOR3 direction;
-	float speed = Utilities::Time::GetTimeElapsedThisFrame_ms() * 0.2f;
+	float speed = Utilities::Time::GetFixedTimeStep_ms() * 0.2f;
 
 	FUNCTION_START;
 
 	if( !GameEngine::IsDebugMenuActivated() )
 	{
-		i_entity.m_v3Velocity = GameEngine::Math::Vector3::Zero;
+		i_entity.SetVelocity( GameEngine::Math::Vector3::Zero );
 
 		// Disable movement while on debug camera
 		if( GameEngine::UserInput::IsKeyUp(VK_SNAPSHOT) )
@@ -145,14 +145,14 @@ void PlayerController::Update( GameEngine::Entity &i_entity )
 			D3DXVec3Cross( &direction, &g_world::Get().m_camera->GetViewDirection(), &g_world::Get().m_camera->m_upVector );
 			D3DXVec3Normalize( &direction, &direction );
 
-			i_entity.m_v3Velocity = -direction;
+			i_entity.SetVelocity( -direction );
 		}
 		else if( GameEngine::UserInput::IsKeyPressed(VK_LEFT) )
 		{
 			D3DXVec3Cross( &direction, &g_world::Get().m_camera->GetViewDirection(), &g_world::Get().m_camera->m_upVector );
 			D3DXVec3Normalize( &direction, &direction );
 
-			i_entity.m_v3Velocity = direction;
+			i_entity.SetVelocity( direction );
 		}
 
 		if( bUpdatePlayerView )
@@ -165,12 +165,12 @@ void PlayerController::Update( GameEngine::Entity &i_entity )
 		if( GameEngine::UserInput::IsKeyPressed(VK_UP) )
 		{
 			bPlayerViewMustBeUpdated = true;
-			i_entity.m_v3Velocity = g_world::Get().m_camera->GetViewDirection();
+			i_entity.SetVelocity( g_world::Get().m_camera->GetViewDirection() );
 		}
 		else if( GameEngine::UserInput::IsKeyPressed(VK_DOWN) )
 		{
 			bPlayerViewMustBeUpdated = true;
-			i_entity.m_v3Velocity = -g_world::Get().m_camera->GetViewDirection();
+			i_entity.SetVelocity( -g_world::Get().m_camera->GetViewDirection() );
 		}
 		// }
 
@@ -202,7 +202,7 @@ void PlayerController::Update( GameEngine::Entity &i_entity )
 
 		if( bSprint )
 		{
-			i_entity.m_v3Velocity *= GlobalConstant::DEFAULT_SPRINT_SPEED;
+			i_entity.SetVelocity( i_entity.m_v3Velocity * GlobalConstant::DEFAULT_SPRINT_SPEED );
 			GameEngine::Audio::Play3DSoundEffect( g_captureTheFlag::Get().m_u32SprintSfxID, "sprint.wav", i_entity.m_v3Position );
 		}
 		else
@@ -271,30 +271,34 @@ bool PlayerController::IsPlayerQuit( void )
 /**
  ****************************************************************************************************
 	\fn			PlayerCollisionHandler::HandleCollision( Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_entity,
-				Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_other, const float i_collisionTime,
-				const GameEngine::Math::Vector3 &i_collisionVector, const Utilities::StringHash &i_hashedTag )
+				Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_other, const GameEngine::Collision::E_COLLISION_HIT i_eHit,
+				const float i_collisionTime, const GameEngine::Math::Vector3 &i_v3PointOrNormal, const Utilities::StringHash &i_hashedTag )
 	\brief		Collision handler of player
 	\param		i_entity current entity
-	\param		i_other other entity which is collided with
-	\param		i_collisionTime time of collision
-	\param		i_collisionVector direction of collision response
+	\param		i_other other entity which is collided with, the entity itself if there is no ground below it
+	\param		i_eHit check which found the collision
+	\param		i_collisionTime time of impact of a swept hit
+	\param		i_v3PointOrNormal ground point of a down hit, hit point of a forward ray, contact normal of a swept hit
+	\param		i_hashedTag tag of the hit triangle
 	\return		NONE
  ****************************************************************************************************
 */
 void PlayerCollisionHandler::HandleCollision( Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_entity, \
-	Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_other, const float i_collisionTime, \
-	const GameEngine::Math::Vector3 &i_collisionPoint, const Utilities::StringHash &i_hashedTag )
+	Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_other, const GameEngine::Collision::E_COLLISION_HIT i_eHit, \
+	const float i_collisionTime, const GameEngine::Math::Vector3 &i_v3PointOrNormal, const Utilities::StringHash &i_hashedTag )
 {
 	FUNCTION_START;
 
 	if( i_other->m_u8EntityID == g_IDCreator::Get().GetID("COL") )
 	{
-		if( Utilities::Math::AreRelativelyEqual(i_collisionTime, 1.0f) )
+		if( i_eHit == GameEngine::Collision::E_COLLISION_HIT_DOWN )
 		{
-			float newHeight = i_collisionPoint.Y() + i_entity->m_size.height;
+			GameEngine::Math::Vector3 v3ProjectedPosition = i_entity->m_v3ProjectedPosition;
+			float newHeight = i_v3PointOrNormal.Y() + i_entity->m_size.height;
 			_groundPos = i_entity->m_v3ProjectedPosition;
-			_groundPos.Y( i_collisionPoint.Y() );
-			i_entity->m_v3ProjectedPosition.Y( newHeight );
+			_groundPos.Y( i_v3PointOrNormal.Y() );
+			v3ProjectedPosition.Y( newHeight );
+			i_entity->SetProjectedPosition( v3ProjectedPosition );
 			if( i_hashedTag == Utilities::StringHash("Floor") )
 			{
 				GameEngine::Audio::Stop3DSoundEffect( g_captureTheFlag::Get().m_u32StairSfxID );
@@ -306,19 +310,32 @@ void PlayerCollisionHandler::HandleCollision( Utilities::Pointer::SmartPtr<GameE
 				GameEngine::Audio::Play3DSoundEffect( g_captureTheFlag::Get().m_u32StairSfxID, "stairs.wav", _groundPos );
 			}
 		}
+		else if( i_eHit == GameEngine::Collision::E_COLLISION_HIT_SWEPT )
+		{
+			// The swept capsule gives the time of impact and the contact normal. The player stops at the
+			// contact and the rest of the move slides along it
+			GameEngine::Math::Vector3 v3Move = i_entity->m_v3ProjectedPosition - i_entity->m_v3Position;
+			GameEngine::Math::Vector3 v3Slide = v3Move * (1.0f - i_collisionTime);
+			v3Slide -= i_v3PointOrNormal * v3Slide.DotProduct( i_v3PointOrNormal );
+			i_entity->SetProjectedPosition( i_entity->m_v3Position + v3Move * i_collisionTime + v3Slide
+				+ i_v3PointOrNormal * GlobalConstant::COLLISION_SKIN );
+		}
 		else
 		{
-			i_entity->m_v3ProjectedPosition = i_entity->m_v3Position;
-			i_entity->m_v3ProjectedPosition.Y( i_entity->m_v3ProjectedPosition.Y() - 20.0f );
+			// A forward ray only gives the point it hit, the player stays where it was
+			GameEngine::Math::Vector3 v3ProjectedPosition = i_entity->m_v3Position;
+			v3ProjectedPosition.Y( v3ProjectedPosition.Y() - 20.0f );
+			i_entity->SetProjectedPosition( v3ProjectedPosition );
 		}
 	}
 	// Gravity
 	else if( i_other->m_u8EntityID == i_entity->m_u8EntityID )
 	{
-		float newHeight = i_entity->m_v3ProjectedPosition.Y() - 20.0f;
-		i_entity->m_v3ProjectedPosition.Y( newHeight );
+		GameEngine::Math::Vector3 v3ProjectedPosition = i_entity->m_v3ProjectedPosition;
+		v3ProjectedPosition.Y( v3ProjectedPosition.Y() - 20.0f );
+		i_entity->SetProjectedPosition( v3ProjectedPosition );
 	}
-	i_entity->m_v3ProjectedVelocity = GameEngine::Math::Vector3::Zero;
+	i_entity->SetProjectedVelocity( GameEngine::Math::Vector3::Zero );
 
 	FUNCTION_FINISH;
 }
@@ -345,7 +362,7 @@ void PlayerTriggerBoxHandler::OnEnter( Utilities::Pointer::SmartPtr<GameEngine::
 			Utilities::Pointer::SmartPtr<GameEngine::Entity> redFlag = g_world::Get().GetEntityByName( g_captureTheFlag::Get().m_enemyTeam );
 			Utilities::Pointer::SmartPtr<GameEngine::Entity> player = g_world::Get().GetEntityByName( "Player" );
 			if( redFlag && player )
-				redFlag->m_v3Position = player->m_v3Position - i_other->m_v3Position;
+				redFlag->SetPosition( player->m_v3Position - i_other->m_v3Position );
 
 			GameEngine::Audio::Play2DSoundEffect( g_captureTheFlag::Get().m_u32PlayerPickUpSfxID, "playerPickFlag.wav" );
 			g_networkManager::Get().SendFlagEvent( true );
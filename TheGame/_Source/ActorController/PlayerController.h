@@ -49,7 +49,8 @@ public:
 	~PlayerCollisionHandler( void ) {}
 
 	void HandleCollision( Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_entity, Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_other,
-		const float i_collisionTime, const GameEngine::Math::Vector3 &i_collisionVector, const Utilities::StringHash &i_hashedTag );
+		const GameEngine::Collision::E_COLLISION_HIT i_eHit, const float i_collisionTime, const GameEngine::Math::Vector3 &i_v3PointOrNormal,
+		const Utilities::StringHash &i_hashedTag );
 };
 
 class PlayerTriggerBoxHandler : public GameEngine::TriggerBox::TriggerBoxHandler
@@ -11,6 +11,7 @@
 #include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <libconfig.hpp>
 
@@ -57,6 +58,7 @@ void ResetFlagPosition( void );
 void TagMessageHandler( void *i_sender );
 void EnemyScoreMessageHandler( void *i_sender );
 void PlayerScoreMessageHandler( void *i_sender );
+GameEngine::EntityController *CreateSnapshotController( const Utilities::StringHash &i_hashedName, const char *i_tag );
 
 /****************************************************************************************************
 			Global functions implementation
@@ -140,11 +142,7 @@ bool CaptureTheFlag::Initialize( void )
 
 	CreateEnemy();
 	CreatePlayer();
-	CreateEntities();
-	CreatePointLight();
-	CreateDirectionalLight();
-	CreateCollisionEntities();
-	LoadWorldConfiguration();
+	CreateLevel();
 
 	InitializeSfx();
 
@@ -182,11 +180,7 @@ bool CaptureTheFlag::Initialize( const D3DXVECTOR3 &i_playerPosition, const D3DX
 
 	CreateEnemy( i_enemyPosition );
 	CreatePlayer( i_playerPosition );
-	CreateEntities();
-	CreatePointLight();
-	CreateDirectionalLight();
-	CreateCollisionEntities();
-	LoadWorldConfiguration();
+	CreateLevel();
 
 	InitializeSfx();
 
@@ -487,6 +481,7 @@ void CaptureTheFlag::CreateEnemy( void )
 	g_world::Get().SetCollisionDetectionType( GameEngine::E_COLLISION_BY_MESH );
 	g_world::Get().CreateCollisionEntity( enemy, collisionFile.c_str() );
 	g_world::Get().SetCollisionHandler( enemy, new EnemyCollisionHandler() );
+	SetCharacterSweptShape( enemy );
 
 	// TriggerBox
 	g_world::Get().CreateTriggerBoxEntity( enemy );
@@ -647,6 +642,7 @@ void CaptureTheFlag::CreateEnemy( const D3DXVECTOR3 &i_position )
 	g_world::Get().SetCollisionDetectionType( GameEngine::E_COLLISION_BY_MESH );
 	g_world::Get().CreateCollisionEntity( enemy, collisionFile.c_str() );
 	g_world::Get().SetCollisionHandler( enemy, new EnemyCollisionHandler() );
+	SetCharacterSweptShape( enemy );
 
 	// TriggerBox
 	/*g_world::Get().CreateTriggerBoxEntity( enemy );
@@ -827,6 +823,7 @@ void CaptureTheFlag::CreatePlayer( void )
 	g_world::Get().SetCollisionDetectionType( GameEngine::E_COLLISION_BY_MESH );
 	g_world::Get().CreateCollisionEntity( player, collisionFile.c_str() );
 	g_world::Get().SetCollisionHandler( player, new PlayerCollisionHandler() );
+	SetCharacterSweptShape( player );
 
 	// TriggerBox
 	g_world::Get().CreateTriggerBoxEntity( player );
@@ -985,6 +982,7 @@ void CaptureTheFlag::CreatePlayer( const D3DXVECTOR3 &i_position )
 	g_world::Get().SetCollisionDetectionType( GameEngine::E_COLLISION_BY_MESH );
 	g_world::Get().CreateCollisionEntity( player, collisionFile.c_str() );
 	g_world::Get().SetCollisionHandler( player, new PlayerCollisionHandler() );
+	SetCharacterSweptShape( player );
 
 	// TriggerBox
 	/*g_world::Get().CreateTriggerBoxEntity( player );
@@ -995,6 +993,79 @@ void CaptureTheFlag::CreatePlayer( const D3DXVECTOR3 &i_position )
 	FUNCTION_FINISH;
 }
 
+/**
+ ****************************************************************************************************
+	\fn			void CreateLevel( void )
+	\brief		Load the level from the world snapshot, or build it from the scene, collision and
+				world configuration files and write the snapshot for the next start up
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void CaptureTheFlag::CreateLevel( void )
+{
+	libconfig::Config &config = GameEngine::Configuration::GetMasterConfig();
+	libconfig::Setting *gameSettings = config.lookup( "CaptureTheFlag" );
+	std::string snapshotFile;
+
+	FUNCTION_START;
+
+	// The snapshot is optional
+	if( gameSettings && gameSettings->lookupValue("snapshotFile", snapshotFile) )
+	{
+		if( g_world::Get().LoadSnapshot(snapshotFile.c_str(), CreateSnapshotController) )
+		{
+			FUNCTION_FINISH;
+			return;
+		}
+	}
+
+	// The actors are created by the game, they are not part of the snapshot
+	const UINT32 u32FirstLevelSlot = g_world::Get().GetTotalEntitySlots();
+
+	CreateEntities();
+	CreatePointLight();
+	CreateDirectionalLight();
+	CreateCollisionEntities();
+	LoadWorldConfiguration();
+
+	if( !snapshotFile.empty() )
+		g_world::Get().SaveSnapshot( snapshotFile.c_str(), u32FirstLevelSlot );
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			GameEngine::EntityController *CreateFlagController( const char *i_tag )
+	\brief		Create the controller of the flag with given tag
+	\param		i_tag tag of the entity
+	\return		Pointer to the flag controller
+	\retval		NULL if the entity is not a flag
+ ****************************************************************************************************
+*/
+GameEngine::EntityController *CaptureTheFlag::CreateFlagController( const char *i_tag )
+{
+	bool bPlayerIsBlue = m_playerTeam == Utilities::StringHash( "BlueFlag" );
+
+	if( !strcmp(i_tag, "RedFlag") )
+	{
+		if( bPlayerIsBlue )
+			return new FlagController( m_bPlayerHasFlag, "Player", "RedFlagArea" );
+		else
+			return new FlagController( m_bEnemyHasFlag, "Enemy", "RedFlagArea" );
+	}
+	else if( !strcmp(i_tag, "BlueFlag") )
+	{
+		if( bPlayerIsBlue )
+			return new FlagController( m_bEnemyHasFlag, "Enemy", "BlueFlagArea" );
+		else
+			return new FlagController( m_bPlayerHasFlag, "Player", "BlueFlagArea" );
+	}
+
+	return NULL;
+}
+
 /**
  ****************************************************************************************************
 	\fn			void CreateEntities( void )
@@ -1034,7 +1105,7 @@ void CaptureTheFlag::CreateEntities( void )
 	tempEntity->m_u32CollisionMask = 0;
 	tempEntity->m_u8EntityID = g_IDCreator::Get().GetID( "Model" );
 	tempEntity->m_orientation = scene.m_entity[0].orientation;
-	tempEntity->m_v3Position = position;
+	tempEntity->SetPosition( position );
 
 	g_world::Get().AddEntity( tempEntity );
 
@@ -1043,47 +1114,13 @@ void CaptureTheFlag::CreateEntities( void )
 		Utilities::MeshParser mesh( scene.m_entity[i].file.c_str() );
 		if( mesh.m_tag )
 		{
-			Utilities::Pointer::SmartPtr<GameEngine::Entity> newEntity;
-			if( !mesh.m_tag->compare("RedFlag") )
-			{
-				if( m_playerTeam == Utilities::StringHash("BlueFlag") )
-				{
-					newEntity = GameEngine::Entity::Create( position, \
-						new FlagController(m_bPlayerHasFlag, "Player", "RedFlagArea"),
-						mesh.m_tag->c_str());
-				}
-				else
-				{
-					newEntity = GameEngine::Entity::Create( position, \
-						new FlagController(m_bEnemyHasFlag, "Enemy", "RedFlagArea"),
-						mesh.m_tag->c_str());
-				}
-			}
-			else if( !mesh.m_tag->compare("BlueFlag") )
-			{
-				if( m_playerTeam == Utilities::StringHash("BlueFlag") )
-				{
-					newEntity = GameEngine::Entity::Create( position, \
-						new FlagController(m_bEnemyHasFlag, "Enemy", "BlueFlagArea"),
-						mesh.m_tag->c_str());
-				}
-				else
-				{
-					newEntity = GameEngine::Entity::Create( position, \
-						new FlagController(m_bPlayerHasFlag, "Player", "BlueFlagArea"),
-						mesh.m_tag->c_str());
-				}
-			}
-			else
-			{
-				newEntity = GameEngine::Entity::Create( position, \
-				NULL, mesh.m_tag->c_str());
-			}
+			Utilities::Pointer::SmartPtr<GameEngine::Entity> newEntity = GameEngine::Entity::Create( position, \
+				CreateFlagController(mesh.m_tag->c_str()), mesh.m_tag->c_str() );
 			newEntity->m_applyPhysics = false;
 			newEntity->m_u32CollisionMask = 0;
 			newEntity->m_u8EntityID = g_IDCreator::Get().GetID( scene.m_entity[i].file.c_str() );
 			newEntity->m_orientation = scene.m_entity[0].orientation;
-			newEntity->m_v3Position = position;
+			newEntity->SetPosition( position );
 			newEntity->m_tag = new std::string( mesh.m_tag->c_str() );
 			g_world::Get().AddEntity( newEntity );
 			g_world::Get().CreateMesh( newEntity, scene.m_entity[i].file.c_str() );
@@ -1095,6 +1132,31 @@ void CaptureTheFlag::CreateEntities( void )
 	FUNCTION_FINISH;
 }
 
+/**
+ ****************************************************************************************************
+	\fn			void SetCharacterSweptShape( Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_entity )
+	\brief		Make the forward collision of a character sweep a capsule as wide as the character. The
+				capsule hangs from the position of the character and stops short of the ground by the
+				step height
+	\param		i_entity the character
+	\return		NONE
+ ****************************************************************************************************
+*/
+void CaptureTheFlag::SetCharacterSweptShape( Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_entity )
+{
+	float reach = i_entity->m_size.height * (1.0f - GlobalConstant::STEP_HEIGHT_RATIO);
+	float radius = 0.5f * ((i_entity->m_size.width < i_entity->m_size.depth) ? i_entity->m_size.width : i_entity->m_size.depth);
+
+	FUNCTION_START;
+
+	if( radius > reach )
+		radius = reach;
+
+	g_world::Get().SetSweptShape( i_entity, radius, reach - radius );
+
+	FUNCTION_FINISH;
+}
+
 /**
  ****************************************************************************************************
 	\fn			void CreateCamera( void )
@@ -1611,7 +1673,7 @@ void CaptureTheFlag::CreateCollisionEntities( void )
 		tempEntity->m_u32CollisionMask = u32CollisionMask;
 		tempEntity->m_u8EntityID = u8CollisionID;
 		tempEntity->m_orientation = 0;
-		tempEntity->m_v3Position = GameEngine::Math::Vector3::Zero;
+		tempEntity->SetPosition( GameEngine::Math::Vector3::Zero );
 
 		g_world::Get().AddEntity( tempEntity );
 		g_world::Get().CreateCollisionEntity( tempEntity, collisionFile.c_str() );
@@ -1639,7 +1701,7 @@ void CaptureTheFlag::CreateCollisionEntities( void )
 			tempEntity->m_u32CollisionMask = u32CollisionMask;
 			tempEntity->m_u8EntityID = u8CollisionID;
 			tempEntity->m_orientation = collision.m_entity[i].orientation;
-			tempEntity->m_v3Position = position;
+			tempEntity->SetPosition( position );
 
 			g_world::Get().AddEntity( tempEntity );
 			g_world::Get().CreateCollisionEntity( tempEntity, collision.m_entity[i].file.c_str() );
@@ -1780,7 +1842,7 @@ void ResetFlagPosition( void )
 		g_captureTheFlag::Get().m_bEnemyHasFlag = false;
 		Utilities::Pointer::SmartPtr<GameEngine::Entity> blueFlag = g_world::Get().GetEntityByName(
 			g_captureTheFlag::Get().m_playerTeam );
-		blueFlag->m_v3Position = GameEngine::Math::Vector3::Zero;
+		blueFlag->SetPosition( GameEngine::Math::Vector3::Zero );
 		g_networkManager::Get().SendFlagEvent( false );
 	}
 
@@ -1789,7 +1851,7 @@ void ResetFlagPosition( void )
 		g_captureTheFlag::Get().m_bPlayerHasFlag = false;
 		Utilities::Pointer::SmartPtr<GameEngine::Entity> redFlag = g_world::Get().GetEntityByName(
 			g_captureTheFlag::Get().m_enemyTeam );
-		redFlag->m_v3Position = GameEngine::Math::Vector3::Zero;
+		redFlag->SetPosition( GameEngine::Math::Vector3::Zero );
 		g_networkManager::Get().SendFlagEvent( true );
 	}
 
@@ -1857,4 +1919,22 @@ void PlayerScoreMessageHandler( void *i_sender )
 	ResetFlagPosition();
 
 	FUNCTION_FINISH;
-}
\ No newline at end of file
+}
+
+/**
+ ****************************************************************************************************
+	\fn			GameEngine::EntityController *CreateSnapshotController( const Utilities::StringHash &i_hashedName, const char *i_tag )
+	\brief		Create the controller of an entity loaded from the world snapshot
+	\param		i_hashedName hashed name of the entity
+	\param		i_tag tag of the entity, NULL if it has no tag
+	\return		Pointer to the controller
+	\retval		NULL if the entity has no controller
+ ****************************************************************************************************
+*/
+GameEngine::EntityController *CreateSnapshotController( const Utilities::StringHash &i_hashedName, const char *i_tag )
+{
+	if( !i_tag )
+		return NULL;
+
+	return g_captureTheFlag::Get().CreateFlagController( i_tag );
+}
@@ -26,8 +26,10 @@ class CaptureTheFlag
 	void CreatePlayer( void );
 	void CreateEnemy( const D3DXVECTOR3 &i_position );
 	void CreatePlayer( const D3DXVECTOR3 &i_position );
+	void CreateLevel( void );
 	void CreateEntities( void );
 	void CreateCamera( Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_entity );
+	void SetCharacterSweptShape( Utilities::Pointer::SmartPtr<GameEngine::Entity> &i_entity );
 	void CreatePointLight( void );
 	void CreateDirectionalLight( void );
 	void CreateCollisionEntities( void );
@@ -70,6 +72,7 @@ public:
 
 	const bool IsGameOver( void ) const;
 	const Utilities::S_SIZE &GetWindowSize( void ) const;
+	GameEngine::EntityController *CreateFlagController( const char *i_tag );
 };
 
 typedef Utilities::Singleton<CaptureTheFlag> g_captureTheFlag;
@@ -23,6 +23,11 @@ namespace GlobalConstant
 	const float DEFAULT_SPRINT_SPEED = 4.0f;
 	const float MINIMUM_DISTANCE_TO_PLAYER = 200.0f;
 	const float TAG_DISTANCE = 50.0f;
+	// Part of the height of a character its swept capsule keeps off the ground, so the capsule passes over
+	// stairs and the down ray keeps the character on the ground
+	const float STEP_HEIGHT_RATIO = 0.3f;
+	// Distance a character is kept from the geometry its capsule is swept into
+	const float COLLISION_SKIN = 0.1f;
 
 	const UINT32 GOAL_NODE_ID = 22;
 	const UINT32 RED_FLAG_NODE_ID = 14;
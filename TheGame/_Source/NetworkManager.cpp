@@ -45,7 +45,7 @@ void NetworkManager::BeginUpdate( void )
 				if( GameEngine::Network::IsServer() )
 				{
 					enemy->SetController( NULL );
-					GameEngine::AI::RemoveAIEntity( enemy->m_u8AIEntityIndex );
+					GameEngine::AI::RemoveAIEntity( enemy->m_u32AIEntityHandle );
 
 					S_START_UP_PACKET startUpPacket;
 					startUpPacket.serverPositionX = player->m_v3Position.X();
@@ -117,8 +117,8 @@ void NetworkManager::BeginUpdate( void )
 				bs.IgnoreBytes( sizeof(RakNet::MessageID) );
 				bs.Read( (char*)&position, sizeof(position) );
 
-				enemy->m_v3Position = position;
-				enemy->m_v3ProjectedPosition = position;
+				enemy->SetPosition( position );
+				enemy->SetProjectedPosition( position );
 				break;
 
 			}
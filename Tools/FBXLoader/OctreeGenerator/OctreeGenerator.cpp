@@ -1,3 +1,4 @@
+#include <map>
 #include <vector>
 #include <fstream>
 #include <assert.h>
@@ -7,6 +8,9 @@
 // Utilities header
 #include<Utilities.h>
 #include <Math/Math.h>
+#include <Time/Time.h>
+#include <JobSystem/JobSystem.h>
+#include <OctreeFile/OctreeFile.h>
 
 #include "OctreeGenerator.h"
 
@@ -20,12 +24,31 @@ namespace Tools
 {
 	namespace OctreeGenerator
 	{
-		typedef struct _s_triangle_data_
+		class OctreeNode;
+
+		// A triangle referenced by a node, with its bounds clipped to the box of that node
+		typedef struct _s_reference_
+		{
+			UINT32 u32Triangle;
+			D3DXVECTOR3 vMin;
+			D3DXVECTOR3 vMax;
+		} S_REFERENCE;
+
+		typedef struct _s_build_job_
+		{
+			OctreeNode *node;
+			std::vector<S_REFERENCE> references;
+			UINT8 u8Depth;
+		} S_BUILD_JOB;
+
+		typedef struct _s_statistics_
 		{
-			Utilities::S_TRIANGLE triangle;
-			UINT8 octant;
-			bool bFitChildren;
-		} S_TRIANGLE_DATA;
+			// Surface area heuristic cost of a ray entering the root
+			float expectedCost;
+			UINT32 u32TotalNodes;
+			UINT32 u32TotalReferences;
+			UINT8 u8MaxDepth;
+		} S_STATISTICS;
 
 		class OctreeNode
 		{
@@ -33,32 +56,54 @@ namespace Tools
 
 			OctreeNode( OctreeNode *parent, const UINT8 &i_u8Octant );
 
-			static bool IsLastTwoTrianglePointsFit( const Utilities::S_TRIANGLE &i_triangle,
-				const D3DXVECTOR3 &i_maxDimension, const UINT8 &i_u8Octant, const float &i_octSize );
-			void InsertTriangleToThisNode( const Utilities::S_TRIANGLE &i_triangle, const UINT8 &i_u8Octant );
+			static UINT8 GetOverlappedOctants( const S_REFERENCE &i_reference, const D3DXVECTOR3 &i_center );
+			void GetOctantBounds( const UINT8 &i_u8Octant, D3DXVECTOR3 &o_vMin, D3DXVECTOR3 &o_vMax ) const;
 
 			public:
 				D3DXVECTOR3 m_maxDimension;
 				float m_octSize;
-				std::vector<S_TRIANGLE_DATA> *m_data;
+				std::vector<UINT32> *m_data;
 				OctreeNode *m_children[Utilities::E_OCTANT_TOTAL];
 				OctreeNode *m_parent;
 
 				OctreeNode( const float &i_octSize, const D3DXVECTOR3 &i_maxDimension );
 				~OctreeNode( void );
 
-				void InsertTriangle( const Utilities::S_TRIANGLE &i_triangle );
-				void Save( std::ofstream &o_octTreeFile
+				void Build( std::vector<S_REFERENCE> &io_references, const UINT8 &i_u8Depth );
+				void GetStatistics( S_STATISTICS &io_statistics, const float &i_rootSize, const UINT8 &i_u8Depth ) const;
+				UINT32 Save( std::vector<Utilities::OctreeFile::S_NODE> &io_nodes, std::vector<Utilities::OctreeFile::S_VERTEX> &io_vertices,
+					std::vector<Utilities::OctreeFile::S_TRIANGLE> &io_triangles, std::vector<Utilities::StringHash> &io_tags
 				#ifdef OUTPUT_OCTREE_TXT
 					, std::ofstream &o_octTreeTxtFile
 				#endif	// #ifdef OUTPUT_OCTREE_TXT
 					);
 		};
 
-		const UINT8 MIN_DATA_IN_NODE = 24;
+		const UINT32 DEFAULT_MAX_LEAF_TRIANGLES = 24;
+		const UINT8 DEFAULT_MAX_DEPTH = 16;
+		// Relative costs of testing a node box and a triangle
+		const float TRAVERSAL_COST = 1.0f;
+		const float INTERSECTION_COST = 1.0f;
+		// A child cube has a quarter of the surface area of its parent, so a ray entering the parent enters it
+		// with that probability
+		const float CHILD_AREA_RATIO = 0.25f;
+		// Smaller subtrees are built on the thread of their parent
+		const UINT32 MIN_PARALLEL_REFERENCES = 1024;
+		const UINT32 BOUND_GRAIN_SIZE = 4096;
+
 		D3DXVECTOR3 maxDimension;
 		std::vector<Utilities::S_TRIANGLE> *triangleDatabase = NULL;
 		OctreeNode *root;
+		UINT32 u32MaxLeafTriangles = DEFAULT_MAX_LEAF_TRIANGLES;
+		UINT8 u8MaxDepth = DEFAULT_MAX_DEPTH;
+
+		static void BoundTrianglesJob( void *i_data, const UINT32 &i_u32Begin, const UINT32 &i_u32End );
+		static void BuildJob( void *i_data, const UINT32 &i_u32Begin, const UINT32 &i_u32End );
+		static void WritePadding( std::ofstream &o_file, const UINT32 &i_u32Offset );
+		static bool QuantizeTriangles( const std::vector<UINT32> &i_data, Utilities::OctreeFile::S_NODE &io_node,
+			std::vector<Utilities::OctreeFile::S_VERTEX> &io_vertices, std::vector<Utilities::OctreeFile::S_TRIANGLE> &io_triangles,
+			std::vector<Utilities::StringHash> &io_tags );
+		static UINT16 QuantizeCoordinate( const float &i_value, const float &i_origin, const float &i_scale );
 #ifdef OUTPUT_OCTREE_TXT
 		UINT32 u32TotalOctreeData = 0;
 #endif	// #ifdef OUTPUT_OCTREE_TXT
@@ -108,6 +153,12 @@ void Tools::OctreeGenerator::SetMaxSize( const float &i_maxX, const float &i_max
 		maxDimension.z = abs(i_maxZ);
 }
 
+void Tools::OctreeGenerator::SetLeafSize( const UINT32 &i_u32MaxTriangles, const UINT8 &i_u8MaxDepth )
+{
+	u32MaxLeafTriangles = i_u32MaxTriangles;
+	u8MaxDepth = i_u8MaxDepth;
+}
+
 void Tools::OctreeGenerator::GenerateOctree( const char *i_sourceName )
 {
 	FbxString octreeFileName = "../../External/Data/Scenes/" + FbxString(i_sourceName) + FbxString( "Octree.txt" );
@@ -159,11 +210,9 @@ void Tools::OctreeGenerator::GenerateOctree( const char *i_sourceName )
 	size *= 2.0f;
 	root = new OctreeNode( size, maxDimension );
 
+#ifdef OUTPUT_TRIANGLE_LIST
 	for( UINT32 i = 0; i < totalTriangles; i++ )
 	{
-		root->InsertTriangle( triangleDatabase->at(i) );
-
-#ifdef OUTPUT_TRIANGLE_LIST
 		debugFile << "{" << std::endl;
 		debugFile << "     " << triangleDatabase->at(i).a.x << ", " << triangleDatabase->at(i).a.y << ", " \
 			<< triangleDatabase->at(i).a.z << std::endl;
@@ -172,14 +221,73 @@ void Tools::OctreeGenerator::GenerateOctree( const char *i_sourceName )
 		debugFile << "     " << triangleDatabase->at(i).c.x << ", " << triangleDatabase->at(i).c.y << ", " \
 			<< triangleDatabase->at(i).c.z << std::endl;
 		debugFile << "}" << std::endl;
-#endif	// #ifdef OUTPUT_TRIANGLE_LIST
 	}
+#endif	// #ifdef OUTPUT_TRIANGLE_LIST
 
-	root->Save( octreeFile
+	// Every triangle is placed by its whole bounds, the subtrees are built in parallel
+	Utilities::Time::Initialize();
+	Utilities::TICK buildStart = Utilities::Time::GetCurrentTick();
+	std::vector<S_REFERENCE> references( totalTriangles );
+	S_STATISTICS statistics = { 0.0f, 0, 0, 0 };
+
+	Utilities::JobSystem::Initialize();
+	Utilities::JobSystem::ParallelFor( BoundTrianglesJob, &references, totalTriangles, BOUND_GRAIN_SIZE );
+	root->Build( references, 0 );
+	Utilities::JobSystem::ShutDown();
+
+	root->GetStatistics( statistics, root->m_octSize, 0 );
+	FBXSDK_printf( "Octree of %s: %u triangles, %u nodes, max depth %u, duplicate ratio %.3f, expected traversal cost %.2f, built in %u ms\n",
+		i_sourceName, totalTriangles, statistics.u32TotalNodes, statistics.u8MaxDepth,
+		totalTriangles ? static_cast<float>(statistics.u32TotalReferences) / totalTriangles : 0.0f, statistics.expectedCost,
+		Utilities::Time::GetDifferenceTick_ms(buildStart, Utilities::Time::GetCurrentTick()) );
+
+	std::vector<Utilities::OctreeFile::S_NODE> nodes;
+	std::vector<Utilities::OctreeFile::S_VERTEX> vertices;
+	std::vector<Utilities::OctreeFile::S_TRIANGLE> triangles;
+	std::vector<Utilities::StringHash> tags;
+	if( root->Save(nodes, vertices, triangles, tags
 #ifdef OUTPUT_OCTREE_TXT
 		, octreeTxtFile
 #endif	// #ifdef OUTPUT_OCTREE_TXT
-		);
+		) == Utilities::OctreeFile::NO_NODE )
+	{
+		FBXSDK_printf( "Error: A node of %s has more than %u vertices or tags\n", octreeFileName.Buffer(), Utilities::OctreeFile::MAX_QUANTIZED + 1 );
+		octreeFile.close();
+		return;
+	}
+
+	// Header, node array, vertex block, triangle block then tag block, each of them starts on the file alignment
+	Utilities::OctreeFile::S_HEADER header;
+	UINT32 u32Offset = Utilities::OctreeFile::AlignOffset( sizeof(header) );
+
+	header.u32Magic = Utilities::OctreeFile::MAGIC;
+	header.u32Version = Utilities::OctreeFile::VERSION;
+	header.u32Alignment = Utilities::OctreeFile::ALIGNMENT;
+	header.node.u32Offset = u32Offset;
+	header.node.u32Total = nodes.size();
+	u32Offset = Utilities::OctreeFile::AlignOffset( u32Offset + nodes.size() * sizeof(Utilities::OctreeFile::S_NODE) );
+	header.vertex.u32Offset = u32Offset;
+	header.vertex.u32Total = vertices.size();
+	u32Offset = Utilities::OctreeFile::AlignOffset( u32Offset + vertices.size() * sizeof(Utilities::OctreeFile::S_VERTEX) );
+	header.triangle.u32Offset = u32Offset;
+	header.triangle.u32Total = triangles.size();
+	u32Offset = Utilities::OctreeFile::AlignOffset( u32Offset + triangles.size() * sizeof(Utilities::OctreeFile::S_TRIANGLE) );
+	header.tag.u32Offset = u32Offset;
+	header.tag.u32Total = tags.size();
+	header.u32FileSize = u32Offset + tags.size() * sizeof( Utilities::StringHash );
+
+	octreeFile.write( reinterpret_cast<const char*> (&header), sizeof(header) );
+	WritePadding( octreeFile, header.node.u32Offset );
+	octreeFile.write( reinterpret_cast<const char*> (&nodes[0]), nodes.size() * sizeof(Utilities::OctreeFile::S_NODE) );
+	WritePadding( octreeFile, header.vertex.u32Offset );
+	if( !vertices.empty() )
+		octreeFile.write( reinterpret_cast<const char*> (&vertices[0]), vertices.size() * sizeof(Utilities::OctreeFile::S_VERTEX) );
+	WritePadding( octreeFile, header.triangle.u32Offset );
+	if( !triangles.empty() )
+		octreeFile.write( reinterpret_cast<const char*> (&triangles[0]), triangles.size() * sizeof(Utilities::OctreeFile::S_TRIANGLE) );
+	WritePadding( octreeFile, header.tag.u32Offset );
+	if( !tags.empty() )
+		octreeFile.write( reinterpret_cast<const char*> (&tags[0]), tags.size() * sizeof(Utilities::StringHash) );
 
 	octreeFile.close();
 
@@ -192,6 +300,137 @@ void Tools::OctreeGenerator::GenerateOctree( const char *i_sourceName )
 #endif	// #ifdef OUTPUT_TRIANGLE_LIST
 }
 
+// Bounds of the triangles [i_u32Begin, i_u32End), clipped to the root box
+void Tools::OctreeGenerator::BoundTrianglesJob( void *i_data, const UINT32 &i_u32Begin, const UINT32 &i_u32End )
+{
+	std::vector<S_REFERENCE> &references = *reinterpret_cast<std::vector<S_REFERENCE> *>( i_data );
+	float rootSize = 2.0f * root->m_octSize;
+	D3DXVECTOR3 vRootMin( root->m_maxDimension.x - rootSize, root->m_maxDimension.y - rootSize, root->m_maxDimension.z - rootSize );
+
+	for( UINT32 i = i_u32Begin; i < i_u32End; i++ )
+	{
+		const Utilities::S_TRIANGLE &triangle = triangleDatabase->at( i );
+		S_REFERENCE &reference = references[i];
+
+		reference.u32Triangle = i;
+		D3DXVec3Minimize( &reference.vMin, &triangle.a, &triangle.b );
+		D3DXVec3Minimize( &reference.vMin, &reference.vMin, &triangle.c );
+		D3DXVec3Maximize( &reference.vMax, &triangle.a, &triangle.b );
+		D3DXVec3Maximize( &reference.vMax, &reference.vMax, &triangle.c );
+		D3DXVec3Maximize( &reference.vMin, &reference.vMin, &vRootMin );
+		D3DXVec3Minimize( &reference.vMax, &reference.vMax, &root->m_maxDimension );
+	}
+}
+
+void Tools::OctreeGenerator::BuildJob( void *i_data, const UINT32 &i_u32Begin, const UINT32 &i_u32End )
+{
+	S_BUILD_JOB *job = reinterpret_cast<S_BUILD_JOB *>( i_data );
+
+	job->node->Build( job->references, job->u8Depth );
+}
+
+void Tools::OctreeGenerator::WritePadding( std::ofstream &o_file, const UINT32 &i_u32Offset )
+{
+	const char padding[Utilities::OctreeFile::ALIGNMENT] = { 0 };
+	UINT32 u32Position = static_cast<UINT32>( o_file.tellp() );
+
+	if( u32Position < i_u32Offset )
+		o_file.write( padding, i_u32Offset - u32Position );
+}
+
+// Vertices are quantized inside the bounds of the node triangles, equal quantized vertices and equal tags
+// are stored once per node
+bool Tools::OctreeGenerator::QuantizeTriangles( const std::vector<UINT32> &i_data, Utilities::OctreeFile::S_NODE &io_node,
+	std::vector<Utilities::OctreeFile::S_VERTEX> &io_vertices, std::vector<Utilities::OctreeFile::S_TRIANGLE> &io_triangles,
+	std::vector<Utilities::StringHash> &io_tags )
+{
+	const float steps = static_cast<float>( Utilities::OctreeFile::MAX_QUANTIZED );
+	std::map<UINT64, UINT16> vertexIndex;
+	D3DXVECTOR3 vMin( FLT_MAX, FLT_MAX, FLT_MAX );
+	D3DXVECTOR3 vMax( -FLT_MAX, -FLT_MAX, -FLT_MAX );
+
+	io_node.u32FirstVertex = io_vertices.size();
+	io_node.u32FirstTag = io_tags.size();
+	io_node.u32TotalVertices = 0;
+	io_node.u32TotalTags = 0;
+	io_node.vertexOrigin = D3DXVECTOR3( 0.0f, 0.0f, 0.0f );
+	io_node.vertexScale = D3DXVECTOR3( 0.0f, 0.0f, 0.0f );
+	if( i_data.empty() )
+		return true;
+
+	for( UINT32 i = 0; i < i_data.size(); i++ )
+	{
+		const Utilities::S_TRIANGLE &triangle = triangleDatabase->at( i_data[i] );
+		D3DXVec3Minimize( &vMin, &vMin, &triangle.a );
+		D3DXVec3Minimize( &vMin, &vMin, &triangle.b );
+		D3DXVec3Minimize( &vMin, &vMin, &triangle.c );
+		D3DXVec3Maximize( &vMax, &vMax, &triangle.a );
+		D3DXVec3Maximize( &vMax, &vMax, &triangle.b );
+		D3DXVec3Maximize( &vMax, &vMax, &triangle.c );
+	}
+	io_node.vertexOrigin = vMin;
+	io_node.vertexScale = (vMax - vMin) / steps;
+
+	for( UINT32 i = 0; i < i_data.size(); i++ )
+	{
+		const Utilities::S_TRIANGLE &triangle = triangleDatabase->at( i_data[i] );
+		const D3DXVECTOR3 *points[3] = { &triangle.a, &triangle.b, &triangle.c };
+		Utilities::OctreeFile::S_TRIANGLE newTriangle;
+
+		for( UINT8 j = 0; j < 3; j++ )
+		{
+			Utilities::OctreeFile::S_VERTEX newVertex;
+			newVertex.u16Position[0] = QuantizeCoordinate( points[j]->x, vMin.x, io_node.vertexScale.x );
+			newVertex.u16Position[1] = QuantizeCoordinate( points[j]->y, vMin.y, io_node.vertexScale.y );
+			newVertex.u16Position[2] = QuantizeCoordinate( points[j]->z, vMin.z, io_node.vertexScale.z );
+			newVertex.u16Padding = 0;
+
+			UINT64 u64Key = newVertex.u16Position[0] | (static_cast<UINT64>( newVertex.u16Position[1] ) << 16)
+				| (static_cast<UINT64>( newVertex.u16Position[2] ) << 32);
+			std::map<UINT64, UINT16>::const_iterator iter = vertexIndex.find( u64Key );
+			if( iter == vertexIndex.end() )
+			{
+				if( io_node.u32TotalVertices > Utilities::OctreeFile::MAX_QUANTIZED )
+					return false;
+
+				iter = vertexIndex.insert( std::make_pair(u64Key, static_cast<UINT16>(io_node.u32TotalVertices++)) ).first;
+				io_vertices.push_back( newVertex );
+			}
+			newTriangle.u16Vertices[j] = iter->second;
+		}
+
+		UINT32 u32Tag = 0;
+		while( (u32Tag < io_node.u32TotalTags)
+			&& (static_cast<UINT32>(io_tags[io_node.u32FirstTag + u32Tag]) != static_cast<UINT32>(triangle.hashedTag)) )
+			u32Tag++;
+		if( u32Tag == io_node.u32TotalTags )
+		{
+			if( io_node.u32TotalTags > Utilities::OctreeFile::MAX_QUANTIZED )
+				return false;
+
+			io_tags.push_back( triangle.hashedTag );
+			io_node.u32TotalTags++;
+		}
+		newTriangle.u16Tag = static_cast<UINT16>( u32Tag );
+
+		io_triangles.push_back( newTriangle );
+	}
+
+	return true;
+}
+
+UINT16 Tools::OctreeGenerator::QuantizeCoordinate( const float &i_value, const float &i_origin, const float &i_scale )
+{
+	if( i_scale <= 0.0f )
+		return 0;
+
+	float quantized = (i_value - i_origin) / i_scale + 0.5f;
+	if( quantized >= static_cast<float>(Utilities::OctreeFile::MAX_QUANTIZED) )
+		return static_cast<UINT16>( Utilities::OctreeFile::MAX_QUANTIZED );
+
+	return quantized > 0.0f ? static_cast<UINT16>( quantized ) : 0;
+}
+
 /****************************************************************************************************
 			OctreeNode class public functions implementation
 ****************************************************************************************************/
@@ -202,7 +441,7 @@ Tools::OctreeGenerator::OctreeNode::OctreeNode( const float &i_octSize, const D3
 	m_data( NULL ),
 	_bHasChildren( FALSE )
 {
-	m_data = new std::vector<S_TRIANGLE_DATA>;
+	m_data = new std::vector<UINT32>;
 
 	for( UINT8 i = 0; i < Utilities::E_OCTANT_TOTAL; i++ )
 		m_children[i] = NULL;
@@ -229,45 +468,152 @@ Tools::OctreeGenerator::OctreeNode::~OctreeNode( void )
 	}
 }
 
-void Tools::OctreeGenerator::OctreeNode::InsertTriangle( const Utilities::S_TRIANGLE &i_triangle )
+// Bin the references into the octants their bounds overlap, then split if the surface area heuristic
+// expects it to be cheaper than keeping a leaf. io_references is released once it is binned
+void Tools::OctreeGenerator::OctreeNode::Build( std::vector<S_REFERENCE> &io_references, const UINT8 &i_u8Depth )
 {
-	UINT8 octant = 0;
+	D3DXVECTOR3 vCenter( m_maxDimension.x - m_octSize, m_maxDimension.y - m_octSize, m_maxDimension.z - m_octSize );
+	std::vector<UINT8> octants( io_references.size() );
+	UINT32 u32ChildReferences[Utilities::E_OCTANT_TOTAL] = { 0 };
+	UINT32 u32KeptReferences = 0;
+	bool bSplit = false;
 
-	if( i_triangle.a.y < (maxDimension.y - m_octSize) )
-		octant += 4;
+	for( UINT32 i = 0; i < io_references.size(); i++ )
+	{
+		UINT8 u8Octants = GetOverlappedOctants( io_references[i], vCenter );
+		UINT8 u8TotalOctants = 0;
 
-	if( i_triangle.a.z < (maxDimension.z - m_octSize) )
-		octant += 2;
+		for( UINT8 j = 0; j < Utilities::E_OCTANT_TOTAL; j++ )
+			u8TotalOctants += (u8Octants >> j) & 1;
 
-	if( i_triangle.a.x < (maxDimension.x - m_octSize) )
-		octant += 1;
+		// A triangle across a split plane is copied to the children only if the rays entering them are
+		// expected to test it less often than the rays entering this node
+		if( (u8TotalOctants * CHILD_AREA_RATIO) < 1.0f )
+		{
+			for( UINT8 j = 0; j < Utilities::E_OCTANT_TOTAL; j++ )
+				u32ChildReferences[j] += (u8Octants >> j) & 1;
+		}
+		else
+		{
+			u8Octants = 0;
+			u32KeptReferences++;
+		}
+		octants[i] = u8Octants;
+	}
 
-	if( !IsLastTwoTrianglePointsFit(i_triangle, m_maxDimension, octant, m_octSize) )
+	if( (io_references.size() > u32MaxLeafTriangles) && (i_u8Depth < u8MaxDepth) )
 	{
-		S_TRIANGLE_DATA newData = { i_triangle, octant, false };
-		m_data->push_back( newData );
+		float splitCost = TRAVERSAL_COST + INTERSECTION_COST * u32KeptReferences;
+
+		for( UINT8 i = 0; i < Utilities::E_OCTANT_TOTAL; i++ )
+		{
+			if( u32ChildReferences[i] )
+				splitCost += CHILD_AREA_RATIO * (TRAVERSAL_COST + INTERSECTION_COST * u32ChildReferences[i]);
+		}
+		bSplit = splitCost < (INTERSECTION_COST * io_references.size());
 	}
-	else
+
+	if( !bSplit )
+	{
+		m_data->reserve( io_references.size() );
+		for( UINT32 i = 0; i < io_references.size(); i++ )
+			m_data->push_back( io_references[i].u32Triangle );
+		std::vector<S_REFERENCE>().swap( io_references );
+		return;
+	}
+
+	S_BUILD_JOB jobs[Utilities::E_OCTANT_TOTAL];
+	D3DXVECTOR3 vOctantMin[Utilities::E_OCTANT_TOTAL];
+	D3DXVECTOR3 vOctantMax[Utilities::E_OCTANT_TOTAL];
+
+	m_data->reserve( u32KeptReferences );
+	for( UINT8 i = 0; i < Utilities::E_OCTANT_TOTAL; i++ )
 	{
-		if( m_children[octant] != NULL )
-			m_children[octant]->InsertTriangle( i_triangle );
+		jobs[i].references.reserve( u32ChildReferences[i] );
+		GetOctantBounds( i, vOctantMin[i], vOctantMax[i] );
+	}
+
+	for( UINT32 i = 0; i < io_references.size(); i++ )
+	{
+		if( octants[i] == 0 )
+		{
+			m_data->push_back( io_references[i].u32Triangle );
+			continue;
+		}
+
+		for( UINT8 j = 0; j < Utilities::E_OCTANT_TOTAL; j++ )
+		{
+			if( octants[i] & (1 << j) )
+			{
+				S_REFERENCE childReference = io_references[i];
+				D3DXVec3Maximize( &childReference.vMin, &childReference.vMin, &vOctantMin[j] );
+				D3DXVec3Minimize( &childReference.vMax, &childReference.vMax, &vOctantMax[j] );
+				jobs[j].references.push_back( childReference );
+			}
+		}
+	}
+	std::vector<S_REFERENCE>().swap( io_references );
+
+	Utilities::JobSystem::JobCounter counter = 0;
+	for( UINT8 i = 0; i < Utilities::E_OCTANT_TOTAL; i++ )
+	{
+		if( jobs[i].references.empty() )
+			continue;
+
+		_bHasChildren = true;
+		m_children[i] = new OctreeNode( this, i );
+		jobs[i].node = m_children[i];
+		jobs[i].u8Depth = i_u8Depth + 1;
+		if( jobs[i].references.size() >= MIN_PARALLEL_REFERENCES )
+			Utilities::JobSystem::Run( BuildJob, &jobs[i], counter );
 		else
-			InsertTriangleToThisNode( i_triangle, octant );
+			m_children[i]->Build( jobs[i].references, jobs[i].u8Depth );
 	}
+	Utilities::JobSystem::WaitForCounter( counter );
 }
 
-void Tools::OctreeGenerator::OctreeNode::Save( std::ofstream &o_octreeFile
+// Accumulate the node count, triangle references, depth and expected cost of this subtree
+void Tools::OctreeGenerator::OctreeNode::GetStatistics( S_STATISTICS &io_statistics, const float &i_rootSize,
+	const UINT8 &i_u8Depth ) const
+{
+	float areaRatio = (m_octSize / i_rootSize) * (m_octSize / i_rootSize);
+
+	io_statistics.expectedCost += areaRatio * (TRAVERSAL_COST + INTERSECTION_COST * m_data->size());
+	io_statistics.u32TotalNodes++;
+	io_statistics.u32TotalReferences += m_data->size();
+	if( i_u8Depth > io_statistics.u8MaxDepth )
+		io_statistics.u8MaxDepth = i_u8Depth;
+
+	for( UINT8 i = 0; i < Utilities::E_OCTANT_TOTAL; i++ )
+	{
+		if( m_children[i] )
+			m_children[i]->GetStatistics( io_statistics, i_rootSize, i_u8Depth + 1 );
+	}
+}
+
+// Append this node and its subtree depth first, every node refers to its children, vertices, triangles and
+// tags by index. Returns NO_NODE if a node has too many vertices or tags to be quantized
+UINT32 Tools::OctreeGenerator::OctreeNode::Save( std::vector<Utilities::OctreeFile::S_NODE> &io_nodes,
+	std::vector<Utilities::OctreeFile::S_VERTEX> &io_vertices, std::vector<Utilities::OctreeFile::S_TRIANGLE> &io_triangles,
+	std::vector<Utilities::StringHash> &io_tags
 #ifdef OUTPUT_OCTREE_TXT
 	, std::ofstream &o_octreeTxtFile
 #endif	// #ifdef OUTPUT_OCTREE_TXT
 	)
 {
 	UINT32 u32DataSize = m_data->size();
+	UINT32 u32Node = io_nodes.size();
+	Utilities::OctreeFile::S_NODE newNode;
 
-	o_octreeFile.write( reinterpret_cast<const char*> (&m_octSize), sizeof(m_octSize) );
-	o_octreeFile.write( reinterpret_cast<const char*> (&m_maxDimension), sizeof(m_maxDimension) );
-	o_octreeFile.write( reinterpret_cast<const char*> (&u32DataSize), sizeof(u32DataSize) );
-	o_octreeFile.write( reinterpret_cast<const char*> (&_bHasChildren), sizeof(_bHasChildren) );
+	newNode.maxDimension = m_maxDimension;
+	newNode.size = m_octSize;
+	newNode.u32StartIndex = io_triangles.size();
+	newNode.u32TotalData = u32DataSize;
+	for( UINT8 i = 0; i < Utilities::E_OCTANT_TOTAL; i++ )
+		newNode.u32Children[i] = Utilities::OctreeFile::NO_NODE;
+	if( !QuantizeTriangles(*m_data, newNode, io_vertices, io_triangles, io_tags) )
+		return Utilities::OctreeFile::NO_NODE;
+	io_nodes.push_back( newNode );
 
 #ifdef OUTPUT_OCTREE_TXT
 	u32TotalOctreeData += u32DataSize;
@@ -278,21 +624,21 @@ void Tools::OctreeGenerator::OctreeNode::Save( std::ofstream &o_octreeFile
 	o_octreeTxtFile << "Has children: " << _bHasChildren << std::endl;
 #endif	// #ifdef OUTPUT_OCTREE_TXT
 
+#ifdef OUTPUT_OCTREE_TXT
 	for( UINT32 i = 0; i < u32DataSize; i++ )
 	{
-		o_octreeFile.write( reinterpret_cast<const char*> (&m_data->at(i).triangle), sizeof(m_data->at(i).triangle) );
-#ifdef OUTPUT_OCTREE_TXT
+		const Utilities::S_TRIANGLE &triangle = triangleDatabase->at( m_data->at(i) );
 		o_octreeTxtFile << "{" << std::endl;
-		o_octreeTxtFile << "    " << m_data->at(i).triangle.a.x << ", " << m_data->at(i).triangle.a.y << ", " \
-			<< m_data->at(i).triangle.a.z << std::endl;
-		o_octreeTxtFile << "    " << m_data->at(i).triangle.b.x << ", " << m_data->at(i).triangle.b.y << ", " \
-			<< m_data->at(i).triangle.b.z << std::endl;
-		o_octreeTxtFile << "    " << m_data->at(i).triangle.c.x << ", " << m_data->at(i).triangle.c.y << ", " \
-			<< m_data->at(i).triangle.c.z << std::endl;
-		o_octreeTxtFile << "    " << m_data->at(i).triangle.hashedTag << std::endl;
+		o_octreeTxtFile << "    " << triangle.a.x << ", " << triangle.a.y << ", " \
+			<< triangle.a.z << std::endl;
+		o_octreeTxtFile << "    " << triangle.b.x << ", " << triangle.b.y << ", " \
+			<< triangle.b.z << std::endl;
+		o_octreeTxtFile << "    " << triangle.c.x << ", " << triangle.c.y << ", " \
+			<< triangle.c.z << std::endl;
+		o_octreeTxtFile << "    " << triangle.hashedTag << std::endl;
 		o_octreeTxtFile << "}" << std::endl;
-#endif	// #ifdef OUTPUT_OCTREE_TXT
 	}
+#endif	// #ifdef OUTPUT_OCTREE_TXT
 
 	if( _bHasChildren )
 	{
@@ -300,22 +646,26 @@ void Tools::OctreeGenerator::OctreeNode::Save( std::ofstream &o_octreeFile
 		{
 			if( m_children[i] != NULL )
 			{
-				m_children[i]->Save( o_octreeFile
+				// The node array grows while the child is saved, so the node is indexed again
+				UINT32 u32Child = m_children[i]->Save( io_nodes, io_vertices, io_triangles, io_tags
 				#ifdef OUTPUT_OCTREE_TXT
 					, o_octreeTxtFile
 				#endif	// #ifdef OUTPUT_OCTREE_TXT
 					);
+				if( u32Child == Utilities::OctreeFile::NO_NODE )
+					return Utilities::OctreeFile::NO_NODE;
+				io_nodes[u32Node].u32Children[i] = u32Child;
 			}
 			else
 			{
-				float size = 0.0f;
-				o_octreeFile.write( reinterpret_cast<const char*> (&size), sizeof(size) );
 			#ifdef OUTPUT_OCTREE_TXT
 				o_octreeTxtFile << "Node " << static_cast<UINT32>(i) << ": 0 " << std::endl;
 			#endif	// #ifdef OUTPUT_OCTREE_TXT
 			}
 		}
 	}
+
+	return u32Node;
 }
 
 /****************************************************************************************************
@@ -334,7 +684,7 @@ Tools::OctreeGenerator::OctreeNode::OctreeNode( OctreeNode *i_parent, const UINT
 	bool bLargerY = true;
 	bool bLargerZ = true;
 
-	m_data = new std::vector<S_TRIANGLE_DATA>;
+	m_data = new std::vector<UINT32>;
 
 	for( UINT8 i = 0; i < Utilities::E_OCTANT_TOTAL; i++ )
 		m_children[i] = NULL;
@@ -375,115 +725,42 @@ Tools::OctreeGenerator::OctreeNode::OctreeNode( OctreeNode *i_parent, const UINT
 	m_octSize = parentOctSize / 2;
 }
 
-void Tools::OctreeGenerator::OctreeNode::InsertTriangleToThisNode( const Utilities::S_TRIANGLE &i_triangle, 
-	const UINT8 &i_u8Octant )
+// Box of an octant of this node, octants below the center have the bit 4 for y, 2 for z and 1 for x
+void Tools::OctreeGenerator::OctreeNode::GetOctantBounds( const UINT8 &i_u8Octant, D3DXVECTOR3 &o_vMin,
+	D3DXVECTOR3 &o_vMax ) const
 {
-	if( _bHasChildren )
-	{
-		m_children[i_u8Octant] = new OctreeNode( this, i_u8Octant );
-		m_children[i_u8Octant]->InsertTriangle( i_triangle );
-	}
-	else
-	{
-		S_TRIANGLE_DATA newData = { i_triangle, i_u8Octant, true };
-		m_data->push_back( newData );
-
-		if( m_data->size() > MIN_DATA_IN_NODE )
-		{
-			std::vector<S_TRIANGLE_DATA> *newData = new std::vector<S_TRIANGLE_DATA>;
-			for( UINT32 i = 0; i < m_data->size(); i++ )
-			{
-				if( m_data->at(i).bFitChildren )
-				{
-					if( m_children[m_data->at(i).octant] == NULL )
-						m_children[m_data->at(i).octant] = new OctreeNode( this, m_data->at(i).octant );
-					_bHasChildren = true;
-					m_children[m_data->at(i).octant]->InsertTriangle( m_data->at(i).triangle );
-				}
-				else
-				{
-					newData->push_back( m_data->at(i) );
-				}
-			}
-
-			m_data->clear();
-			for( UINT32 i = 0; i < newData->size(); i++ )
-				m_data->push_back( newData->at(i) );
-
-			delete newData;
-		}
-	}
+	assert( i_u8Octant < Utilities::E_OCTANT_TOTAL );
+
+	o_vMax = m_maxDimension;
+	if( i_u8Octant & 4 )
+		o_vMax.y -= m_octSize;
+	if( i_u8Octant & 2 )
+		o_vMax.z -= m_octSize;
+	if( i_u8Octant & 1 )
+		o_vMax.x -= m_octSize;
+	o_vMin = D3DXVECTOR3( o_vMax.x - m_octSize, o_vMax.y - m_octSize, o_vMax.z - m_octSize );
 }
 
 /****************************************************************************************************
 			OctreeNode class static functions implementation
 ****************************************************************************************************/
-bool Tools::OctreeGenerator::OctreeNode::IsLastTwoTrianglePointsFit( const Utilities::S_TRIANGLE &i_triangle,
-	const D3DXVECTOR3 &i_maxDimension, const UINT8 &i_u8Octant, const float &i_octSize )
+// Mask of the octants overlapped by the bounds of a reference, bit i is set for octant i
+UINT8 Tools::OctreeGenerator::OctreeNode::GetOverlappedOctants( const S_REFERENCE &i_reference, const D3DXVECTOR3 &i_center )
 {
-	float octMinRange = 0.0f;
-	float octMaxRange = 0.0f;
-	UINT8 u8Octant = i_u8Octant;
-	bool bLargerX = true;
-	bool bLargerY = true;
-	bool bLargerZ = true;
-
-	assert( u8Octant < Utilities::E_OCTANT_TOTAL );
+	// A bounds lying on a split plane is placed below it
+	bool bUpperX = i_reference.vMax.x > i_center.x;
+	bool bUpperY = i_reference.vMax.y > i_center.y;
+	bool bUpperZ = i_reference.vMax.z > i_center.z;
+	bool bLowerX = (i_reference.vMin.x < i_center.x) || !bUpperX;
+	bool bLowerY = (i_reference.vMin.y < i_center.y) || !bUpperY;
+	bool bLowerZ = (i_reference.vMin.z < i_center.z) || !bUpperZ;
+	UINT8 u8Octants = 0;
 
-	if( u8Octant >= 4 )
-	{
-		u8Octant -= 4;
-		bLargerY = false;
-	}
-
-	if( u8Octant >= 2 )
+	for( UINT8 i = 0; i < Utilities::E_OCTANT_TOTAL; i++ )
 	{
-		u8Octant -= 2;
-		bLargerZ = false;
+		if( ((i & 4) ? bLowerY : bUpperY) && ((i & 2) ? bLowerZ : bUpperZ) && ((i & 1) ? bLowerX : bUpperX) )
+			u8Octants |= 1 << i;
 	}
 
-	if( u8Octant >= 1 )
-		bLargerX = false;
-
-	// Get the x range
-	if( bLargerX )
-		octMaxRange = i_maxDimension.x;
-	else
-		octMaxRange = i_maxDimension.x - i_octSize;
-	octMinRange = octMaxRange - i_octSize;
-
-	// If either of the x not within the range
-	if( (i_triangle.b.x > octMaxRange) || (i_triangle.b.x < octMinRange)
-		|| (i_triangle.c.x > octMaxRange) || (i_triangle.c.x < octMinRange)
-		)
-		return false;
-
-	// Get the y range
-	if( bLargerY )
-		octMaxRange = i_maxDimension.y;
-	else
-		octMaxRange = i_maxDimension.y - i_octSize;
-	octMinRange = octMaxRange - i_octSize;
-
-	// If either of the y not within the range
-	if( (i_triangle.b.y > octMaxRange) || (i_triangle.b.y < octMinRange)
-		|| (i_triangle.c.y > octMaxRange) || (i_triangle.c.y < octMinRange)
-		)
-		return false;
-
-	// Get the z range
-	if( bLargerZ )
-		octMaxRange = i_maxDimension.z;
-	else
-		octMaxRange = i_maxDimension.z - i_octSize;
-	octMinRange = octMaxRange - i_octSize;
-
-	// If either of the z not within the range
-	if( (i_triangle.b.z > octMaxRange) || (i_triangle.b.z < octMinRange)
-		|| (i_triangle.c.z > octMaxRange) || (i_triangle.c.z < octMinRange)
-		)
-		return false;
-
-	return true;
+	return u8Octants;
 }
-
@@ -13,6 +13,8 @@ namespace Tools
 		void AddTriangle( const D3DXVECTOR3 &i_a, const D3DXVECTOR3 &i_b, const D3DXVECTOR3 &i_c, \
 			Utilities::StringHash &i_hashedTag );
 		void SetMaxSize( const float &i_maxX, const float &i_maxY, const float &i_maxZ );
+		// A node is split only while it has more than i_u32MaxTriangles and is shallower than i_u8MaxDepth
+		void SetLeafSize( const UINT32 &i_u32MaxTriangles, const UINT8 &i_u8MaxDepth );
 		void GenerateOctree( const char *i_sourceName );
 	}
 }
@@ -55,7 +55,7 @@ void CameraController::Update( GameEngine::Entity &i_entity )
 		//D3DXVec3Cross( &direction, &i_entity.m_vLookAt, &GameEngine::D3DXVECTOR3_UP );
 		D3DXVec3Normalize( &direction, &direction );
 
-		i_entity.m_v3Velocity = -direction;
+		i_entity.SetVelocity( -direction );
 	}
 	else if( GameEngine::UserInput::IsKeyPressed(VK_LEFT) )
 	{
@@ -64,22 +64,22 @@ void CameraController::Update( GameEngine::Entity &i_entity )
 		//D3DXVec3Cross( &direction, &i_entity.m_vLookAt, &GameEngine::D3DXVECTOR3_UP );
 		D3DXVec3Normalize( &direction, &direction );
 
-		i_entity.m_v3Velocity = direction;
+		i_entity.SetVelocity( direction );
 	}
 
 	if( GameEngine::UserInput::IsKeyPressed(VK_UP) )
 	{
 		bPlayerMove = true;
-		i_entity.m_v3Velocity = g_world::Get().m_camera->GetViewDirection();
+		i_entity.SetVelocity( g_world::Get().m_camera->GetViewDirection() );
 	}
 	else if( GameEngine::UserInput::IsKeyPressed(VK_DOWN) )
 	{
 		bPlayerMove = true;
-		i_entity.m_v3Velocity = -g_world::Get().m_camera->GetViewDirection();
+		i_entity.SetVelocity( -g_world::Get().m_camera->GetViewDirection() );
 	}
 
 	if( !bPlayerMove )
 	{
-		i_entity.m_v3Velocity = GameEngine::Math::Vector3::Zero;
+		i_entity.SetVelocity( GameEngine::Math::Vector3::Zero );
 	}
 }
@@ -664,26 +664,15 @@ void GamePanel::OnLeftClick( wxMouseEvent &i_event )
 	UINT32 u32Index = 0;
 	float prevCollisionDistance = 0.0f;
 	bool bRayTracingResult = false;
-	bool bSelectableEntityFound = false;
 	float collisionDistance = 0.0f;
 	for( iter = _selectableEntities->begin(); iter != _selectableEntities->end(); ++iter )
 	{
-		D3DXVECTOR3 collisionPoint;
+		Utilities::Math::S_RAY_HIT hit;
+		hit.distance = 1.0f;
 		bRayTracingResult = false;
-		UINT32 u32TotalIndices = (*iter)->m_u32TotalPrimitives * 3;
-		for( UINT32 i = 0; i < u32TotalIndices; i += 3 )
-		{
-			bRayTracingResult |= Utilities::Math::RayTracing( startPoint, endPoint,\
-				(*iter)->m_vertices[(*iter)->m_u16Indices[i]],\
-				(*iter)->m_vertices[(*iter)->m_u16Indices[i+1]],\
-				(*iter)->m_vertices[(*iter)->m_u16Indices[i+2]],\
-				bSelectableEntityFound, collisionPoint, collisionDistance );
-			if( bRayTracingResult )
-			{
-				if( !bSelectableEntityFound )
-					bSelectableEntityFound = true;
-			}
-		}
+		for( UINT32 i = 0; i < (*iter)->m_trianglePackets->size(); ++i )
+			bRayTracingResult |= Utilities::Math::RayTracing( startPoint, endPoint, (*iter)->m_trianglePackets->at(i), hit );
+		collisionDistance = hit.distance;
 
 		if( bRayTracingResult )
 		{
@@ -709,8 +698,9 @@ void GamePanel::OnLeftClick( wxMouseEvent &i_event )
 	else if( _u32SelectedEntityIndex < _selectableEntities->size() )
 	{
 		m_bEntitySelected = true;
-		float originalPosition = _selectableEntities->at(_u32SelectedEntityIndex)->m_entity->m_v3Position.Y();
-		_selectableEntities->at(_u32SelectedEntityIndex)->m_entity->m_v3Position.Y( originalPosition + 50.0f );
+		GameEngine::Math::Vector3 v3Position = _selectableEntities->at(_u32SelectedEntityIndex)->m_entity->m_v3Position;
+		v3Position.Y( v3Position.Y() + 50.0f );
+		_selectableEntities->at(_u32SelectedEntityIndex)->m_entity->SetPosition( v3Position );
 
 		// Fill in the entity property page
 		_workingPanel->SetEntityName( *_selectedEntityName );
@@ -1043,7 +1033,7 @@ bool GamePanel::CreateEntities( const std::string &i_filename )
 		tempEntity->m_applyPhysics = false;
 		tempEntity->m_u32CollisionMask = 0;
 		tempEntity->m_orientation = scene.m_entity[i].orientation;
-		tempEntity->m_v3Position = position;
+		tempEntity->SetPosition( position );
 
 		Utilities::MeshParser mesh( scene.m_entity[i].file.c_str() );
 		if( mesh.m_tag )
@@ -1084,8 +1074,9 @@ void GamePanel::UnselectEntity( void )
 		_workingPanel->ResetEntityPropertyPage();
 
 		// Unselect it
-		float originalPosition = _selectableEntities->at(_u32SelectedEntityIndex)->m_entity->m_v3Position.Y();
-		_selectableEntities->at(_u32SelectedEntityIndex)->m_entity->m_v3Position.Y( originalPosition - 50.0f );
+		GameEngine::Math::Vector3 v3Position = _selectableEntities->at(_u32SelectedEntityIndex)->m_entity->m_v3Position;
+		v3Position.Y( v3Position.Y() - 50.0f );
+		_selectableEntities->at(_u32SelectedEntityIndex)->m_entity->SetPosition( v3Position );
 		_u32SelectedEntityIndex = 0;
 		m_bEntitySelected = false;
 	}
@@ -1109,6 +1100,7 @@ GamePanel::SelectableEntity::SelectableEntity( Utilities::Pointer::SmartPtr<Game
 	m_entity( i_entity ),
 	m_u16Indices( NULL ),
 	m_vertices( NULL ),
+	m_trianglePackets( NULL ),
 	m_u32TotalPrimitives( 0 ),
 	m_u32TotalVertices( 0 ),
 	m_collisionDistance( 0.0f )
@@ -1132,6 +1124,9 @@ GamePanel::SelectableEntity::SelectableEntity( Utilities::Pointer::SmartPtr<Game
 		m_vertices[i] = vertexData[i].position;
 
 	delete [] vertexData;
+
+	m_trianglePackets = new std::vector<Utilities::Math::S_TRIANGLE_PACKET>;
+	Utilities::Math::BuildTrianglePackets( m_vertices, m_u16Indices, m_u32TotalPrimitives, *m_trianglePackets );
 }
 
 /**
@@ -1158,6 +1153,12 @@ GamePanel::SelectableEntity::~SelectableEntity( void )
 		m_vertices = NULL;
 	}
 
+	if( m_trianglePackets )
+	{
+		delete m_trianglePackets;
+		m_trianglePackets = NULL;
+	}
+
 	if( m_name )
 	{
 		delete m_name;
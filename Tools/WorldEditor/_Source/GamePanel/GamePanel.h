@@ -19,6 +19,7 @@
 #endif
 
 // Utilities header
+#include <Math/Math.h>
 #include <SmartPtr/SmartPtr.h>
 
 // GameEngine header
@@ -49,6 +50,7 @@ public:
 		Utilities::Pointer::SmartPtr<GameEngine::Entity>	m_entity;
 		uint16_t																				*m_u16Indices;
 		D3DXVECTOR3																			*m_vertices;
+		std::vector<Utilities::Math::S_TRIANGLE_PACKET>	*m_trianglePackets;
 		std::string																			*m_name;
 		UINT32																					m_u32TotalPrimitives;
 		UINT32																					m_u32TotalVertices;
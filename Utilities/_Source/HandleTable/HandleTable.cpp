@@ -0,0 +1,176 @@
+/**
+ ****************************************************************************************************
+ * \file		HandleTable.cpp
+ * \brief		The implementation of HandleTable class
+ ****************************************************************************************************
+*/
+
+#include <string.h>
+
+#include "HandleTable.h"
+
+/****************************************************************************************************
+			PUBLIC FUNCTIONS IMPLEMENTATION
+****************************************************************************************************/
+/**
+ ****************************************************************************************************
+	\fn			HandleTable *Create( const UINT32 &i_u32Capacity )
+	\brief		Create HandleTable
+	\param		i_u32Capacity total handles which can be alive at the same time
+	\return		Pointer to the created handle table
+ ****************************************************************************************************
+*/
+Utilities::HandleTable *Utilities::HandleTable::Create( const UINT32 &i_u32Capacity )
+{
+	assert( i_u32Capacity );
+	assert( i_u32Capacity <= MAX_HANDLE_CAPACITY );
+
+	FUNCTION_START;
+
+	HandleTable *newTable = new HandleTable( i_u32Capacity );
+
+	if( !newTable->_u32Index || !newTable->_u16Generation || !newTable->_u32FreeSlots )
+	{
+		delete newTable;
+		newTable = NULL;
+	}
+
+	FUNCTION_FINISH;
+	return newTable;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			~HandleTable( void )
+	\brief		Destroy HandleTable class
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+Utilities::HandleTable::~HandleTable( void )
+{
+	FUNCTION_START;
+
+	_aligned_free( _u32Index );
+	_aligned_free( _u16Generation );
+	_aligned_free( _u32FreeSlots );
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			UINT32 Add( const UINT32 &i_u32Index )
+	\brief		Create a handle for an element
+	\param		i_u32Index index of the element in the owner's database
+	\return		UINT32
+	\retval		the new handle
+	\retval		INVALID_HANDLE if the table is full
+ ****************************************************************************************************
+*/
+UINT32 Utilities::HandleTable::Add( const UINT32 &i_u32Index )
+{
+	assert( i_u32Index != INVALID_HANDLE );
+
+	if( IsFull() )
+		return INVALID_HANDLE;
+
+	UINT32 u32Slot = _u32FreeSlots[--_u32TotalFreeSlots];
+	_u32Index[u32Slot] = i_u32Index;
+
+	return (static_cast<UINT32>(_u16Generation[u32Slot]) << HANDLE_INDEX_BITS) | u32Slot;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void Remove( const UINT32 &i_u32Handle )
+	\brief		Release the handle. Every copy of it becomes invalid
+	\param		i_u32Handle the handle to be released
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::HandleTable::Remove( const UINT32 &i_u32Handle )
+{
+	if( !IsValid(i_u32Handle) )
+		return;
+
+	UINT32 u32Slot = i_u32Handle & HANDLE_INDEX_MASK;
+
+	_u32Index[u32Slot] = INVALID_HANDLE;
+	_u16Generation[u32Slot] = (_u16Generation[u32Slot] + 1) & HANDLE_GENERATION_MASK;
+	_u32FreeSlots[_u32TotalFreeSlots++] = u32Slot;
+}
+
+#ifdef _DEBUG
+/**
+ ****************************************************************************************************
+	\fn			void UnitTest( void )
+	\brief		Unit test for HandleTable class
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::HandleTable::UnitTest( void )
+{
+	FUNCTION_START;
+
+	HandleTable *handleTableTest = HandleTable::Create( 2 );
+
+	assert( handleTableTest->IsEmpty() );
+	assert( !handleTableTest->IsValid(INVALID_HANDLE) );
+
+	UINT32 u32HandleA = handleTableTest->Add( 0 );
+	UINT32 u32HandleB = handleTableTest->Add( 1 );
+	assert( handleTableTest->IsFull() );
+	assert( handleTableTest->Add(2) == INVALID_HANDLE );
+	assert( handleTableTest->GetIndex(u32HandleA) == 0 );
+	assert( handleTableTest->GetIndex(u32HandleB) == 1 );
+
+	// Swap and pop A, B takes its place
+	handleTableTest->SetIndex( u32HandleB, 0 );
+	handleTableTest->Remove( u32HandleA );
+	assert( !handleTableTest->IsValid(u32HandleA) );
+	assert( handleTableTest->GetIndex(u32HandleB) == 0 );
+
+	// The slot is recycled with a new generation, the stale handle stays invalid
+	UINT32 u32HandleC = handleTableTest->Add( 1 );
+	assert( (u32HandleC & HANDLE_INDEX_MASK) == (u32HandleA & HANDLE_INDEX_MASK) );
+	assert( u32HandleC != u32HandleA );
+	assert( !handleTableTest->IsValid(u32HandleA) );
+	assert( handleTableTest->IsValid(u32HandleC) );
+
+	delete handleTableTest;
+
+	FUNCTION_FINISH;
+}
+#endif	// #ifdef _DEBUG
+
+/****************************************************************************************************
+			PRIVATE FUNCTIONS IMPLEMENTATION
+****************************************************************************************************/
+/**
+ ****************************************************************************************************
+	\fn			HandleTable( const UINT32 &i_u32Capacity )
+	\brief		HandleTable constructor
+	\param		i_u32Capacity total handles which can be alive at the same time
+	\return		NONE
+ ****************************************************************************************************
+*/
+Utilities::HandleTable::HandleTable( const UINT32 &i_u32Capacity ) :
+	_u32TotalFreeSlots( i_u32Capacity ),
+	_u32Capacity( i_u32Capacity )
+{
+	_u32Index = reinterpret_cast<UINT32 *>( _aligned_malloc(sizeof(UINT32) * i_u32Capacity, CACHE_LINE) );
+	_u16Generation = reinterpret_cast<UINT16 *>( _aligned_malloc(sizeof(UINT16) * i_u32Capacity, CACHE_LINE) );
+	_u32FreeSlots = reinterpret_cast<UINT32 *>( _aligned_malloc(sizeof(UINT32) * i_u32Capacity, CACHE_LINE) );
+
+	if( _u32Index && _u16Generation && _u32FreeSlots )
+	{
+		memset( _u32Index, 0xFF, sizeof(UINT32) * i_u32Capacity );
+		memset( _u16Generation, 0, sizeof(UINT16) * i_u32Capacity );
+
+		// Hand out the lowest slot first
+		for( UINT32 i = 0; i < i_u32Capacity; ++i )
+			_u32FreeSlots[i] = i_u32Capacity - 1 - i;
+	}
+}
@@ -0,0 +1,66 @@
+/**
+ ****************************************************************************************************
+ * \file		HandleTable.h
+ * \brief		The header of HandleTable class. A handle packs a slot index with a generation, so a
+ *          handle to a removed element is detected instead of silently pointing at its successor
+ ****************************************************************************************************
+*/
+
+#ifndef _HANDLE_TABLE_H_
+#define _HANDLE_TABLE_H_
+
+#include <assert.h>
+#include <malloc.h>
+
+#include "../UtilitiesTypes.h"
+#include "../Debug/Debug.h"
+#include "../Target/Target.h"
+
+namespace Utilities
+{
+	const UINT32 INVALID_HANDLE = 0xFFFFFFFF;
+
+	// Lower bits are the slot, upper bits the generation of that slot
+	const UINT8 HANDLE_INDEX_BITS = 20;
+	const UINT32 HANDLE_INDEX_MASK = (1 << HANDLE_INDEX_BITS) - 1;
+	const UINT32 HANDLE_GENERATION_MASK = 0xFFFFFFFF >> HANDLE_INDEX_BITS;
+	const UINT32 MAX_HANDLE_CAPACITY = HANDLE_INDEX_MASK;
+
+	class HandleTable
+	{
+		UINT32 *_u32Index;
+		UINT16 *_u16Generation;
+		UINT32 *_u32FreeSlots;
+		UINT32 _u32TotalFreeSlots;
+		UINT32 _u32Capacity;
+
+		HandleTable( const UINT32 &i_u32Capacity );
+
+		// Prohibit duplication and assignment
+		HandleTable( const HandleTable &i_other );
+		const HandleTable &operator=( const HandleTable &i_other );
+
+	public:
+		static HandleTable *Create( const UINT32 &i_u32Capacity );
+
+		// Destructor
+		~HandleTable( void );
+
+		// Operations
+		UINT32 Add( const UINT32 &i_u32Index );
+		void Remove( const UINT32 &i_u32Handle );
+		inline bool IsValid( const UINT32 &i_u32Handle ) const;
+		inline const UINT32 GetIndex( const UINT32 &i_u32Handle ) const;
+		inline void SetIndex( const UINT32 &i_u32Handle, const UINT32 &i_u32Index );
+		inline bool IsFull( void ) const;
+		inline bool IsEmpty( void ) const;
+
+	#ifdef _DEBUG
+		static void UnitTest( void );
+	#endif	// #ifdef _DEBUG
+	};
+}	// namespace Utilities
+
+#include "HandleTable.inl"
+
+#endif	// #ifndef _HANDLE_TABLE_H_
@@ -0,0 +1,85 @@
+/**
+ ****************************************************************************************************
+ * \file		HandleTable.inl
+ * \brief		The inline functions implementation of HandleTable class
+ ****************************************************************************************************
+*/
+
+/**
+ ****************************************************************************************************
+	\fn			bool IsValid( const UINT32 &i_u32Handle ) const
+	\brief		Check whether the handle still refers to a live element
+	\param		i_u32Handle the handle to be checked
+	\return		boolean
+	\retval		TRUE if valid
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+bool Utilities::HandleTable::IsValid( const UINT32 &i_u32Handle ) const
+{
+	UINT32 u32Slot = i_u32Handle & HANDLE_INDEX_MASK;
+
+	if( (i_u32Handle == INVALID_HANDLE) || (u32Slot >= _u32Capacity) )
+		return false;
+
+	return (_u16Generation[u32Slot] == (i_u32Handle >> HANDLE_INDEX_BITS)) && (_u32Index[u32Slot] != INVALID_HANDLE);
+}
+
+/**
+ ****************************************************************************************************
+	\fn			const UINT32 GetIndex( const UINT32 &i_u32Handle ) const
+	\brief		Get the index of the element referred by the handle
+	\param		i_u32Handle a valid handle
+	\return		UINT32
+	\retval		index of the element in the owner's database
+ ****************************************************************************************************
+*/
+const UINT32 Utilities::HandleTable::GetIndex( const UINT32 &i_u32Handle ) const
+{
+	assert( IsValid(i_u32Handle) );
+
+	return _u32Index[i_u32Handle & HANDLE_INDEX_MASK];
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void SetIndex( const UINT32 &i_u32Handle, const UINT32 &i_u32Index )
+	\brief		Update the index of the element after it has been moved in the owner's database
+	\param		i_u32Handle a valid handle
+	\param		i_u32Index new index of the element
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::HandleTable::SetIndex( const UINT32 &i_u32Handle, const UINT32 &i_u32Index )
+{
+	assert( IsValid(i_u32Handle) );
+	assert( i_u32Index != INVALID_HANDLE );
+
+	_u32Index[i_u32Handle & HANDLE_INDEX_MASK] = i_u32Index;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool IsFull( void ) const
+	\brief		Check whether handle table is full
+	\param		NONE
+	\return		boolean
+ ****************************************************************************************************
+*/
+bool Utilities::HandleTable::IsFull( void ) const
+{
+	return _u32TotalFreeSlots == 0;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool IsEmpty( void ) const
+	\brief		Check whether handle table is empty
+	\param		NONE
+	\return		boolean
+ ****************************************************************************************************
+*/
+bool Utilities::HandleTable::IsEmpty( void ) const
+{
+	return _u32TotalFreeSlots == _u32Capacity;
+}
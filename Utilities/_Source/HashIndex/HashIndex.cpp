@@ -0,0 +1,275 @@
+/**
+ ****************************************************************************************************
+ * \file		HashIndex.cpp
+ * \brief		The implementation of HashIndex class
+ ****************************************************************************************************
+*/
+
+#include "HashIndex.h"
+
+/****************************************************************************************************
+			PUBLIC FUNCTIONS IMPLEMENTATION
+****************************************************************************************************/
+/**
+ ****************************************************************************************************
+	\fn			HashIndex *Create( const UINT32 &i_u32InitialCapacity )
+	\brief		Create HashIndex
+	\param		i_u32InitialCapacity expected total entries, the table grows when it gets half full
+	\return		Pointer to the created hash index
+ ****************************************************************************************************
+*/
+Utilities::HashIndex *Utilities::HashIndex::Create( const UINT32 &i_u32InitialCapacity )
+{
+	UINT32 u32Capacity = 16;
+
+	FUNCTION_START;
+
+	while( u32Capacity < (i_u32InitialCapacity * 2) )
+		u32Capacity <<= 1;
+
+	HashIndex *newIndex = new HashIndex( new S_HASH_INDEX_ENTRY[u32Capacity], u32Capacity );
+
+	FUNCTION_FINISH;
+	return newIndex;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			~HashIndex( void )
+	\brief		Destroy HashIndex class
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+Utilities::HashIndex::~HashIndex( void )
+{
+	FUNCTION_START;
+
+	delete [] _entries;
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void Insert( const UINT32 &i_u32Key, const UINT32 &i_u32Value )
+	\brief		Add an entry. The same key may be inserted several times with different values
+	\param		i_u32Key the hashed key
+	\param		i_u32Value the value of the entry
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::HashIndex::Insert( const UINT32 &i_u32Key, const UINT32 &i_u32Value )
+{
+	assert( i_u32Value != INVALID_HASH_INDEX_VALUE );
+
+	if( ((_u32Count + 1) * 2) > _u32Capacity )
+		Grow();
+
+	UINT32 u32Bucket = HomeOf( i_u32Key );
+	while( _entries[u32Bucket].u32Value != INVALID_HASH_INDEX_VALUE )
+		u32Bucket = (u32Bucket + 1) & _u32Mask;
+
+	_entries[u32Bucket].u32Key = i_u32Key;
+	_entries[u32Bucket].u32Value = i_u32Value;
+	_u32Count++;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool Remove( const UINT32 &i_u32Key, const UINT32 &i_u32Value )
+	\brief		Remove the entry matching both key and value
+	\param		i_u32Key the hashed key
+	\param		i_u32Value the value of the entry
+	\return		boolean
+	\retval		TRUE if removed
+	\retval		FALSE if not found
+ ****************************************************************************************************
+*/
+bool Utilities::HashIndex::Remove( const UINT32 &i_u32Key, const UINT32 &i_u32Value )
+{
+	UINT32 u32Bucket = HomeOf( i_u32Key );
+
+	while( (_entries[u32Bucket].u32Key != i_u32Key) || (_entries[u32Bucket].u32Value != i_u32Value) )
+	{
+		if( _entries[u32Bucket].u32Value == INVALID_HASH_INDEX_VALUE )
+			return false;
+		u32Bucket = (u32Bucket + 1) & _u32Mask;
+	}
+
+	// Shift the following entries of the cluster back instead of leaving a tombstone, so lookups
+	// never walk over deleted buckets
+	UINT32 u32Hole = u32Bucket;
+	UINT32 u32Next = (u32Hole + 1) & _u32Mask;
+	while( _entries[u32Next].u32Value != INVALID_HASH_INDEX_VALUE )
+	{
+		UINT32 u32Home = HomeOf( _entries[u32Next].u32Key );
+
+		// Move the entry only if its home is not between the hole and its current bucket
+		if( ((u32Next - u32Home) & _u32Mask) >= ((u32Next - u32Hole) & _u32Mask) )
+		{
+			_entries[u32Hole] = _entries[u32Next];
+			u32Hole = u32Next;
+		}
+		u32Next = (u32Next + 1) & _u32Mask;
+	}
+
+	_entries[u32Hole].u32Value = INVALID_HASH_INDEX_VALUE;
+	_u32Count--;
+
+	return true;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			UINT32 Find( const UINT32 &i_u32Key ) const
+	\brief		Find a value stored with the key
+	\param		i_u32Key the hashed key
+	\return		UINT32
+	\retval		the value of the first entry found
+	\retval		INVALID_HASH_INDEX_VALUE if not found
+ ****************************************************************************************************
+*/
+UINT32 Utilities::HashIndex::Find( const UINT32 &i_u32Key ) const
+{
+	UINT32 u32Bucket = HomeOf( i_u32Key );
+
+	while( _entries[u32Bucket].u32Value != INVALID_HASH_INDEX_VALUE )
+	{
+		if( _entries[u32Bucket].u32Key == i_u32Key )
+			return _entries[u32Bucket].u32Value;
+		u32Bucket = (u32Bucket + 1) & _u32Mask;
+	}
+
+	return INVALID_HASH_INDEX_VALUE;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void Clear( void )
+	\brief		Remove all entries
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::HashIndex::Clear( void )
+{
+	for( UINT32 i = 0; i < _u32Capacity; ++i )
+		_entries[i].u32Value = INVALID_HASH_INDEX_VALUE;
+
+	_u32Count = 0;
+}
+
+#ifdef _DEBUG
+/**
+ ****************************************************************************************************
+	\fn			void UnitTest( void )
+	\brief		Unit test for HashIndex class
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::HashIndex::UnitTest( void )
+{
+	FUNCTION_START;
+
+	HashIndex *hashIndexTest = HashIndex::Create( 4 );
+
+	assert( hashIndexTest->Find(1234) == INVALID_HASH_INDEX_VALUE );
+
+	// Keys which only differ in their upper bits get different home buckets
+	for( UINT32 i = 0; i < hashIndexTest->_u32Capacity; ++i )
+	{
+		for( UINT32 j = i + 1; j < hashIndexTest->_u32Capacity; ++j )
+			assert( hashIndexTest->HomeOf(i << 28) != hashIndexTest->HomeOf(j << 28) );
+	}
+
+	// Enough entries to force a few rehashes
+	for( UINT32 i = 0; i < 1000; ++i )
+		hashIndexTest->Insert( i * 7919, i );
+	assert( hashIndexTest->Count() == 1000 );
+
+	for( UINT32 i = 0; i < 1000; ++i )
+		assert( hashIndexTest->Find(i * 7919) == i );
+
+	// Duplicated keys
+	hashIndexTest->Insert( 42, 5000 );
+	hashIndexTest->Insert( 42, 5001 );
+	assert( hashIndexTest->Remove(42, 5000) );
+	assert( hashIndexTest->Find(42) == 5001 );
+	assert( !hashIndexTest->Remove(42, 5000) );
+
+	for( UINT32 i = 0; i < 1000; i += 2 )
+		assert( hashIndexTest->Remove(i * 7919, i) );
+	for( UINT32 i = 0; i < 1000; ++i )
+		assert( hashIndexTest->Find(i * 7919) == ((i & 1) ? i : INVALID_HASH_INDEX_VALUE) );
+
+	hashIndexTest->Clear();
+	assert( hashIndexTest->Count() == 0 );
+
+	delete hashIndexTest;
+
+	FUNCTION_FINISH;
+}
+#endif	// #ifdef _DEBUG
+
+/****************************************************************************************************
+			PRIVATE FUNCTIONS IMPLEMENTATION
+****************************************************************************************************/
+/**
+ ****************************************************************************************************
+	\fn			HashIndex( S_HASH_INDEX_ENTRY *i_entries, const UINT32 &i_u32Capacity )
+	\brief		HashIndex constructor
+	\param		i_entries the buckets, the total has to be power of two
+	\param		i_u32Capacity total buckets
+	\return		NONE
+ ****************************************************************************************************
+*/
+Utilities::HashIndex::HashIndex( S_HASH_INDEX_ENTRY *i_entries, const UINT32 &i_u32Capacity ) :
+	_entries( i_entries ),
+	_u32Capacity( i_u32Capacity ),
+	_u32Mask( i_u32Capacity - 1 ),
+	_u32Shift( 32 ),
+	_u32Count( 0 )
+{
+	assert( _entries );
+	assert( (_u32Capacity & _u32Mask) == 0 );
+	assert( _u32Capacity > 1 );
+
+	for( UINT32 u32Capacity = _u32Capacity; u32Capacity > 1; u32Capacity >>= 1 )
+		--_u32Shift;
+
+	Clear();
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void Grow( void )
+	\brief		Double the buckets and reinsert every entry
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::HashIndex::Grow( void )
+{
+	S_HASH_INDEX_ENTRY *oldEntries = _entries;
+	UINT32 u32OldCapacity = _u32Capacity;
+
+	FUNCTION_START;
+
+	_u32Capacity <<= 1;
+	_u32Mask = _u32Capacity - 1;
+	--_u32Shift;
+	_entries = new S_HASH_INDEX_ENTRY[_u32Capacity];
+	Clear();
+
+	for( UINT32 i = 0; i < u32OldCapacity; ++i )
+	{
+		if( oldEntries[i].u32Value != INVALID_HASH_INDEX_VALUE )
+			Insert( oldEntries[i].u32Key, oldEntries[i].u32Value );
+	}
+
+	delete [] oldEntries;
+
+	FUNCTION_FINISH;
+}
@@ -0,0 +1,66 @@
+/**
+ ****************************************************************************************************
+ * \file		HashIndex.h
+ * \brief		The header of HashIndex class. An open-addressing (linear probing) multimap from a
+ *          32-bit hashed key, e.g. StringHash, to a 32-bit value
+ ****************************************************************************************************
+*/
+
+#ifndef _HASH_INDEX_H_
+#define _HASH_INDEX_H_
+
+#include <assert.h>
+
+#include "../UtilitiesTypes.h"
+#include "../Debug/Debug.h"
+
+namespace Utilities
+{
+	const UINT32 INVALID_HASH_INDEX_VALUE = 0xFFFFFFFF;
+
+	class HashIndex
+	{
+		typedef struct _s_hash_index_entry_
+		{
+			UINT32 u32Key;
+			UINT32 u32Value;
+		} S_HASH_INDEX_ENTRY;
+
+		S_HASH_INDEX_ENTRY *_entries;
+		UINT32 _u32Capacity;
+		UINT32 _u32Mask;
+		// 32 - log2( _u32Capacity ), the home bucket is taken from the upper bits of the key product
+		UINT32 _u32Shift;
+		UINT32 _u32Count;
+
+		HashIndex( S_HASH_INDEX_ENTRY *i_entries, const UINT32 &i_u32Capacity );
+
+		// Prohibit duplication and assignment
+		HashIndex( const HashIndex &i_other );
+		const HashIndex &operator=( const HashIndex &i_other );
+
+		inline UINT32 HomeOf( const UINT32 &i_u32Key ) const;
+		void Grow( void );
+
+	public:
+		static HashIndex *Create( const UINT32 &i_u32InitialCapacity );
+
+		// Destructor
+		~HashIndex( void );
+
+		// Operations
+		void Insert( const UINT32 &i_u32Key, const UINT32 &i_u32Value );
+		bool Remove( const UINT32 &i_u32Key, const UINT32 &i_u32Value );
+		UINT32 Find( const UINT32 &i_u32Key ) const;
+		void Clear( void );
+		inline const UINT32 Count( void ) const;
+
+	#ifdef _DEBUG
+		static void UnitTest( void );
+	#endif	// #ifdef _DEBUG
+	};
+}	// namespace Utilities
+
+#include "HashIndex.inl"
+
+#endif	// #ifndef _HASH_INDEX_H_
@@ -0,0 +1,34 @@
+/**
+ ****************************************************************************************************
+ * \file		HashIndex.inl
+ * \brief		The inline functions implementation of HashIndex class
+ ****************************************************************************************************
+*/
+
+/**
+ ****************************************************************************************************
+	\fn			const UINT32 Count( void ) const
+	\brief		Get total entries in the index
+	\param		NONE
+	\return		UINT32
+ ****************************************************************************************************
+*/
+const UINT32 Utilities::HashIndex::Count( void ) const
+{
+	return _u32Count;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			UINT32 HomeOf( const UINT32 &i_u32Key ) const
+	\brief		Get the first bucket to probe for the key
+	\param		i_u32Key the hashed key
+	\return		UINT32
+ ****************************************************************************************************
+*/
+UINT32 Utilities::HashIndex::HomeOf( const UINT32 &i_u32Key ) const
+{
+	// Fibonacci hashing, the upper bits of the product depend on every bit of the key while the lower
+	// bits only depend on the lower bits of the key
+	return (i_u32Key * 0x9E3779B1) >> _u32Shift;
+}
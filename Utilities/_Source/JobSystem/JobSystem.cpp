@@ -0,0 +1,498 @@
+/**
+ ****************************************************************************************************
+ * \file		JobSystem.cpp
+ * \brief		The implementation of job system
+ ****************************************************************************************************
+*/
+
+#include <assert.h>
+#include <malloc.h>
+#include <process.h>
+#include <string.h>
+#include <windows.h>
+
+#include "JobSystem.h"
+#include "../Debug/Debug.h"
+
+namespace Utilities
+{
+	namespace JobSystem
+	{
+		// Has to be power of two
+		const UINT32 JOB_DEQUE_SIZE = 4096;
+
+		typedef struct _s_job_
+		{
+			JobFunction function;
+			void *data;
+			UINT32 u32Begin;
+			UINT32 u32End;
+			UINT32 u32GrainSize;
+			JobCounter *counter;
+		} S_JOB;
+
+		// Aligned so the lock of one worker never shares a cache line with another worker
+		typedef struct CACHE_ALIGN _s_job_deque_
+		{
+			volatile LONG lock;
+			UINT32 u32Top;
+			UINT32 u32Bottom;
+			S_JOB jobs[JOB_DEQUE_SIZE];
+		} S_JOB_DEQUE;
+
+		static S_JOB_DEQUE *jobDeque = NULL;
+		static HANDLE workerThread[MAX_WORKERS];
+		static HANDLE wakeUpSemaphore = NULL;
+		static UINT32 u32TotalWorkers = 0;
+		static volatile LONG sleepingWorkers = 0;
+		static volatile bool bShutDown = false;
+
+		// The thread calling Initialize is worker 0
+		static __declspec(thread) UINT32 u32CurrentWorker = 0;
+
+		void Lock( volatile LONG &io_lock );
+		void Unlock( volatile LONG &io_lock );
+		bool Push( const S_JOB &i_job );
+		bool PopOrSteal( S_JOB &o_job );
+		void Execute( S_JOB &i_job );
+		unsigned int __stdcall WorkerThread( void *i_param );
+	}	// namespace JobSystem
+}	// namespace Utilities
+
+/****************************************************************************************************
+			Global functions implementation
+****************************************************************************************************/
+/**
+ ****************************************************************************************************
+	\fn			bool Initialize( const UINT32 &i_u32TotalWorkers )
+	\brief		Initialize job system and start the worker threads
+	\param		i_u32TotalWorkers total workers including the calling thread, 0 to use every core
+	\return		boolean
+	\retval		1 SUCCESS
+	\retval		0 FAIL
+ ****************************************************************************************************
+*/
+bool Utilities::JobSystem::Initialize( const UINT32 &i_u32TotalWorkers )
+{
+	SYSTEM_INFO systemInfo;
+
+	FUNCTION_START;
+
+	assert( jobDeque == NULL );
+
+	u32TotalWorkers = i_u32TotalWorkers;
+	if( u32TotalWorkers == 0 )
+	{
+		GetSystemInfo( &systemInfo );
+		u32TotalWorkers = systemInfo.dwNumberOfProcessors;
+	}
+	if( u32TotalWorkers > MAX_WORKERS )
+		u32TotalWorkers = MAX_WORKERS;
+	else if( u32TotalWorkers == 0 )
+		u32TotalWorkers = 1;
+
+	jobDeque = reinterpret_cast<S_JOB_DEQUE *>( _aligned_malloc(sizeof(S_JOB_DEQUE) * u32TotalWorkers, CACHE_LINE) );
+	wakeUpSemaphore = CreateSemaphore( NULL, 0, MAXLONG, NULL );
+	if( !jobDeque || !wakeUpSemaphore )
+	{
+		DBG_MSG_LEVEL( D_ERR, "Failed to create job system\n" );
+		u32TotalWorkers = 0;
+		FUNCTION_FINISH;
+		return FAIL;
+	}
+
+	for( UINT32 i = 0; i < u32TotalWorkers; ++i )
+	{
+		jobDeque[i].lock = 0;
+		jobDeque[i].u32Top = 0;
+		jobDeque[i].u32Bottom = 0;
+	}
+
+	bShutDown = false;
+	sleepingWorkers = 0;
+	u32CurrentWorker = 0;
+
+	for( UINT32 i = 1; i < u32TotalWorkers; ++i )
+	{
+		workerThread[i] = reinterpret_cast<HANDLE>( _beginthreadex(NULL, 0, WorkerThread, reinterpret_cast<void *>(i), 0, NULL) );
+		if( !workerThread[i] )
+		{
+			DBG_MSG_LEVEL( D_ERR, "Failed to start worker %u\n", i );
+			u32TotalWorkers = i;
+			break;
+		}
+	}
+
+	FUNCTION_FINISH;
+	return SUCCESS;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void ShutDown( void )
+	\brief		Stop the worker threads and shut down job system
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::JobSystem::ShutDown( void )
+{
+	FUNCTION_START;
+
+	if( u32TotalWorkers > 1 )
+	{
+		bShutDown = true;
+		ReleaseSemaphore( wakeUpSemaphore, u32TotalWorkers - 1, NULL );
+		WaitForMultipleObjects( u32TotalWorkers - 1, &workerThread[1], TRUE, INFINITE );
+
+		for( UINT32 i = 1; i < u32TotalWorkers; ++i )
+			CloseHandle( workerThread[i] );
+	}
+
+	if( wakeUpSemaphore )
+	{
+		CloseHandle( wakeUpSemaphore );
+		wakeUpSemaphore = NULL;
+	}
+
+	if( jobDeque )
+	{
+		_aligned_free( jobDeque );
+		jobDeque = NULL;
+	}
+
+	u32TotalWorkers = 0;
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void Run( JobFunction i_function, void *i_data, JobCounter &io_counter )
+	\brief		Queue a job, it is called once with the range [0, 1)
+	\param		i_function the job
+	\param		i_data data passed to the job
+	\param		io_counter counter to be decremented when the job is done
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::JobSystem::Run( JobFunction i_function, void *i_data, JobCounter &io_counter )
+{
+	S_JOB newJob = { i_function, i_data, 0, 1, 1, &io_counter };
+
+	InterlockedIncrement( &io_counter );
+
+	// Without a free worker the job is run immediately
+	if( (u32TotalWorkers <= 1) || !Push(newJob) )
+		Execute( newJob );
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void WaitForCounter( JobCounter &i_counter )
+	\brief		Wait until every job of the counter is done. The calling thread executes queued jobs
+				while waiting, so a job may wait for the jobs it started
+	\param		i_counter the counter to wait for
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::JobSystem::WaitForCounter( JobCounter &i_counter )
+{
+	S_JOB job;
+
+	while( i_counter > 0 )
+	{
+		if( PopOrSteal(job) )
+			Execute( job );
+		else
+			YieldProcessor();
+	}
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool ExecuteJob( void )
+	\brief		Execute one queued job on the calling thread
+	\param		NONE
+	\return		boolean
+	\retval		TRUE if a job has been executed
+	\retval		FALSE if there is no queued job
+ ****************************************************************************************************
+*/
+bool Utilities::JobSystem::ExecuteJob( void )
+{
+	S_JOB job;
+
+	if( (u32TotalWorkers <= 1) || !PopOrSteal(job) )
+		return false;
+
+	Execute( job );
+	return true;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void ParallelFor( JobFunction i_function, void *i_data, const UINT32 &i_u32Total,
+					const UINT32 &i_u32GrainSize )
+	\brief		Process the items [0, i_u32Total) on every worker and return once all are done. The range
+				is halved recursively until it is not bigger than the grain size
+	\param		i_function the job, it has to be safe to call on disjoint ranges at the same time
+	\param		i_data data passed to the job
+	\param		i_u32Total total items
+	\param		i_u32GrainSize the most items processed by one call of the job
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::JobSystem::ParallelFor( JobFunction i_function, void *i_data, const UINT32 &i_u32Total,
+	const UINT32 &i_u32GrainSize )
+{
+	assert( i_u32GrainSize );
+
+	if( i_u32Total == 0 )
+		return;
+
+	if( (u32TotalWorkers <= 1) || (i_u32Total <= i_u32GrainSize) )
+	{
+		i_function( i_data, 0, i_u32Total );
+		return;
+	}
+
+	JobCounter counter = 1;
+	S_JOB job = { i_function, i_data, 0, i_u32Total, i_u32GrainSize, &counter };
+
+	Execute( job );
+	WaitForCounter( counter );
+}
+
+#ifdef _DEBUG
+namespace Utilities
+{
+	namespace JobSystem
+	{
+		static void UnitTestJob( void *i_data, const UINT32 &i_u32Begin, const UINT32 &i_u32End )
+		{
+			UINT32 *u32Item = reinterpret_cast<UINT32 *>( i_data );
+
+			for( UINT32 i = i_u32Begin; i < i_u32End; ++i )
+				u32Item[i]++;
+		}
+
+		static void UnitTestNestedJob( void *i_data, const UINT32 &i_u32Begin, const UINT32 &i_u32End )
+		{
+			ParallelFor( UnitTestJob, i_data, 1000, 16 );
+		}
+	}	// namespace JobSystem
+}	// namespace Utilities
+
+/**
+ ****************************************************************************************************
+	\fn			void UnitTest( void )
+	\brief		Unit test for job system
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::JobSystem::UnitTest( void )
+{
+	const UINT32 u32TotalItems = 100000;
+	UINT32 *u32Item = new UINT32[u32TotalItems];
+
+	FUNCTION_START;
+
+	// Every item is processed exactly once
+	memset( u32Item, 0, sizeof(UINT32) * u32TotalItems );
+	ParallelFor( UnitTestJob, u32Item, u32TotalItems, 64 );
+	for( UINT32 i = 0; i < u32TotalItems; ++i )
+		assert( u32Item[i] == 1 );
+
+	// Jobs waiting for their own jobs
+	JobCounter counter = 0;
+	for( UINT32 i = 0; i < 8; ++i )
+		Run( UnitTestNestedJob, u32Item + (i * 1000), counter );
+	WaitForCounter( counter );
+	assert( counter == 0 );
+	for( UINT32 i = 0; i < 8000; ++i )
+		assert( u32Item[i] == 2 );
+
+	delete [] u32Item;
+
+	FUNCTION_FINISH;
+}
+#endif	// #ifdef _DEBUG
+
+/****************************************************************************************************
+			Private functions implementation
+****************************************************************************************************/
+/**
+ ****************************************************************************************************
+	\fn			void Lock( volatile LONG &io_lock )
+	\brief		Acquire a spin lock
+	\param		io_lock the lock
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::JobSystem::Lock( volatile LONG &io_lock )
+{
+	while( InterlockedCompareExchange(&io_lock, 1, 0) != 0 )
+		YieldProcessor();
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void Unlock( volatile LONG &io_lock )
+	\brief		Release a spin lock
+	\param		io_lock the lock
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::JobSystem::Unlock( volatile LONG &io_lock )
+{
+	InterlockedExchange( &io_lock, 0 );
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool Push( const S_JOB &i_job )
+	\brief		Push a job to the bottom of the deque of the current worker and wake up a sleeping worker
+	\param		i_job the job
+	\return		boolean
+	\retval		TRUE if pushed
+	\retval		FALSE if the deque is full
+ ****************************************************************************************************
+*/
+bool Utilities::JobSystem::Push( const S_JOB &i_job )
+{
+	S_JOB_DEQUE &deque = jobDeque[u32CurrentWorker];
+
+	Lock( deque.lock );
+	if( (deque.u32Bottom - deque.u32Top) >= JOB_DEQUE_SIZE )
+	{
+		Unlock( deque.lock );
+		return false;
+	}
+	deque.jobs[deque.u32Bottom & (JOB_DEQUE_SIZE - 1)] = i_job;
+	deque.u32Bottom++;
+	Unlock( deque.lock );
+
+	// Unlock is a full barrier, a worker going to sleep either sees the job or is counted here
+	if( sleepingWorkers > 0 )
+		ReleaseSemaphore( wakeUpSemaphore, 1, NULL );
+
+	return true;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool PopOrSteal( S_JOB &o_job )
+	\brief		Take the newest job of the current worker, or the oldest job of another worker
+	\param		o_job the job taken
+	\return		boolean
+	\retval		TRUE if a job is taken
+	\retval		FALSE if every deque is empty
+ ****************************************************************************************************
+*/
+bool Utilities::JobSystem::PopOrSteal( S_JOB &o_job )
+{
+	S_JOB_DEQUE &ownDeque = jobDeque[u32CurrentWorker];
+
+	Lock( ownDeque.lock );
+	if( ownDeque.u32Bottom != ownDeque.u32Top )
+	{
+		ownDeque.u32Bottom--;
+		o_job = ownDeque.jobs[ownDeque.u32Bottom & (JOB_DEQUE_SIZE - 1)];
+		Unlock( ownDeque.lock );
+		return true;
+	}
+	Unlock( ownDeque.lock );
+
+	for( UINT32 i = 1; i < u32TotalWorkers; ++i )
+	{
+		S_JOB_DEQUE &victimDeque = jobDeque[(u32CurrentWorker + i) % u32TotalWorkers];
+
+		// Peek first so idle workers do not fight over the locks of empty deques
+		if( victimDeque.u32Bottom == victimDeque.u32Top )
+			continue;
+
+		Lock( victimDeque.lock );
+		if( victimDeque.u32Bottom != victimDeque.u32Top )
+		{
+			o_job = victimDeque.jobs[victimDeque.u32Top & (JOB_DEQUE_SIZE - 1)];
+			victimDeque.u32Top++;
+			Unlock( victimDeque.lock );
+			return true;
+		}
+		Unlock( victimDeque.lock );
+	}
+
+	return false;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void Execute( S_JOB &i_job )
+	\brief		Execute a job. The upper half of a range bigger than the grain size is pushed for the
+				other workers to steal
+	\param		i_job the job
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::JobSystem::Execute( S_JOB &i_job )
+{
+	UINT32 u32End = i_job.u32End;
+
+	while( (u32End - i_job.u32Begin) > i_job.u32GrainSize )
+	{
+		S_JOB upperHalf = i_job;
+		upperHalf.u32Begin = i_job.u32Begin + ((u32End - i_job.u32Begin) / 2);
+		upperHalf.u32End = u32End;
+
+		InterlockedIncrement( i_job.counter );
+		if( !Push(upperHalf) )
+		{
+			// The deque is full, process the rest here
+			InterlockedDecrement( i_job.counter );
+			break;
+		}
+		u32End = upperHalf.u32Begin;
+	}
+
+	i_job.function( i_job.data, i_job.u32Begin, u32End );
+	InterlockedDecrement( i_job.counter );
+}
+
+/**
+ ****************************************************************************************************
+	\fn			unsigned int __stdcall WorkerThread( void *i_param )
+	\brief		Main loop of a worker thread
+	\param		i_param index of the worker
+	\return		0
+ ****************************************************************************************************
+*/
+unsigned int __stdcall Utilities::JobSystem::WorkerThread( void *i_param )
+{
+	S_JOB job;
+
+	u32CurrentWorker = static_cast<UINT32>( reinterpret_cast<UINT_PTR>(i_param) );
+
+	while( !bShutDown )
+	{
+		if( PopOrSteal(job) )
+		{
+			Execute( job );
+			continue;
+		}
+
+		// Check again after being counted as sleeping, a job pushed in between would be missed
+		InterlockedIncrement( &sleepingWorkers );
+		if( PopOrSteal(job) )
+		{
+			InterlockedDecrement( &sleepingWorkers );
+			Execute( job );
+			continue;
+		}
+		WaitForSingleObject( wakeUpSemaphore, INFINITE );
+		InterlockedDecrement( &sleepingWorkers );
+	}
+
+	return 0;
+}
@@ -0,0 +1,43 @@
+/**
+ ****************************************************************************************************
+ * \file		JobSystem.h
+ * \brief		The header of job system. Every worker owns a job deque, it pushes and pops the newest
+ *          job at the bottom while idle workers steal the oldest job from the top
+ ****************************************************************************************************
+*/
+
+#ifndef _JOB_SYSTEM_H_
+#define _JOB_SYSTEM_H_
+
+#include "../Target/Target.h"
+#include "../UtilitiesTypes.h"
+
+namespace Utilities
+{
+	namespace JobSystem
+	{
+		// Process the items [i_u32Begin, i_u32End) of i_data
+		typedef void (*JobFunction)( void *i_data, const UINT32 &i_u32Begin, const UINT32 &i_u32End );
+
+		// Total unfinished jobs, a job is joined once its counter drops to zero
+		typedef volatile long JobCounter;
+
+		const UINT32 MAX_WORKERS = 32;
+		const UINT32 DEFAULT_GRAIN_SIZE = 256;
+
+		bool Initialize( const UINT32 &i_u32TotalWorkers = 0 );
+		void ShutDown( void );
+
+		void Run( JobFunction i_function, void *i_data, JobCounter &io_counter );
+		void WaitForCounter( JobCounter &i_counter );
+		bool ExecuteJob( void );
+		void ParallelFor( JobFunction i_function, void *i_data, const UINT32 &i_u32Total,
+			const UINT32 &i_u32GrainSize = DEFAULT_GRAIN_SIZE );
+
+	#ifdef _DEBUG
+		void UnitTest( void );
+	#endif	// #ifdef _DEBUG
+	}	// namespace JobSystem
+}	// namespace Utilities
+
+#endif	// #ifndef _JOB_SYSTEM_H_
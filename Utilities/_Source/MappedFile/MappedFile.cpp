@@ -0,0 +1,110 @@
+/**
+ ****************************************************************************************************
+ * \file		MappedFile.cpp
+ * \brief		The implementation of MappedFile class
+ ****************************************************************************************************
+*/
+
+#include <assert.h>
+#include <windows.h>
+
+#include "MappedFile.h"
+#include "../Debug/Debug.h"
+
+/****************************************************************************************************
+			PUBLIC FUNCTIONS IMPLEMENTATION
+****************************************************************************************************/
+/**
+ ****************************************************************************************************
+	\fn			MappedFile *Create( const char *i_filename )
+	\brief		Map the whole file read only
+	\param		i_filename name of the file to be mapped
+	\return		Pointer to the mapped file
+	\retval		NULL if the file cannot be opened or is empty
+ ****************************************************************************************************
+*/
+Utilities::MappedFile *Utilities::MappedFile::Create( const char *i_filename )
+{
+	assert( i_filename );
+
+	FUNCTION_START;
+
+	MappedFile *newFile = new MappedFile();
+
+	newFile->_file = CreateFileA( i_filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+	if( newFile->_file == INVALID_HANDLE_VALUE )
+	{
+		newFile->_file = NULL;
+		delete newFile;
+		FUNCTION_FINISH;
+		return NULL;
+	}
+
+	LARGE_INTEGER fileSize;
+	if( !GetFileSizeEx(newFile->_file, &fileSize) || (fileSize.QuadPart == 0) || fileSize.HighPart )
+	{
+		DBG_MSG_LEVEL( D_ERR, "Cannot map %s\n", i_filename );
+		delete newFile;
+		FUNCTION_FINISH;
+		return NULL;
+	}
+	newFile->_u32Size = fileSize.LowPart;
+
+	newFile->_mapping = CreateFileMappingA( newFile->_file, NULL, PAGE_READONLY, 0, 0, NULL );
+	if( newFile->_mapping )
+		newFile->_data = reinterpret_cast<const UINT8 *>( MapViewOfFile(newFile->_mapping, FILE_MAP_READ, 0, 0, 0) );
+
+	if( !newFile->_data )
+	{
+		DBG_MSG_LEVEL( D_ERR, "Cannot map %s\n", i_filename );
+		delete newFile;
+		newFile = NULL;
+	}
+
+	FUNCTION_FINISH;
+	return newFile;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			~MappedFile( void )
+	\brief		Unmap and close the file
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+Utilities::MappedFile::~MappedFile( void )
+{
+	FUNCTION_START;
+
+	if( _data )
+		UnmapViewOfFile( _data );
+
+	if( _mapping )
+		CloseHandle( _mapping );
+
+	if( _file )
+		CloseHandle( _file );
+
+	FUNCTION_FINISH;
+}
+
+/****************************************************************************************************
+			PRIVATE FUNCTIONS IMPLEMENTATION
+****************************************************************************************************/
+/**
+ ****************************************************************************************************
+	\fn			MappedFile( void )
+	\brief		MappedFile constructor
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+Utilities::MappedFile::MappedFile( void ) :
+	_file( NULL ),
+	_mapping( NULL ),
+	_data( NULL ),
+	_u32Size( 0 )
+{
+}
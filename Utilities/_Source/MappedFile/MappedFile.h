@@ -0,0 +1,42 @@
+/**
+ ****************************************************************************************************
+ * \file		MappedFile.h
+ * \brief		The header of MappedFile class. The whole file is mapped read only into the address
+ *          space, so a binary image can be used in place without being read or parsed
+ ****************************************************************************************************
+*/
+
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+#include "../UtilitiesTypes.h"
+
+namespace Utilities
+{
+	class MappedFile
+	{
+		void *_file;
+		void *_mapping;
+		const UINT8 *_data;
+		UINT32 _u32Size;
+
+		MappedFile( void );
+
+		// Prohibit duplication and assignment
+		MappedFile( const MappedFile &i_other );
+		const MappedFile &operator=( const MappedFile &i_other );
+
+	public:
+		static MappedFile *Create( const char *i_filename );
+
+		// Destructor
+		~MappedFile( void );
+
+		inline const UINT8 *GetData( void ) const;
+		inline const UINT32 GetSize( void ) const;
+	};
+}	// namespace Utilities
+
+#include "MappedFile.inl"
+
+#endif	// #ifndef _MAPPED_FILE_H_
@@ -0,0 +1,33 @@
+/**
+ ****************************************************************************************************
+ * \file		MappedFile.inl
+ * \brief		The inline functions implementation of MappedFile class
+ ****************************************************************************************************
+*/
+
+/**
+ ****************************************************************************************************
+	\fn			const UINT8 *GetData( void ) const
+	\brief		Get the first byte of the mapped file
+	\param		NONE
+	\return		Pointer to the mapped file
+ ****************************************************************************************************
+*/
+const UINT8 *Utilities::MappedFile::GetData( void ) const
+{
+	return _data;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			const UINT32 GetSize( void ) const
+	\brief		Get the size of the mapped file
+	\param		NONE
+	\return		UINT32
+	\retval		Size of the file in bytes
+ ****************************************************************************************************
+*/
+const UINT32 Utilities::MappedFile::GetSize( void ) const
+{
+	return _u32Size;
+}
@@ -7,9 +7,177 @@
 
 #include <math.h>
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "Math.h"
+#include "../Time/Time.h"
 #include "../Debug/Debug.h"
+#include "../Target/Target.h"
+
+#ifdef TARGET_SSE
+	#include <xmmintrin.h>
+#endif	// #ifdef TARGET_SSE
+
+namespace Utilities
+{
+	namespace Math
+	{
+		namespace SweepHelper
+		{
+			// Take a contact at i_time if it is earlier than io_hit and the sphere moves towards it
+			static bool SetContact( const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_direction, const float &i_time,
+				const D3DXVECTOR3 &i_contactPoint, S_SWEEP_HIT &io_hit )
+			{
+				if( i_time >= io_hit.time )
+					return false;
+
+				D3DXVECTOR3 normal = i_startPoint + i_direction * i_time - i_contactPoint;
+				const float length = D3DXVec3Length( &normal );
+				if( (length < FLT_EPSILON) || (D3DXVec3Dot(&normal, &i_direction) >= 0.0f) )
+					return false;
+
+				io_hit.point = i_contactPoint;
+				io_hit.normal = normal / length;
+				io_hit.time = i_time;
+				return true;
+			}
+
+			// Solve the earlier root of a * t^2 + 2 * b * t + c = 0, a sphere already touching the feature is at 0
+			static bool EarlierRoot( const float &i_a, const float &i_b, const float &i_c, float &o_time )
+			{
+				if( i_b >= 0.0f )
+					return false;
+
+				if( i_c <= 0.0f )
+				{
+					o_time = 0.0f;
+					return true;
+				}
+
+				const float discriminant = i_b * i_b - i_a * i_c;
+				if( discriminant < 0.0f )
+					return false;
+
+				o_time = (-i_b - sqrtf(discriminant)) / i_a;
+				return true;
+			}
+
+			static bool SweepVertex( const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_direction, const float &i_radius,
+				const D3DXVECTOR3 &i_vertex, S_SWEEP_HIT &io_hit )
+			{
+				const D3DXVECTOR3 m = i_startPoint - i_vertex;
+				float time;
+
+				if( !EarlierRoot(D3DXVec3Dot(&i_direction, &i_direction), D3DXVec3Dot(&m, &i_direction),
+					D3DXVec3Dot(&m, &m) - i_radius * i_radius, time) )
+					return false;
+
+				return SetContact( i_startPoint, i_direction, time, i_vertex, io_hit );
+			}
+
+			// The sphere is swept against the cylinder around the edge, the vertices take the contacts beyond its ends
+			static bool SweepEdge( const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_direction, const float &i_radius,
+				const D3DXVECTOR3 &i_edgeStart, const D3DXVECTOR3 &i_edgeEnd, S_SWEEP_HIT &io_hit )
+			{
+				const D3DXVECTOR3 edge = i_edgeEnd - i_edgeStart;
+				const D3DXVECTOR3 m = i_startPoint - i_edgeStart;
+				const float ee = D3DXVec3Dot( &edge, &edge );
+				const float ed = D3DXVec3Dot( &edge, &i_direction );
+				const float em = D3DXVec3Dot( &edge, &m );
+				const float dd = D3DXVec3Dot( &i_direction, &i_direction );
+				float time;
+
+				if( ee < FLT_EPSILON )
+					return false;
+
+				const float a = ee * dd - ed * ed;
+				if( a <= FLT_EPSILON * ee * dd )
+					return false;
+
+				if( !EarlierRoot(a, ee * D3DXVec3Dot(&m, &i_direction) - em * ed,
+					ee * (D3DXVec3Dot(&m, &m) - i_radius * i_radius) - em * em, time) )
+					return false;
+
+				const float s = (em + time * ed) / ee;
+				if( (s < 0.0f) || (s > 1.0f) )
+					return false;
+
+				return SetContact( i_startPoint, i_direction, time, i_edgeStart + edge * s, io_hit );
+			}
+
+			// Convex polygon with its vertices in winding order
+			static bool SweepFace( const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_direction, const float &i_radius,
+				const D3DXVECTOR3 *i_vertices, const UINT32 &i_u32TotalVertices, S_SWEEP_HIT &io_hit )
+			{
+				const D3DXVECTOR3 edge1 = i_vertices[1] - i_vertices[0];
+				const D3DXVECTOR3 edge2 = i_vertices[2] - i_vertices[0];
+				D3DXVECTOR3 normal;
+
+				D3DXVec3Cross( &normal, &edge1, &edge2 );
+				const float length = D3DXVec3Length( &normal );
+				if( length < FLT_EPSILON )
+					return false;
+				normal /= length;
+
+				// Distance is measured on the side of the sphere
+				const D3DXVECTOR3 m = i_startPoint - i_vertices[0];
+				float distance = D3DXVec3Dot( &m, &normal );
+				float speed = D3DXVec3Dot( &i_direction, &normal );
+				if( distance < 0.0f )
+				{
+					distance = -distance;
+					speed = -speed;
+				}
+
+				if( speed >= 0.0f )
+					return false;
+
+				float time = (distance - i_radius) / -speed;
+				if( time < 0.0f )
+					time = 0.0f;
+
+				const float planeDistance = distance + time * speed;
+				const D3DXVECTOR3 sphereNormal = (D3DXVec3Dot(&m, &normal) < 0.0f) ? -normal : normal;
+				const D3DXVECTOR3 contactPoint = i_startPoint + i_direction * time - sphereNormal * planeDistance;
+
+				for( UINT32 i = 0; i < i_u32TotalVertices; ++i )
+				{
+					const D3DXVECTOR3 side = i_vertices[(i + 1) % i_u32TotalVertices] - i_vertices[i];
+					const D3DXVECTOR3 toPoint = contactPoint - i_vertices[i];
+					D3DXVECTOR3 inside;
+
+					D3DXVec3Cross( &inside, &side, &toPoint );
+					if( D3DXVec3Dot(&inside, &normal) < 0.0f )
+						return false;
+				}
+
+				if( time >= io_hit.time )
+					return false;
+
+				io_hit.point = contactPoint;
+				io_hit.normal = sphereNormal;
+				io_hit.time = time;
+				return true;
+			}
+
+			static bool SweepPolygon( const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_direction, const float &i_radius,
+				const D3DXVECTOR3 *i_vertices, const UINT32 &i_u32TotalVertices, S_SWEEP_HIT &io_hit )
+			{
+				bool bResult = SweepFace( i_startPoint, i_direction, i_radius, i_vertices, i_u32TotalVertices, io_hit );
+
+				for( UINT32 i = 0; i < i_u32TotalVertices; ++i )
+				{
+					bResult |= SweepEdge( i_startPoint, i_direction, i_radius, i_vertices[i],
+						i_vertices[(i + 1) % i_u32TotalVertices], io_hit );
+					bResult |= SweepVertex( i_startPoint, i_direction, i_radius, i_vertices[i], io_hit );
+				}
+
+				return bResult;
+			}
+		}	// namespace SweepHelper
+	}	// namespace Math
+}	// namespace Utilities
 
 /**
  ****************************************************************************************************
@@ -252,3 +420,761 @@ bool Utilities::Math::RayTracing( const D3DXVECTOR3 &i_startPoint, const D3DXVEC
 
 	return collisionDetected;
 }
+
+/**
+ ****************************************************************************************************
+	\fn			void ClearTrianglePacket( S_TRIANGLE_PACKET &o_packet )
+	\brief		Make every triangle of the packet degenerate
+	\param		o_packet the triangle packet
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::Math::ClearTrianglePacket( S_TRIANGLE_PACKET &o_packet )
+{
+	FUNCTION_START;
+
+	memset( &o_packet, 0, sizeof(S_TRIANGLE_PACKET) );
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void SetTriangle( S_TRIANGLE_PACKET &io_packet, const UINT32 &i_u32Slot,
+				const D3DXVECTOR3 &i_vertex0, const D3DXVECTOR3 &i_vertex1, const D3DXVECTOR3 &i_vertex2 )
+	\brief		Store a triangle in a slot of the packet
+	\param		io_packet the triangle packet
+	\param		i_u32Slot slot of the triangle
+	\param		i_vertex0 first point of triangle
+	\param		i_vertex1 second point of triangle
+	\param		i_vertex2 third point of triangle
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::Math::SetTriangle( S_TRIANGLE_PACKET &io_packet, const UINT32 &i_u32Slot,
+	const D3DXVECTOR3 &i_vertex0, const D3DXVECTOR3 &i_vertex1, const D3DXVECTOR3 &i_vertex2 )
+{
+	assert( i_u32Slot < TRIANGLE_PACKET_SIZE );
+
+	FUNCTION_START;
+
+	for( UINT8 i = 0; i < 3; ++i )
+	{
+		io_packet.vertex0[i][i_u32Slot] = i_vertex0[i];
+		io_packet.edge1[i][i_u32Slot] = i_vertex1[i] - i_vertex0[i];
+		io_packet.edge2[i][i_u32Slot] = i_vertex2[i] - i_vertex0[i];
+	}
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void BuildTrianglePackets( const D3DXVECTOR3 *i_vertices, const uint16_t *i_u16Indices,
+				const UINT32 &i_u32TotalTriangles, std::vector<S_TRIANGLE_PACKET> &o_packets )
+	\brief		Convert an indexed triangle list to triangle packets, triangle i is stored in slot
+				i % TRIANGLE_PACKET_SIZE of packet i / TRIANGLE_PACKET_SIZE
+	\param		i_vertices vertex buffer
+	\param		i_u16Indices index buffer, three indices per triangle
+	\param		i_u32TotalTriangles total triangles
+	\param		o_packets the triangle packets
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::Math::BuildTrianglePackets( const D3DXVECTOR3 *i_vertices, const uint16_t *i_u16Indices,
+	const UINT32 &i_u32TotalTriangles, std::vector<S_TRIANGLE_PACKET> &o_packets )
+{
+	FUNCTION_START;
+
+	o_packets.resize( (i_u32TotalTriangles + TRIANGLE_PACKET_SIZE - 1) / TRIANGLE_PACKET_SIZE );
+	for( UINT32 i = 0; i < o_packets.size(); ++i )
+		ClearTrianglePacket( o_packets[i] );
+
+	for( UINT32 i = 0; i < i_u32TotalTriangles; ++i )
+	{
+		SetTriangle( o_packets[i / TRIANGLE_PACKET_SIZE], i % TRIANGLE_PACKET_SIZE,
+			i_vertices[i_u16Indices[i * 3]], i_vertices[i_u16Indices[i * 3 + 1]], i_vertices[i_u16Indices[i * 3 + 2]] );
+	}
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool RayTracing( const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint,
+				const S_TRIANGLE_PACKET &i_packet, S_RAY_HIT &io_hit )
+	\brief		Find the closest intersection of a segment and the triangles of a packet, both faces
+				of a triangle are tested. All triangles are tested at once when SSE is available
+	\param		i_startPoint segment start point
+	\param		i_endPoint segment end point
+	\param		i_packet the triangle packet
+	\param		io_hit closest collision, it is only updated if a closer collision is found
+	\return		Intersection validity
+	\retval		TRUE if closer intersection is found
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+bool Utilities::Math::RayTracing( const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint,
+	const S_TRIANGLE_PACKET &i_packet, S_RAY_HIT &io_hit )
+{
+	float t[TRIANGLE_PACKET_SIZE];
+	float d[TRIANGLE_PACKET_SIZE];
+	float v[TRIANGLE_PACKET_SIZE];
+	float w[TRIANGLE_PACKET_SIZE];
+	UINT32 u32HitMask = 0;
+	UINT32 u32Closest = TRIANGLE_PACKET_SIZE;
+
+	FUNCTION_START;
+
+#ifdef TARGET_SSE
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 signMask = _mm_set1_ps( -0.0f );
+
+	const __m128 lineX = _mm_set1_ps( i_startPoint.x - i_endPoint.x );
+	const __m128 lineY = _mm_set1_ps( i_startPoint.y - i_endPoint.y );
+	const __m128 lineZ = _mm_set1_ps( i_startPoint.z - i_endPoint.z );
+
+	const __m128 apX = _mm_sub_ps( _mm_set1_ps(i_startPoint.x), _mm_loadu_ps(i_packet.vertex0[0]) );
+	const __m128 apY = _mm_sub_ps( _mm_set1_ps(i_startPoint.y), _mm_loadu_ps(i_packet.vertex0[1]) );
+	const __m128 apZ = _mm_sub_ps( _mm_set1_ps(i_startPoint.z), _mm_loadu_ps(i_packet.vertex0[2]) );
+
+	const __m128 abX = _mm_loadu_ps( i_packet.edge1[0] );
+	const __m128 abY = _mm_loadu_ps( i_packet.edge1[1] );
+	const __m128 abZ = _mm_loadu_ps( i_packet.edge1[2] );
+	const __m128 acX = _mm_loadu_ps( i_packet.edge2[0] );
+	const __m128 acY = _mm_loadu_ps( i_packet.edge2[1] );
+	const __m128 acZ = _mm_loadu_ps( i_packet.edge2[2] );
+
+	// n = ab x ac
+	const __m128 nX = _mm_sub_ps( _mm_mul_ps(abY, acZ), _mm_mul_ps(abZ, acY) );
+	const __m128 nY = _mm_sub_ps( _mm_mul_ps(abZ, acX), _mm_mul_ps(abX, acZ) );
+	const __m128 nZ = _mm_sub_ps( _mm_mul_ps(abX, acY), _mm_mul_ps(abY, acX) );
+
+	// e = line x ap
+	const __m128 eX = _mm_sub_ps( _mm_mul_ps(lineY, apZ), _mm_mul_ps(lineZ, apY) );
+	const __m128 eY = _mm_sub_ps( _mm_mul_ps(lineZ, apX), _mm_mul_ps(lineX, apZ) );
+	const __m128 eZ = _mm_sub_ps( _mm_mul_ps(lineX, apY), _mm_mul_ps(lineY, apX) );
+
+	// A back face is a front face with every term negated
+	__m128 dd = _mm_add_ps( _mm_add_ps(_mm_mul_ps(lineX, nX), _mm_mul_ps(lineY, nY)), _mm_mul_ps(lineZ, nZ) );
+	const __m128 sign = _mm_and_ps( dd, signMask );
+	dd = _mm_xor_ps( dd, sign );
+	const __m128 tt = _mm_xor_ps( _mm_add_ps(_mm_add_ps(_mm_mul_ps(apX, nX), _mm_mul_ps(apY, nY)), _mm_mul_ps(apZ, nZ)), sign );
+	const __m128 vv = _mm_xor_ps( _mm_add_ps(_mm_add_ps(_mm_mul_ps(acX, eX), _mm_mul_ps(acY, eY)), _mm_mul_ps(acZ, eZ)), sign );
+	const __m128 ww = _mm_xor_ps( _mm_add_ps(_mm_add_ps(_mm_mul_ps(abX, eX), _mm_mul_ps(abY, eY)), _mm_mul_ps(abZ, eZ)),
+		_mm_xor_ps(sign, signMask) );
+
+	__m128 mask = _mm_cmpgt_ps( dd, zero );
+	mask = _mm_and_ps( mask, _mm_cmpge_ps(tt, zero) );
+	mask = _mm_and_ps( mask, _mm_cmple_ps(tt, dd) );
+	mask = _mm_and_ps( mask, _mm_cmpge_ps(vv, zero) );
+	mask = _mm_and_ps( mask, _mm_cmpge_ps(ww, zero) );
+	mask = _mm_and_ps( mask, _mm_cmple_ps(_mm_add_ps(vv, ww), dd) );
+	mask = _mm_and_ps( mask, _mm_cmplt_ps(tt, _mm_mul_ps(dd, _mm_set1_ps(io_hit.distance))) );
+
+	u32HitMask = static_cast<UINT32>( _mm_movemask_ps(mask) );
+	if( u32HitMask )
+	{
+		_mm_storeu_ps( t, _mm_div_ps(tt, dd) );
+		_mm_storeu_ps( d, dd );
+		_mm_storeu_ps( v, vv );
+		_mm_storeu_ps( w, ww );
+	}
+#else
+	const D3DXVECTOR3 line = i_startPoint - i_endPoint;
+
+	for( UINT32 i = 0; i < TRIANGLE_PACKET_SIZE; ++i )
+	{
+		const D3DXVECTOR3 ab( i_packet.edge1[0][i], i_packet.edge1[1][i], i_packet.edge1[2][i] );
+		const D3DXVECTOR3 ac( i_packet.edge2[0][i], i_packet.edge2[1][i], i_packet.edge2[2][i] );
+		const D3DXVECTOR3 ap( i_startPoint.x - i_packet.vertex0[0][i], i_startPoint.y - i_packet.vertex0[1][i],
+			i_startPoint.z - i_packet.vertex0[2][i] );
+		D3DXVECTOR3 n;
+		D3DXVECTOR3 e;
+
+		D3DXVec3Cross( &n, &ab, &ac );
+		D3DXVec3Cross( &e, &line, &ap );
+
+		// A back face is a front face with every term negated
+		float sign = 1.0f;
+		d[i] = D3DXVec3Dot( &line, &n );
+		if( d[i] < 0.0f )
+		{
+			sign = -1.0f;
+			d[i] = -d[i];
+		}
+		t[i] = sign * D3DXVec3Dot( &ap, &n );
+		v[i] = sign * D3DXVec3Dot( &ac, &e );
+		w[i] = -sign * D3DXVec3Dot( &ab, &e );
+
+		if( (d[i] > 0.0f) && (t[i] >= 0.0f) && (t[i] <= d[i]) && (v[i] >= 0.0f) && (w[i] >= 0.0f) && (v[i] + w[i] <= d[i])
+			&& (t[i] < d[i] * io_hit.distance) )
+		{
+			u32HitMask |= 1 << i;
+			t[i] /= d[i];
+		}
+	}
+#endif	// #ifdef TARGET_SSE
+
+	if( u32HitMask == 0 )
+	{
+		FUNCTION_FINISH;
+		return false;
+	}
+
+	for( UINT32 i = 0; i < TRIANGLE_PACKET_SIZE; ++i )
+	{
+		if( (u32HitMask & (1 << i)) && ((u32Closest == TRIANGLE_PACKET_SIZE) || (t[i] < t[u32Closest])) )
+			u32Closest = i;
+	}
+
+	float ood = 1.0f / d[u32Closest];
+	io_hit.distance = t[u32Closest];
+	io_hit.barycentric.y = v[u32Closest] * ood;
+	io_hit.barycentric.z = w[u32Closest] * ood;
+	io_hit.barycentric.x = 1.0f - io_hit.barycentric.y - io_hit.barycentric.z;
+	io_hit.u32Triangle = u32Closest;
+	for( UINT8 i = 0; i < 3; ++i )
+	{
+		io_hit.point[i] = i_packet.vertex0[i][u32Closest] + io_hit.barycentric.y * i_packet.edge1[i][u32Closest]
+			+ io_hit.barycentric.z * i_packet.edge2[i][u32Closest];
+	}
+
+	FUNCTION_FINISH;
+	return true;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void SetSegment( S_SEGMENT &o_segment, const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint )
+	\brief		Prepare a segment for box tests
+	\param		o_segment the segment
+	\param		i_startPoint segment start point
+	\param		i_endPoint segment end point
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::Math::SetSegment( S_SEGMENT &o_segment, const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint )
+{
+	D3DXVECTOR3 direction = i_endPoint - i_startPoint;
+
+	FUNCTION_START;
+
+	o_segment.startPoint = i_startPoint;
+	for( UINT8 i = 0; i < 3; ++i )
+	{
+		o_segment.bParallel[i] = fabsf( direction[i] ) < FLT_EPSILON;
+		o_segment.invDirection[i] = o_segment.bParallel[i] ? 0.0f : 1.0f / direction[i];
+	}
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool SegmentBoxEntry( const S_SEGMENT &i_segment, const D3DXVECTOR3 &i_boxMin, const D3DXVECTOR3 &i_boxMax,
+				float &o_tEntry )
+	\brief		Clip a segment against an axis aligned box
+	\param		i_segment the segment
+	\param		i_boxMin minimum corner of the box
+	\param		i_boxMax maximum corner of the box
+	\param		o_tEntry fraction of the segment where it enters the box, 0 if it starts inside
+	\return		Intersection validity
+	\retval		TRUE if the segment touches the box
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+bool Utilities::Math::SegmentBoxEntry( const S_SEGMENT &i_segment, const D3DXVECTOR3 &i_boxMin, const D3DXVECTOR3 &i_boxMax,
+	float &o_tEntry )
+{
+	float tMin = 0.0f;
+	float tMax = 1.0f;
+
+	FUNCTION_START;
+
+	for( UINT8 i = 0; i < 3; ++i )
+	{
+		const float start = i_segment.startPoint[i];
+
+		if( i_segment.bParallel[i] )
+		{
+			if( (start < i_boxMin[i]) || (start > i_boxMax[i]) )
+			{
+				FUNCTION_FINISH;
+				return false;
+			}
+			continue;
+		}
+
+		float t1 = (i_boxMin[i] - start) * i_segment.invDirection[i];
+		float t2 = (i_boxMax[i] - start) * i_segment.invDirection[i];
+		if( t1 > t2 )
+		{
+			float temp = t1;
+			t1 = t2;
+			t2 = temp;
+		}
+		if( t1 > tMin )
+			tMin = t1;
+		if( t2 < tMax )
+			tMax = t2;
+		if( tMin > tMax )
+		{
+			FUNCTION_FINISH;
+			return false;
+		}
+	}
+
+	o_tEntry = tMin;
+
+	FUNCTION_FINISH;
+	return true;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool SweepSphere( const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint, const float &i_radius,
+				const D3DXVECTOR3 &i_vertex0, const D3DXVECTOR3 &i_vertex1, const D3DXVECTOR3 &i_vertex2,
+				S_SWEEP_HIT &io_hit )
+	\brief		Find the first contact of a sphere moving along a segment with a triangle, both faces of
+				the triangle are tested. Only contacts the sphere moves towards are taken, so a sphere
+				resting on or sliding along the triangle does not collide with it
+	\param		i_startPoint centre of the sphere at the start of the sweep
+	\param		i_endPoint centre of the sphere at the end of the sweep
+	\param		i_radius radius of the sphere
+	\param		i_vertex0 first point of triangle
+	\param		i_vertex1 second point of triangle
+	\param		i_vertex2 third point of triangle
+	\param		io_hit earliest contact, it is only updated if an earlier contact is found
+	\return		Intersection validity
+	\retval		TRUE if earlier contact is found
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+bool Utilities::Math::SweepSphere( const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint, const float &i_radius,
+	const D3DXVECTOR3 &i_vertex0, const D3DXVECTOR3 &i_vertex1, const D3DXVECTOR3 &i_vertex2, S_SWEEP_HIT &io_hit )
+{
+	const D3DXVECTOR3 direction = i_endPoint - i_startPoint;
+	const D3DXVECTOR3 triangle[3] = { i_vertex0, i_vertex1, i_vertex2 };
+
+	FUNCTION_START;
+
+	bool bResult = SweepHelper::SweepPolygon( i_startPoint, direction, i_radius, triangle, 3, io_hit );
+
+	FUNCTION_FINISH;
+	return bResult;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool SweepCapsule( const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint, const D3DXVECTOR3 &i_axis,
+				const float &i_radius, const D3DXVECTOR3 &i_vertex0, const D3DXVECTOR3 &i_vertex1,
+				const D3DXVECTOR3 &i_vertex2, S_SWEEP_HIT &io_hit )
+	\brief		Find the first contact of a capsule moving along a segment with a triangle. The capsule
+				touches the triangle when its first sphere touches the prism swept by the triangle along
+				the negated axis, so the sphere is swept against the faces of that prism
+	\param		i_startPoint centre of the first sphere of the capsule at the start of the sweep
+	\param		i_endPoint centre of the first sphere of the capsule at the end of the sweep
+	\param		i_axis from the centre of the first sphere to the centre of the second sphere
+	\param		i_radius radius of the capsule
+	\param		i_vertex0 first point of triangle
+	\param		i_vertex1 second point of triangle
+	\param		i_vertex2 third point of triangle
+	\param		io_hit earliest contact, it is only updated if an earlier contact is found
+	\return		Intersection validity
+	\retval		TRUE if earlier contact is found
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+bool Utilities::Math::SweepCapsule( const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint, const D3DXVECTOR3 &i_axis,
+	const float &i_radius, const D3DXVECTOR3 &i_vertex0, const D3DXVECTOR3 &i_vertex1, const D3DXVECTOR3 &i_vertex2,
+	S_SWEEP_HIT &io_hit )
+{
+	const D3DXVECTOR3 direction = i_endPoint - i_startPoint;
+	const D3DXVECTOR3 triangle[3] = { i_vertex0, i_vertex1, i_vertex2 };
+	const float axisLengthSquared = D3DXVec3Dot( &i_axis, &i_axis );
+	bool bResult = false;
+
+	FUNCTION_START;
+
+	if( axisLengthSquared < FLT_EPSILON )
+	{
+		bResult = SweepHelper::SweepPolygon( i_startPoint, direction, i_radius, triangle, 3, io_hit );
+		FUNCTION_FINISH;
+		return bResult;
+	}
+
+	// Bottom of the prism, the contact point is on the triangle
+	bResult |= SweepHelper::SweepPolygon( i_startPoint, direction, i_radius, triangle, 3, io_hit );
+
+	// Top of the prism, the contact point is lifted back by the axis
+	const D3DXVECTOR3 top[3] = { i_vertex0 - i_axis, i_vertex1 - i_axis, i_vertex2 - i_axis };
+	if( SweepHelper::SweepPolygon(i_startPoint, direction, i_radius, top, 3, io_hit) )
+	{
+		io_hit.point += i_axis;
+		bResult = true;
+	}
+
+	// Sides of the prism, the contact point is lifted back by its share of the axis
+	for( UINT8 i = 0; i < 3; ++i )
+	{
+		const D3DXVECTOR3 &edgeStart = triangle[i];
+		const D3DXVECTOR3 &edgeEnd = triangle[(i + 1) % 3];
+		const D3DXVECTOR3 side[4] = { edgeStart, edgeEnd, edgeEnd - i_axis, edgeStart - i_axis };
+
+		if( SweepHelper::SweepPolygon(i_startPoint, direction, i_radius, side, 4, io_hit) )
+		{
+			const D3DXVECTOR3 edge = edgeEnd - edgeStart;
+			const D3DXVECTOR3 offset = io_hit.point - edgeStart;
+			const float ee = D3DXVec3Dot( &edge, &edge );
+			const float ea = -D3DXVec3Dot( &edge, &i_axis );
+			const float oe = D3DXVec3Dot( &offset, &edge );
+			const float oa = -D3DXVec3Dot( &offset, &i_axis );
+			const float det = ee * axisLengthSquared - ea * ea;
+			float lift = (det > FLT_EPSILON * ee * axisLengthSquared) ? (ee * oa - ea * oe) / det : oa / axisLengthSquared;
+
+			if( lift < 0.0f )
+				lift = 0.0f;
+			else if( lift > 1.0f )
+				lift = 1.0f;
+
+			io_hit.point += i_axis * lift;
+			bResult = true;
+		}
+	}
+
+	FUNCTION_FINISH;
+	return bResult;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void SetBox( S_BOX_PACKET &io_packet, const UINT32 &i_u32Slot, const D3DXVECTOR3 &i_center,
+					const D3DXVECTOR3 &i_halfSize, const D3DXVECTOR3 &i_velocity )
+	\brief		Store a moving box in a slot of the packet
+	\param		io_packet the box packet
+	\param		i_u32Slot slot of the box
+	\param		i_center center of the box
+	\param		i_halfSize half of the width, height and depth of the box
+	\param		i_velocity velocity of the box
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::Math::SetBox( S_BOX_PACKET &io_packet, const UINT32 &i_u32Slot, const D3DXVECTOR3 &i_center,
+	const D3DXVECTOR3 &i_halfSize, const D3DXVECTOR3 &i_velocity )
+{
+	assert( i_u32Slot < BOX_PACKET_SIZE );
+
+	FUNCTION_START;
+
+	for( UINT8 i = 0; i < 3; ++i )
+	{
+		io_packet.center[i][i_u32Slot] = i_center[i];
+		io_packet.halfSize[i][i_u32Slot] = i_halfSize[i];
+		io_packet.velocity[i][i_u32Slot] = i_velocity[i];
+	}
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			UINT32 SweepBoxes( const D3DXVECTOR3 &i_center, const D3DXVECTOR3 &i_halfSize,
+					const D3DXVECTOR3 &i_velocity, const S_BOX_PACKET &i_packet, const UINT32 &i_u32TotalBoxes,
+					const float &i_time, S_BOX_SWEEP_HIT &o_hit )
+	\brief		Check which boxes of a packet intersect a box within a time, both of them moving. Every
+				packet box moves relative to the box, on each axis it has to enter the summed extent
+				within the time or already be inside it. An axis without relative velocity only needs the
+				box inside it. The enter time is the latest of the three axes, the earlier axis wins a tie.
+				All boxes are tested at once when SSE is available
+	\param		i_center center of the box
+	\param		i_halfSize half of the width, height and depth of the box
+	\param		i_velocity velocity of the box
+	\param		i_packet the box packet
+	\param		i_u32TotalBoxes boxes stored in the packet, from the first slot
+	\param		i_time the time to check within
+	\param		o_hit enter time and normal of every slot, earliest enter time and leave mask
+	\return		UINT32
+	\retval		mask of the intersecting slots
+ ****************************************************************************************************
+*/
+UINT32 Utilities::Math::SweepBoxes( const D3DXVECTOR3 &i_center, const D3DXVECTOR3 &i_halfSize, const D3DXVECTOR3 &i_velocity,
+	const S_BOX_PACKET &i_packet, const UINT32 &i_u32TotalBoxes, const float &i_time, S_BOX_SWEEP_HIT &o_hit )
+{
+	const UINT32 u32ValidMask = (1 << i_u32TotalBoxes) - 1;
+	UINT32 u32HitMask = 0;
+
+	assert( i_u32TotalBoxes <= BOX_PACKET_SIZE );
+
+	FUNCTION_START;
+
+#ifdef TARGET_SSE
+	// Largest magnitude AreRelativelyEqual takes as zero
+	const INT32 i32ZeroBits = 10;
+	float zeroLimit;
+	memcpy( &zeroLimit, &i32ZeroBits, sizeof(zeroLimit) );
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps( 1.0f );
+	const __m128 signMask = _mm_set1_ps( -0.0f );
+	const __m128 allMask = _mm_cmpeq_ps( zero, zero );
+	const __m128 zeroVelocity = _mm_set1_ps( zeroLimit );
+	const __m128 time = _mm_set1_ps( i_time );
+	__m128 mask = allMask;
+	__m128 enter[3];
+	__m128 direction[3];
+
+	for( UINT8 i = 0; i < 3; ++i )
+	{
+		const __m128 d = _mm_sub_ps( _mm_loadu_ps(i_packet.center[i]), _mm_set1_ps(i_center[i]) );
+		const __m128 h = _mm_add_ps( _mm_loadu_ps(i_packet.halfSize[i]), _mm_set1_ps(i_halfSize[i]) );
+		const __m128 v = _mm_sub_ps( _mm_loadu_ps(i_packet.velocity[i]), _mm_set1_ps(i_velocity[i]) );
+		const __m128 bStill = _mm_cmple_ps( _mm_andnot_ps(signMask, v), zeroVelocity );
+
+		__m128 enterTime = _mm_div_ps( _mm_sub_ps(_mm_sub_ps(zero, h), d), v );
+		__m128 leaveTime = _mm_div_ps( _mm_sub_ps(h, d), v );
+		const __m128 bSwap = _mm_cmplt_ps( leaveTime, enterTime );
+		const __m128 earlier = _mm_min_ps( enterTime, leaveTime );
+		leaveTime = _mm_max_ps( enterTime, leaveTime );
+		enterTime = earlier;
+
+		const __m128 bMoving = _mm_or_ps( _mm_and_ps(_mm_cmpge_ps(enterTime, zero), _mm_cmple_ps(enterTime, time)),
+			_mm_and_ps(_mm_cmplt_ps(enterTime, zero), _mm_cmpgt_ps(leaveTime, zero)) );
+		const __m128 bInside = _mm_cmple_ps( _mm_andnot_ps(signMask, d), h );
+
+		mask = _mm_and_ps( mask, _mm_or_ps(_mm_and_ps(bStill, bInside), _mm_andnot_ps(bStill, bMoving)) );
+		enter[i] = _mm_andnot_ps( bStill, enterTime );
+		// Entered from the positive side when the axis had to be swapped
+		direction[i] = _mm_andnot_ps( bStill, _mm_or_ps(_mm_and_ps(bSwap, one), _mm_andnot_ps(bSwap, _mm_xor_ps(one, signMask))) );
+	}
+
+	u32HitMask = static_cast<UINT32>( _mm_movemask_ps(mask) ) & u32ValidMask;
+
+	const __m128 bXBeforeY = _mm_cmplt_ps( enter[0], enter[1] );
+	const __m128 bUseZ = _mm_or_ps( _mm_and_ps(bXBeforeY, _mm_cmplt_ps(enter[1], enter[2])),
+		_mm_andnot_ps(bXBeforeY, _mm_cmplt_ps(enter[0], enter[2])) );
+	const __m128 bUseY = _mm_andnot_ps( bUseZ, bXBeforeY );
+	const __m128 bUseX = _mm_andnot_ps( _mm_or_ps(bUseY, bUseZ), allMask );
+
+	_mm_storeu_ps( o_hit.enterTime, _mm_or_ps(_mm_or_ps(_mm_and_ps(bUseX, enter[0]), _mm_and_ps(bUseY, enter[1])),
+		_mm_and_ps(bUseZ, enter[2])) );
+	_mm_storeu_ps( o_hit.enterNormal[0], _mm_and_ps(bUseX, direction[0]) );
+	_mm_storeu_ps( o_hit.enterNormal[1], _mm_and_ps(bUseY, direction[1]) );
+	_mm_storeu_ps( o_hit.enterNormal[2], _mm_and_ps(bUseZ, direction[2]) );
+#else
+	for( UINT32 i = 0; i < i_u32TotalBoxes; ++i )
+	{
+		float enter[3];
+		float direction[3];
+		bool bHit = true;
+
+		for( UINT8 j = 0; j < 3; ++j )
+		{
+			const float d = i_packet.center[j][i] - i_center[j];
+			const float h = i_packet.halfSize[j][i] + i_halfSize[j];
+			const float v = i_packet.velocity[j][i] - i_velocity[j];
+
+			enter[j] = 0.0f;
+			direction[j] = 0.0f;
+			if( AreRelativelyEqual(v, 0.0f) )
+			{
+				bHit &= fabs( d ) <= h;
+				continue;
+			}
+
+			float enterTime = (-h - d) / v;
+			float leaveTime = (h - d) / v;
+			direction[j] = -1.0f;
+			if( leaveTime < enterTime )
+			{
+				float swap = enterTime;
+				enterTime = leaveTime;
+				leaveTime = swap;
+				direction[j] = 1.0f;
+			}
+			bHit &= ((enterTime >= 0.0f) && (enterTime <= i_time)) || ((enterTime < 0.0f) && (leaveTime > 0.0f));
+			enter[j] = enterTime;
+		}
+
+		UINT8 u8Axis = 0;
+		if( enter[0] < enter[1] )
+			u8Axis = (enter[1] < enter[2]) ? 2 : 1;
+		else if( enter[0] < enter[2] )
+			u8Axis = 2;
+
+		o_hit.enterTime[i] = enter[u8Axis];
+		for( UINT8 j = 0; j < 3; ++j )
+			o_hit.enterNormal[j][i] = (j == u8Axis) ? direction[j] : 0.0f;
+		if( bHit )
+			u32HitMask |= 1 << i;
+	}
+#endif	// #ifdef TARGET_SSE
+
+	o_hit.earliestEnterTime = FLT_MAX;
+	for( UINT32 i = 0; i < i_u32TotalBoxes; ++i )
+	{
+		if( (u32HitMask & (1 << i)) && (o_hit.enterTime[i] < o_hit.earliestEnterTime) )
+			o_hit.earliestEnterTime = o_hit.enterTime[i];
+	}
+	o_hit.u32LeaveMask = u32ValidMask & ~u32HitMask;
+
+	FUNCTION_FINISH;
+	return u32HitMask;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void RayTracingBenchmark( void )
+	\brief		Compare the time taken to trace segments against a triangle soup one triangle at a time
+				and one packet at a time
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::Math::RayTracingBenchmark( void )
+{
+	const UINT32 u32TotalTriangles = 4096;
+	const UINT32 u32TotalSegments = 1024;
+	std::vector<D3DXVECTOR3> vertices( u32TotalTriangles * 3 );
+	std::vector<uint16_t> u16Indices( u32TotalTriangles * 3 );
+	std::vector<S_TRIANGLE_PACKET> packets;
+	std::vector<D3DXVECTOR3> segments( u32TotalSegments * 2 );
+	UINT32 u32ScalarHits = 0;
+	UINT32 u32PacketHits = 0;
+
+	FUNCTION_START;
+
+	srand( 0 );
+	for( UINT32 i = 0; i < vertices.size(); ++i )
+	{
+		D3DXVECTOR3 offset( static_cast<float>(rand() % 100), static_cast<float>(rand() % 100), static_cast<float>(rand() % 100) );
+		vertices[i] = (i % 3) ? vertices[i - (i % 3)] + offset * 0.1f : offset * 10.0f;
+		u16Indices[i] = static_cast<uint16_t>( i );
+	}
+	for( UINT32 i = 0; i < segments.size(); ++i )
+		segments[i] = D3DXVECTOR3( static_cast<float>(rand() % 1000), static_cast<float>(rand() % 1000), static_cast<float>(rand() % 1000) );
+
+	BuildTrianglePackets( &vertices[0], &u16Indices[0], u32TotalTriangles, packets );
+
+	TICK startTick = Time::GetCurrentTick();
+	for( UINT32 i = 0; i < u32TotalSegments; ++i )
+	{
+		D3DXVECTOR3 collisionPoint;
+		float collisionDistance = 1.0f;
+		bool bCollided = false;
+
+		for( UINT32 j = 0; j < u32TotalTriangles; ++j )
+		{
+			bCollided |= RayTracing( segments[i * 2], segments[i * 2 + 1],
+				vertices[j * 3], vertices[j * 3 + 1], vertices[j * 3 + 2], bCollided, collisionPoint, collisionDistance );
+		}
+		if( bCollided )
+			++u32ScalarHits;
+	}
+	TICK scalarTick = Time::GetCurrentTick();
+
+	for( UINT32 i = 0; i < u32TotalSegments; ++i )
+	{
+		S_RAY_HIT hit;
+		bool bCollided = false;
+
+		hit.distance = 1.0f;
+		for( UINT32 j = 0; j < packets.size(); ++j )
+			bCollided |= RayTracing( segments[i * 2], segments[i * 2 + 1], packets[j], hit );
+		if( bCollided )
+			++u32PacketHits;
+	}
+	TICK packetTick = Time::GetCurrentTick();
+
+	DBG_MSG_LEVEL( D_INFO, "Ray tracing %d segments against %d triangles\n", u32TotalSegments, u32TotalTriangles );
+	DBG_MSG_LEVEL( D_INFO, "Per triangle: %d ms, %d hits\n", Time::GetDifferenceTick_ms(startTick, scalarTick), u32ScalarHits );
+	DBG_MSG_LEVEL( D_INFO, "Per packet: %d ms, %d hits\n", Time::GetDifferenceTick_ms(scalarTick, packetTick), u32PacketHits );
+
+	FUNCTION_FINISH;
+}
+
+#ifdef _DEBUG
+/**
+ ****************************************************************************************************
+	\fn			void UnitTest( void )
+	\brief		Check the first contact of swept spheres and capsules with the face, an edge and a vertex
+				of a triangle against contacts worked out by hand
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::Math::UnitTest( void )
+{
+	// Right triangle on the y = 0 plane, its long edge is on x + z = 4
+	const D3DXVECTOR3 vertex0( 0.0f, 0.0f, 0.0f );
+	const D3DXVECTOR3 vertex1( 4.0f, 0.0f, 0.0f );
+	const D3DXVECTOR3 vertex2( 0.0f, 0.0f, 4.0f );
+	const D3DXVECTOR3 axis( 0.0f, 2.0f, 0.0f );
+	const float halfSqrt2 = sqrtf( 2.0f ) * 0.5f;
+	const float tolerance = 0.001f;
+	S_SWEEP_HIT hit;
+	D3DXVECTOR3 difference;
+
+	FUNCTION_START;
+
+	// Sphere falling onto the face stops one radius above it
+	hit.time = 1.0f;
+	assert( SweepSphere(D3DXVECTOR3(1.0f, 5.0f, 1.0f), D3DXVECTOR3(1.0f, -5.0f, 1.0f), 1.0f, vertex0, vertex1, vertex2, hit) );
+	assert( fabsf(hit.time - 0.4f) < tolerance );
+	difference = hit.point - D3DXVECTOR3( 1.0f, 0.0f, 1.0f );
+	assert( D3DXVec3Length(&difference) < tolerance );
+	difference = hit.normal - D3DXVECTOR3( 0.0f, 1.0f, 0.0f );
+	assert( D3DXVec3Length(&difference) < tolerance );
+
+	// Only an earlier contact is taken, and a sphere moving away does not collide
+	assert( !SweepSphere(D3DXVECTOR3(1.0f, 5.0f, 1.0f), D3DXVECTOR3(1.0f, -5.0f, 1.0f), 0.5f, vertex0, vertex1, vertex2, hit) );
+	hit.time = 1.0f;
+	assert( !SweepSphere(D3DXVECTOR3(1.0f, 2.0f, 1.0f), D3DXVECTOR3(1.0f, 5.0f, 1.0f), 1.0f, vertex0, vertex1, vertex2, hit) );
+	assert( hit.time == 1.0f );
+
+	// Sphere moving on the plane of the triangle towards the middle of its long edge
+	hit.time = 1.0f;
+	assert( SweepSphere(D3DXVECTOR3(4.0f, 0.0f, 4.0f), D3DXVECTOR3(0.0f, 0.0f, 0.0f), 1.0f, vertex0, vertex1, vertex2, hit) );
+	assert( fabsf(hit.time - (1.0f - (4.0f + 2.0f * halfSqrt2) / 8.0f)) < tolerance );
+	difference = hit.point - D3DXVECTOR3( 2.0f, 0.0f, 2.0f );
+	assert( D3DXVec3Length(&difference) < tolerance );
+	difference = hit.normal - D3DXVECTOR3( halfSqrt2, 0.0f, halfSqrt2 );
+	assert( D3DXVec3Length(&difference) < tolerance );
+
+	// Sphere moving on the plane of the triangle towards its right angle corner
+	hit.time = 1.0f;
+	assert( SweepSphere(D3DXVECTOR3(-3.0f, 0.0f, -3.0f), D3DXVECTOR3(1.0f, 0.0f, 1.0f), 1.0f, vertex0, vertex1, vertex2, hit) );
+	assert( fabsf(hit.time - (3.0f - halfSqrt2) / 4.0f) < tolerance );
+	difference = hit.point - vertex0;
+	assert( D3DXVec3Length(&difference) < tolerance );
+	difference = hit.normal - D3DXVECTOR3( -halfSqrt2, 0.0f, -halfSqrt2 );
+	assert( D3DXVec3Length(&difference) < tolerance );
+
+	// Capsule rising onto the face from below, its second sphere touches it
+	hit.time = 1.0f;
+	assert( SweepCapsule(D3DXVECTOR3(1.0f, -5.0f, 1.0f), D3DXVECTOR3(1.0f, 1.0f, 1.0f), axis, 0.5f, vertex0, vertex1, vertex2, hit) );
+	assert( fabsf(hit.time - 2.5f / 6.0f) < tolerance );
+	difference = hit.point - D3DXVECTOR3( 1.0f, 0.0f, 1.0f );
+	assert( D3DXVec3Length(&difference) < tolerance );
+	difference = hit.normal - D3DXVECTOR3( 0.0f, -1.0f, 0.0f );
+	assert( D3DXVec3Length(&difference) < tolerance );
+
+	// Upright capsule across the plane of the triangle, its side touches the long edge
+	hit.time = 1.0f;
+	assert( SweepCapsule(D3DXVECTOR3(6.0f, -1.0f, 1.0f), D3DXVECTOR3(0.0f, -1.0f, 1.0f), axis, 0.5f, vertex0, vertex1, vertex2, hit) );
+	assert( fabsf(hit.time - (3.0f - halfSqrt2) / 6.0f) < tolerance );
+	difference = hit.point - D3DXVECTOR3( 3.0f + halfSqrt2 - 0.5f * halfSqrt2, 0.0f, 1.0f - 0.5f * halfSqrt2 );
+	assert( D3DXVec3Length(&difference) < tolerance );
+	difference = hit.normal - D3DXVECTOR3( halfSqrt2, 0.0f, halfSqrt2 );
+	assert( D3DXVec3Length(&difference) < tolerance );
+
+	// Capsule moving past the corner of the triangle, the end of its first sphere touches the vertex
+	hit.time = 1.0f;
+	assert( SweepCapsule(D3DXVECTOR3(-3.0f, 0.0f, -3.0f), D3DXVECTOR3(1.0f, 0.0f, 1.0f), axis, 1.0f, vertex0, vertex1, vertex2, hit) );
+	assert( fabsf(hit.time - (3.0f - halfSqrt2) / 4.0f) < tolerance );
+	difference = hit.point - vertex0;
+	assert( D3DXVec3Length(&difference) < tolerance );
+
+	FUNCTION_FINISH;
+}
+#endif	// #ifdef _DEBUG
@@ -8,18 +8,105 @@
 #ifndef _MATH_H_
 #define _MATH_H_
 
+#include <vector>
+
 #include "..\UtilitiesTypes.h"
 
 namespace Utilities
 {
 	namespace Math
 	{
+		const UINT32 TRIANGLE_PACKET_SIZE = 4;
+		const UINT32 BOX_PACKET_SIZE = 4;
+
+		// Triangles in structure of arrays layout, one array per component. Unused slots are left
+		// degenerate so they are never hit
+		typedef struct _s_triangle_packet_
+		{
+			float vertex0[3][TRIANGLE_PACKET_SIZE];
+			float edge1[3][TRIANGLE_PACKET_SIZE];
+			float edge2[3][TRIANGLE_PACKET_SIZE];
+		} S_TRIANGLE_PACKET;
+
+		typedef struct _s_ray_hit_
+		{
+			D3DXVECTOR3 point;
+			// Weights of vertex 0, 1 and 2 at the collision point
+			D3DXVECTOR3 barycentric;
+			// Fraction of the segment, only a collision closer than it is taken
+			float distance;
+			// Slot of the collided triangle in its packet
+			UINT32 u32Triangle;
+		} S_RAY_HIT;
+
+		typedef struct _s_sweep_hit_
+		{
+			// Contact point on the triangle
+			D3DXVECTOR3 point;
+			// Unit normal at the contact, from the triangle towards the swept shape
+			D3DXVECTOR3 normal;
+			// Fraction of the sweep, only a contact earlier than it is taken
+			float time;
+		} S_SWEEP_HIT;
+
+		// Moving boxes in structure of arrays layout, one array per component
+		typedef struct _s_box_packet_
+		{
+			float center[3][BOX_PACKET_SIZE];
+			float halfSize[3][BOX_PACKET_SIZE];
+			float velocity[3][BOX_PACKET_SIZE];
+		} S_BOX_PACKET;
+
+		typedef struct _s_box_sweep_hit_
+		{
+			// Time the box of a slot starts to intersect, negative if it already does
+			float enterTime[BOX_PACKET_SIZE];
+			// Unit normal of the face entered, zero if no face is crossed
+			float enterNormal[3][BOX_PACKET_SIZE];
+			// Earliest enter time of the intersecting boxes, FLT_MAX if there is none
+			float earliestEnterTime;
+			// Boxes which do not intersect within the time
+			UINT32 u32LeaveMask;
+		} S_BOX_SWEEP_HIT;
+
+		// Segment start + t * (end - start), t in [0, 1], prepared for box tests
+		typedef struct _s_segment_
+		{
+			D3DXVECTOR3 startPoint;
+			D3DXVECTOR3 invDirection;
+			bool bParallel[3];
+		} S_SEGMENT;
+
 		bool AreRelativelyEqual( const float &i_lhs, const float &i_rhs, const int &i_Ulps = 10 );
 		bool AreWithinRange( const D3DXVECTOR3 &i_point1, const D3DXVECTOR3 &i_point2, const float &i_range );
 		float MaxFloats( const float &i_float1, const float &i_float2, const float &i_float3 );
 		bool RayTracing( const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint,
 			const D3DXVECTOR3 &i_vertex0, const D3DXVECTOR3 &i_vertex1, const D3DXVECTOR3 &i_vertex2,
 			const bool &i_bCollisionHasDetected, D3DXVECTOR3 &o_collisionPoint, float &o_collisionDistance );
+
+		void ClearTrianglePacket( S_TRIANGLE_PACKET &o_packet );
+		void SetTriangle( S_TRIANGLE_PACKET &io_packet, const UINT32 &i_u32Slot,
+			const D3DXVECTOR3 &i_vertex0, const D3DXVECTOR3 &i_vertex1, const D3DXVECTOR3 &i_vertex2 );
+		void BuildTrianglePackets( const D3DXVECTOR3 *i_vertices, const uint16_t *i_u16Indices, const UINT32 &i_u32TotalTriangles,
+			std::vector<S_TRIANGLE_PACKET> &o_packets );
+		bool RayTracing( const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint, const S_TRIANGLE_PACKET &i_packet,
+			S_RAY_HIT &io_hit );
+		void SetSegment( S_SEGMENT &o_segment, const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint );
+		bool SegmentBoxEntry( const S_SEGMENT &i_segment, const D3DXVECTOR3 &i_boxMin, const D3DXVECTOR3 &i_boxMax, float &o_tEntry );
+		bool SweepSphere( const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint, const float &i_radius,
+			const D3DXVECTOR3 &i_vertex0, const D3DXVECTOR3 &i_vertex1, const D3DXVECTOR3 &i_vertex2, S_SWEEP_HIT &io_hit );
+		bool SweepCapsule( const D3DXVECTOR3 &i_startPoint, const D3DXVECTOR3 &i_endPoint, const D3DXVECTOR3 &i_axis,
+			const float &i_radius, const D3DXVECTOR3 &i_vertex0, const D3DXVECTOR3 &i_vertex1, const D3DXVECTOR3 &i_vertex2,
+			S_SWEEP_HIT &io_hit );
+		void SetBox( S_BOX_PACKET &io_packet, const UINT32 &i_u32Slot, const D3DXVECTOR3 &i_center,
+			const D3DXVECTOR3 &i_halfSize, const D3DXVECTOR3 &i_velocity );
+		UINT32 SweepBoxes( const D3DXVECTOR3 &i_center, const D3DXVECTOR3 &i_halfSize, const D3DXVECTOR3 &i_velocity,
+			const S_BOX_PACKET &i_packet, const UINT32 &i_u32TotalBoxes, const float &i_time, S_BOX_SWEEP_HIT &o_hit );
+		void RayTracingBenchmark( void );
+
+	#ifdef _DEBUG
+		void UnitTest( void );
+	#endif	// #ifdef _DEBUG
 	}	// namespace Math
 }	// namespace GameEngine
 
@@ -0,0 +1,89 @@
+/**
+ ****************************************************************************************************
+ * \file		OctreeFile.h
+ * \brief		The binary collision octree layout shared by the octree generator and the engine. The
+ *          file is a header followed by a node array, a vertex block, a triangle block and a tag
+ *          block, nodes refer to their children, vertices, triangles and tags by index so the file
+ *          can be used straight from a mapped view
+ ****************************************************************************************************
+*/
+
+#ifndef _OCTREE_FILE_H_
+#define _OCTREE_FILE_H_
+
+#include "../UtilitiesTypes.h"
+
+namespace Utilities
+{
+	namespace OctreeFile
+	{
+		// "OCTR"
+		const UINT32 MAGIC = 0x5254434F;
+		// Bump it whenever a record changes, old octree files have to be generated again
+		const UINT32 VERSION = 2;
+		// Every section starts on this boundary, so the records can be loaded with aligned reads
+		const UINT32 ALIGNMENT = 16;
+		const UINT32 NO_NODE = 0xFFFFFFFF;
+		// Largest quantized coordinate, and the most vertices or tags a node can have
+		const UINT32 MAX_QUANTIZED = 0xFFFF;
+
+		typedef struct _s_section_
+		{
+			UINT32 u32Offset;
+			UINT32 u32Total;
+		} S_SECTION;
+
+		// Position quantized inside the vertex bounds of its node, padded so a vertex is one 64 bit load
+		typedef struct _s_vertex_
+		{
+			UINT16 u16Position[3];
+			UINT16 u16Padding;
+		} S_VERTEX;
+
+		typedef struct _s_triangle_
+		{
+			// Vertices of the node the triangle belongs to
+			UINT16 u16Vertices[3];
+			// Tag in the tag palette of the node
+			UINT16 u16Tag;
+		} S_TRIANGLE;
+
+		// Nodes are stored depth first, the root is the first node and every child comes after its parent
+		typedef struct _s_node_
+		{
+			D3DXVECTOR3 maxDimension;
+			// Half of the length of the node box
+			float size;
+			// Position of the quantized vertex (0, 0, 0)
+			D3DXVECTOR3 vertexOrigin;
+			UINT32 u32FirstVertex;
+			// Length of one quantization step on each axis
+			D3DXVECTOR3 vertexScale;
+			UINT32 u32FirstTag;
+			UINT32 u32StartIndex;
+			UINT32 u32TotalData;
+			UINT32 u32TotalVertices;
+			UINT32 u32TotalTags;
+			UINT32 u32Children[E_OCTANT_TOTAL];
+		} S_NODE;
+
+		typedef struct _s_header_
+		{
+			UINT32 u32Magic;
+			UINT32 u32Version;
+			UINT32 u32FileSize;
+			UINT32 u32Alignment;
+			S_SECTION node;
+			S_SECTION vertex;
+			S_SECTION triangle;
+			S_SECTION tag;
+		} S_HEADER;
+
+		inline UINT32 AlignOffset( const UINT32 &i_u32Offset )
+		{
+			return (i_u32Offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+		}
+	}	// namespace OctreeFile
+}	// namespace Utilities
+
+#endif	// #ifndef _OCTREE_FILE_H_
@@ -32,6 +32,7 @@ namespace Utilities
 
 		inline bool operator==( const StringHash &i_other );
 		inline operator UINT32( void ) const;
+		inline static StringHash FromHash( const UINT32 &i_u32Hash );
 		static UINT32 Hash( const char *i_string );
 		static UINT32 Hash( void *i_bytes, UINT32 i_count );
 	};
@@ -101,4 +101,19 @@ StringHash::operator UINT32( void ) const
 	return _hash;
 }
 
+/**
+ ****************************************************************************************************
+	\fn			StringHash FromHash( const UINT32 &i_u32Hash )
+	\brief		Rebuild a StringHash from a hash value saved earlier
+	\param		i_u32Hash the hash value
+	\return		StringHash
+ ****************************************************************************************************
+*/
+StringHash StringHash::FromHash( const UINT32 &i_u32Hash )
+{
+	StringHash newHash;
+	newHash._hash = i_u32Hash;
+	return newHash;
+}
+
 }	// namespace GameEngine
\ No newline at end of file
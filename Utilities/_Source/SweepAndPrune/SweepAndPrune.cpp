@@ -0,0 +1,641 @@
+/**
+ ****************************************************************************************************
+ * \file		SweepAndPrune.cpp
+ * \brief		The implementation of SweepAndPrune class
+ ****************************************************************************************************
+*/
+
+#include <float.h>
+#include <stdlib.h>
+
+#include "SweepAndPrune.h"
+
+namespace Utilities
+{
+	static const UINT32 ENDPOINT_MAX_BIT = 0x01;
+
+	// A minimum goes before a maximum of the same value, so touching bounds overlap
+	static inline bool IsLess( const float &i_lhsValue, const UINT32 &i_u32LhsData,
+		const float &i_rhsValue, const UINT32 &i_u32RhsData )
+	{
+		if( i_lhsValue != i_rhsValue )
+			return i_lhsValue < i_rhsValue;
+
+		return !(i_u32LhsData & ENDPOINT_MAX_BIT) && (i_u32RhsData & ENDPOINT_MAX_BIT);
+	}
+}	// namespace Utilities
+
+/****************************************************************************************************
+			PUBLIC FUNCTIONS IMPLEMENTATION
+****************************************************************************************************/
+/**
+ ****************************************************************************************************
+	\fn			SweepAndPrune *Create( const UINT32 &i_u32Capacity )
+	\brief		Create SweepAndPrune
+	\param		i_u32Capacity total proxies which can be alive at the same time
+	\return		Pointer to the created sweep and prune
+ ****************************************************************************************************
+*/
+Utilities::SweepAndPrune *Utilities::SweepAndPrune::Create( const UINT32 &i_u32Capacity )
+{
+	assert( i_u32Capacity );
+	assert( i_u32Capacity <= MAX_PROXY_CAPACITY );
+
+	FUNCTION_START;
+
+	SweepAndPrune *newSweepAndPrune = new SweepAndPrune( i_u32Capacity );
+
+	if( !newSweepAndPrune->_proxy || !newSweepAndPrune->_u32FreeProxies || !newSweepAndPrune->_u32MovedProxies
+		|| !newSweepAndPrune->_u32ActiveProxies || !newSweepAndPrune->_endpoint[0] || !newSweepAndPrune->_endpoint[1]
+		|| !newSweepAndPrune->_endpoint[2] )
+	{
+		delete newSweepAndPrune;
+		newSweepAndPrune = NULL;
+	}
+
+	FUNCTION_FINISH;
+	return newSweepAndPrune;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			~SweepAndPrune( void )
+	\brief		Destroy SweepAndPrune class
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+Utilities::SweepAndPrune::~SweepAndPrune( void )
+{
+	FUNCTION_START;
+
+	_aligned_free( _proxy );
+	_aligned_free( _u32FreeProxies );
+	_aligned_free( _u32MovedProxies );
+	_aligned_free( _u32ActiveProxies );
+	for( UINT8 i = 0; i < 3; ++i )
+		_aligned_free( _endpoint[i] );
+
+	delete _overlappingPairs;
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			UINT32 AddProxy( const D3DXVECTOR3 &i_vMin, const D3DXVECTOR3 &i_vMax, const UINT32 &i_u32UserData )
+	\brief		Add an active proxy and find every proxy it overlaps
+	\param		i_vMin minimum corner of the bounds
+	\param		i_vMax maximum corner of the bounds
+	\param		i_u32UserData the value reported with the overlapping pairs of this proxy
+	\return		UINT32
+	\retval		the new proxy
+	\retval		INVALID_PROXY if the sweep and prune is full
+ ****************************************************************************************************
+*/
+UINT32 Utilities::SweepAndPrune::AddProxy( const D3DXVECTOR3 &i_vMin, const D3DXVECTOR3 &i_vMax, const UINT32 &i_u32UserData )
+{
+	FUNCTION_START;
+
+	if( IsFull() )
+	{
+		FUNCTION_FINISH;
+		return INVALID_PROXY;
+	}
+
+	UINT32 u32Proxy = _u32FreeProxies[--_u32TotalFreeProxies];
+	S_PROXY &proxy = _proxy[u32Proxy];
+	proxy.vMin = i_vMin;
+	proxy.vMax = i_vMax;
+	proxy.u32UserData = i_u32UserData;
+	proxy.u32MovedSlot = INVALID_PROXY;
+	proxy.u32ActiveSlot = INVALID_PROXY;
+	SetActive( u32Proxy, true );
+
+	// Append the endpoints past every other one, the proxy then overlaps nothing. Sliding them into
+	// place reports the overlaps as the minimum passes the maximum of every proxy it overlaps
+	for( UINT8 i = 0; i < 3; ++i )
+	{
+		_endpoint[i][_u32TotalEndpoints].value = FLT_MAX;
+		_endpoint[i][_u32TotalEndpoints].u32Data = u32Proxy << 1;
+		_endpoint[i][_u32TotalEndpoints + 1].value = FLT_MAX;
+		_endpoint[i][_u32TotalEndpoints + 1].u32Data = (u32Proxy << 1) | ENDPOINT_MAX_BIT;
+		proxy.u32Endpoint[i][0] = _u32TotalEndpoints;
+		proxy.u32Endpoint[i][1] = _u32TotalEndpoints + 1;
+	}
+	_u32TotalEndpoints += 2;
+
+	MoveProxy( u32Proxy );
+
+	FUNCTION_FINISH;
+	return u32Proxy;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void RemoveProxy( const UINT32 &i_u32Proxy )
+	\brief		Remove a proxy with its overlapping pairs. The endpoints after the ones of the proxy are
+				shifted down, so it costs a pass over the endpoints
+	\param		i_u32Proxy the proxy
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::SweepAndPrune::RemoveProxy( const UINT32 &i_u32Proxy )
+{
+	assert( i_u32Proxy < _u32Capacity );
+
+	FUNCTION_START;
+
+	S_PROXY &proxy = _proxy[i_u32Proxy];
+
+	for( UINT8 i = 0; i < 3; ++i )
+	{
+		S_ENDPOINT *endpoint = _endpoint[i];
+		UINT32 u32Total = proxy.u32Endpoint[i][0];
+
+		for( UINT32 j = u32Total + 1; j < _u32TotalEndpoints; ++j )
+		{
+			if( (endpoint[j].u32Data >> 1) != i_u32Proxy )
+			{
+				endpoint[u32Total] = endpoint[j];
+				_proxy[endpoint[u32Total].u32Data >> 1].u32Endpoint[i][endpoint[u32Total].u32Data & ENDPOINT_MAX_BIT] = u32Total;
+				++u32Total;
+			}
+		}
+		assert( u32Total == _u32TotalEndpoints - 2 );
+	}
+	_u32TotalEndpoints -= 2;
+
+	// The pairs of the proxy follow each other when it is in the upper half
+	std::set<UINT64>::iterator iter = _overlappingPairs->lower_bound( PairKey(i_u32Proxy, 0) );
+	while( (iter != _overlappingPairs->end()) && (static_cast<UINT32>(*iter >> 32) == i_u32Proxy) )
+	{
+		_overlappingPairs->erase( PairKey(static_cast<UINT32>(*iter), i_u32Proxy) );
+		_overlappingPairs->erase( iter++ );
+	}
+
+	if( proxy.u32MovedSlot != INVALID_PROXY )
+	{
+		_u32MovedProxies[proxy.u32MovedSlot] = _u32MovedProxies[--_u32TotalMovedProxies];
+		_proxy[_u32MovedProxies[proxy.u32MovedSlot]].u32MovedSlot = proxy.u32MovedSlot;
+		proxy.u32MovedSlot = INVALID_PROXY;
+	}
+	SetActive( i_u32Proxy, false );
+
+	_u32FreeProxies[_u32TotalFreeProxies++] = i_u32Proxy;
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void SetActive( const UINT32 &i_u32Proxy, const bool &i_bActive )
+	\brief		Set whether the pairs of the proxy are reported by GetActivePairs. An inactive proxy is
+				still overlapped by the others, pairs of two inactive proxies are not reported
+	\param		i_u32Proxy the proxy
+	\param		i_bActive whether the proxy is active
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::SweepAndPrune::SetActive( const UINT32 &i_u32Proxy, const bool &i_bActive )
+{
+	assert( i_u32Proxy < _u32Capacity );
+
+	S_PROXY &proxy = _proxy[i_u32Proxy];
+
+	if( i_bActive && (proxy.u32ActiveSlot == INVALID_PROXY) )
+	{
+		proxy.u32ActiveSlot = _u32TotalActiveProxies;
+		_u32ActiveProxies[_u32TotalActiveProxies++] = i_u32Proxy;
+	}
+	else if( !i_bActive && (proxy.u32ActiveSlot != INVALID_PROXY) )
+	{
+		_u32ActiveProxies[proxy.u32ActiveSlot] = _u32ActiveProxies[--_u32TotalActiveProxies];
+		_proxy[_u32ActiveProxies[proxy.u32ActiveSlot]].u32ActiveSlot = proxy.u32ActiveSlot;
+		proxy.u32ActiveSlot = INVALID_PROXY;
+	}
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void Update( void )
+	\brief		Move the endpoints of the proxies moved since the last update to their current bounds
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::SweepAndPrune::Update( void )
+{
+	FUNCTION_START;
+
+	for( UINT32 i = 0; i < _u32TotalMovedProxies; ++i )
+	{
+		_proxy[_u32MovedProxies[i]].u32MovedSlot = INVALID_PROXY;
+		MoveProxy( _u32MovedProxies[i] );
+	}
+	_u32TotalMovedProxies = 0;
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void GetOverlappingPairs( std::vector<S_OVERLAPPING_PAIR> &o_pairs ) const
+	\brief		Get the user data of every overlapping pair, the lower proxy is reported as A
+	\param		o_pairs the overlapping pairs
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::SweepAndPrune::GetOverlappingPairs( std::vector<S_OVERLAPPING_PAIR> &o_pairs ) const
+{
+	FUNCTION_START;
+
+	o_pairs.resize( _overlappingPairs->size() / 2 );
+
+	UINT32 u32Pair = 0;
+	for( std::set<UINT64>::const_iterator iter = _overlappingPairs->begin(); iter != _overlappingPairs->end(); ++iter )
+	{
+		const UINT32 u32ProxyA = static_cast<UINT32>( *iter >> 32 );
+		const UINT32 u32ProxyB = static_cast<UINT32>( *iter );
+
+		if( u32ProxyA < u32ProxyB )
+		{
+			o_pairs[u32Pair].u32UserDataA = _proxy[u32ProxyA].u32UserData;
+			o_pairs[u32Pair].u32UserDataB = _proxy[u32ProxyB].u32UserData;
+			++u32Pair;
+		}
+	}
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void GetActivePairs( std::vector<S_OVERLAPPING_PAIR> &o_pairs ) const
+	\brief		Get the user data of every overlapping pair with at least one active proxy, the lower
+				proxy is reported as A. Only the pairs of the active proxies are visited
+	\param		o_pairs the overlapping pairs
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::SweepAndPrune::GetActivePairs( std::vector<S_OVERLAPPING_PAIR> &o_pairs ) const
+{
+	FUNCTION_START;
+
+	o_pairs.clear();
+
+	for( UINT32 i = 0; i < _u32TotalActiveProxies; ++i )
+	{
+		const UINT32 u32Proxy = _u32ActiveProxies[i];
+		std::set<UINT64>::const_iterator iter = _overlappingPairs->lower_bound( PairKey(u32Proxy, 0) );
+
+		for( ; (iter != _overlappingPairs->end()) && (static_cast<UINT32>(*iter >> 32) == u32Proxy); ++iter )
+		{
+			const UINT32 u32Other = static_cast<UINT32>( *iter );
+			S_OVERLAPPING_PAIR pair;
+
+			// A pair of two active proxies is reported by the lower one
+			if( (u32Other < u32Proxy) && IsActive(u32Other) )
+				continue;
+
+			pair.u32UserDataA = _proxy[u32Proxy < u32Other ? u32Proxy : u32Other].u32UserData;
+			pair.u32UserDataB = _proxy[u32Proxy < u32Other ? u32Other : u32Proxy].u32UserData;
+			o_pairs.push_back( pair );
+		}
+	}
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void GetProxyPairs( const UINT32 &i_u32Proxy, std::vector<S_OVERLAPPING_PAIR> &o_pairs ) const
+	\brief		Get the user data of every pair of one proxy, the proxy is reported as A
+	\param		i_u32Proxy the proxy
+	\param		o_pairs the overlapping pairs
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::SweepAndPrune::GetProxyPairs( const UINT32 &i_u32Proxy, std::vector<S_OVERLAPPING_PAIR> &o_pairs ) const
+{
+	assert( i_u32Proxy < _u32Capacity );
+
+	FUNCTION_START;
+
+	o_pairs.clear();
+
+	std::set<UINT64>::const_iterator iter = _overlappingPairs->lower_bound( PairKey(i_u32Proxy, 0) );
+	for( ; (iter != _overlappingPairs->end()) && (static_cast<UINT32>(*iter >> 32) == i_u32Proxy); ++iter )
+	{
+		S_OVERLAPPING_PAIR pair;
+
+		pair.u32UserDataA = _proxy[i_u32Proxy].u32UserData;
+		pair.u32UserDataB = _proxy[static_cast<UINT32>(*iter)].u32UserData;
+		o_pairs.push_back( pair );
+	}
+
+	FUNCTION_FINISH;
+}
+
+#ifdef _DEBUG
+/**
+ ****************************************************************************************************
+	\fn			void UnitTest( void )
+	\brief		Unit test for SweepAndPrune class
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::SweepAndPrune::UnitTest( void )
+{
+	FUNCTION_START;
+
+	SweepAndPrune *sweepAndPruneTest = SweepAndPrune::Create( 3 );
+	std::vector<S_OVERLAPPING_PAIR> pairs;
+
+	UINT32 u32ProxyA = sweepAndPruneTest->AddProxy( D3DXVECTOR3(0.0f, 0.0f, 0.0f), D3DXVECTOR3(2.0f, 2.0f, 2.0f), 10 );
+	UINT32 u32ProxyB = sweepAndPruneTest->AddProxy( D3DXVECTOR3(1.0f, 1.0f, 1.0f), D3DXVECTOR3(3.0f, 3.0f, 3.0f), 11 );
+	// Overlaps A on X only
+	UINT32 u32ProxyC = sweepAndPruneTest->AddProxy( D3DXVECTOR3(1.0f, 5.0f, 0.0f), D3DXVECTOR3(2.0f, 6.0f, 1.0f), 12 );
+	assert( sweepAndPruneTest->IsFull() );
+	assert( sweepAndPruneTest->TotalOverlappingPairs() == 1 );
+
+	sweepAndPruneTest->GetOverlappingPairs( pairs );
+	assert( (pairs[0].u32UserDataA == 10) && (pairs[0].u32UserDataB == 11) );
+
+	// B moves away on Z
+	sweepAndPruneTest->SetBounds( u32ProxyB, D3DXVECTOR3(1.0f, 1.0f, 4.0f), D3DXVECTOR3(3.0f, 3.0f, 5.0f) );
+	sweepAndPruneTest->Update();
+	assert( sweepAndPruneTest->TotalOverlappingPairs() == 0 );
+
+	// C drops onto A, touching bounds overlap
+	sweepAndPruneTest->SetBounds( u32ProxyC, D3DXVECTOR3(1.0f, 2.0f, 0.0f), D3DXVECTOR3(2.0f, 3.0f, 1.0f) );
+	sweepAndPruneTest->Update();
+	assert( sweepAndPruneTest->TotalOverlappingPairs() == 1 );
+
+	// Pairs of two inactive proxies are not reported
+	sweepAndPruneTest->SetActive( u32ProxyA, false );
+	sweepAndPruneTest->GetActivePairs( pairs );
+	assert( (pairs.size() == 1) && (pairs[0].u32UserDataA == 10) && (pairs[0].u32UserDataB == 12) );
+	sweepAndPruneTest->SetActive( u32ProxyC, false );
+	sweepAndPruneTest->GetActivePairs( pairs );
+	assert( pairs.empty() && (sweepAndPruneTest->TotalOverlappingPairs() == 1) );
+	sweepAndPruneTest->GetProxyPairs( u32ProxyC, pairs );
+	assert( (pairs.size() == 1) && (pairs[0].u32UserDataA == 12) && (pairs[0].u32UserDataB == 10) );
+
+	sweepAndPruneTest->RemoveProxy( u32ProxyA );
+	assert( sweepAndPruneTest->TotalOverlappingPairs() == 0 );
+	assert( !sweepAndPruneTest->IsFull() );
+
+	delete sweepAndPruneTest;
+
+	// Move a few proxies at a time, the pairs found have to match a brute force check
+	const UINT32 u32TotalProxies = 64;
+	UINT32 u32Proxies[u32TotalProxies];
+
+	sweepAndPruneTest = SweepAndPrune::Create( u32TotalProxies );
+	srand( 0 );
+	for( UINT32 i = 0; i < u32TotalProxies; ++i )
+	{
+		D3DXVECTOR3 vMin( static_cast<float>(rand() % 50), static_cast<float>(rand() % 50), static_cast<float>(rand() % 50) );
+		u32Proxies[i] = sweepAndPruneTest->AddProxy( vMin, vMin + D3DXVECTOR3(5.0f, 5.0f, 5.0f), i );
+	}
+
+	for( UINT32 i = 0; i < 100; ++i )
+	{
+		for( UINT32 j = 0; j < 8; ++j )
+		{
+			UINT32 u32Proxy = u32Proxies[rand() % u32TotalProxies];
+			D3DXVECTOR3 vMin( static_cast<float>(rand() % 50), static_cast<float>(rand() % 50), static_cast<float>(rand() % 50) );
+			sweepAndPruneTest->SetBounds( u32Proxy, vMin, vMin + D3DXVECTOR3(static_cast<float>(rand() % 8), 5.0f, 5.0f) );
+		}
+		sweepAndPruneTest->Update();
+
+		UINT32 u32TotalPairs = 0;
+		for( UINT32 j = 0; j < u32TotalProxies; ++j )
+		{
+			for( UINT32 k = j + 1; k < u32TotalProxies; ++k )
+			{
+				if( sweepAndPruneTest->Overlaps(u32Proxies[j], u32Proxies[k]) )
+				{
+					assert( sweepAndPruneTest->_overlappingPairs->count(PairKey(u32Proxies[j], u32Proxies[k])) == 1 );
+					++u32TotalPairs;
+				}
+			}
+		}
+		assert( sweepAndPruneTest->TotalOverlappingPairs() == u32TotalPairs );
+	}
+
+	delete sweepAndPruneTest;
+
+	FUNCTION_FINISH;
+}
+#endif	// #ifdef _DEBUG
+
+/****************************************************************************************************
+			PRIVATE FUNCTIONS IMPLEMENTATION
+****************************************************************************************************/
+/**
+ ****************************************************************************************************
+	\fn			SweepAndPrune( const UINT32 &i_u32Capacity )
+	\brief		SweepAndPrune constructor
+	\param		i_u32Capacity total proxies which can be alive at the same time
+	\return		NONE
+ ****************************************************************************************************
+*/
+Utilities::SweepAndPrune::SweepAndPrune( const UINT32 &i_u32Capacity ) :
+	_u32TotalFreeProxies( i_u32Capacity ),
+	_u32TotalMovedProxies( 0 ),
+	_u32TotalActiveProxies( 0 ),
+	_u32TotalEndpoints( 0 ),
+	_u32Capacity( i_u32Capacity ),
+	_overlappingPairs( new std::set<UINT64> )
+{
+	_proxy = reinterpret_cast<S_PROXY *>( _aligned_malloc(sizeof(S_PROXY) * i_u32Capacity, CACHE_LINE) );
+	_u32FreeProxies = reinterpret_cast<UINT32 *>( _aligned_malloc(sizeof(UINT32) * i_u32Capacity, CACHE_LINE) );
+	_u32MovedProxies = reinterpret_cast<UINT32 *>( _aligned_malloc(sizeof(UINT32) * i_u32Capacity, CACHE_LINE) );
+	_u32ActiveProxies = reinterpret_cast<UINT32 *>( _aligned_malloc(sizeof(UINT32) * i_u32Capacity, CACHE_LINE) );
+	for( UINT8 i = 0; i < 3; ++i )
+		_endpoint[i] = reinterpret_cast<S_ENDPOINT *>( _aligned_malloc(sizeof(S_ENDPOINT) * i_u32Capacity * 2, CACHE_LINE) );
+
+	if( _u32FreeProxies )
+	{
+		// Hand out the lowest proxy first
+		for( UINT32 i = 0; i < i_u32Capacity; ++i )
+			_u32FreeProxies[i] = i_u32Capacity - 1 - i;
+	}
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void MoveProxy( const UINT32 &i_u32Proxy )
+	\brief		Slide the endpoints of a proxy to its current bounds. On each axis the endpoint moving
+				towards the other one goes first, so a proxy never passes its own endpoints
+	\param		i_u32Proxy the proxy
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::SweepAndPrune::MoveProxy( const UINT32 &i_u32Proxy )
+{
+	const S_PROXY &proxy = _proxy[i_u32Proxy];
+
+	for( UINT8 i = 0; i < 3; ++i )
+	{
+		if( proxy.vMin[i] < _endpoint[i][proxy.u32Endpoint[i][0]].value )
+		{
+			MoveEndpoint( i, proxy.u32Endpoint[i][0], proxy.vMin[i] );
+			MoveEndpoint( i, proxy.u32Endpoint[i][1], proxy.vMax[i] );
+		}
+		else
+		{
+			MoveEndpoint( i, proxy.u32Endpoint[i][1], proxy.vMax[i] );
+			MoveEndpoint( i, proxy.u32Endpoint[i][0], proxy.vMin[i] );
+		}
+	}
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void MoveEndpoint( const UINT8 &i_u8Axis, const UINT32 &i_u32Index, const float &i_value )
+	\brief		Give an endpoint a new value and slide it into place. A minimum passing a maximum to its
+				left or a maximum passing a minimum to its right starts an overlap on this axis, the
+				opposite swaps end one, only those swaps can change whether a pair overlaps
+	\param		i_u8Axis the axis
+	\param		i_u32Index index of the endpoint
+	\param		i_value new value of the endpoint
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::SweepAndPrune::MoveEndpoint( const UINT8 &i_u8Axis, const UINT32 &i_u32Index, const float &i_value )
+{
+	S_ENDPOINT *endpoint = _endpoint[i_u8Axis];
+	S_ENDPOINT key = endpoint[i_u32Index];
+	const UINT32 u32Proxy = key.u32Data >> 1;
+	const bool bKeyIsMax = (key.u32Data & ENDPOINT_MAX_BIT) != 0;
+	UINT32 j = i_u32Index;
+
+	key.value = i_value;
+
+	while( (j > 0) && IsLess(key.value, key.u32Data, endpoint[j - 1].value, endpoint[j - 1].u32Data) )
+	{
+		const UINT32 u32Other = endpoint[j - 1].u32Data >> 1;
+		const bool bOtherIsMax = (endpoint[j - 1].u32Data & ENDPOINT_MAX_BIT) != 0;
+
+		assert( u32Other != u32Proxy );
+
+		if( !bKeyIsMax && bOtherIsMax )
+		{
+			if( OverlapsOnOtherAxes(u32Proxy, u32Other, i_u8Axis) )
+				AddPair( u32Proxy, u32Other );
+		}
+		else if( bKeyIsMax && !bOtherIsMax )
+			RemovePair( u32Proxy, u32Other );
+
+		endpoint[j] = endpoint[j - 1];
+		_proxy[u32Other].u32Endpoint[i_u8Axis][bOtherIsMax ? 1 : 0] = j;
+		--j;
+	}
+
+	while( (j + 1 < _u32TotalEndpoints) && IsLess(endpoint[j + 1].value, endpoint[j + 1].u32Data, key.value, key.u32Data) )
+	{
+		const UINT32 u32Other = endpoint[j + 1].u32Data >> 1;
+		const bool bOtherIsMax = (endpoint[j + 1].u32Data & ENDPOINT_MAX_BIT) != 0;
+
+		assert( u32Other != u32Proxy );
+
+		if( bKeyIsMax && !bOtherIsMax )
+		{
+			if( OverlapsOnOtherAxes(u32Proxy, u32Other, i_u8Axis) )
+				AddPair( u32Proxy, u32Other );
+		}
+		else if( !bKeyIsMax && bOtherIsMax )
+			RemovePair( u32Proxy, u32Other );
+
+		endpoint[j] = endpoint[j + 1];
+		_proxy[u32Other].u32Endpoint[i_u8Axis][bOtherIsMax ? 1 : 0] = j;
+		++j;
+	}
+
+	endpoint[j] = key;
+	_proxy[u32Proxy].u32Endpoint[i_u8Axis][bKeyIsMax ? 1 : 0] = j;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void AddPair( const UINT32 &i_u32ProxyA, const UINT32 &i_u32ProxyB )
+	\brief		Store an overlapping pair under both proxies
+	\param		i_u32ProxyA first proxy
+	\param		i_u32ProxyB second proxy
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::SweepAndPrune::AddPair( const UINT32 &i_u32ProxyA, const UINT32 &i_u32ProxyB )
+{
+	_overlappingPairs->insert( PairKey(i_u32ProxyA, i_u32ProxyB) );
+	_overlappingPairs->insert( PairKey(i_u32ProxyB, i_u32ProxyA) );
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void RemovePair( const UINT32 &i_u32ProxyA, const UINT32 &i_u32ProxyB )
+	\brief		Remove an overlapping pair from both proxies
+	\param		i_u32ProxyA first proxy
+	\param		i_u32ProxyB second proxy
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::SweepAndPrune::RemovePair( const UINT32 &i_u32ProxyA, const UINT32 &i_u32ProxyB )
+{
+	_overlappingPairs->erase( PairKey(i_u32ProxyA, i_u32ProxyB) );
+	_overlappingPairs->erase( PairKey(i_u32ProxyB, i_u32ProxyA) );
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool OverlapsOnOtherAxes( const UINT32 &i_u32ProxyA, const UINT32 &i_u32ProxyB,
+					const UINT8 &i_u8Axis ) const
+	\brief		Check the endpoints of both proxies overlap on the two other axes. The order of the
+				endpoints is used rather than the bounds, a moved proxy not updated yet keeps its pairs
+	\param		i_u32ProxyA first proxy
+	\param		i_u32ProxyB second proxy
+	\param		i_u8Axis the axis not checked
+	\return		boolean
+	\retval		TRUE if overlap
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+bool Utilities::SweepAndPrune::OverlapsOnOtherAxes( const UINT32 &i_u32ProxyA, const UINT32 &i_u32ProxyB,
+	const UINT8 &i_u8Axis ) const
+{
+	const S_PROXY &a = _proxy[i_u32ProxyA];
+	const S_PROXY &b = _proxy[i_u32ProxyB];
+
+	for( UINT8 i = 0; i < 3; ++i )
+	{
+		if( (i != i_u8Axis) && ((a.u32Endpoint[i][0] > b.u32Endpoint[i][1]) || (b.u32Endpoint[i][0] > a.u32Endpoint[i][1])) )
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool Overlaps( const UINT32 &i_u32ProxyA, const UINT32 &i_u32ProxyB ) const
+	\brief		Check the current bounds of both proxies overlap on every axis, used to verify the pairs
+	\param		i_u32ProxyA first proxy
+	\param		i_u32ProxyB second proxy
+	\return		boolean
+	\retval		TRUE if overlap
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+bool Utilities::SweepAndPrune::Overlaps( const UINT32 &i_u32ProxyA, const UINT32 &i_u32ProxyB ) const
+{
+	const S_PROXY &a = _proxy[i_u32ProxyA];
+	const S_PROXY &b = _proxy[i_u32ProxyB];
+
+	return (a.vMin.x <= b.vMax.x) && (b.vMin.x <= a.vMax.x)
+		&& (a.vMin.y <= b.vMax.y) && (b.vMin.y <= a.vMax.y)
+		&& (a.vMin.z <= b.vMax.z) && (b.vMin.z <= a.vMax.z);
+}
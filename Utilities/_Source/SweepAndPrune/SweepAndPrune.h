@@ -0,0 +1,113 @@
+/**
+ ****************************************************************************************************
+ * \file		SweepAndPrune.h
+ * \brief		The header of SweepAndPrune class. The bounds of every proxy are kept as endpoints sorted
+ *          on each axis. Only the endpoints of the proxies moved since the last update are slid back
+ *          into place, they barely move between frames and every swap they make updates the set of
+ *          overlapping pairs
+ ****************************************************************************************************
+*/
+
+#ifndef _SWEEP_AND_PRUNE_H_
+#define _SWEEP_AND_PRUNE_H_
+
+#include <set>
+#include <vector>
+#include <assert.h>
+#include <malloc.h>
+
+#include "../UtilitiesTypes.h"
+#include "../Debug/Debug.h"
+#include "../Target/Target.h"
+
+namespace Utilities
+{
+	const UINT32 INVALID_PROXY = 0xFFFFFFFF;
+	const UINT32 MAX_PROXY_CAPACITY = 0x7FFFFFFF;
+
+	class SweepAndPrune
+	{
+	public:
+		typedef struct _s_overlapping_pair_
+		{
+			UINT32 u32UserDataA;
+			UINT32 u32UserDataB;
+		} S_OVERLAPPING_PAIR;
+
+	private:
+		typedef struct _s_proxy_
+		{
+			D3DXVECTOR3 vMin;
+			D3DXVECTOR3 vMax;
+			UINT32 u32UserData;
+			// Index of the minimum and the maximum endpoint on each axis
+			UINT32 u32Endpoint[3][2];
+			// Slot in the moved and the active proxies, INVALID_PROXY if not in them
+			UINT32 u32MovedSlot;
+			UINT32 u32ActiveSlot;
+		} S_PROXY;
+
+		// Lowest bit tells a maximum from a minimum, the rest is the proxy
+		typedef struct _s_endpoint_
+		{
+			float value;
+			UINT32 u32Data;
+		} S_ENDPOINT;
+
+		S_PROXY *_proxy;
+		S_ENDPOINT *_endpoint[3];
+		UINT32 *_u32FreeProxies;
+		UINT32 *_u32MovedProxies;
+		UINT32 *_u32ActiveProxies;
+		UINT32 _u32TotalFreeProxies;
+		UINT32 _u32TotalMovedProxies;
+		UINT32 _u32TotalActiveProxies;
+		UINT32 _u32TotalEndpoints;
+		UINT32 _u32Capacity;
+		// Every pair is stored twice, once with each proxy in the upper half, so the pairs of a proxy
+		// follow each other
+		std::set<UINT64> *_overlappingPairs;
+
+		SweepAndPrune( const UINT32 &i_u32Capacity );
+
+		// Prohibit duplication and assignment
+		SweepAndPrune( const SweepAndPrune &i_other );
+		const SweepAndPrune &operator=( const SweepAndPrune &i_other );
+
+		void MoveProxy( const UINT32 &i_u32Proxy );
+		void MoveEndpoint( const UINT8 &i_u8Axis, const UINT32 &i_u32Index, const float &i_value );
+		void AddPair( const UINT32 &i_u32ProxyA, const UINT32 &i_u32ProxyB );
+		void RemovePair( const UINT32 &i_u32ProxyA, const UINT32 &i_u32ProxyB );
+		bool OverlapsOnOtherAxes( const UINT32 &i_u32ProxyA, const UINT32 &i_u32ProxyB, const UINT8 &i_u8Axis ) const;
+		bool Overlaps( const UINT32 &i_u32ProxyA, const UINT32 &i_u32ProxyB ) const;
+		inline static UINT64 PairKey( const UINT32 &i_u32ProxyA, const UINT32 &i_u32ProxyB );
+
+	public:
+		static SweepAndPrune *Create( const UINT32 &i_u32Capacity );
+
+		// Destructor
+		~SweepAndPrune( void );
+
+		// Operations
+		UINT32 AddProxy( const D3DXVECTOR3 &i_vMin, const D3DXVECTOR3 &i_vMax, const UINT32 &i_u32UserData );
+		void RemoveProxy( const UINT32 &i_u32Proxy );
+		inline void SetBounds( const UINT32 &i_u32Proxy, const D3DXVECTOR3 &i_vMin, const D3DXVECTOR3 &i_vMax );
+		inline void SetUserData( const UINT32 &i_u32Proxy, const UINT32 &i_u32UserData );
+		void SetActive( const UINT32 &i_u32Proxy, const bool &i_bActive );
+		inline bool IsActive( const UINT32 &i_u32Proxy ) const;
+		void Update( void );
+		void GetOverlappingPairs( std::vector<S_OVERLAPPING_PAIR> &o_pairs ) const;
+		void GetActivePairs( std::vector<S_OVERLAPPING_PAIR> &o_pairs ) const;
+		void GetProxyPairs( const UINT32 &i_u32Proxy, std::vector<S_OVERLAPPING_PAIR> &o_pairs ) const;
+		inline const UINT32 TotalOverlappingPairs( void ) const;
+		inline bool IsFull( void ) const;
+
+	#ifdef _DEBUG
+		static void UnitTest( void );
+	#endif	// #ifdef _DEBUG
+	};
+}	// namespace Utilities
+
+#include "SweepAndPrune.inl"
+
+#endif	// #ifndef _SWEEP_AND_PRUNE_H_
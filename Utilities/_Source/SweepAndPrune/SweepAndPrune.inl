@@ -0,0 +1,104 @@
+/**
+ ****************************************************************************************************
+ * \file		SweepAndPrune.inl
+ * \brief		The inline functions implementation of SweepAndPrune class
+ ****************************************************************************************************
+*/
+
+/**
+ ****************************************************************************************************
+	\fn			void SetBounds( const UINT32 &i_u32Proxy, const D3DXVECTOR3 &i_vMin, const D3DXVECTOR3 &i_vMax )
+	\brief		Move the bounds of the proxy, its endpoints follow on the next Update
+	\param		i_u32Proxy the proxy
+	\param		i_vMin minimum corner of the bounds
+	\param		i_vMax maximum corner of the bounds
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::SweepAndPrune::SetBounds( const UINT32 &i_u32Proxy, const D3DXVECTOR3 &i_vMin, const D3DXVECTOR3 &i_vMax )
+{
+	assert( i_u32Proxy < _u32Capacity );
+
+	_proxy[i_u32Proxy].vMin = i_vMin;
+	_proxy[i_u32Proxy].vMax = i_vMax;
+	if( _proxy[i_u32Proxy].u32MovedSlot == INVALID_PROXY )
+	{
+		_proxy[i_u32Proxy].u32MovedSlot = _u32TotalMovedProxies;
+		_u32MovedProxies[_u32TotalMovedProxies++] = i_u32Proxy;
+	}
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void SetUserData( const UINT32 &i_u32Proxy, const UINT32 &i_u32UserData )
+	\brief		Set the value reported with the overlapping pairs of the proxy
+	\param		i_u32Proxy the proxy
+	\param		i_u32UserData the user data
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::SweepAndPrune::SetUserData( const UINT32 &i_u32Proxy, const UINT32 &i_u32UserData )
+{
+	assert( i_u32Proxy < _u32Capacity );
+
+	_proxy[i_u32Proxy].u32UserData = i_u32UserData;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool IsActive( const UINT32 &i_u32Proxy ) const
+	\brief		Check whether the pairs of the proxy are reported by GetActivePairs
+	\param		i_u32Proxy the proxy
+	\return		boolean
+	\retval		TRUE if active
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+bool Utilities::SweepAndPrune::IsActive( const UINT32 &i_u32Proxy ) const
+{
+	assert( i_u32Proxy < _u32Capacity );
+
+	return _proxy[i_u32Proxy].u32ActiveSlot != INVALID_PROXY;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			const UINT32 TotalOverlappingPairs( void ) const
+	\brief		Get total overlapping pairs
+	\param		NONE
+	\return		UINT32
+ ****************************************************************************************************
+*/
+const UINT32 Utilities::SweepAndPrune::TotalOverlappingPairs( void ) const
+{
+	return _overlappingPairs->size() / 2;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool IsFull( void ) const
+	\brief		Check whether every proxy is in use
+	\param		NONE
+	\return		boolean
+	\retval		TRUE if full
+	\retval		FALSE otherwise
+ ****************************************************************************************************
+*/
+bool Utilities::SweepAndPrune::IsFull( void ) const
+{
+	return _u32TotalFreeProxies == 0;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			UINT64 PairKey( const UINT32 &i_u32ProxyA, const UINT32 &i_u32ProxyB )
+	\brief		Get the key of a pair as seen from the first proxy
+	\param		i_u32ProxyA first proxy, in the upper half
+	\param		i_u32ProxyB second proxy, in the lower half
+	\return		UINT64
+ ****************************************************************************************************
+*/
+UINT64 Utilities::SweepAndPrune::PairKey( const UINT32 &i_u32ProxyA, const UINT32 &i_u32ProxyB )
+{
+	return (static_cast<UINT64>(i_u32ProxyA) << 32) | i_u32ProxyB;
+}
@@ -13,4 +13,12 @@
 
 typedef __int64 TICK;
 
+// SSE/SSE2 intrinsics are always available to MSVC on x86 and x64. The Win32
+// projects build with /arch:SSE2 so scalar code is SSE2 as well, but a config
+// that misses the switch still gets the SIMD paths rather than silently none.
+#if defined( _M_X64 ) || defined( _M_IX86 )
+	#define TARGET_SSE
+	#define TARGET_SSE2
+#endif
+
 #endif	// #ifndef _TARGET_WIN32_H_
\ No newline at end of file
@@ -0,0 +1,497 @@
+/**
+ ****************************************************************************************************
+ * \file		TaskGraph.cpp
+ * \brief		The implementation of TaskGraph class
+ ****************************************************************************************************
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <windows.h>
+
+#include "TaskGraph.h"
+#include "../JobSystem/JobSystem.h"
+
+namespace Utilities
+{
+	static const UINT32 NO_TASK = 0xFFFFFFFF;
+
+#ifdef _DEBUG
+	// Declared resources of the task running on this thread
+	static __declspec(thread) const char *currentTaskName = NULL;
+	static __declspec(thread) UINT32 u32CurrentTaskReads = 0;
+	static __declspec(thread) UINT32 u32CurrentTaskWrites = 0;
+#endif	// #ifdef _DEBUG
+
+	static float TickToMs( const TICK &i_tick )
+	{
+		LARGE_INTEGER frequency;
+
+		QueryPerformanceFrequency( &frequency );
+		return static_cast<float>( (static_cast<double>(i_tick) * 1000.0) / static_cast<double>(frequency.QuadPart) );
+	}
+
+	static TICK GetTick( void )
+	{
+		LARGE_INTEGER tick;
+
+		QueryPerformanceCounter( &tick );
+		return tick.QuadPart;
+	}
+}	// namespace Utilities
+
+/****************************************************************************************************
+			PUBLIC FUNCTIONS IMPLEMENTATION
+****************************************************************************************************/
+/**
+ ****************************************************************************************************
+	\fn			TaskGraph *Create( void )
+	\brief		Create TaskGraph
+	\param		NONE
+	\return		Pointer to the created task graph
+ ****************************************************************************************************
+*/
+Utilities::TaskGraph *Utilities::TaskGraph::Create( void )
+{
+	FUNCTION_START;
+
+	TaskGraph *newGraph = new TaskGraph();
+
+	FUNCTION_FINISH;
+	return newGraph;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			~TaskGraph( void )
+	\brief		Destroy TaskGraph class
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+Utilities::TaskGraph::~TaskGraph( void )
+{
+	FUNCTION_START;
+
+	delete _task;
+
+	if( _mainThreadQueue )
+		delete [] _mainThreadQueue;
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			UINT32 AddTask( const char *i_name, TaskFunction i_function, const UINT32 &i_u32Reads,
+					const UINT32 &i_u32Writes, const bool &i_bMainThread )
+	\brief		Add a task after every task added before. It waits for every earlier task which writes
+				a resource it accesses, or reads a resource it writes
+	\param		i_name name of the task, it has to outlive the graph
+	\param		i_function the task
+	\param		i_u32Reads bit mask of the resources read by the task
+	\param		i_u32Writes bit mask of the resources written by the task
+	\param		i_bMainThread TRUE if the task may only run on the thread calling Execute
+	\return		UINT32
+	\retval		index of the task
+ ****************************************************************************************************
+*/
+UINT32 Utilities::TaskGraph::AddTask( const char *i_name, TaskFunction i_function, const UINT32 &i_u32Reads,
+	const UINT32 &i_u32Writes, const bool &i_bMainThread )
+{
+	S_TASK newTask;
+	const UINT32 u32NewTask = _task->size();
+
+	FUNCTION_START;
+
+	assert( i_name && i_function );
+
+	newTask.name = i_name;
+	newTask.function = i_function;
+	newTask.graph = this;
+	newTask.u32Reads = i_u32Reads;
+	newTask.u32Writes = i_u32Writes;
+	newTask.u32TotalPredecessors = 0;
+	newTask.u32ReleasedBy = NO_TASK;
+	newTask.pendingPredecessors = 0;
+	newTask.bMainThread = i_bMainThread;
+	newTask.startTick = 0;
+	newTask.finishTick = 0;
+
+	for( UINT32 i = 0; i < u32NewTask; ++i )
+	{
+		S_TASK &earlierTask = _task->at( i );
+
+		if( (earlierTask.u32Writes & (i_u32Reads | i_u32Writes)) || (earlierTask.u32Reads & i_u32Writes) )
+		{
+			earlierTask.successor.push_back( u32NewTask );
+			newTask.u32TotalPredecessors++;
+		}
+	}
+
+	_task->push_back( newTask );
+
+	if( _mainThreadQueue )
+		delete [] _mainThreadQueue;
+	_mainThreadQueue = new long[_task->size()];
+
+	FUNCTION_FINISH;
+	return u32NewTask;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void Execute( void )
+	\brief		Run every task once and return when all are done. The calling thread runs the main
+				thread tasks and helps the job system in between
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::TaskGraph::Execute( void )
+{
+	const UINT32 u32TotalTasks = _task->size();
+	UINT32 u32Task;
+
+	FUNCTION_START;
+
+	_startTick = GetTick();
+	_mainThreadQueueTail = 0;
+	_u32MainThreadQueueHead = 0;
+	_remainingTasks = u32TotalTasks;
+
+	for( UINT32 i = 0; i < u32TotalTasks; ++i )
+	{
+		S_TASK &task = _task->at( i );
+
+		_mainThreadQueue[i] = 0;
+		task.pendingPredecessors = task.u32TotalPredecessors;
+		task.u32ReleasedBy = NO_TASK;
+	}
+
+	for( UINT32 i = 0; i < u32TotalTasks; ++i )
+	{
+		if( _task->at(i).u32TotalPredecessors == 0 )
+			Schedule( _task->at(i) );
+	}
+
+	while( _remainingTasks > 0 )
+	{
+		if( PopMainThreadTask(u32Task) )
+			RunTask( _task->at(u32Task) );
+		else if( !JobSystem::ExecuteJob() )
+			YieldProcessor();
+	}
+
+	// The last job may still be returning
+	JobSystem::WaitForCounter( _jobCounter );
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void GetCriticalPath( char *o_buffer, const UINT32 &i_u32BufferSize ) const
+	\brief		Describe the chain of tasks which delayed the end of the last Execute the most. It starts
+				from the task finished last and follows the predecessor which finished last
+	\param		o_buffer buffer to write the description to
+	\param		i_u32BufferSize size of the buffer
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::TaskGraph::GetCriticalPath( char *o_buffer, const UINT32 &i_u32BufferSize ) const
+{
+	std::vector<UINT32> path;
+	UINT32 u32LastTask = NO_TASK;
+	int length;
+
+	assert( o_buffer && i_u32BufferSize );
+	o_buffer[0] = '\0';
+
+	for( UINT32 i = 0; i < _task->size(); ++i )
+	{
+		if( (u32LastTask == NO_TASK) || (_task->at(i).finishTick > _task->at(u32LastTask).finishTick) )
+			u32LastTask = i;
+	}
+	if( u32LastTask == NO_TASK )
+		return;
+
+	for( UINT32 i = u32LastTask; i != NO_TASK; i = _task->at(i).u32ReleasedBy )
+		path.push_back( i );
+
+	// A description longer than the buffer is truncated
+	length = _snprintf_s( o_buffer, i_u32BufferSize, _TRUNCATE, "%.2fms:", TickToMs(_task->at(u32LastTask).finishTick - _startTick) );
+	for( UINT32 i = path.size(); (i > 0) && (length > 0); --i )
+	{
+		const S_TASK &task = _task->at( path[i - 1] );
+		int written = _snprintf_s( o_buffer + length, i_u32BufferSize - length, _TRUNCATE, " %s %.2f",
+			task.name, TickToMs(task.finishTick - task.startTick) );
+		if( written < 0 )
+			break;
+		length += written;
+	}
+}
+
+#ifdef _DEBUG
+/**
+ ****************************************************************************************************
+	\fn			void CheckAccess( const UINT32 &i_u32Reads, const UINT32 &i_u32Writes )
+	\brief		Report an access which is not declared by the task running on this thread
+	\param		i_u32Reads bit mask of the resources to be read
+	\param		i_u32Writes bit mask of the resources to be written
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::TaskGraph::CheckAccess( const UINT32 &i_u32Reads, const UINT32 &i_u32Writes )
+{
+	if( !currentTaskName )
+		return;
+
+	if( (i_u32Reads & ~(u32CurrentTaskReads | u32CurrentTaskWrites)) || (i_u32Writes & ~u32CurrentTaskWrites) )
+	{
+		DBG_MSG_LEVEL( D_ERR, "Task %s reads 0x%08x and writes 0x%08x without declaring them\n", currentTaskName,
+			i_u32Reads & ~(u32CurrentTaskReads | u32CurrentTaskWrites), i_u32Writes & ~u32CurrentTaskWrites );
+		assert( false );
+	}
+}
+
+namespace Utilities
+{
+	static volatile long unitTestSequence;
+	static volatile long unitTestOrder[4];
+
+	static void UnitTestTaskA( void ) { unitTestOrder[0] = InterlockedIncrement( &unitTestSequence ); }
+	static void UnitTestTaskB( void ) { unitTestOrder[1] = InterlockedIncrement( &unitTestSequence ); }
+	static void UnitTestTaskC( void ) { unitTestOrder[2] = InterlockedIncrement( &unitTestSequence ); }
+	static void UnitTestTaskD( void ) { unitTestOrder[3] = InterlockedIncrement( &unitTestSequence ); }
+}	// namespace Utilities
+
+/**
+ ****************************************************************************************************
+	\fn			void UnitTest( void )
+	\brief		Unit test for TaskGraph class
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::TaskGraph::UnitTest( void )
+{
+	char buffer[256];
+
+	FUNCTION_START;
+
+	TaskGraph *taskGraphTest = TaskGraph::Create();
+
+	// B reads what A writes, C is independent of both, D writes everything
+	taskGraphTest->AddTask( "A", UnitTestTaskA, 0, 0x1 );
+	taskGraphTest->AddTask( "B", UnitTestTaskB, 0x1, 0x2 );
+	taskGraphTest->AddTask( "C", UnitTestTaskC, 0x8, 0x4, true );
+	taskGraphTest->AddTask( "D", UnitTestTaskD, 0, 0xF );
+	assert( taskGraphTest->TotalTasks() == 4 );
+	assert( taskGraphTest->_task->at(2).u32TotalPredecessors == 0 );
+	assert( taskGraphTest->_task->at(3).u32TotalPredecessors == 3 );
+
+	for( UINT32 i = 0; i < 100; ++i )
+	{
+		unitTestSequence = 0;
+		taskGraphTest->Execute();
+
+		assert( unitTestSequence == 4 );
+		assert( unitTestOrder[0] < unitTestOrder[1] );
+		assert( unitTestOrder[3] == 4 );
+	}
+
+	taskGraphTest->GetCriticalPath( buffer, sizeof(buffer) );
+	assert( strstr(buffer, " D ") != NULL );
+
+	delete taskGraphTest;
+
+	FUNCTION_FINISH;
+}
+#endif	// #ifdef _DEBUG
+
+/****************************************************************************************************
+			PRIVATE FUNCTIONS IMPLEMENTATION
+****************************************************************************************************/
+/**
+ ****************************************************************************************************
+	\fn			TaskGraph( void )
+	\brief		TaskGraph constructor
+	\param		NONE
+	\return		NONE
+ ****************************************************************************************************
+*/
+Utilities::TaskGraph::TaskGraph( void ) :
+	_task( new std::vector<S_TASK> ),
+	_mainThreadQueue( NULL ),
+	_mainThreadQueueTail( 0 ),
+	_u32MainThreadQueueHead( 0 ),
+	_remainingTasks( 0 ),
+	_jobCounter( 0 ),
+	_startTick( 0 )
+{
+#ifdef _DEBUG
+	for( UINT32 i = 0; i < MAX_TASK_RESOURCES; ++i )
+	{
+		_activeReaders[i] = 0;
+		_activeWriters[i] = 0;
+	}
+#endif	// #ifdef _DEBUG
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void Schedule( S_TASK &i_task )
+	\brief		Queue a task whose predecessors are all done
+	\param		i_task the task
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::TaskGraph::Schedule( S_TASK &i_task )
+{
+	if( i_task.bMainThread )
+	{
+		long slot = InterlockedIncrement( &_mainThreadQueueTail ) - 1;
+		InterlockedExchange( &_mainThreadQueue[slot], static_cast<long>(&i_task - &_task->front()) + 1 );
+	}
+	else
+	{
+		JobSystem::Run( RunTaskJob, &i_task, _jobCounter );
+	}
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void RunTask( S_TASK &i_task )
+	\brief		Run a task and queue the successors it has released
+	\param		i_task the task
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::TaskGraph::RunTask( S_TASK &i_task )
+{
+	const UINT32 u32Task = &i_task - &_task->front();
+
+#ifdef _DEBUG
+	// A job system thread may run a task while it waits inside another one
+	const char *previousTaskName = currentTaskName;
+	UINT32 u32PreviousTaskReads = u32CurrentTaskReads;
+	UINT32 u32PreviousTaskWrites = u32CurrentTaskWrites;
+
+	currentTaskName = i_task.name;
+	u32CurrentTaskReads = i_task.u32Reads;
+	u32CurrentTaskWrites = i_task.u32Writes;
+	BeginAccess( i_task );
+#endif	// #ifdef _DEBUG
+
+	i_task.startTick = GetTick();
+	i_task.function();
+	i_task.finishTick = GetTick();
+
+#ifdef _DEBUG
+	EndAccess( i_task );
+	currentTaskName = previousTaskName;
+	u32CurrentTaskReads = u32PreviousTaskReads;
+	u32CurrentTaskWrites = u32PreviousTaskWrites;
+#endif	// #ifdef _DEBUG
+
+	for( UINT32 i = 0; i < i_task.successor.size(); ++i )
+	{
+		S_TASK &successor = _task->at( i_task.successor[i] );
+
+		if( InterlockedDecrement(&successor.pendingPredecessors) == 0 )
+		{
+			successor.u32ReleasedBy = u32Task;
+			Schedule( successor );
+		}
+	}
+
+	InterlockedDecrement( &_remainingTasks );
+}
+
+/**
+ ****************************************************************************************************
+	\fn			bool PopMainThreadTask( UINT32 &o_u32Task )
+	\brief		Take the oldest queued main thread task
+	\param		o_u32Task index of the task
+	\return		boolean
+	\retval		TRUE if a task is taken
+	\retval		FALSE if there is none
+ ****************************************************************************************************
+*/
+bool Utilities::TaskGraph::PopMainThreadTask( UINT32 &o_u32Task )
+{
+	if( (static_cast<long>(_u32MainThreadQueueHead) >= _mainThreadQueueTail) || (_mainThreadQueue[_u32MainThreadQueueHead] == 0) )
+		return false;
+
+	o_u32Task = _mainThreadQueue[_u32MainThreadQueueHead++] - 1;
+	return true;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void RunTaskJob( void *i_data, const UINT32 &i_u32Begin, const UINT32 &i_u32End )
+	\brief		Job system entry of a task
+	\param		i_data the task
+	\param		i_u32Begin not used
+	\param		i_u32End not used
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::TaskGraph::RunTaskJob( void *i_data, const UINT32 &i_u32Begin, const UINT32 &i_u32End )
+{
+	S_TASK &task = *reinterpret_cast<S_TASK *>( i_data );
+
+	task.graph->RunTask( task );
+}
+
+#ifdef _DEBUG
+/**
+ ****************************************************************************************************
+	\fn			void BeginAccess( const S_TASK &i_task )
+	\brief		Mark the resources of the task as in use and report a conflict with a running task
+	\param		i_task the task
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::TaskGraph::BeginAccess( const S_TASK &i_task )
+{
+	for( UINT32 i = 0; i < MAX_TASK_RESOURCES; ++i )
+	{
+		const UINT32 u32Resource = 1 << i;
+
+		if( i_task.u32Writes & u32Resource )
+		{
+			if( (InterlockedIncrement(&_activeWriters[i]) > 1) || (_activeReaders[i] > 0) )
+				DBG_MSG_LEVEL( D_ERR, "Task %s writes resource %u while it is in use\n", i_task.name, i );
+		}
+		else if( i_task.u32Reads & u32Resource )
+		{
+			InterlockedIncrement( &_activeReaders[i] );
+			if( _activeWriters[i] > 0 )
+				DBG_MSG_LEVEL( D_ERR, "Task %s reads resource %u while it is written\n", i_task.name, i );
+		}
+	}
+}
+
+/**
+ ****************************************************************************************************
+	\fn			void EndAccess( const S_TASK &i_task )
+	\brief		Release the resources of the task
+	\param		i_task the task
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::TaskGraph::EndAccess( const S_TASK &i_task )
+{
+	for( UINT32 i = 0; i < MAX_TASK_RESOURCES; ++i )
+	{
+		const UINT32 u32Resource = 1 << i;
+
+		if( i_task.u32Writes & u32Resource )
+			InterlockedDecrement( &_activeWriters[i] );
+		else if( i_task.u32Reads & u32Resource )
+			InterlockedDecrement( &_activeReaders[i] );
+	}
+}
+#endif	// #ifdef _DEBUG
@@ -0,0 +1,100 @@
+/**
+ ****************************************************************************************************
+ * \file		TaskGraph.h
+ * \brief		The header of TaskGraph class. Every task declares the resources it reads and writes as
+ *          bit masks, a task depends on every earlier task it conflicts with, so the graph gives the
+ *          same result as running the tasks one by one in the order they are added
+ ****************************************************************************************************
+*/
+
+#ifndef _TASK_GRAPH_H_
+#define _TASK_GRAPH_H_
+
+#include <assert.h>
+#include <vector>
+
+#include "../Target/Target.h"
+#include "../UtilitiesTypes.h"
+#include "../Debug/Debug.h"
+
+#ifdef _DEBUG
+	#define TASK_CHECK_ACCESS( reads, writes )	Utilities::TaskGraph::CheckAccess( reads, writes )
+#else
+	#define TASK_CHECK_ACCESS( reads, writes )	void( 0 )
+#endif	// #ifdef _DEBUG
+
+namespace Utilities
+{
+	const UINT32 MAX_TASK_RESOURCES = 32;
+
+	class TaskGraph
+	{
+	public:
+		typedef void (*TaskFunction)( void );
+
+	private:
+		typedef struct _s_task_
+		{
+			const char *name;
+			TaskFunction function;
+			TaskGraph *graph;
+			UINT32 u32Reads;
+			UINT32 u32Writes;
+			UINT32 u32TotalPredecessors;
+			UINT32 u32ReleasedBy;
+			volatile long pendingPredecessors;
+			bool bMainThread;
+			TICK startTick;
+			TICK finishTick;
+			std::vector<UINT32> successor;
+		} S_TASK;
+
+		std::vector<S_TASK> *_task;
+		volatile long *_mainThreadQueue;
+		volatile long _mainThreadQueueTail;
+		UINT32 _u32MainThreadQueueHead;
+		volatile long _remainingTasks;
+		volatile long _jobCounter;
+		TICK _startTick;
+	#ifdef _DEBUG
+		volatile long _activeReaders[MAX_TASK_RESOURCES];
+		volatile long _activeWriters[MAX_TASK_RESOURCES];
+	#endif	// #ifdef _DEBUG
+
+		TaskGraph( void );
+
+		// Prohibit duplication and assignment
+		TaskGraph( const TaskGraph &i_other );
+		const TaskGraph &operator=( const TaskGraph &i_other );
+
+		void Schedule( S_TASK &i_task );
+		void RunTask( S_TASK &i_task );
+		bool PopMainThreadTask( UINT32 &o_u32Task );
+		static void RunTaskJob( void *i_data, const UINT32 &i_u32Begin, const UINT32 &i_u32End );
+	#ifdef _DEBUG
+		void BeginAccess( const S_TASK &i_task );
+		void EndAccess( const S_TASK &i_task );
+	#endif	// #ifdef _DEBUG
+
+	public:
+		static TaskGraph *Create( void );
+
+		// Destructor
+		~TaskGraph( void );
+
+		UINT32 AddTask( const char *i_name, TaskFunction i_function, const UINT32 &i_u32Reads,
+			const UINT32 &i_u32Writes, const bool &i_bMainThread = false );
+		void Execute( void );
+		void GetCriticalPath( char *o_buffer, const UINT32 &i_u32BufferSize ) const;
+		inline const UINT32 TotalTasks( void ) const;
+
+	#ifdef _DEBUG
+		static void CheckAccess( const UINT32 &i_u32Reads, const UINT32 &i_u32Writes );
+		static void UnitTest( void );
+	#endif	// #ifdef _DEBUG
+	};
+}	// namespace Utilities
+
+#include "TaskGraph.inl"
+
+#endif	// #ifndef _TASK_GRAPH_H_
@@ -0,0 +1,19 @@
+/**
+ ****************************************************************************************************
+ * \file		TaskGraph.inl
+ * \brief		The inline functions implementation of TaskGraph class
+ ****************************************************************************************************
+*/
+
+/**
+ ****************************************************************************************************
+	\fn			const UINT32 TotalTasks( void ) const
+	\brief		Get total tasks in the graph
+	\param		NONE
+	\return		UINT32
+ ****************************************************************************************************
+*/
+const UINT32 Utilities::TaskGraph::TotalTasks( void ) const
+{
+	return _task->size();
+}
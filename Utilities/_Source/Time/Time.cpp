@@ -20,6 +20,10 @@ namespace Utilities
 		LARGE_INTEGER g_totalCountsElapsed_duringRun;
 		LARGE_INTEGER g_totalCountsElapsed_previousFrame;
 		LARGE_INTEGER g_totalCountsElapsed_atInitialization;
+
+		float g_fixedTimeStep_ms = 1000.0f / 60.0f;
+		float g_fixedTimeAccumulator_ms = 0.0f;
+		UINT32 g_u32MaxFixedSteps = 5;
 	}	// namespace Time
 }	// namespace GameEngine
 
@@ -131,6 +135,88 @@ float Utilities::Time::GetTimeElapsedThisFrame_ms( void )
 	return lastFrame;
 }
 
+/**
+ ****************************************************************************************************
+	\fn			void SetFixedTimeStep( const float &i_step_ms, const UINT32 &i_u32MaxSteps )
+	\brief		Set the fixed simulation step
+	\param		i_step_ms length of one simulation step in ms
+	\param		i_u32MaxSteps maximum simulation steps run in one frame
+	\return		NONE
+ ****************************************************************************************************
+*/
+void Utilities::Time::SetFixedTimeStep( const float &i_step_ms, const UINT32 &i_u32MaxSteps )
+{
+	assert( i_step_ms > 0.0f );
+	assert( i_u32MaxSteps > 0 );
+
+	FUNCTION_START;
+
+	g_fixedTimeStep_ms = i_step_ms;
+	g_u32MaxFixedSteps = i_u32MaxSteps;
+	g_fixedTimeAccumulator_ms = 0.0f;
+
+	FUNCTION_FINISH;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			UINT32 AdvanceFixedTime( void )
+	\brief		Add the time elapsed during previous frame to the accumulator and take as many whole
+				simulation steps out of it as possible. After a hitch the steps are capped and the
+				time that does not fit is dropped, so the simulation slows down instead of spiralling
+	\param		NONE
+	\return		UINT32
+	\retval		Total simulation steps to be run this frame
+ ****************************************************************************************************
+*/
+UINT32 Utilities::Time::AdvanceFixedTime( void )
+{
+	UINT32 u32TotalSteps = 0;
+
+	FUNCTION_START;
+
+	g_fixedTimeAccumulator_ms += GetTimeElapsedThisFrame_ms();
+
+	u32TotalSteps = static_cast<UINT32>( g_fixedTimeAccumulator_ms / g_fixedTimeStep_ms );
+	g_fixedTimeAccumulator_ms -= u32TotalSteps * g_fixedTimeStep_ms;
+	if( g_fixedTimeAccumulator_ms < 0.0f )
+		g_fixedTimeAccumulator_ms = 0.0f;
+
+	if( u32TotalSteps > g_u32MaxFixedSteps )
+		u32TotalSteps = g_u32MaxFixedSteps;
+
+	FUNCTION_FINISH;
+	return u32TotalSteps;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			float GetFixedTimeStep_ms( void )
+	\brief		Get the length of one simulation step
+	\param		NONE
+	\return		float
+	\retval		Fixed simulation step in ms
+ ****************************************************************************************************
+*/
+float Utilities::Time::GetFixedTimeStep_ms( void )
+{
+	return g_fixedTimeStep_ms;
+}
+
+/**
+ ****************************************************************************************************
+	\fn			float GetInterpolationAlpha( void )
+	\brief		Get how far the render frame is between the last two simulation steps
+	\param		NONE
+	\return		float
+	\retval		0.0 at the previous step, 1.0 at the current step
+ ****************************************************************************************************
+*/
+float Utilities::Time::GetInterpolationAlpha( void )
+{
+	return g_fixedTimeAccumulator_ms / g_fixedTimeStep_ms;
+}
+
 /**
  ****************************************************************************************************
 	\fn			UINT32 GetCurrentCounter_ms( void )
@@ -224,4 +310,25 @@ UINT32 Utilities::Time::GetDifferenceTick_ms( TICK i_start, TICK i_end )
 	FUNCTION_START;
 	FUNCTION_FINISH;
 	return TickDifferenceToMs( static_cast<UINT32>(i_end - i_start) );
-}
\ No newline at end of file
+}
+
+/**
+ ****************************************************************************************************
+	\fn			UINT32 GetDifferenceTick_us( TICK i_start, TICK i_end )
+	\brief		Get the tick difference in microseconds
+	\param		i_start start tick
+	\param		i_end end tick
+	\return		UINT32
+	\retval		The tick difference in microseconds
+ ****************************************************************************************************
+*/
+UINT32 Utilities::Time::GetDifferenceTick_us( TICK i_start, TICK i_end )
+{
+	FUNCTION_START;
+
+	if( g_countsPerSecond.QuadPart == 0LL )
+		Initialize();
+
+	FUNCTION_FINISH;
+	return static_cast<UINT32>( (i_end - i_start) * 1000000.0 * g_frequency_s );
+}
@@ -20,11 +20,18 @@ namespace Utilities
 		float GetTotalSecondsElapsed( void );
 		float GetTimeElapsedThisFrame_ms( void );
 
+		// Fixed simulation step, the render frame time is accumulated and consumed in whole steps
+		void SetFixedTimeStep( const float &i_step_ms, const UINT32 &i_u32MaxSteps );
+		UINT32 AdvanceFixedTime( void );
+		float GetFixedTimeStep_ms( void );
+		float GetInterpolationAlpha( void );
+
 		UINT32 GetCurrentCounter_ms( void );
 		UINT32 TickDifferenceToMs( UINT32 i_u32Ticks );
 		TICK GetCurrentTick( void );
 		UINT32 GetDifferenceTick( TICK i_start, TICK i_end );
 		UINT32 GetDifferenceTick_ms( TICK i_start, TICK i_end );
+		UINT32 GetDifferenceTick_us( TICK i_start, TICK i_end );
 	}	// namespace Time
 }	// namespace GameEngine
 
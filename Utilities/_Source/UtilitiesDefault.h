@@ -4,10 +4,12 @@
 #include "UtilitiesTypes.h"
 
 #define SHOW_FPS
+//#define SHOW_CRITICAL_PATH
 #define ENABLE_FREE_CAMERA
 #define ENABLE_COLLISION_WIREFRAME
 #define ENABLE_OCTREE_DISPLAY
 #define ENABLE_WAY_POINT_DISPLAY
+//#define ENABLE_BENCHMARK
 
 #define MAX_FONT_FILENAME_INPUT		128
 #define MAX_INPUT_LEN							128